@@ -0,0 +1,270 @@
+/* The benchmark suite, run with `make bench`.
+ *
+ * Measures the throughput of every hash algorithm across buffer sizes,
+ * through its engine and through its hashwrapper, the files per second
+ * hashed by the Checker on generated trees of tiny, mixed and huge files,
+ * how the Checker scales with the number of threads and the memory it
+ * keeps per file. The results are written as JSON, to track them across
+ * releases:
+ *
+ *     ./bench [output.json]
+ *
+ * The trees are generated once and read from the page cache, so the
+ * numbers measure the CPU side of shazam, not the disks.
+ * */
+#include "../include/shazam/basic-types.hh"
+#include "../include/shazam/checker.hh"
+#include "../include/shazam/engine.hh"
+#include "../include/shazam/files.hh"
+#include "../include/shazam/pool.hh"
+
+#include "../include/external/hashlib2plus/hl_cpuid.h"
+#include "../include/external/hashlib2plus/hl_hashwrapper.h"
+#include "../include/external/hashlib2plus/hl_multibuffer.h"
+#include "../include/external/hashlib2plus/hl_sha1.h"
+#include "../include/external/hashlib2plus/hl_sha256.h"
+#include "../include/external/hashlib2plus/hl_wrapperfactory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+
+#define BENCH_DIR ".bench.shazam.tmp"
+
+using Clock = std::chrono::steady_clock;
+
+/* Time spent on each algorithm and buffer size. */
+constexpr double ALGORITHM_SECONDS = 0.25;
+
+/* A generated tree of files. */
+struct Tree {
+    std::string name;
+    std::vector<std::string> files;
+    std::uintmax_t bytes;
+};
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static std::string jsonString(const std::string& value)
+{
+    std::string quoted = "\"";
+
+    for (char c : value) {
+        if (c == '"' || c == '\\')
+            quoted.push_back('\\');
+        quoted.push_back(c);
+    }
+
+    return quoted + "\"";
+}
+
+/* Hashes data in `bufferSize` updates for about ALGORITHM_SECONDS with
+ * `hasher`, which has the start(), update() and finish() of the engines,
+ * returning MB/s. */
+template<typename Hasher>
+static double algorithmThroughput(Hasher& hasher, std::size_t bufferSize)
+{
+    std::vector<unsigned char> buffer(bufferSize, 0x5a);
+    unsigned char digest[shazam::Digest::MAX_SIZE];
+    std::uintmax_t bytes = 0;
+    const auto start = Clock::now();
+
+    // One message per round, so that the finalization is part of the cost
+    while (secondsSince(start) < ALGORITHM_SECONDS) {
+        hasher.start();
+
+        for (std::size_t hashed = 0; hashed < (1 << 20); hashed += bufferSize)
+            hasher.update(buffer.data(), bufferSize);
+
+        hasher.finish(digest);
+        bytes += ((1 << 20) + bufferSize - 1) / bufferSize * bufferSize;
+    }
+
+    return bytes / secondsSince(start) / 1e6;
+}
+
+/* Writes `count` files with sizes given by `size`, returning the tree. */
+template<typename SizeFunction>
+static Tree generateTree(const std::string& name, std::size_t count, SizeFunction size)
+{
+    Tree tree { name, {}, 0 };
+    const std::string directory = BENCH_DIR "/" + name;
+    std::filesystem::create_directories(directory);
+    std::mt19937_64 random(42);
+    std::vector<char> content;
+
+    for (std::size_t i = 0; i < count; i++) {
+        const std::size_t bytes = size(random);
+        content.resize(bytes);
+
+        for (auto& c : content)
+            c = (char) random();
+
+        const std::string path = directory + "/" + std::to_string(i);
+        std::ofstream(path, std::ios::binary).write(content.data(), content.size());
+        tree.files.push_back(path);
+        tree.bytes += bytes;
+    }
+
+    return tree;
+}
+
+/* Hashes the tree with a new Checker, returning the seconds it took. */
+static double hashTree(const Tree& tree, unsigned int jobs)
+{
+    shazam::Checker checker(false, false);
+    shazam::FileFactory ffactory;
+    checker.setJobs(jobs);
+
+    const auto start = Clock::now();
+
+    for (auto& file : tree.files)
+        checker.add(ffactory.create(file), "SHA256");
+
+    checker.calculateHashSums();
+    return secondsSince(start);
+}
+
+/* Returns the heap bytes the Checker keeps per file, once the hash sums
+ * of the tree are calculated. */
+static double checkerBytesPerFile(const Tree& tree)
+{
+    const std::size_t before = mallinfo2().uordblks;
+    std::size_t after;
+
+    {
+        shazam::Checker checker(false, false);
+        shazam::FileFactory ffactory;
+
+        for (auto& file : tree.files)
+            checker.add(ffactory.create(file), "SHA256");
+
+        checker.calculateHashSums();
+        after = mallinfo2().uordblks;
+    }
+
+    return (double) (after - before) / tree.files.size();
+}
+
+int main(int argc, char** argv)
+{
+    const std::string output = argc > 1 ? argv[1] : "bench.json";
+    const unsigned int cpus = shazam::onlineCpus();
+    std::ostringstream json;
+
+    json << "{\n";
+    json << "  \"cpu_features\": " << jsonString(hlCpuFeaturesString()) << ",\n";
+    json << "  \"online_cpus\": " << cpus << ",\n";
+    json << "  \"kernels\": {\"sha1\": " << jsonString(SHA1::SHA1Kernel())
+         << ", \"sha256\": " << jsonString(SHA256::SHA256_Kernel())
+         << ", \"multibuffer\": " << jsonString(multibuffer::kernel()) << "},\n";
+
+    // ---- Hash algorithms
+    json << "  \"algorithms\": [\n";
+
+    const std::vector<std::size_t> bufferSizes = {64, 1024, 64 * 1024, 1024 * 1024};
+
+    for (std::size_t t = 0; t < shazam::STREAM_HASH_TYPES; t++) {
+        const std::string type = shazam::HASH_TYPES[t];
+
+        for (std::size_t b = 0; b < bufferSizes.size(); b++) {
+            std::unique_ptr<hashwrapper> wrapper(wrapperfactory().create(type));
+            const double wrapperMbps = algorithmThroughput(*wrapper, bufferSizes[b]);
+            const double mbps = shazam::withEngine(t, [&](auto& engine) {
+                return algorithmThroughput(engine, bufferSizes[b]);
+            });
+
+            std::cerr << "algorithm " << type << " buffer " << bufferSizes[b] << ": " << mbps << " MB/s ("
+                      << wrapperMbps << " MB/s through the wrapper)\n";
+
+            json << "    {\"algorithm\": " << jsonString(type) << ", \"buffer_size\": " << bufferSizes[b]
+                 << ", \"mb_per_second\": " << mbps << ", \"wrapper_mb_per_second\": " << wrapperMbps << "}"
+                 << (t + 1 == shazam::STREAM_HASH_TYPES && b + 1 == bufferSizes.size() ? "\n" : ",\n");
+        }
+    }
+
+    json << "  ],\n";
+
+    // ---- Generated trees
+    std::filesystem::remove_all(BENCH_DIR);
+
+    const std::vector<Tree> trees = {
+        generateTree("tiny", 4000, [](std::mt19937_64& random) { return 64 + random() % 1024; }),
+        generateTree("mixed", 300, [](std::mt19937_64& random) {
+            // Sizes spread evenly over the orders of magnitude, from 1 KiB to 4 MiB
+            return (std::size_t) (1024 * std::pow(4096.0, (random() % 1000) / 1000.0));
+        }),
+        generateTree("huge", 1, [](std::mt19937_64&) { return (std::size_t) 256 << 20; })
+    };
+
+    json << "  \"trees\": [\n";
+
+    for (std::size_t i = 0; i < trees.size(); i++) {
+        hashTree(trees[i], cpus); // Warms up the page cache
+        const double seconds = hashTree(trees[i], cpus);
+        std::cerr << "tree " << trees[i].name << ": " << trees[i].files.size() / seconds << " files/s\n";
+
+        json << "    {\"tree\": " << jsonString(trees[i].name) << ", \"files\": " << trees[i].files.size()
+             << ", \"bytes\": " << trees[i].bytes << ", \"jobs\": " << cpus << ", \"seconds\": " << seconds
+             << ", \"files_per_second\": " << trees[i].files.size() / seconds
+             << ", \"mb_per_second\": " << trees[i].bytes / seconds / 1e6 << "}"
+             << (i + 1 == trees.size() ? "\n" : ",\n");
+    }
+
+    json << "  ],\n";
+
+    // ---- Checker scaling
+    // Always over a few threads, to show the cost of oversubscription on small machines
+    std::vector<unsigned int> threadCounts = {1};
+
+    for (unsigned int jobs = 2; jobs <= std::max(4u, cpus) && jobs <= 64; jobs *= 2)
+        threadCounts.push_back(jobs);
+
+    json << "  \"scaling\": [\n";
+
+    const Tree& mixed = trees[1];
+    double baseline = 0;
+
+    for (std::size_t i = 0; i < threadCounts.size(); i++) {
+        const double seconds = hashTree(mixed, threadCounts[i]);
+
+        if (i == 0)
+            baseline = seconds;
+
+        std::cerr << "scaling " << threadCounts[i] << " threads: " << baseline / seconds << "x\n";
+
+        json << "    {\"tree\": " << jsonString(mixed.name) << ", \"jobs\": " << threadCounts[i]
+             << ", \"seconds\": " << seconds << ", \"speedup\": " << baseline / seconds << "}"
+             << (i + 1 == threadCounts.size() ? "\n" : ",\n");
+    }
+
+    json << "  ],\n";
+
+    // ---- Checker memory
+    const double bytesPerFile = checkerBytesPerFile(trees[0]);
+    std::cerr << "memory: " << bytesPerFile << " bytes per file\n";
+
+    json << "  \"memory\": {\"tree\": " << jsonString(trees[0].name) << ", \"files\": " << trees[0].files.size()
+         << ", \"bytes_per_file\": " << bytesPerFile << "}\n";
+    json << "}\n";
+
+    std::filesystem::remove_all(BENCH_DIR);
+    std::ofstream(output) << json.str();
+    std::cerr << "Results written to " << output << "\n";
+    return 0;
+}
@@ -0,0 +1,132 @@
+/* Counts the system calls made by shazam for each file it hashes.
+ *
+ * Runs `./shazam -md5 -j 1` under ptrace over a few and over many small
+ * files, and prints the difference per file, by system call. Usage:
+ *
+ *     ./bench-syscalls [files]
+ * */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <signal.h>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define BENCH_DIR ".syscallsbench.shazam.tmp"
+
+/* Returns the name of the system calls that matter when hashing files. */
+static std::string syscallName(unsigned long long nr)
+{
+    static const std::map<unsigned long long, std::string> names = {
+        {SYS_open, "open"}, {SYS_openat, "openat"}, {SYS_close, "close"},
+        {SYS_read, "read"}, {SYS_pread64, "pread64"}, {SYS_write, "write"},
+        {SYS_stat, "stat"}, {SYS_lstat, "lstat"}, {SYS_fstat, "fstat"},
+        {SYS_newfstatat, "newfstatat"}, {SYS_statx, "statx"}, {SYS_lseek, "lseek"},
+        {SYS_fcntl, "fcntl"}, {SYS_mmap, "mmap"}, {SYS_munmap, "munmap"},
+        {SYS_madvise, "madvise"}, {SYS_getdents64, "getdents64"}, {SYS_futex, "futex"}
+    };
+
+    const auto it = names.find(nr);
+    return it != names.end() ? it->second : "other";
+}
+
+/* Runs the command under ptrace, following its threads, and returns
+ * the number of calls to each system call. */
+static std::map<std::string, long> countSyscalls(std::vector<std::string> command)
+{
+    std::map<std::string, long> counts;
+    const pid_t child = fork();
+
+    if (child == 0) {
+        std::vector<char*> argv;
+
+        for (auto& arg : command)
+            argv.push_back(arg.data());
+        argv.push_back(nullptr);
+
+        freopen("/dev/null", "w", stdout);
+        ptrace(PTRACE_TRACEME, 0, nullptr, nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    int status;
+    waitpid(child, &status, 0);
+    ptrace(PTRACE_SETOPTIONS, child, nullptr,
+           PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE | PTRACE_O_EXITKILL);
+    ptrace(PTRACE_SYSCALL, child, nullptr, nullptr);
+
+    while (true) {
+        const pid_t tid = waitpid(-1, &status, __WALL);
+
+        if (tid < 0)
+            break;
+
+        if (WIFEXITED(status) || WIFSIGNALED(status))
+            continue;
+
+        int signal = 0;
+
+        if (WSTOPSIG(status) == (SIGTRAP | 0x80)) {
+            __ptrace_syscall_info info;
+
+            if (ptrace(PTRACE_GET_SYSCALL_INFO, tid, sizeof(info), &info) > 0
+                    && info.op == PTRACE_SYSCALL_INFO_ENTRY)
+                counts[syscallName(info.entry.nr)]++;
+        } else if (WSTOPSIG(status) != SIGTRAP && WSTOPSIG(status) != SIGSTOP) {
+            signal = WSTOPSIG(status);
+        }
+
+        ptrace(PTRACE_SYSCALL, tid, nullptr, signal);
+    }
+
+    return counts;
+}
+
+/* Returns the shazam command hashing the first `count` files. */
+static std::vector<std::string> hashCommand(int count)
+{
+    std::vector<std::string> command = {"./shazam", "-md5", "-j", "1"};
+
+    for (int i = 0; i < count; i++)
+        command.push_back(BENCH_DIR "/" + std::to_string(i));
+
+    return command;
+}
+
+int main(int argc, char** argv)
+{
+    const int files = argc > 1 ? std::max(2, std::atoi(argv[1])) : 1001;
+
+    std::system("rm -rf " BENCH_DIR " && mkdir " BENCH_DIR);
+
+    for (int i = 0; i < files; i++)
+        std::ofstream(BENCH_DIR "/" + std::to_string(i)) << "file number " << i << "\n";
+
+    // The difference cancels out the start up of the program
+    auto few = countSyscalls(hashCommand(1));
+    auto many = countSyscalls(hashCommand(files));
+    long total = 0;
+
+    std::printf("System calls per file, hashing %d small files:\n", files);
+
+    for (auto& entry : many) {
+        const double perFile = (double) (entry.second - few[entry.first]) / (files - 1);
+
+        if (perFile >= 0.01)
+            std::printf("  %-12s %6.2f\n", entry.first.c_str(), perFile);
+
+        total += entry.second - few[entry.first];
+    }
+
+    std::printf("  %-12s %6.2f\n", "total", (double) total / (files - 1));
+    std::system("rm -rf " BENCH_DIR);
+    return 0;
+}
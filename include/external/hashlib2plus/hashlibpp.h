@@ -52,6 +52,10 @@
 #include "hl_sha256wrapper.h"
 #include "hl_sha384wrapper.h"
 #include "hl_sha512wrapper.h"
+#include "hl_blake2bwrapper.h"
+#include "hl_blake3wrapper.h"
+#include "hl_xxh3wrapper.h"
+#include "hl_xxh128wrapper.h"
 
 
 //----------------------------------------------------------------------
@@ -0,0 +1,233 @@
+/*
+ * hashlib++ - a simple hash library for C++
+ *
+ * This file is an addition to hashlib++ and is distributed under
+ * the same license, see hl_hashwrapper.h for the full text.
+ */
+
+//----------------------------------------------------------------------
+
+/**
+ *  @file 	hl_blake2b.cpp
+ *  @brief	This file contains the implementation of the BLAKE2b class
+ */
+
+//----------------------------------------------------------------------
+//hashlib++ includes
+#include "hl_blake2b.h"
+
+//----------------------------------------------------------------------
+//C includes
+#include <string.h>
+
+//----------------------------------------------------------------------
+//constants
+
+/*
+ * Initialization vector, the one of SHA512
+ */
+static const hl_uint64 BLAKE2B_IV[8] = {
+	0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+	0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+	0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+	0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+/*
+ * Order of the message words in each round, the last two
+ * rounds repeating the first two
+ */
+static const hl_uint8 BLAKE2B_SIGMA[12][16] = {
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+	{ 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+	{  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+	{  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+	{  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+	{ 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+	{ 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+	{  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+	{ 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 }
+};
+
+//----------------------------------------------------------------------
+//helpers
+
+/*
+ * Rotates the 64 bit word x right
+ */
+#define BLAKE2B_ROTR(x, bits) (((x) >> (bits)) | ((x) << (64 - (bits))))
+
+/*
+ * The mixing function, on the words a, b, c and d of v
+ */
+#define BLAKE2B_G(v, a, b, c, d, x, y) \
+	do { \
+		v[a] = v[a] + v[b] + (x); \
+		v[d] = BLAKE2B_ROTR(v[d] ^ v[a], 32); \
+		v[c] = v[c] + v[d]; \
+		v[b] = BLAKE2B_ROTR(v[b] ^ v[c], 24); \
+		v[a] = v[a] + v[b] + (y); \
+		v[d] = BLAKE2B_ROTR(v[d] ^ v[a], 16); \
+		v[c] = v[c] + v[d]; \
+		v[b] = BLAKE2B_ROTR(v[b] ^ v[c], 63); \
+	} while(0)
+
+/**
+ *  @brief 	Reads a little endian 64 bit word
+ */
+static inline hl_uint64 BLAKE2b_Load64(const hl_uint8* p)
+{
+	hl_uint64 word = 0;
+	for(int i = 7; i >= 0; i--)
+	{
+		word = (word << 8) | p[i];
+	}
+	return word;
+}
+
+//----------------------------------------------------------------------
+//private member functions
+
+/**
+ *  @brief 	Compresses the block in the buffer
+ *  @param	context The context to use
+ *  @param	block The block to compress
+ *  @param	last True if it is the last block
+ */
+void BLAKE2b::BLAKE2b_Compress(HL_BLAKE2B_CTX* context, const hl_uint8* block, bool last)
+{
+	hl_uint64 v[16], m[16];
+
+	for(int i = 0; i < 16; i++)
+	{
+		m[i] = BLAKE2b_Load64(block + 8 * i);
+	}
+
+	for(int i = 0; i < 8; i++)
+	{
+		v[i] = context->h[i];
+		v[i + 8] = BLAKE2B_IV[i];
+	}
+
+	v[12] ^= context->t[0];
+	v[13] ^= context->t[1];
+
+	if(last)
+	{
+		v[14] = ~v[14];
+	}
+
+	for(int r = 0; r < 12; r++)
+	{
+		const hl_uint8* s = BLAKE2B_SIGMA[r];
+		BLAKE2B_G(v, 0, 4,  8, 12, m[s[ 0]], m[s[ 1]]);
+		BLAKE2B_G(v, 1, 5,  9, 13, m[s[ 2]], m[s[ 3]]);
+		BLAKE2B_G(v, 2, 6, 10, 14, m[s[ 4]], m[s[ 5]]);
+		BLAKE2B_G(v, 3, 7, 11, 15, m[s[ 6]], m[s[ 7]]);
+		BLAKE2B_G(v, 0, 5, 10, 15, m[s[ 8]], m[s[ 9]]);
+		BLAKE2B_G(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+		BLAKE2B_G(v, 2, 7,  8, 13, m[s[12]], m[s[13]]);
+		BLAKE2B_G(v, 3, 4,  9, 14, m[s[14]], m[s[15]]);
+	}
+
+	for(int i = 0; i < 8; i++)
+	{
+		context->h[i] ^= v[i] ^ v[i + 8];
+	}
+}
+
+//----------------------------------------------------------------------
+//public member functions
+
+/**
+ *  @brief 	Initialize the context
+ *  @param	context The context to init.
+ */
+void BLAKE2b::BLAKE2b_Init(HL_BLAKE2B_CTX* context)
+{
+	memcpy(context->h, BLAKE2B_IV, sizeof(context->h));
+
+	/*
+	 * parameter block: digest length, no key, fanout
+	 * and depth of 1, for sequential hashing
+	 */
+	context->h[0] ^= 0x01010000ULL ^ BLAKE2B_DIGEST_LENGTH;
+	context->t[0] = context->t[1] = 0;
+	context->buflen = 0;
+}
+
+/**
+ *  @brief	Updates the context
+ *  @param	context The context to update.
+ *  @param	data The data for updating the context.
+ *  @param	len The length of the given data.
+ */
+void BLAKE2b::BLAKE2b_Update(HL_BLAKE2B_CTX* context, const hl_uint8* data, size_t len)
+{
+	while(len > 0)
+	{
+		/*
+		 * a full buffer is only compressed once more data
+		 * comes, since the last block is compressed differently
+		 */
+		if(context->buflen == BLAKE2B_BLOCK_LENGTH)
+		{
+			context->t[0] += BLAKE2B_BLOCK_LENGTH;
+			context->t[1] += context->t[0] < BLAKE2B_BLOCK_LENGTH;
+			BLAKE2b_Compress(context, context->buffer, false);
+			context->buflen = 0;
+		}
+
+		/*
+		 * whole blocks are compressed in place, all but the
+		 * last one of the data
+		 */
+		if(context->buflen == 0)
+		{
+			while(len > BLAKE2B_BLOCK_LENGTH)
+			{
+				context->t[0] += BLAKE2B_BLOCK_LENGTH;
+				context->t[1] += context->t[0] < BLAKE2B_BLOCK_LENGTH;
+				BLAKE2b_Compress(context, data, false);
+				data += BLAKE2B_BLOCK_LENGTH;
+				len -= BLAKE2B_BLOCK_LENGTH;
+			}
+		}
+
+		size_t fill = BLAKE2B_BLOCK_LENGTH - context->buflen;
+		if(fill > len)
+		{
+			fill = len;
+		}
+
+		memcpy(context->buffer + context->buflen, data, fill);
+		context->buflen += fill;
+		data += fill;
+		len -= fill;
+	}
+}
+
+/**
+ *  @brief 	Finalize the BLAKE2b operation
+ *  @param	digest This OUT-Parameter receives the digest
+ *  @param	context The context to finalize.
+ */
+void BLAKE2b::BLAKE2b_Final(hl_uint8 digest[BLAKE2B_DIGEST_LENGTH], HL_BLAKE2B_CTX* context)
+{
+	context->t[0] += context->buflen;
+	context->t[1] += context->t[0] < context->buflen;
+
+	memset(context->buffer + context->buflen, 0, BLAKE2B_BLOCK_LENGTH - context->buflen);
+	BLAKE2b_Compress(context, context->buffer, true);
+
+	for(int i = 0; i < BLAKE2B_DIGEST_LENGTH; i++)
+	{
+		digest[i] = (hl_uint8) (context->h[i / 8] >> (8 * (i % 8)));
+	}
+}
+
+//----------------------------------------------------------------------
+//EOF
@@ -0,0 +1,121 @@
+/*
+ * hashlib++ - a simple hash library for C++
+ *
+ * This file is an addition to hashlib++ and is distributed under
+ * the same license, see hl_hashwrapper.h for the full text.
+ */
+
+//----------------------------------------------------------------------
+
+/**
+ *  @file 	hl_blake2b.h
+ *  @brief	This file contains the declaration of the BLAKE2b class
+ */
+
+//----------------------------------------------------------------------
+//include protection
+#ifndef BLAKE2B_H
+#define BLAKE2B_H
+
+//----------------------------------------------------------------------
+//length defines
+#define BLAKE2B_BLOCK_LENGTH		128
+#define BLAKE2B_DIGEST_LENGTH		64
+
+//----------------------------------------------------------------------
+//hashlib++ includes
+#include "hl_types.h"
+
+//----------------------------------------------------------------------
+//C includes
+#include <stddef.h>
+
+//----------------------------------------------------------------------
+
+/**
+ * @brief This struct represents a BLAKE2b-hash context
+ */
+typedef struct HL_BLAKE2B_CTX
+{
+	/**
+	 * chained state
+	 */
+	hl_uint64	h[8];
+
+	/**
+	 * number of bytes hashed, low and high words
+	 */
+	hl_uint64	t[2];
+
+	/**
+	 * message buffer, holding the last block until
+	 * it is known whether it is the final one
+	 */
+	hl_uint8	buffer[BLAKE2B_BLOCK_LENGTH];
+
+	/**
+	 * number of bytes in the buffer
+	 */
+	size_t		buflen;
+} HL_BLAKE2B_CTX;
+
+//----------------------------------------------------------------------
+
+/**
+ *  @brief 	This class represents the implementation of
+ *   		the BLAKE2b algorithm (RFC 7693), unkeyed and
+ *   		with the digest of 64 bytes of b2sum.
+ *
+ *   		Basically the class provides three public member-functions
+ *   		to create a hash: BLAKE2b_Init(), BLAKE2b_Update() and
+ *   		BLAKE2b_Final(). If you want to create a hash based on a
+ *   		string or file quickly you should use the blake2bwrapper
+ *   		class instead of BLAKE2b.
+ */
+class BLAKE2b
+{
+	private:
+
+		/**
+		 *  @brief 	Compresses the block in the buffer
+		 *  @param	context The context to use
+		 *  @param	block The block to compress
+		 *  @param	last True if it is the last block
+		 */
+		void BLAKE2b_Compress(HL_BLAKE2B_CTX* context,
+				      const hl_uint8* block,
+				      bool last);
+
+	public:
+
+		/**
+		 *  @brief 	Initialize the context
+		 *  @param	context The context to init.
+		 */
+		void BLAKE2b_Init(HL_BLAKE2B_CTX* context);
+
+		/**
+		 *  @brief	Updates the context
+		 *  @param	context The context to update.
+		 *  @param	data The data for updating the context.
+		 *  @param	len The length of the given data.
+		 */
+		void BLAKE2b_Update(HL_BLAKE2B_CTX* context,
+				    const hl_uint8* data,
+				    size_t len);
+
+		/**
+		 *  @brief 	Finalize the BLAKE2b operation
+		 *  @param	digest This OUT-Parameter receives the digest
+		 *  @param	context The context to finalize.
+		 */
+		void BLAKE2b_Final(hl_uint8 digest[BLAKE2B_DIGEST_LENGTH],
+				   HL_BLAKE2B_CTX* context);
+};
+
+//----------------------------------------------------------------------
+//end of include protection
+#endif
+
+//----------------------------------------------------------------------
+//EOF
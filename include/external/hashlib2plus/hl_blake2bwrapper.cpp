@@ -0,0 +1,127 @@
+/*
+ * hashlib++ - a simple hash library for C++
+ *
+ * This file is an addition to hashlib++ and is distributed under
+ * the same license, see hl_hashwrapper.h for the full text.
+ */
+
+//----------------------------------------------------------------------
+
+/**
+ *  @file 	hl_blake2bwrapper.cpp
+ *  @brief	This file contains the implementation of the blake2bwrapper
+ *  		class.
+ */
+
+//----------------------------------------------------------------------
+//hashlib++ includes
+#include "hl_blake2bwrapper.h"
+#include "hl_blake2b.h"
+
+//----------------------------------------------------------------------
+//STL includes
+#include <sstream>
+#include <string>
+
+//----------------------------------------------------------------------
+//private memberfunctions
+
+/**
+ *  @brief 	This method ends the hash process
+ *  		and returns the hash as string.
+ *
+ *  @return 	a hash as std::string
+ */
+std::string blake2bwrapper::hashIt(void)
+{
+	hl_uint8 buff[BLAKE2B_DIGEST_LENGTH];
+	blake2b->BLAKE2b_Final(buff,&context);
+
+	return convToString(buff);
+}
+
+/**
+ *  @brief 	This method ends the hash process
+ *  		and writes the digest as bytes.
+ *
+ *  @param 	digest Receives the digest
+ *  @return 	the length of the digest
+ */
+unsigned int blake2bwrapper::digestIt(unsigned char *digest)
+{
+	blake2b->BLAKE2b_Final(digest,&context);
+	return BLAKE2B_DIGEST_LENGTH;
+}
+
+/**
+ *  @brief 	This internal member-function
+ *  		convertes the hash-data to a
+ *  		std::string (HEX).
+ *
+ *  @param 	data The hash-data to covert into HEX
+ *  @return	the converted data as std::string
+ */
+std::string blake2bwrapper::convToString(unsigned char *data)
+{
+	std::ostringstream os;
+	for(int i=0; i<BLAKE2B_DIGEST_LENGTH; ++i)
+	{
+		os.width(2);
+		os.fill('0');
+		os << std::hex << static_cast<unsigned int>(data[i]);
+	}
+	return os.str();
+}
+
+/**
+ *  @brief 	This method adds the given data to the
+ *  		current hash context
+ *
+ *  @param 	data The data to add to the current context
+ *  @param 	len The length of the data to add
+ */
+void blake2bwrapper::updateContext(unsigned char *data, unsigned int len)
+{
+	this->blake2b->BLAKE2b_Update(&context,data,len);
+}
+
+/**
+ *  @brief 	This method resets the current hash context.
+ *  		In other words: It starts a new hash process.
+ */
+void blake2bwrapper::resetContext(void)
+{
+	blake2b->BLAKE2b_Init(&context);
+}
+
+/**
+ * @brief 	This method should return the hash of the
+ * 		test-string "The quick brown fox jumps over the lazy
+ * 		dog"
+ */
+std::string blake2bwrapper::getTestHash(void)
+{
+	return "a8add4bdddfd93e4877d2746e62817b116364a1fa7bc148d95090bc7333b3673f82401cf7aa2e4cb1ecd90296e3f14cb5413f8ed77be73045b13914cdcd6a918";
+}
+
+//----------------------------------------------------------------------
+//public memberfunctions
+
+/**
+ *  @brief 	default constructor
+ */
+blake2bwrapper::blake2bwrapper()
+{
+	this->blake2b = new BLAKE2b();
+}
+
+/**
+ *  @brief 	default destructor
+ */
+blake2bwrapper::~blake2bwrapper()
+{
+	delete blake2b;
+}
+
+//----------------------------------------------------------------------
+//EOF
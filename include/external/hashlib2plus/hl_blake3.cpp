@@ -0,0 +1,712 @@
+/*
+ * hashlib++ - a simple hash library for C++
+ *
+ * This file is an addition to hashlib++ and is distributed under
+ * the same license, see hl_hashwrapper.h for the full text.
+ */
+
+//----------------------------------------------------------------------
+
+/**
+ *  @file 	hl_blake3.cpp
+ *  @brief	This file contains the implementation of the BLAKE3 class
+ */
+
+//----------------------------------------------------------------------
+//hashlib++ includes
+#include "hl_blake3.h"
+#include "hl_cpuid.h"
+
+//----------------------------------------------------------------------
+//C includes
+#include <string.h>
+
+//----------------------------------------------------------------------
+//STL includes
+#include <algorithm>
+#include <atomic>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------
+//defines
+
+/*
+ * The lane functions must be inlined into the kernels, so they
+ * are compiled for the instruction set of each kernel
+ */
+#define HL_B3_INLINE inline __attribute__((always_inline))
+
+/*
+ * Domain flags of the compressions
+ */
+#define BLAKE3_CHUNK_START		1
+#define BLAKE3_CHUNK_END		2
+#define BLAKE3_PARENT			4
+#define BLAKE3_ROOT			8
+
+/*
+ * A subtree is only split between two threads when each half has
+ * at least these chunks, so starting a thread costs little next to
+ * hashing them
+ */
+#define BLAKE3_PARALLEL_MIN_CHUNKS	256
+
+//----------------------------------------------------------------------
+//constants
+
+/*
+ * Initialization vector, the one of SHA256
+ */
+static const hl_uint32 BLAKE3_IV[8] = {
+	0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL,
+	0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL
+};
+
+/*
+ * Order of the message words in each round, every round
+ * permuting the order of the one before
+ */
+static const hl_uint8 BLAKE3_SCHEDULE[7][16] = {
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{  2,  6,  3, 10,  7,  0,  4, 13,  1, 11, 12,  5,  9, 14, 15,  8 },
+	{  3,  4, 10, 12, 13,  2,  7, 14,  6,  5,  9,  0, 11, 15,  8,  1 },
+	{ 10,  7, 12,  9, 14,  3, 13, 15,  4,  0, 11,  2,  5,  8,  1,  6 },
+	{ 12, 13,  9, 11, 15, 10, 14,  8,  7,  2,  5,  3,  0,  1,  6,  4 },
+	{  9, 14, 11,  5,  8, 12, 15,  1, 13,  3,  0, 10,  2,  6,  4,  7 },
+	{ 11, 15,  5,  0,  1,  9,  8,  6, 14, 10,  2, 12,  3,  4,  7, 13 }
+};
+
+//----------------------------------------------------------------------
+//compression
+
+/**
+ *  @brief 	Reads a little endian 32 bit word
+ */
+static HL_B3_INLINE hl_uint32 BLAKE3_Load32(const hl_uint8* p)
+{
+	return (hl_uint32) p[0] | ((hl_uint32) p[1] << 8) | ((hl_uint32) p[2] << 16) | ((hl_uint32) p[3] << 24);
+}
+
+/**
+ *  @brief 	Writes a little endian 32 bit word
+ */
+static HL_B3_INLINE void BLAKE3_Store32(hl_uint8* p, hl_uint32 word)
+{
+	p[0] = (hl_uint8) word;
+	p[1] = (hl_uint8) (word >> 8);
+	p[2] = (hl_uint8) (word >> 16);
+	p[3] = (hl_uint8) (word >> 24);
+}
+
+/*
+ * Rotates every word of x right, x must be a plain variable
+ */
+#define BLAKE3_ROTR(x, bits) (((x) >> (bits)) | ((x) << (32 - (bits))))
+
+/**
+ *  @brief 	The mixing function, on single words or on lanes
+ */
+template<class V>
+static HL_B3_INLINE void BLAKE3_G(V v[16], int a, int b, int c, int d, const V& x, const V& y)
+{
+	v[a] = v[a] + v[b] + x;
+	v[d] = v[d] ^ v[a];
+	v[d] = BLAKE3_ROTR(v[d], 16);
+	v[c] = v[c] + v[d];
+	v[b] = v[b] ^ v[c];
+	v[b] = BLAKE3_ROTR(v[b], 12);
+	v[a] = v[a] + v[b] + y;
+	v[d] = v[d] ^ v[a];
+	v[d] = BLAKE3_ROTR(v[d], 8);
+	v[c] = v[c] + v[d];
+	v[b] = v[b] ^ v[c];
+	v[b] = BLAKE3_ROTR(v[b], 7);
+}
+
+/**
+ *  @brief 	The seven rounds of a compression, on single words
+ *  		or on lanes
+ */
+template<class V>
+static HL_B3_INLINE void BLAKE3_Rounds(V v[16], const V m[16])
+{
+	for(int r = 0; r < 7; r++)
+	{
+		const hl_uint8* s = BLAKE3_SCHEDULE[r];
+		BLAKE3_G(v, 0, 4,  8, 12, m[s[ 0]], m[s[ 1]]);
+		BLAKE3_G(v, 1, 5,  9, 13, m[s[ 2]], m[s[ 3]]);
+		BLAKE3_G(v, 2, 6, 10, 14, m[s[ 4]], m[s[ 5]]);
+		BLAKE3_G(v, 3, 7, 11, 15, m[s[ 6]], m[s[ 7]]);
+		BLAKE3_G(v, 0, 5, 10, 15, m[s[ 8]], m[s[ 9]]);
+		BLAKE3_G(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+		BLAKE3_G(v, 2, 7,  8, 13, m[s[12]], m[s[13]]);
+		BLAKE3_G(v, 3, 4,  9, 14, m[s[14]], m[s[15]]);
+	}
+}
+
+/**
+ *  @brief 	Compresses a block, writing the new chaining value
+ *  @param	cv The chaining value of the block
+ *  @param	block The block, BLAKE3_BLOCK_LENGTH bytes
+ *  @param	counter The position of its chunk, 0 for the others
+ *  @param	blockLen The number of bytes of the block used
+ *  @param	flags The domain flags
+ *  @param	out This OUT-Parameter receives the new chaining value,
+ *  		it may be cv itself
+ */
+static void BLAKE3_Compress(const hl_uint32 cv[8], const hl_uint8* block, hl_uint64 counter,
+			    hl_uint32 blockLen, hl_uint32 flags, hl_uint32 out[8])
+{
+	hl_uint32 v[16], m[16];
+
+	for(int i = 0; i < 16; i++)
+	{
+		m[i] = BLAKE3_Load32(block + 4 * i);
+	}
+
+	for(int i = 0; i < 8; i++)
+	{
+		v[i] = cv[i];
+	}
+
+	v[8] = BLAKE3_IV[0];
+	v[9] = BLAKE3_IV[1];
+	v[10] = BLAKE3_IV[2];
+	v[11] = BLAKE3_IV[3];
+	v[12] = (hl_uint32) counter;
+	v[13] = (hl_uint32) (counter >> 32);
+	v[14] = blockLen;
+	v[15] = flags;
+
+	BLAKE3_Rounds(v, m);
+
+	for(int i = 0; i < 8; i++)
+	{
+		out[i] = v[i] ^ v[i + 8];
+	}
+}
+
+/**
+ *  @brief 	Writes the chaining value of the parent of two
+ *  		subtrees, whose chaining values are left and right
+ */
+static void BLAKE3_Parent(const hl_uint8* left, const hl_uint8* right, hl_uint8* out)
+{
+	hl_uint8 block[BLAKE3_BLOCK_LENGTH];
+	hl_uint32 cv[8];
+
+	memcpy(block, left, BLAKE3_DIGEST_LENGTH);
+	memcpy(block + BLAKE3_DIGEST_LENGTH, right, BLAKE3_DIGEST_LENGTH);
+	BLAKE3_Compress(BLAKE3_IV, block, 0, BLAKE3_BLOCK_LENGTH, BLAKE3_PARENT, cv);
+
+	for(int i = 0; i < 8; i++)
+	{
+		BLAKE3_Store32(out + 4 * i, cv[i]);
+	}
+}
+
+//----------------------------------------------------------------------
+//lanes
+
+/**
+ *  @brief 	The vector type holding one 32 bit word per lane
+ */
+template<int N>
+struct BLAKE3_Lanes_Type
+{
+	typedef hl_uint32 V __attribute__((vector_size(N * 4)));
+};
+
+/**
+ *  @brief 	Hashes up to N inputs of the same number of blocks,
+ *  		one per lane, writing the chaining value of each one
+ *
+ *  @param	inputs The inputs to hash
+ *  @param	count The number of inputs, at most N
+ *  @param	blocks The number of blocks of each input
+ *  @param	counter The counter of the first input
+ *  @param	increment True if the counter of each input is the
+ *  		one of the input before plus one, as for chunks
+ *  @param	flags The domain flags of every block
+ *  @param	flagsStart The flags added to the first block
+ *  @param	flagsEnd The flags added to the last block
+ *  @param	out This OUT-Parameter receives the chaining values,
+ *  		one after the other
+ */
+template<int N>
+static HL_B3_INLINE void BLAKE3_Hash_Lanes(const hl_uint8* const* inputs, size_t count, size_t blocks,
+					   hl_uint64 counter, bool increment, hl_uint32 flags,
+					   hl_uint32 flagsStart, hl_uint32 flagsEnd, hl_uint8* out)
+{
+	typedef typename BLAKE3_Lanes_Type<N>::V V;
+
+	const V zero = { 0 };
+	const hl_uint8* data[N];
+	V h[8], v[16], m[16], low, high;
+
+	for(int l = 0; l < N; l++)
+	{
+		const hl_uint64 position = counter + (increment ? l : 0);
+
+		/*
+		 * the lanes without an input hash the first one again
+		 */
+		data[l] = (size_t) l < count ? inputs[l] : inputs[0];
+		low[l] = (hl_uint32) position;
+		high[l] = (hl_uint32) (position >> 32);
+	}
+
+	for(int i = 0; i < 8; i++)
+	{
+		h[i] = zero + BLAKE3_IV[i];
+	}
+
+	for(size_t b = 0; b < blocks; b++)
+	{
+		for(int w = 0; w < 16; w++)
+		{
+			for(int l = 0; l < N; l++)
+			{
+				m[w][l] = BLAKE3_Load32(data[l] + b * BLAKE3_BLOCK_LENGTH + w * 4);
+			}
+		}
+
+		hl_uint32 blockFlags = flags;
+		if(b == 0)
+			blockFlags |= flagsStart;
+		if(b + 1 == blocks)
+			blockFlags |= flagsEnd;
+
+		for(int i = 0; i < 8; i++)
+		{
+			v[i] = h[i];
+		}
+
+		v[8] = zero + BLAKE3_IV[0];
+		v[9] = zero + BLAKE3_IV[1];
+		v[10] = zero + BLAKE3_IV[2];
+		v[11] = zero + BLAKE3_IV[3];
+		v[12] = low;
+		v[13] = high;
+		v[14] = zero + BLAKE3_BLOCK_LENGTH;
+		v[15] = zero + blockFlags;
+
+		BLAKE3_Rounds(v, m);
+
+		for(int i = 0; i < 8; i++)
+		{
+			h[i] = v[i] ^ v[i + 8];
+		}
+	}
+
+	for(size_t l = 0; l < count; l++)
+	{
+		for(int i = 0; i < 8; i++)
+		{
+			BLAKE3_Store32(out + l * BLAKE3_DIGEST_LENGTH + 4 * i, h[i][l]);
+		}
+	}
+}
+
+//----------------------------------------------------------------------
+//kernels
+
+typedef void (*BLAKE3_Lanes_Function)(const hl_uint8* const*, size_t, size_t, hl_uint64, bool,
+				      hl_uint32, hl_uint32, hl_uint32, hl_uint8*);
+
+typedef struct BLAKE3_Kernel_Entry
+{
+	const char*		name;
+	unsigned int		lanes;
+	BLAKE3_Lanes_Function	function;
+	bool			(*supported)(void);
+} BLAKE3_Kernel_Entry;
+
+#define HL_B3_KERNEL_FUNCTION(N, ATTRIBUTES) \
+	ATTRIBUTES static void BLAKE3_Lanes##N(const hl_uint8* const* i, size_t c, size_t b, hl_uint64 n, \
+					       bool inc, hl_uint32 f, hl_uint32 fs, hl_uint32 fe, hl_uint8* o) \
+	{ BLAKE3_Hash_Lanes<N>(i, c, b, n, inc, f, fs, fe, o); }
+
+HL_B3_KERNEL_FUNCTION(4, )
+
+/**
+ *  @brief 	Hashes the inputs one at a time, without the lanes
+ */
+static void BLAKE3_Lanes1(const hl_uint8* const* inputs, size_t count, size_t blocks, hl_uint64 counter,
+			  bool increment, hl_uint32 flags, hl_uint32 flagsStart, hl_uint32 flagsEnd,
+			  hl_uint8* out)
+{
+	for(size_t l = 0; l < count; l++)
+	{
+		hl_uint32 cv[8];
+		memcpy(cv, BLAKE3_IV, sizeof(cv));
+
+		for(size_t b = 0; b < blocks; b++)
+		{
+			hl_uint32 blockFlags = flags;
+			if(b == 0)
+				blockFlags |= flagsStart;
+			if(b + 1 == blocks)
+				blockFlags |= flagsEnd;
+
+			BLAKE3_Compress(cv, inputs[l] + b * BLAKE3_BLOCK_LENGTH, counter + (increment ? l : 0),
+					BLAKE3_BLOCK_LENGTH, blockFlags, cv);
+		}
+
+		for(int i = 0; i < 8; i++)
+		{
+			BLAKE3_Store32(out + l * BLAKE3_DIGEST_LENGTH + 4 * i, cv[i]);
+		}
+	}
+}
+
+static bool BLAKE3_Always_Supported(void) { return true; }
+
+#if defined(__x86_64__) || defined(__i386__)
+HL_B3_KERNEL_FUNCTION(8, __attribute__((target("avx2"))))
+HL_B3_KERNEL_FUNCTION(16, __attribute__((target("avx512f,avx512bw"))))
+
+static bool BLAKE3_AVX2_Supported(void) { return hlGetCpuFeatures().avx2; }
+static bool BLAKE3_AVX512_Supported(void) { return hlGetCpuFeatures().avx512; }
+#endif
+
+static const BLAKE3_Kernel_Entry blake3_kernels[] = {
+#if defined(__x86_64__) || defined(__i386__)
+	{ "avx512",   16, BLAKE3_Lanes16, BLAKE3_AVX512_Supported },
+	{ "avx2",      8, BLAKE3_Lanes8,  BLAKE3_AVX2_Supported },
+#endif
+	{ "vector",    4, BLAKE3_Lanes4,  BLAKE3_Always_Supported },
+	{ "portable",  1, BLAKE3_Lanes1,  BLAKE3_Always_Supported }
+};
+
+/**
+ *  @brief 	Returns the kernel with most lanes supported by the cpu
+ */
+static const BLAKE3_Kernel_Entry* BLAKE3_Select_Kernel(void)
+{
+	for(const BLAKE3_Kernel_Entry& kernel : blake3_kernels)
+	{
+		if(kernel.supported())
+		{
+			return &kernel;
+		}
+	}
+	return &blake3_kernels[0];
+}
+
+/*
+ * The kernel in use, chosen once at startup
+ */
+static const BLAKE3_Kernel_Entry* blake3_kernel = BLAKE3_Select_Kernel();
+
+/*
+ * The number of threads an update can use
+ */
+static std::atomic<unsigned int> blake3_threads(1);
+
+/**
+ *  @brief 	Hashes the inputs with the kernel in use, as many at
+ *  		once as it has lanes. The arguments are the ones of
+ *  		BLAKE3_Hash_Lanes(), but for any number of inputs.
+ */
+static void BLAKE3_Hash_Many(const hl_uint8* const* inputs, size_t count, size_t blocks, hl_uint64 counter,
+			     bool increment, hl_uint32 flags, hl_uint32 flagsStart, hl_uint32 flagsEnd,
+			     hl_uint8* out)
+{
+	const BLAKE3_Kernel_Entry* kernel = blake3_kernel;
+
+	for(size_t first = 0; first < count; first += kernel->lanes)
+	{
+		kernel->function(inputs + first, std::min<size_t>(kernel->lanes, count - first), blocks,
+				 counter + (increment ? first : 0), increment, flags, flagsStart, flagsEnd,
+				 out + first * BLAKE3_DIGEST_LENGTH);
+	}
+}
+
+//----------------------------------------------------------------------
+//subtrees
+
+/**
+ *  @brief 	Writes the chaining value of a complete subtree, which
+ *  		is never the root
+ *
+ *  		The subtree is split in halves, hashed by two threads,
+ *  		while it is big enough and there are threads left.
+ *  		Then the chunks are hashed in groups of lanes, and so
+ *  		is each level of parents above them.
+ *
+ *  @param	input The chunks of the subtree
+ *  @param	chunks The number of chunks, a power of two
+ *  @param	counter The position of the first chunk
+ *  @param	cv This OUT-Parameter receives the chaining value
+ *  @param	threads The threads to use, counting the calling one
+ */
+static void BLAKE3_Subtree(const hl_uint8* input, size_t chunks, hl_uint64 counter,
+			   hl_uint8* cv, unsigned int threads)
+{
+	if(threads > 1 && chunks >= 2 * BLAKE3_PARALLEL_MIN_CHUNKS)
+	{
+		const size_t half = chunks / 2;
+		hl_uint8 children[2 * BLAKE3_DIGEST_LENGTH];
+
+		try
+		{
+			std::thread helper(BLAKE3_Subtree, input, half, counter, children, threads / 2);
+			BLAKE3_Subtree(input + half * BLAKE3_CHUNK_LENGTH, half, counter + half,
+				       children + BLAKE3_DIGEST_LENGTH, threads - threads / 2);
+			helper.join();
+
+			BLAKE3_Parent(children, children + BLAKE3_DIGEST_LENGTH, cv);
+			return;
+		}
+		catch(const std::system_error& error)
+		{
+			/*
+			 * no thread could be started, so the subtree
+			 * is hashed by the calling one alone
+			 */
+		}
+	}
+
+	std::vector<hl_uint8> cvs(chunks * BLAKE3_DIGEST_LENGTH);
+	std::vector<const hl_uint8*> inputs(chunks);
+
+	for(size_t i = 0; i < chunks; i++)
+	{
+		inputs[i] = input + i * BLAKE3_CHUNK_LENGTH;
+	}
+
+	BLAKE3_Hash_Many(inputs.data(), chunks, BLAKE3_CHUNK_LENGTH / BLAKE3_BLOCK_LENGTH, counter, true, 0,
+			 BLAKE3_CHUNK_START, BLAKE3_CHUNK_END, cvs.data());
+
+	/*
+	 * every level is written over the start of the one below it,
+	 * each parent being the pair of chaining values at its input
+	 */
+	for(size_t count = chunks; count > 1; count /= 2)
+	{
+		for(size_t i = 0; i < count / 2; i++)
+		{
+			inputs[i] = cvs.data() + 2 * i * BLAKE3_DIGEST_LENGTH;
+		}
+
+		BLAKE3_Hash_Many(inputs.data(), count / 2, 1, 0, false, BLAKE3_PARENT, 0, 0, cvs.data());
+	}
+
+	memcpy(cv, cvs.data(), BLAKE3_DIGEST_LENGTH);
+}
+
+//----------------------------------------------------------------------
+//private member functions
+
+/**
+ *  @brief 	Adds the chaining value of a complete subtree
+ *  		to the stack, merging it with the ones it
+ *  		completes a bigger subtree with
+ *  @param	context The context to use
+ *  @param	cv The chaining value of the subtree
+ *  @param	chunks The number of chunks hashed, counting
+ *  		the ones of the subtree
+ *  @param	level The height of the subtree, which has
+ *  		2^level chunks
+ */
+void BLAKE3::BLAKE3_Push(HL_BLAKE3_CTX* context, hl_uint8 cv[BLAKE3_DIGEST_LENGTH],
+			 hl_uint64 chunks, unsigned int level)
+{
+	/*
+	 * the stack holds a subtree for each bit set in the number
+	 * of chunks, so a carry merges the two subtrees of its bit
+	 */
+	for(hl_uint64 total = chunks >> level; (total & 1) == 0; total >>= 1)
+	{
+		context->stackLen--;
+		BLAKE3_Parent(context->stack[context->stackLen], cv, cv);
+	}
+
+	memcpy(context->stack[context->stackLen], cv, BLAKE3_DIGEST_LENGTH);
+	context->stackLen++;
+}
+
+//----------------------------------------------------------------------
+//public member functions
+
+/**
+ *  @brief 	Initialize the context
+ *  @param	context The context to init.
+ */
+void BLAKE3::BLAKE3_Init(HL_BLAKE3_CTX* context)
+{
+	memcpy(context->cv, BLAKE3_IV, sizeof(context->cv));
+	context->chunkCounter = 0;
+	context->blockLen = 0;
+	context->blocksCompressed = 0;
+	context->stackLen = 0;
+}
+
+/**
+ *  @brief	Updates the context
+ *  @param	context The context to update.
+ *  @param	data The data for updating the context.
+ *  @param	len The length of the given data.
+ */
+void BLAKE3::BLAKE3_Update(HL_BLAKE3_CTX* context, const hl_uint8* data, size_t len)
+{
+	while(len > 0)
+	{
+		/*
+		 * a full chunk is only finished once more data comes,
+		 * since the last one is finished differently
+		 */
+		if(context->blocksCompressed * BLAKE3_BLOCK_LENGTH + context->blockLen == BLAKE3_CHUNK_LENGTH)
+		{
+			hl_uint8 cv[BLAKE3_DIGEST_LENGTH];
+			BLAKE3_Compress(context->cv, context->block, context->chunkCounter, BLAKE3_BLOCK_LENGTH,
+					BLAKE3_CHUNK_END, context->cv);
+
+			for(int i = 0; i < 8; i++)
+			{
+				BLAKE3_Store32(cv + 4 * i, context->cv[i]);
+			}
+
+			context->chunkCounter++;
+			BLAKE3_Push(context, cv, context->chunkCounter, 0);
+
+			memcpy(context->cv, BLAKE3_IV, sizeof(context->cv));
+			context->blockLen = 0;
+			context->blocksCompressed = 0;
+		}
+
+		/*
+		 * between chunks, the biggest subtree that starts here
+		 * and is followed by more data is hashed at once
+		 */
+		if(context->blocksCompressed == 0 && context->blockLen == 0 && len > BLAKE3_CHUNK_LENGTH)
+		{
+			hl_uint64 chunks = 1;
+			unsigned int level = 0;
+
+			while(2 * chunks <= (len - 1) / BLAKE3_CHUNK_LENGTH
+			      && (context->chunkCounter & (2 * chunks - 1)) == 0)
+			{
+				chunks *= 2;
+				level++;
+			}
+
+			hl_uint8 cv[BLAKE3_DIGEST_LENGTH];
+			BLAKE3_Subtree(data, chunks, context->chunkCounter, cv, blake3_threads);
+
+			context->chunkCounter += chunks;
+			BLAKE3_Push(context, cv, context->chunkCounter, level);
+
+			data += chunks * BLAKE3_CHUNK_LENGTH;
+			len -= chunks * BLAKE3_CHUNK_LENGTH;
+			continue;
+		}
+
+		/*
+		 * a full block is only compressed once more data comes,
+		 * since the last one of the chunk is compressed differently
+		 */
+		if(context->blockLen == BLAKE3_BLOCK_LENGTH)
+		{
+			BLAKE3_Compress(context->cv, context->block, context->chunkCounter, BLAKE3_BLOCK_LENGTH,
+					context->blocksCompressed == 0 ? BLAKE3_CHUNK_START : 0, context->cv);
+			context->blocksCompressed++;
+			context->blockLen = 0;
+		}
+
+		const size_t fill = std::min(BLAKE3_BLOCK_LENGTH - context->blockLen, len);
+		memcpy(context->block + context->blockLen, data, fill);
+		context->blockLen += fill;
+		data += fill;
+		len -= fill;
+	}
+}
+
+/**
+ *  @brief 	Finalize the BLAKE3 operation
+ *  @param	digest This OUT-Parameter receives the digest
+ *  @param	context The context to finalize.
+ */
+void BLAKE3::BLAKE3_Final(hl_uint8 digest[BLAKE3_DIGEST_LENGTH], HL_BLAKE3_CTX* context)
+{
+	/*
+	 * the last node is the last block of the chunk being hashed,
+	 * or the parent of the subtrees of the stack above it
+	 */
+	hl_uint32 cv[8];
+	hl_uint8 block[BLAKE3_BLOCK_LENGTH];
+	hl_uint32 blockLen = (hl_uint32) context->blockLen;
+	hl_uint32 flags = BLAKE3_CHUNK_END | (context->blocksCompressed == 0 ? BLAKE3_CHUNK_START : 0);
+	hl_uint64 counter = context->chunkCounter;
+
+	memcpy(cv, context->cv, sizeof(cv));
+	memset(block, 0, sizeof(block));
+	memcpy(block, context->block, context->blockLen);
+
+	for(size_t i = context->stackLen; i > 0; i--)
+	{
+		hl_uint32 child[8];
+		BLAKE3_Compress(cv, block, counter, blockLen, flags, child);
+
+		memcpy(block, context->stack[i - 1], BLAKE3_DIGEST_LENGTH);
+		for(int w = 0; w < 8; w++)
+		{
+			BLAKE3_Store32(block + BLAKE3_DIGEST_LENGTH + 4 * w, child[w]);
+		}
+
+		memcpy(cv, BLAKE3_IV, sizeof(cv));
+		blockLen = BLAKE3_BLOCK_LENGTH;
+		flags = BLAKE3_PARENT;
+		counter = 0;
+	}
+
+	BLAKE3_Compress(cv, block, 0, blockLen, flags | BLAKE3_ROOT, cv);
+
+	for(int i = 0; i < 8; i++)
+	{
+		BLAKE3_Store32(digest + 4 * i, cv[i]);
+	}
+}
+
+/**
+ *  @brief 	Returns the name of the kernel in use
+ */
+const char* BLAKE3::BLAKE3_Kernel(void)
+{
+	return blake3_kernel->name;
+}
+
+/**
+ *  @brief 	Changes the kernel in use
+ *  @param	name The name of the kernel to use
+ *  @return	false if there is no such kernel or the cpu
+ *  		doesn't support it
+ */
+bool BLAKE3::BLAKE3_Use_Kernel(const char* name)
+{
+	for(const BLAKE3_Kernel_Entry& kernel : blake3_kernels)
+	{
+		if(strcmp(name, kernel.name) == 0 && kernel.supported())
+		{
+			blake3_kernel = &kernel;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ *  @brief 	Sets the number of threads a single update
+ *  		can use, counting the calling one
+ *  @param	threads The number of threads, at least 1
+ */
+void BLAKE3::BLAKE3_Set_Threads(unsigned int threads)
+{
+	blake3_threads = std::max(1u, threads);
+}
+
+//----------------------------------------------------------------------
+//EOF
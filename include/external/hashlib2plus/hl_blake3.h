@@ -0,0 +1,181 @@
+/*
+ * hashlib++ - a simple hash library for C++
+ *
+ * This file is an addition to hashlib++ and is distributed under
+ * the same license, see hl_hashwrapper.h for the full text.
+ */
+
+//----------------------------------------------------------------------
+
+/**
+ *  @file 	hl_blake3.h
+ *  @brief	This file contains the declaration of the BLAKE3 class
+ */
+
+//----------------------------------------------------------------------
+//include protection
+#ifndef BLAKE3_H
+#define BLAKE3_H
+
+//----------------------------------------------------------------------
+//length defines
+#define BLAKE3_BLOCK_LENGTH		64
+#define BLAKE3_CHUNK_LENGTH		1024
+#define BLAKE3_DIGEST_LENGTH		32
+
+/*
+ * Depth of the stack of subtrees, enough for 2^64 bytes
+ */
+#define BLAKE3_MAX_DEPTH		54
+
+//----------------------------------------------------------------------
+//hashlib++ includes
+#include "hl_types.h"
+
+//----------------------------------------------------------------------
+//C includes
+#include <stddef.h>
+
+//----------------------------------------------------------------------
+
+/**
+ * @brief This struct represents a BLAKE3-hash context
+ */
+typedef struct HL_BLAKE3_CTX
+{
+	/**
+	 * chaining value of the chunk being hashed
+	 */
+	hl_uint32	cv[8];
+
+	/**
+	 * position of the chunk being hashed
+	 */
+	hl_uint64	chunkCounter;
+
+	/**
+	 * block buffer of the chunk, holding the last block
+	 * until it is known whether it ends the chunk
+	 */
+	hl_uint8	block[BLAKE3_BLOCK_LENGTH];
+
+	/**
+	 * number of bytes in the block buffer
+	 */
+	size_t		blockLen;
+
+	/**
+	 * number of blocks of the chunk compressed
+	 */
+	size_t		blocksCompressed;
+
+	/**
+	 * chaining values of the complete subtrees not merged
+	 * yet, from the biggest to the smallest
+	 */
+	hl_uint8	stack[BLAKE3_MAX_DEPTH][BLAKE3_DIGEST_LENGTH];
+
+	/**
+	 * number of chaining values in the stack
+	 */
+	size_t		stackLen;
+} HL_BLAKE3_CTX;
+
+//----------------------------------------------------------------------
+
+/**
+ *  @brief 	This class represents the implementation of
+ *   		the BLAKE3 algorithm, unkeyed and with the digest
+ *   		of 32 bytes of b3sum.
+ *
+ *   		The chunks of the long updates are hashed several
+ *   		at once, one per lane of the vector registers: 16
+ *   		with AVX-512, 8 with AVX2 and 4 otherwise. Their
+ *   		subtrees are split between threads once they are
+ *   		big enough to pay for them, when
+ *   		BLAKE3_Set_Threads() allows for more than one.
+ *
+ *   		Basically the class provides three public member-functions
+ *   		to create a hash: BLAKE3_Init(), BLAKE3_Update() and
+ *   		BLAKE3_Final(). If you want to create a hash based on a
+ *   		string or file quickly you should use the blake3wrapper
+ *   		class instead of BLAKE3.
+ */
+class BLAKE3
+{
+	private:
+
+		/**
+		 *  @brief 	Adds the chaining value of a complete subtree
+		 *  		to the stack, merging it with the ones it
+		 *  		completes a bigger subtree with
+		 *  @param	context The context to use
+		 *  @param	cv The chaining value of the subtree
+		 *  @param	chunks The number of chunks hashed, counting
+		 *  		the ones of the subtree
+		 *  @param	level The height of the subtree, which has
+		 *  		2^level chunks
+		 */
+		void BLAKE3_Push(HL_BLAKE3_CTX* context,
+				 hl_uint8 cv[BLAKE3_DIGEST_LENGTH],
+				 hl_uint64 chunks,
+				 unsigned int level);
+
+	public:
+
+		/**
+		 *  @brief 	Initialize the context
+		 *  @param	context The context to init.
+		 */
+		void BLAKE3_Init(HL_BLAKE3_CTX* context);
+
+		/**
+		 *  @brief	Updates the context
+		 *  @param	context The context to update.
+		 *  @param	data The data for updating the context.
+		 *  @param	len The length of the given data.
+		 */
+		void BLAKE3_Update(HL_BLAKE3_CTX* context,
+				   const hl_uint8* data,
+				   size_t len);
+
+		/**
+		 *  @brief 	Finalize the BLAKE3 operation
+		 *  @param	digest This OUT-Parameter receives the digest
+		 *  @param	context The context to finalize.
+		 */
+		void BLAKE3_Final(hl_uint8 digest[BLAKE3_DIGEST_LENGTH],
+				  HL_BLAKE3_CTX* context);
+
+		/**
+		 *  @brief 	Returns the name of the kernel in use:
+		 *  		"avx512", "avx2", "vector" or "portable".
+		 *  		The one with most lanes supported by the
+		 *  		cpu is chosen at startup.
+		 */
+		static const char* BLAKE3_Kernel(void);
+
+		/**
+		 *  @brief 	Changes the kernel in use
+		 *  @param	name The name of the kernel to use
+		 *  @return	false if there is no such kernel or the cpu
+		 *  		doesn't support it
+		 */
+		static bool BLAKE3_Use_Kernel(const char* name);
+
+		/**
+		 *  @brief 	Sets the number of threads a single update
+		 *  		can use, counting the calling one. It starts
+		 *  		as 1, so that the updates of the files hashed
+		 *  		in parallel don't start threads of their own.
+		 *  @param	threads The number of threads, at least 1
+		 */
+		static void BLAKE3_Set_Threads(unsigned int threads);
+};
+
+//----------------------------------------------------------------------
+//end of include protection
+#endif
+
+//----------------------------------------------------------------------
+//EOF
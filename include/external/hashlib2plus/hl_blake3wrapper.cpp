@@ -0,0 +1,127 @@
+/*
+ * hashlib++ - a simple hash library for C++
+ *
+ * This file is an addition to hashlib++ and is distributed under
+ * the same license, see hl_hashwrapper.h for the full text.
+ */
+
+//----------------------------------------------------------------------
+
+/**
+ *  @file 	hl_blake3wrapper.cpp
+ *  @brief	This file contains the implementation of the blake3wrapper
+ *  		class.
+ */
+
+//----------------------------------------------------------------------
+//hashlib++ includes
+#include "hl_blake3wrapper.h"
+#include "hl_blake3.h"
+
+//----------------------------------------------------------------------
+//STL includes
+#include <sstream>
+#include <string>
+
+//----------------------------------------------------------------------
+//private memberfunctions
+
+/**
+ *  @brief 	This method ends the hash process
+ *  		and returns the hash as string.
+ *
+ *  @return 	a hash as std::string
+ */
+std::string blake3wrapper::hashIt(void)
+{
+	hl_uint8 buff[BLAKE3_DIGEST_LENGTH];
+	blake3->BLAKE3_Final(buff,&context);
+
+	return convToString(buff);
+}
+
+/**
+ *  @brief 	This method ends the hash process
+ *  		and writes the digest as bytes.
+ *
+ *  @param 	digest Receives the digest
+ *  @return 	the length of the digest
+ */
+unsigned int blake3wrapper::digestIt(unsigned char *digest)
+{
+	blake3->BLAKE3_Final(digest,&context);
+	return BLAKE3_DIGEST_LENGTH;
+}
+
+/**
+ *  @brief 	This internal member-function
+ *  		convertes the hash-data to a
+ *  		std::string (HEX).
+ *
+ *  @param 	data The hash-data to covert into HEX
+ *  @return	the converted data as std::string
+ */
+std::string blake3wrapper::convToString(unsigned char *data)
+{
+	std::ostringstream os;
+	for(int i=0; i<BLAKE3_DIGEST_LENGTH; ++i)
+	{
+		os.width(2);
+		os.fill('0');
+		os << std::hex << static_cast<unsigned int>(data[i]);
+	}
+	return os.str();
+}
+
+/**
+ *  @brief 	This method adds the given data to the
+ *  		current hash context
+ *
+ *  @param 	data The data to add to the current context
+ *  @param 	len The length of the data to add
+ */
+void blake3wrapper::updateContext(unsigned char *data, unsigned int len)
+{
+	this->blake3->BLAKE3_Update(&context,data,len);
+}
+
+/**
+ *  @brief 	This method resets the current hash context.
+ *  		In other words: It starts a new hash process.
+ */
+void blake3wrapper::resetContext(void)
+{
+	blake3->BLAKE3_Init(&context);
+}
+
+/**
+ * @brief 	This method should return the hash of the
+ * 		test-string "The quick brown fox jumps over the lazy
+ * 		dog"
+ */
+std::string blake3wrapper::getTestHash(void)
+{
+	return "2f1514181aadccd913abd94cfa592701a5686ab23f8df1dff1b74710febc6d4a";
+}
+
+//----------------------------------------------------------------------
+//public memberfunctions
+
+/**
+ *  @brief 	default constructor
+ */
+blake3wrapper::blake3wrapper()
+{
+	this->blake3 = new BLAKE3();
+}
+
+/**
+ *  @brief 	default destructor
+ */
+blake3wrapper::~blake3wrapper()
+{
+	delete blake3;
+}
+
+//----------------------------------------------------------------------
+//EOF
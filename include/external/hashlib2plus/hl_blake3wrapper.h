@@ -0,0 +1,126 @@
+/*
+ * hashlib++ - a simple hash library for C++
+ *
+ * This file is an addition to hashlib++ and is distributed under
+ * the same license, see hl_hashwrapper.h for the full text.
+ */
+
+//----------------------------------------------------------------------
+
+/**
+ *  @file 	hl_blake3wrapper.h
+ *  @brief	This file contains the definition of the blake3wrapper
+ *  		class.
+ */
+
+//----------------------------------------------------------------------
+//include protection
+#ifndef BLAKE3WRAPPER_H
+#define BLAKE3WRAPPER_H
+
+//----------------------------------------------------------------------
+//hashlib++ includes
+#include "hl_hashwrapper.h"
+#include "hl_blake3.h"
+
+//----------------------------------------------------------------------
+//STL
+#include <string>
+
+//----------------------------------------------------------------------
+
+/**
+ *  @brief 	This class represents the BLAKE3 wrapper-class
+ *
+ *  		You can use this class to easily create a BLAKE3 hash.
+ *  		Just create an instance of blake3wrapper and call the
+ *  		inherited memberfunctions getHashFromString()
+ *  		and getHashFromFile() to create a hash based on a
+ *  		string or a file.
+ *
+ *  		blake3wrapper implements resetContext(), updateContext()
+ *  		and hashIt() to create a hash.
+ */
+class blake3wrapper : public hashwrapper
+{
+	private:
+			/**
+			 * BLAKE3 access
+			 */
+			BLAKE3 *blake3;
+
+			/**
+			 * BLAKE3 context
+			 */
+			HL_BLAKE3_CTX context;
+
+			/**
+			 *  @brief 	This method ends the hash process
+			 *  		and returns the hash as string.
+			 *
+			 *  @return 	a hash as std::string
+			 */
+			virtual std::string hashIt(void);
+
+			/**
+			 *  @brief 	This method ends the hash process
+			 *  		and writes the digest as bytes.
+			 *
+			 *  @param 	digest Receives the digest, at least
+			 *  		HL_MAX_DIGEST_LENGTH bytes long
+			 *  @return 	the length of the digest
+			 */
+			virtual unsigned int digestIt(unsigned char *digest);
+
+			/**
+			 *  @brief 	This internal member-function
+			 *  		convertes the hash-data to a
+			 *  		std::string (HEX).
+			 *
+			 *  @param 	data The hash-data to covert into HEX
+			 *  @return	the converted data as std::string
+			 */
+			virtual std::string convToString(unsigned char *data);
+
+			/**
+			 *  @brief 	This method adds the given data to the
+			 *  		current hash context
+			 *
+			 *  @param 	data The data to add to the current context
+			 *  @param 	len The length of the data to add
+			 */
+			virtual void updateContext(unsigned char *data, unsigned int len);
+
+			/**
+			 *  @brief 	This method resets the current hash context.
+			 *  		In other words: It starts a new hash process.
+			 */
+			virtual void resetContext(void);
+
+			/**
+			 * @brief 	This method should return the hash of the
+			 * 		test-string "The quick brown fox jumps over the lazy
+			 * 		dog"
+			 */
+			virtual std::string getTestHash(void);
+
+	public:
+
+			/**
+			 *  @brief 	default constructor
+			 */
+			blake3wrapper();
+
+			/**
+			 *  @brief 	default destructor
+			 */
+			virtual ~blake3wrapper();
+
+};
+
+//----------------------------------------------------------------------
+//end of include protection
+#endif
+
+//----------------------------------------------------------------------
+//EOF
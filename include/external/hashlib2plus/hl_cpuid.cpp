@@ -0,0 +1,113 @@
+/* 
+ * hashlib++ - a simple hash library for C++
+ * 
+ * This file is an addition to hashlib++ and is distributed under
+ * the same license, see hl_hashwrapper.h for the full text.
+ */
+
+//----------------------------------------------------------------------	
+
+/**
+ *  @file 	hl_cpuid.cpp
+ *  @brief	This file contains the detection of the cpu features
+ */  
+
+//----------------------------------------------------------------------	
+//hashlib++ includes
+#include "hl_cpuid.h"
+
+//----------------------------------------------------------------------	
+//C includes
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+//----------------------------------------------------------------------	
+//STL includes
+#include <string>
+
+//----------------------------------------------------------------------	
+
+/**
+ *  @brief 	Queries the cpu and the operating system for the
+ *  		supported features.
+ *
+ *  @return	The detected features
+ */  
+static hlCpuFeatures hlDetectCpuFeatures(void)
+{
+	hlCpuFeatures features = { false, false, false, false, false };
+
+#if defined(__x86_64__) || defined(__i386__)
+	unsigned int eax, ebx, ecx, edx;
+	unsigned long long xcr0 = 0;
+
+	if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+	{
+		return features;
+	}
+
+	features.ssse3 = (ecx & bit_SSSE3) != 0;
+	features.sse41 = (ecx & bit_SSE4_1) != 0;
+
+	/*
+	 * the wide registers can only be used if the
+	 * operating system saves them (OSXSAVE + XCR0)
+	 */
+	if(ecx & bit_OSXSAVE)
+	{
+		unsigned int lo, hi;
+		__asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		xcr0 = ((unsigned long long) hi << 32) | lo;
+	}
+
+	if(__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+	{
+		const bool ymm = (xcr0 & 0x06) == 0x06;
+		const bool zmm = (xcr0 & 0xe6) == 0xe6;
+
+		features.avx2 = ymm && (ebx & bit_AVX2) != 0;
+		features.avx512 = zmm && (ebx & bit_AVX512F) != 0 && (ebx & bit_AVX512BW) != 0;
+		features.sha = features.sse41 && features.ssse3 && (ebx & bit_SHA) != 0;
+	}
+#endif
+
+	return features;
+}
+
+//----------------------------------------------------------------------	
+
+/**
+ *  @brief 	Returns the features of the running cpu. They are
+ *  		detected once, on the first call.
+ *
+ *  @return	The features of the running cpu
+ */  
+const hlCpuFeatures& hlGetCpuFeatures(void)
+{
+	static const hlCpuFeatures features = hlDetectCpuFeatures();
+	return features;
+}
+
+/**
+ *  @brief 	Returns the names of the detected features,
+ *  		separated by spaces
+ *
+ *  @return	The names of the detected features
+ */  
+std::string hlCpuFeaturesString(void)
+{
+	const hlCpuFeatures& features = hlGetCpuFeatures();
+	std::string names;
+
+	if(features.ssse3)  names += " ssse3";
+	if(features.sse41)  names += " sse4.1";
+	if(features.avx2)   names += " avx2";
+	if(features.avx512) names += " avx512";
+	if(features.sha)    names += " sha";
+
+	return names.empty() ? "none" : names.substr(1);
+}
+
+//----------------------------------------------------------------------	
+//EOF
@@ -0,0 +1,71 @@
+/* 
+ * hashlib++ - a simple hash library for C++
+ * 
+ * This file is an addition to hashlib++ and is distributed under
+ * the same license, see hl_hashwrapper.h for the full text.
+ */
+
+//----------------------------------------------------------------------	
+
+/**
+ *  @file 	hl_cpuid.h
+ *  @brief	This file contains the detection of the cpu features
+ *  		used to choose the hash kernels at runtime
+ */  
+
+//----------------------------------------------------------------------	
+//include protection
+#ifndef HL_CPUID_H
+#define HL_CPUID_H
+
+//----------------------------------------------------------------------	
+//STL includes
+#include <string>
+
+//----------------------------------------------------------------------	
+
+/**
+ *  @brief	This struct holds the cpu features that can be used
+ *  		by the hash kernels. Every feature is only reported when
+ *  		the operating system also saves the registers it needs.
+ */  
+typedef struct hlCpuFeatures
+{
+	/** Supplemental SSE3 */
+	bool ssse3;
+
+	/** SSE 4.1 */
+	bool sse41;
+
+	/** Advanced Vector Extensions 2 */
+	bool avx2;
+
+	/** AVX-512 Foundation and Byte/Word instructions */
+	bool avx512;
+
+	/** SHA extensions (SHA-NI) */
+	bool sha;
+} hlCpuFeatures;
+
+/**
+ *  @brief 	Returns the features of the running cpu. They are
+ *  		detected once, on the first call.
+ *
+ *  @return	The features of the running cpu
+ */  
+const hlCpuFeatures& hlGetCpuFeatures(void);
+
+/**
+ *  @brief 	Returns the names of the detected features,
+ *  		separated by spaces
+ *
+ *  @return	The names of the detected features
+ */  
+std::string hlCpuFeaturesString(void);
+
+//----------------------------------------------------------------------	
+//end of include protection
+#endif
+
+//----------------------------------------------------------------------	
+//EOF
@@ -75,6 +75,7 @@
 //----------------------------------------------------------------------	
 //STL includes
 #include <string>
+#include <vector>
 
 //----------------------------------------------------------------------	
 //C includes
@@ -85,6 +86,14 @@
 //hashlib++ includes
 #include "hl_exception.h"
 
+//----------------------------------------------------------------------	
+//definitions
+
+/**
+ * The length in bytes of the longest hash, the one of SHA512
+ */
+#define HL_MAX_DIGEST_LENGTH 64
+
 //----------------------------------------------------------------------	
 
 /**
@@ -121,6 +130,19 @@ class hashwrapper
 		 */  
 		virtual std::string hashIt(void) = 0;
 
+		/**
+		 *  @brief 	This method finalizes the hash process
+		 *  		and writes the hash as bytes
+		 *
+		 *  		This memberfunction is pure virtual and
+		 *  		has to be implemented by the subclass
+		 *
+		 *  @param 	digest Receives the hash, at least
+		 *  		HL_MAX_DIGEST_LENGTH bytes long
+		 *  @return 	the length of the hash in bytes
+		 */  
+		virtual unsigned int digestIt(unsigned char *digest) = 0;
+
 		/**
 		 *  @brief 	This internal member-function
 		 *  		convertes the hash-data to a
@@ -196,6 +218,53 @@ class hashwrapper
 			}
 		}
 
+		/**
+		 *  @brief 	This method starts a new hash process, to
+		 *  		be fed with data read by the caller
+		 *
+		 *  		Together with update() and finish() it lets
+		 *  		the caller decide how the data is read.
+		 */  
+		void start(void)
+		{
+			resetContext();
+		}
+
+		/**
+		 *  @brief 	This method adds the given data to the
+		 *  		current hash process
+		 *
+		 *  @param 	data The data to add to the current context
+		 *  @param 	len The length of the data to add
+		 */  
+		void update(const unsigned char *data, unsigned int len)
+		{
+			updateContext(const_cast<unsigned char*>(data), len);
+		}
+
+		/**
+		 *  @brief 	This method ends the current hash process
+		 *
+		 *  @return 	the created hash as std::string
+		 */  
+		std::string finish(void)
+		{
+			return hashIt();
+		}
+
+		/**
+		 *  @brief 	This method ends the current hash process,
+		 *  		without converting the hash to a string
+		 *
+		 *  @param 	digest Receives the hash, at least
+		 *  		HL_MAX_DIGEST_LENGTH bytes long
+		 *  @return 	the length of the hash in bytes
+		 */  
+		unsigned int finish(unsigned char *digest)
+		{
+			return digestIt(digest);
+		}
+
 		/**
 		 *  @brief 	This method creates a hash based on the
 		 *  		given string
@@ -281,6 +350,70 @@ class hashwrapper
 			fclose(file);
 			return(hashIt());
 		}
+
+		/**
+		 *  @brief 	This method creates several hashes from a given
+		 *  		file, reading it only once
+		 *
+		 *  		Works like getHashFromFile(), but every 1024 byte
+		 *  		block is forwarded to the context of each one of
+		 *  		the given wrappers.
+		 *
+		 *  @param 	filename The file to created the hashes from
+		 *  @param 	wrappers The wrappers used to create the hashes
+		 *
+		 *  @return	The created hashes of the file, in the same
+		 *  		order as the given wrappers
+		 *  @throw	Throws a hlException if the specified file could not
+		 *  		be opened.
+		 */  
+		static std::vector<std::string> getHashesFromFile(std::string filename,
+				const std::vector<hashwrapper*>& wrappers)
+		{
+			FILE *file;
+			int len;
+			unsigned char buffer[1024];
+			std::vector<std::string> hashes;
+
+			/*
+			 * reset the current hash contexts
+			 */
+			for (hashwrapper* wrapper : wrappers)
+			{
+				wrapper->resetContext();
+			}
+
+			/*
+			 * open the specified file
+			 */
+			if((file = fopen(filename.c_str(), "rb")) == NULL)
+			{
+				throw hlException(HL_FILE_READ_ERROR,
+						  "Cannot read file \"" + 
+						  filename + 
+						  "\".");
+			}
+
+			/*
+			 * read the file in 1024b blocks and
+			 * update every context for every block
+			 */
+			while( (len = fread(buffer,1,1024,file)) )
+			{
+				for (hashwrapper* wrapper : wrappers)
+				{
+					wrapper->updateContext(buffer, len);
+				}
+			}
+
+			//close the file and create the hashes
+			fclose(file);
+			for (hashwrapper* wrapper : wrappers)
+			{
+				hashes.push_back(wrapper->hashIt());
+			}
+			return(hashes);
+		}
 }; 
 
 //----------------------------------------------------------------------	
@@ -334,12 +334,15 @@ void MD5::MD5Update (HL_MD5_CTX *context, unsigned char *input, unsigned int inp
 	  /* Compute number of bytes mod 64 */
 	  index = (unsigned int)((context->count[0] >> 3) & 0x3F);
 
-	  /* Update number of bits */
-	  if ( (context->count[0] += ((unsigned long int)inputLen << 3))
-	       < ((unsigned long int)inputLen << 3))
-		context->count[1]++;
-
-	  context->count[1] += ((unsigned long int)inputLen >> 29);
+	  /*
+	   * Update number of bits, kept in two 32 bit words even
+	   * where long is wider, as Encode only writes those
+	   */
+	  context->count[0] += ((unsigned long int)inputLen << 3) & 0xffffffffUL;
+	  context->count[1] += ((unsigned long int)inputLen >> 29)
+	                       + ((context->count[0] >> 16) >> 16);
+	  context->count[0] &= 0xffffffffUL;
+	  context->count[1] &= 0xffffffffUL;
 	  partLen = 64 - index;
 
 	  /*
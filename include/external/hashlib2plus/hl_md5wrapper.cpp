@@ -65,6 +65,19 @@ std::string md5wrapper::hashIt(void)
 	return convToString(buff);	
 }
 
+/**
+ *  @brief 	This method ends the hash process
+ *  		and writes the digest as bytes.
+ *
+ *  @param 	digest Receives the digest
+ *  @return 	the length of the digest
+ */  
+unsigned int md5wrapper::digestIt(unsigned char *digest)
+{
+	md5->MD5Final(digest,&ctx);
+	return 16;
+}
+
 /**
  *  @brief 	This internal member-function
  *  		convertes the hash-data to a
@@ -89,6 +89,16 @@ class md5wrapper : public hashwrapper
 		 */  
 		virtual std::string hashIt(void);
 
+		/**
+		 *  @brief 	This method ends the hash process
+		 *  		and writes the digest as bytes.
+		 *
+		 *  @param 	digest Receives the digest, at least
+		 *  		HL_MAX_DIGEST_LENGTH bytes long
+		 *  @return 	the length of the digest
+		 */  
+		virtual unsigned int digestIt(unsigned char *digest);
+
 		/**
 		 *  @brief 	This internal member-function
 		 *  		convertes the hash-data to a
@@ -0,0 +1,726 @@
+/* 
+ * hashlib++ - a simple hash library for C++
+ * 
+ * This file is an addition to hashlib++ and is distributed under
+ * the same license, see hl_hashwrapper.h for the full text.
+ */
+
+//----------------------------------------------------------------------	
+
+/**
+ *  @file 	hl_multibuffer.cpp
+ *  @brief	This file contains the implementation of the
+ *  		multi-buffer hasher
+ */  
+
+//----------------------------------------------------------------------	
+//hashlib++ includes
+#include "hl_multibuffer.h"
+#include "hl_cpuid.h"
+#include "hl_exception.h"
+#include "hl_sha1.h"
+#include "hl_sha256.h"
+
+//----------------------------------------------------------------------	
+//C includes
+#include <string.h>
+
+//----------------------------------------------------------------------	
+//STL includes
+#include <algorithm>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------	
+//defines
+
+/*
+ * The lane functions must be inlined into the kernels, so they
+ * are compiled for the instruction set of each kernel
+ */
+#define HL_MB_INLINE inline __attribute__((always_inline))
+
+/*
+ * Maximum number of lanes of a kernel
+ */
+#define HL_MB_MAX_LANES 16
+
+/*
+ * Room for each hash, as bytes, when they are converted to strings
+ */
+#define HL_MB_DIGEST_STRIDE 32
+
+//----------------------------------------------------------------------	
+
+/**
+ *  @brief 	The vector types holding one 32 bit word per lane
+ */  
+template<int N>
+struct hlLanes
+{
+	/** unsigned words */
+	typedef hl_uint32 V __attribute__((vector_size(N * 4)));
+
+	/** signed words, used by the lane masks */
+	typedef int S __attribute__((vector_size(N * 4)));
+};
+
+/*
+ * Rotates every word of x left, x must be a plain variable
+ */
+#define HL_MB_ROTL(x, bits) (((x) << (bits)) | ((x) >> (32 - (bits))))
+
+//----------------------------------------------------------------------	
+//MD5
+
+/*
+ * MD5 sine table and shift amounts
+ */
+static const hl_uint32 MB_MD5_T[64] = {
+	0xd76aa478UL, 0xe8c7b756UL, 0x242070dbUL, 0xc1bdceeeUL,
+	0xf57c0fafUL, 0x4787c62aUL, 0xa8304613UL, 0xfd469501UL,
+	0x698098d8UL, 0x8b44f7afUL, 0xffff5bb1UL, 0x895cd7beUL,
+	0x6b901122UL, 0xfd987193UL, 0xa679438eUL, 0x49b40821UL,
+	0xf61e2562UL, 0xc040b340UL, 0x265e5a51UL, 0xe9b6c7aaUL,
+	0xd62f105dUL, 0x02441453UL, 0xd8a1e681UL, 0xe7d3fbc8UL,
+	0x21e1cde6UL, 0xc33707d6UL, 0xf4d50d87UL, 0x455a14edUL,
+	0xa9e3e905UL, 0xfcefa3f8UL, 0x676f02d9UL, 0x8d2a4c8aUL,
+	0xfffa3942UL, 0x8771f681UL, 0x6d9d6122UL, 0xfde5380cUL,
+	0xa4beea44UL, 0x4bdecfa9UL, 0xf6bb4b60UL, 0xbebfbc70UL,
+	0x289b7ec6UL, 0xeaa127faUL, 0xd4ef3085UL, 0x04881d05UL,
+	0xd9d4d039UL, 0xe6db99e5UL, 0x1fa27cf8UL, 0xc4ac5665UL,
+	0xf4292244UL, 0x432aff97UL, 0xab9423a7UL, 0xfc93a039UL,
+	0x655b59c3UL, 0x8f0ccc92UL, 0xffeff47dUL, 0x85845dd1UL,
+	0x6fa87e4fUL, 0xfe2ce6e0UL, 0xa3014314UL, 0x4e0811a1UL,
+	0xf7537e82UL, 0xbd3af235UL, 0x2ad7d2bbUL, 0xeb86d391UL
+};
+
+static const int MB_MD5_S[4][4] = {
+	{ 7, 12, 17, 22 }, { 5, 9, 14, 20 }, { 4, 11, 16, 23 }, { 6, 10, 15, 21 }
+};
+
+/**
+ *  @brief 	MD5 over the lanes
+ */  
+struct hlMD5Lanes
+{
+	static const int words = 4;
+	static const bool bigEndian = false;
+
+	static void init(hl_uint32 state[8])
+	{
+		state[0] = 0x67452301UL;
+		state[1] = 0xefcdab89UL;
+		state[2] = 0x98badcfeUL;
+		state[3] = 0x10325476UL;
+	}
+
+	template<class V>
+	static HL_MB_INLINE void compress(V state[8], const V X[16])
+	{
+		V a = state[0], b = state[1], c = state[2], d = state[3];
+
+		for(int i = 0; i < 64; i++)
+		{
+			V f;
+			int k;
+
+			if(i < 16)
+			{
+				f = d ^ (b & (c ^ d));
+				k = i;
+			}
+			else if(i < 32)
+			{
+				f = c ^ (d & (b ^ c));
+				k = (5 * i + 1) % 16;
+			}
+			else if(i < 48)
+			{
+				f = b ^ c ^ d;
+				k = (3 * i + 5) % 16;
+			}
+			else
+			{
+				f = c ^ (b | ~d);
+				k = (7 * i) % 16;
+			}
+
+			V t = d;
+			V sum = a + f + X[k] + MB_MD5_T[i];
+			d = c;
+			c = b;
+			b = b + HL_MB_ROTL(sum, MB_MD5_S[i / 16][i % 4]);
+			a = t;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+	}
+};
+
+//----------------------------------------------------------------------	
+//SHA1
+
+/**
+ *  @brief 	SHA1 over the lanes
+ */  
+struct hlSHA1Lanes
+{
+	static const int words = 5;
+	static const bool bigEndian = true;
+
+	static void init(hl_uint32 state[8])
+	{
+		state[0] = 0x67452301UL;
+		state[1] = 0xefcdab89UL;
+		state[2] = 0x98badcfeUL;
+		state[3] = 0x10325476UL;
+		state[4] = 0xc3d2e1f0UL;
+	}
+
+	template<class V>
+	static HL_MB_INLINE void compress(V state[8], const V X[16])
+	{
+		V W[16];
+		V a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+
+		for(int t = 0; t < 80; t++)
+		{
+			V f;
+			hl_uint32 k;
+
+			if(t < 16)
+			{
+				W[t] = X[t];
+			}
+			else
+			{
+				V w = W[(t - 3) % 16] ^ W[(t - 8) % 16] ^
+				      W[(t - 14) % 16] ^ W[t % 16];
+				W[t % 16] = HL_MB_ROTL(w, 1);
+			}
+
+			if(t < 20)
+			{
+				f = d ^ (b & (c ^ d));
+				k = 0x5a827999UL;
+			}
+			else if(t < 40)
+			{
+				f = b ^ c ^ d;
+				k = 0x6ed9eba1UL;
+			}
+			else if(t < 60)
+			{
+				f = (b & c) | (d & (b | c));
+				k = 0x8f1bbcdcUL;
+			}
+			else
+			{
+				f = b ^ c ^ d;
+				k = 0xca62c1d6UL;
+			}
+
+			V temp = HL_MB_ROTL(a, 5) + f + e + W[t % 16] + k;
+			e = d;
+			d = c;
+			c = HL_MB_ROTL(b, 30);
+			b = a;
+			a = temp;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+	}
+};
+
+//----------------------------------------------------------------------	
+//SHA256
+
+/*
+ * SHA256 round constants
+ */
+static const hl_uint32 MB_SHA256_K[64] = {
+	0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL,
+	0x3956c25bUL, 0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL,
+	0xd807aa98UL, 0x12835b01UL, 0x243185beUL, 0x550c7dc3UL,
+	0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL, 0xc19bf174UL,
+	0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL,
+	0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL,
+	0x983e5152UL, 0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL,
+	0xc6e00bf3UL, 0xd5a79147UL, 0x06ca6351UL, 0x14292967UL,
+	0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL, 0x53380d13UL,
+	0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
+	0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL,
+	0xd192e819UL, 0xd6990624UL, 0xf40e3585UL, 0x106aa070UL,
+	0x19a4c116UL, 0x1e376c08UL, 0x2748774cUL, 0x34b0bcb5UL,
+	0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL, 0x682e6ff3UL,
+	0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL,
+	0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL
+};
+
+/**
+ *  @brief 	SHA256 over the lanes
+ */  
+struct hlSHA256Lanes
+{
+	static const int words = 8;
+	static const bool bigEndian = true;
+
+	static void init(hl_uint32 state[8])
+	{
+		state[0] = 0x6a09e667UL;
+		state[1] = 0xbb67ae85UL;
+		state[2] = 0x3c6ef372UL;
+		state[3] = 0xa54ff53aUL;
+		state[4] = 0x510e527fUL;
+		state[5] = 0x9b05688cUL;
+		state[6] = 0x1f83d9abUL;
+		state[7] = 0x5be0cd19UL;
+	}
+
+	template<class V>
+	static HL_MB_INLINE void compress(V state[8], const V X[16])
+	{
+		V W[16];
+		V a = state[0], b = state[1], c = state[2], d = state[3];
+		V e = state[4], f = state[5], g = state[6], h = state[7];
+
+		for(int t = 0; t < 64; t++)
+		{
+			if(t < 16)
+			{
+				W[t] = X[t];
+			}
+			else
+			{
+				V w15 = W[(t - 15) % 16];
+				V w2 = W[(t - 2) % 16];
+				V s0 = HL_MB_ROTL(w15, 25) ^ HL_MB_ROTL(w15, 14) ^ (w15 >> 3);
+				V s1 = HL_MB_ROTL(w2, 15) ^ HL_MB_ROTL(w2, 13) ^ (w2 >> 10);
+				W[t % 16] += s0 + W[(t - 7) % 16] + s1;
+			}
+
+			V S1 = HL_MB_ROTL(e, 26) ^ HL_MB_ROTL(e, 21) ^ HL_MB_ROTL(e, 7);
+			V ch = g ^ (e & (f ^ g));
+			V T1 = h + S1 + ch + MB_SHA256_K[t] + W[t % 16];
+			V S0 = HL_MB_ROTL(a, 30) ^ HL_MB_ROTL(a, 19) ^ HL_MB_ROTL(a, 10);
+			V maj = (a & b) | (c & (a | b));
+			V T2 = S0 + maj;
+
+			h = g;
+			g = f;
+			f = e;
+			e = d + T1;
+			d = c;
+			c = b;
+			b = a;
+			a = T1 + T2;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+	}
+};
+
+//----------------------------------------------------------------------	
+//lanes driver
+
+/*
+ * Block used by the lanes without a message
+ */
+static const hl_uint8 mb_zero_block[64] = { 0 };
+
+/**
+ *  @brief 	Reads a 32 bit word in the byte order of the algorithm
+ */  
+template<bool BigEndian>
+static HL_MB_INLINE hl_uint32 hlLoadWord(const hl_uint8* p)
+{
+	hl_uint32 word;
+	memcpy(&word, p, 4);
+	return BigEndian ? __builtin_bswap32(word) : word;
+}
+
+/**
+ *  @brief 	Hashes up to N messages, one per lane
+ *
+ *  		Each lane walks the blocks of its message followed by
+ *  		the padding blocks. The lanes whose message is done
+ *  		keep computing, but their state is left unchanged.
+ *
+ *  @param	messages The messages to hash
+ *  @param	lengths The length of each message
+ *  @param	count The number of messages, at most N
+ *  @param	states This OUT-Parameter receives the final state
+ *  		of each message
+ */  
+template<int N, class Algorithm>
+static HL_MB_INLINE void hlHashLanes(const hl_uint8* const* messages, const size_t* lengths,
+				     size_t count, hl_uint32 states[][8])
+{
+	typedef typename hlLanes<N>::V V;
+	typedef typename hlLanes<N>::S S;
+
+	hl_uint8 tails[N][128];
+	const hl_uint8* data[N];
+	size_t full[N];
+	size_t maxBlocks = 0;
+	S blocks;
+	V state[8], next[8], X[16];
+	hl_uint32 initial[8] = { 0 };
+
+	Algorithm::init(initial);
+
+	for(int l = 0; l < N; l++)
+	{
+		if((size_t) l >= count)
+		{
+			data[l] = mb_zero_block;
+			full[l] = 0;
+			blocks[l] = 0;
+			continue;
+		}
+
+		/*
+		 * the tail holds the last partial block, the padding
+		 * and the message length in bits
+		 */
+		const size_t len = lengths[l];
+		const size_t rest = len % 64;
+		const size_t tail = rest < 56 ? 64 : 128;
+		const hl_uint64 bits = (hl_uint64) len * 8;
+
+		data[l] = messages[l];
+		full[l] = len / 64;
+		blocks[l] = (int) (full[l] + tail / 64);
+		maxBlocks = std::max(maxBlocks, (size_t) blocks[l]);
+
+		memset(tails[l], 0, tail);
+		memcpy(tails[l], messages[l] + full[l] * 64, rest);
+		tails[l][rest] = 0x80;
+
+		for(int i = 0; i < 8; i++)
+		{
+			tails[l][tail - 8 + i] = Algorithm::bigEndian
+				? (hl_uint8) (bits >> (56 - 8 * i))
+				: (hl_uint8) (bits >> (8 * i));
+		}
+	}
+
+	for(int i = 0; i < 8; i++)
+	{
+		for(int l = 0; l < N; l++)
+		{
+			state[i][l] = initial[i];
+		}
+	}
+
+	for(size_t b = 0; b < maxBlocks; b++)
+	{
+		for(int l = 0; l < N; l++)
+		{
+			const hl_uint8* block;
+
+			if(b < full[l])
+				block = data[l] + b * 64;
+			else if((int) b < blocks[l])
+				block = tails[l] + (b - full[l]) * 64;
+			else
+				block = mb_zero_block;
+
+			for(int w = 0; w < 16; w++)
+			{
+				X[w][l] = hlLoadWord<Algorithm::bigEndian>(block + w * 4);
+			}
+		}
+
+		for(int i = 0; i < 8; i++)
+		{
+			next[i] = state[i];
+		}
+
+		Algorithm::compress(next, X);
+
+		/*
+		 * only the lanes with blocks left take the new state
+		 */
+		const V active = (V) (blocks > (int) b);
+		for(int i = 0; i < Algorithm::words; i++)
+		{
+			state[i] = (next[i] & active) | (state[i] & ~active);
+		}
+	}
+
+	for(size_t l = 0; l < count; l++)
+	{
+		for(int i = 0; i < 8; i++)
+		{
+			states[l][i] = state[i][l];
+		}
+	}
+}
+
+//----------------------------------------------------------------------	
+//kernels
+
+typedef void (*hlLanesFunction)(const hl_uint8* const*, const size_t*, size_t, hl_uint32[][8]);
+
+typedef struct hlMultibufferKernel
+{
+	const char*	name;
+	unsigned int	lanes;
+	hlLanesFunction	md5;
+	hlLanesFunction	sha1;
+	hlLanesFunction	sha256;
+	bool		(*supported)(void);
+} hlMultibufferKernel;
+
+#define HL_MB_KERNEL_FUNCTIONS(N, ATTRIBUTES) \
+	ATTRIBUTES static void hlMD5Lanes##N(const hl_uint8* const* m, const size_t* l, size_t c, hl_uint32 s[][8]) \
+	{ hlHashLanes<N, hlMD5Lanes>(m, l, c, s); } \
+	ATTRIBUTES static void hlSHA1Lanes##N(const hl_uint8* const* m, const size_t* l, size_t c, hl_uint32 s[][8]) \
+	{ hlHashLanes<N, hlSHA1Lanes>(m, l, c, s); } \
+	ATTRIBUTES static void hlSHA256Lanes##N(const hl_uint8* const* m, const size_t* l, size_t c, hl_uint32 s[][8]) \
+	{ hlHashLanes<N, hlSHA256Lanes>(m, l, c, s); }
+
+HL_MB_KERNEL_FUNCTIONS(4, )
+
+static bool hlAlwaysSupported(void) { return true; }
+
+#if defined(__x86_64__) || defined(__i386__)
+HL_MB_KERNEL_FUNCTIONS(8, __attribute__((target("avx2"))))
+HL_MB_KERNEL_FUNCTIONS(16, __attribute__((target("avx512f,avx512bw"))))
+
+static bool hlAVX2Supported(void) { return hlGetCpuFeatures().avx2; }
+static bool hlAVX512Supported(void) { return hlGetCpuFeatures().avx512; }
+#endif
+
+static const hlMultibufferKernel mb_kernels[] = {
+#if defined(__x86_64__) || defined(__i386__)
+	{ "avx512", 16, hlMD5Lanes16, hlSHA1Lanes16, hlSHA256Lanes16, hlAVX512Supported },
+	{ "avx2",    8, hlMD5Lanes8,  hlSHA1Lanes8,  hlSHA256Lanes8,  hlAVX2Supported },
+#endif
+	{ "vector",  4, hlMD5Lanes4,  hlSHA1Lanes4,  hlSHA256Lanes4,  hlAlwaysSupported }
+};
+
+/**
+ *  @brief 	Returns the kernel with most lanes supported by the cpu
+ */  
+static const hlMultibufferKernel* hlSelectMultibufferKernel(void)
+{
+	for(const hlMultibufferKernel& kernel : mb_kernels)
+	{
+		if(kernel.supported())
+		{
+			return &kernel;
+		}
+	}
+	return &mb_kernels[0];
+}
+
+/*
+ * The kernel in use, chosen once at startup
+ */
+static const hlMultibufferKernel* mb_kernel = hlSelectMultibufferKernel();
+
+//----------------------------------------------------------------------	
+//public member functions
+
+/**
+ *  @brief 	Returns true if the given hash type can be
+ *  		calculated by the multi-buffer hasher
+ *
+ *  @param	type The hash type
+ */  
+bool multibuffer::supports(HL_Wrappertype type)
+{
+	return type == HL_MD5 || type == HL_SHA1 || type == HL_SHA256;
+}
+
+/**
+ *  @brief 	Returns true if hashing small messages of the
+ *  		given type together is faster than hashing them
+ *  		one by one
+ *
+ *  @param	type The hash type
+ */  
+bool multibuffer::preferred(HL_Wrappertype type)
+{
+	if(!supports(type))
+	{
+		return false;
+	}
+
+	if(mb_kernel->lanes >= 16)
+	{
+		return true;
+	}
+
+	if(type == HL_SHA1)
+	{
+		return strcmp(SHA1::SHA1Kernel(), "sha-ni") != 0;
+	}
+
+	if(type == HL_SHA256)
+	{
+		return strcmp(SHA256::SHA256_Kernel(), "sha-ni") != 0;
+	}
+
+	return true;
+}
+
+/**
+ *  @brief 	Returns the number of messages hashed at once
+ */  
+unsigned int multibuffer::lanes(void)
+{
+	return mb_kernel->lanes;
+}
+
+/**
+ *  @brief 	Returns the name of the kernel in use
+ */  
+const char* multibuffer::kernel(void)
+{
+	return mb_kernel->name;
+}
+
+/**
+ *  @brief 	Selects the kernel with the given name
+ *
+ *  @param	name The name of the kernel
+ *  @return	False if there is no such kernel or the cpu
+ *  		doesn't support it
+ */  
+bool multibuffer::useKernel(const char* name)
+{
+	for(const hlMultibufferKernel& kernel : mb_kernels)
+	{
+		if(strcmp(name, kernel.name) == 0 && kernel.supported())
+		{
+			mb_kernel = &kernel;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ *  @brief 	Hashes the given messages
+ *
+ *  @param	type The hash type, one of the supported ones
+ *  @param	messages The messages to hash
+ *  @param	lengths The length of each message
+ *  @param	count The number of messages
+ *  @param	hashes This OUT-Parameter receives the hash of
+ *  		each message, as hexadecimal std::string
+ */  
+void multibuffer::hash(HL_Wrappertype type,
+		       const hl_uint8* const* messages,
+		       const size_t* lengths,
+		       size_t count,
+		       std::string* hashes)
+{
+	static const char* hex = "0123456789abcdef";
+	std::vector<hl_uint8> digests(count * HL_MB_DIGEST_STRIDE);
+	const size_t length = hash(type, messages, lengths, count, digests.data(), HL_MB_DIGEST_STRIDE);
+
+	for(size_t m = 0; m < count; m++)
+	{
+		const hl_uint8* digest = digests.data() + m * HL_MB_DIGEST_STRIDE;
+		std::string& out = hashes[m];
+		out.resize(length * 2);
+
+		for(size_t i = 0; i < length; i++)
+		{
+			out[i * 2] = hex[digest[i] >> 4];
+			out[i * 2 + 1] = hex[digest[i] & 0x0f];
+		}
+	}
+}
+
+/**
+ *  @brief 	Hashes the given messages, writing the
+ *  		hashes as bytes
+ *
+ *  @param	type The hash type, one of the supported ones
+ *  @param	messages The messages to hash
+ *  @param	lengths The length of each message
+ *  @param	count The number of messages
+ *  @param	digests This OUT-Parameter receives the hash of
+ *  		each message, the one of the message i
+ *  		starting at digests + i * stride
+ *  @param	stride The distance between two hashes
+ *  @return	The length of each hash in bytes
+ */  
+size_t multibuffer::hash(HL_Wrappertype type,
+			 const hl_uint8* const* messages,
+			 const size_t* lengths,
+			 size_t count,
+			 hl_uint8* digests,
+			 size_t stride)
+{
+	hlLanesFunction function;
+	int words;
+	bool bigEndian;
+
+	if(type == HL_MD5)
+	{
+		function = mb_kernel->md5;
+		words = hlMD5Lanes::words;
+		bigEndian = hlMD5Lanes::bigEndian;
+	}
+	else if(type == HL_SHA1)
+	{
+		function = mb_kernel->sha1;
+		words = hlSHA1Lanes::words;
+		bigEndian = hlSHA1Lanes::bigEndian;
+	}
+	else if(type == HL_SHA256)
+	{
+		function = mb_kernel->sha256;
+		words = hlSHA256Lanes::words;
+		bigEndian = hlSHA256Lanes::bigEndian;
+	}
+	else
+	{
+		throw hlException(HL_UNKNOWN_HASH_TYPE,"Unknown hashtype");
+	}
+
+	hl_uint32 states[HL_MB_MAX_LANES][8];
+
+	for(size_t first = 0; first < count; first += mb_kernel->lanes)
+	{
+		const size_t group = std::min<size_t>(mb_kernel->lanes, count - first);
+		function(messages + first, lengths + first, group, states);
+
+		for(size_t l = 0; l < group; l++)
+		{
+			hl_uint8* out = digests + (first + l) * stride;
+
+			for(int i = 0; i < words * 4; i++)
+			{
+				const int shift = bigEndian ? 24 - 8 * (i % 4) : 8 * (i % 4);
+				out[i] = (hl_uint8) (states[l][i / 4] >> shift);
+			}
+		}
+	}
+
+	return words * 4;
+}
+
+//----------------------------------------------------------------------	
+//EOF
@@ -0,0 +1,138 @@
+/* 
+ * hashlib++ - a simple hash library for C++
+ * 
+ * This file is an addition to hashlib++ and is distributed under
+ * the same license, see hl_hashwrapper.h for the full text.
+ */
+
+//----------------------------------------------------------------------	
+
+/**
+ *  @file 	hl_multibuffer.h
+ *  @brief	This file contains the multi-buffer hasher, which hashes
+ *  		several independent messages at once
+ */  
+
+//----------------------------------------------------------------------	
+//include protection
+#ifndef HL_MULTIBUFFER_H
+#define HL_MULTIBUFFER_H
+
+//----------------------------------------------------------------------	
+//hashlib++ includes
+#include "hl_types.h"
+#include "hl_wrapperfactory.h"
+
+//----------------------------------------------------------------------	
+//STL includes
+#include <cstddef>
+#include <string>
+
+//----------------------------------------------------------------------	
+
+/**
+ *  @brief 	This class hashes several independent messages at once,
+ *  		one message per lane of the vector registers.
+ *
+ *  		It pays off for many small messages, where the
+ *  		serial compression of each one would dominate. The
+ *  		number of lanes depends on the cpu: 16 with AVX-512,
+ *  		8 with AVX2 and 4 otherwise. MD5, SHA1 and SHA256 are
+ *  		supported.
+ */  
+class multibuffer
+{
+	public:
+
+		/**
+		 *  @brief 	Returns true if the given hash type can be
+		 *  		calculated by the multi-buffer hasher
+		 *
+		 *  @param	type The hash type
+		 */  
+		static bool supports(HL_Wrappertype type);
+
+		/**
+		 *  @brief 	Returns true if hashing small messages of the
+		 *  		given type together is faster than hashing them
+		 *  		one by one, which is not the case when the one
+		 *  		by one hasher uses the SHA extensions and the
+		 *  		kernel in use has less than 16 lanes
+		 *
+		 *  @param	type The hash type
+		 */  
+		static bool preferred(HL_Wrappertype type);
+
+		/**
+		 *  @brief 	Returns the number of messages hashed at once
+		 */  
+		static unsigned int lanes(void);
+
+		/**
+		 *  @brief 	Returns the name of the kernel in use:
+		 *  		"avx512", "avx2" or "vector"
+		 */  
+		static const char* kernel(void);
+
+		/**
+		 *  @brief 	Selects the kernel with the given name,
+		 *  		mostly useful for testing
+		 *
+		 *  @param	name The name of the kernel
+		 *  @return	False if there is no such kernel or the cpu
+		 *  		doesn't support it
+		 */  
+		static bool useKernel(const char* name);
+
+		/**
+		 *  @brief 	Hashes the given messages
+		 *
+		 *  		Messages of similar lengths should be hashed
+		 *  		together, since every lane of a group is busy
+		 *  		until the longest message is done.
+		 *
+		 *  @param	type The hash type, one of the supported ones
+		 *  @param	messages The messages to hash
+		 *  @param	lengths The length of each message
+		 *  @param	count The number of messages
+		 *  @param	hashes This OUT-Parameter receives the hash of
+		 *  		each message, as hexadecimal std::string
+		 *  @throw	Throws a hlException if the hash type is not
+		 *  		supported
+		 */  
+		static void hash(HL_Wrappertype type,
+				 const hl_uint8* const* messages,
+				 const size_t* lengths,
+				 size_t count,
+				 std::string* hashes);
+
+		/**
+		 *  @brief 	Hashes the given messages, writing the
+		 *  		hashes as bytes
+		 *
+		 *  @param	type The hash type, one of the supported ones
+		 *  @param	messages The messages to hash
+		 *  @param	lengths The length of each message
+		 *  @param	count The number of messages
+		 *  @param	digests This OUT-Parameter receives the hash of
+		 *  		each message, the one of the message i
+		 *  		starting at digests + i * stride
+		 *  @param	stride The distance between two hashes
+		 *  @return	The length of each hash in bytes
+		 *  @throw	Throws a hlException if the hash type is not
+		 *  		supported
+		 */  
+		static size_t hash(HL_Wrappertype type,
+				   const hl_uint8* const* messages,
+				   const size_t* lengths,
+				   size_t count,
+				   hl_uint8* digests,
+				   size_t stride);
+};
+
+//----------------------------------------------------------------------	
+//end of include protection
+#endif
+
+//----------------------------------------------------------------------	
+//EOF
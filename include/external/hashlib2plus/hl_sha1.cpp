@@ -70,6 +70,15 @@
 //---------------------------------------------------------------------- 
 //hashlib++ includes
 #include "hl_sha1.h"
+#include "hl_cpuid.h"
+
+//---------------------------------------------------------------------- 
+//C includes
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 
 //---------------------------------------------------------------------- 
@@ -150,16 +159,18 @@ void SHA1::SHA1PadMessage(HL_SHA1_CTX *context)
 }
 
 /**
- *  @brief      This member-function will process the next 512 bits of the
- *  		message stored in the Message_Block array.
+ *  @brief      Portable data transformation, processes the next 512 bits
+ *  		of the message for each block.
  *
  *      	Many of the variable names in this code, especially the
  *      	single character names, were used because those were the
  *      	names used in the publication.
  *
- *  @param	context The context to process
+ *  @param	state The intermediate hash value to update
+ *  @param	block The data to transform
+ *  @param	blocks The number of 64 byte blocks to transform
  */  
-void SHA1::SHA1ProcessMessageBlock(HL_SHA1_CTX *context)
+static void SHA1_Transform_Portable(hl_uint32 state[5], const hl_uint8 *block, size_t blocks)
 {
 	const hl_uint32 K[] =    {       /* Constants defined in SHA-1   */
 		0x5A827999,
@@ -172,76 +183,221 @@ void SHA1::SHA1ProcessMessageBlock(HL_SHA1_CTX *context)
 	hl_uint32      W[80];             /* Word sequence               */
 	hl_uint32      A, B, C, D, E;     /* Word buffers                */
 
-	/*
-	 *  Initialize the first 16 words in the array W
-	 */
-	for(t = 0; t < 16; t++)
+	for(; blocks > 0; blocks--, block += 64)
 	{
-		W[t] = context->Message_Block[t * 4] << 24;
-		W[t] |= context->Message_Block[t * 4 + 1] << 16;
-		W[t] |= context->Message_Block[t * 4 + 2] << 8;
-		W[t] |= context->Message_Block[t * 4 + 3];
-	}
+		/*
+		 *  Initialize the first 16 words in the array W
+		 */
+		for(t = 0; t < 16; t++)
+		{
+			W[t] = block[t * 4] << 24;
+			W[t] |= block[t * 4 + 1] << 16;
+			W[t] |= block[t * 4 + 2] << 8;
+			W[t] |= block[t * 4 + 3];
+		}
 
-	for(t = 16; t < 80; t++)
-	{
-		W[t] = SHA1CircularShift(1,W[t-3] ^ W[t-8] ^ W[t-14] ^ W[t-16]);
-	}
+		for(t = 16; t < 80; t++)
+		{
+			W[t] = SHA1CircularShift(1,W[t-3] ^ W[t-8] ^ W[t-14] ^ W[t-16]);
+		}
 
-	A = context->Intermediate_Hash[0];
-	B = context->Intermediate_Hash[1];
-	C = context->Intermediate_Hash[2];
-	D = context->Intermediate_Hash[3];
-	E = context->Intermediate_Hash[4];
+		A = state[0];
+		B = state[1];
+		C = state[2];
+		D = state[3];
+		E = state[4];
 
-	for(t = 0; t < 20; t++)
-	{
-		temp =  SHA1CircularShift(5,A) +
-			((B & C) | ((~B) & D)) + E + W[t] + K[0];
-		E = D;
-		D = C;
-		C = SHA1CircularShift(30,B);
-		B = A;
-		A = temp;
-	}
+		for(t = 0; t < 20; t++)
+		{
+			temp =  SHA1CircularShift(5,A) +
+				((B & C) | ((~B) & D)) + E + W[t] + K[0];
+			E = D;
+			D = C;
+			C = SHA1CircularShift(30,B);
+			B = A;
+			A = temp;
+		}
 
-	for(t = 20; t < 40; t++)
-	{
-		temp = SHA1CircularShift(5,A) + (B ^ C ^ D) + E + W[t] + K[1];
-		E = D;
-		D = C;
-		C = SHA1CircularShift(30,B);
-		B = A;
-		A = temp;
+		for(t = 20; t < 40; t++)
+		{
+			temp = SHA1CircularShift(5,A) + (B ^ C ^ D) + E + W[t] + K[1];
+			E = D;
+			D = C;
+			C = SHA1CircularShift(30,B);
+			B = A;
+			A = temp;
+		}
+
+		for(t = 40; t < 60; t++)
+		{
+			temp = SHA1CircularShift(5,A) +
+				((B & C) | (B & D) | (C & D)) + E + W[t] + K[2];
+			E = D;
+			D = C;
+			C = SHA1CircularShift(30,B);
+			B = A;
+			A = temp;
+		}
+
+		for(t = 60; t < 80; t++)
+		{
+			temp = SHA1CircularShift(5,A) + (B ^ C ^ D) + E + W[t] + K[3];
+			E = D;
+			D = C;
+			C = SHA1CircularShift(30,B);
+			B = A;
+			A = temp;
+		}
+
+		state[0] += A;
+		state[1] += B;
+		state[2] += C;
+		state[3] += D;
+		state[4] += E;
 	}
+}
+
 
-	for(t = 40; t < 60; t++)
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ *  @brief      Data transformation with the SHA extensions (SHA-NI)
+ *
+ *  @param	state The intermediate hash value to update
+ *  @param	block The data to transform
+ *  @param	blocks The number of 64 byte blocks to transform
+ */  
+__attribute__((target("sha,sse4.1,ssse3")))
+static void SHA1_Transform_SHANI(hl_uint32 state[5], const hl_uint8 *block, size_t blocks)
+{
+	const __m128i MASK = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+	__m128i ABCD, ABCD_SAVE, E0, E0_SAVE, E1;
+	__m128i M[4];
+	int g;
+
+	ABCD = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*) state), 0x1b);
+	E0 = _mm_set_epi32(state[4], 0, 0, 0);
+
+	for(; blocks > 0; blocks--, block += 64)
 	{
-		temp = SHA1CircularShift(5,A) +
-			((B & C) | (B & D) | (C & D)) + E + W[t] + K[2];
-		E = D;
-		D = C;
-		C = SHA1CircularShift(30,B);
-		B = A;
-		A = temp;
+		ABCD_SAVE = ABCD;
+		E0_SAVE = E0;
+
+		/*
+		 *  20 groups of 4 rounds, M[g % 4] holds the words of the
+		 *  group g and E0/E1 take turns holding the E value
+		 */
+#pragma GCC unroll 20
+		for(g = 0; g < 20; g++)
+		{
+			__m128i& E = (g % 2) ? E1 : E0;
+
+			if(g < 4)
+			{
+				M[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(block + g * 16)), MASK);
+			}
+
+			if(g == 0)
+			{
+				E0 = _mm_add_epi32(E0, M[0]);
+			}
+			else
+			{
+				E = _mm_sha1nexte_epu32(E, M[g % 4]);
+			}
+
+			((g % 2) ? E0 : E1) = ABCD;
+
+			if(g >= 3 && g < 19)
+			{
+				/* Finish the words of the group g + 1 */
+				M[(g + 1) % 4] = _mm_sha1msg2_epu32(M[(g + 1) % 4], M[g % 4]);
+			}
+
+			switch(g / 5)
+			{
+				case 0:  ABCD = _mm_sha1rnds4_epu32(ABCD, E, 0); break;
+				case 1:  ABCD = _mm_sha1rnds4_epu32(ABCD, E, 1); break;
+				case 2:  ABCD = _mm_sha1rnds4_epu32(ABCD, E, 2); break;
+				default: ABCD = _mm_sha1rnds4_epu32(ABCD, E, 3); break;
+			}
+
+			if(g >= 1 && g < 17)
+			{
+				/* Start the words of the group g + 3 */
+				M[(g + 3) % 4] = _mm_sha1msg1_epu32(M[(g + 3) % 4], M[g % 4]);
+			}
+
+			if(g >= 2 && g < 18)
+			{
+				M[(g + 2) % 4] = _mm_xor_si128(M[(g + 2) % 4], M[g % 4]);
+			}
+		}
+
+		E0 = _mm_sha1nexte_epu32(E0, E0_SAVE);
+		ABCD = _mm_add_epi32(ABCD, ABCD_SAVE);
 	}
 
-	for(t = 60; t < 80; t++)
+	_mm_storeu_si128((__m128i*) state, _mm_shuffle_epi32(ABCD, 0x1b));
+	state[4] = _mm_extract_epi32(E0, 3);
+}
+
+#endif /* __x86_64__ || __i386__ */
+
+/*
+ * The transformation kernels, from the fastest to the portable one
+ */
+typedef void (*SHA1_Kernel_Function)(hl_uint32 state[5], const hl_uint8 *block, size_t blocks);
+
+typedef struct SHA1_Kernel_Entry
+{
+	const char*		name;
+	SHA1_Kernel_Function	function;
+	bool			(*supported)(void);
+} SHA1_Kernel_Entry;
+
+static bool SHA1_Always_Supported(void) { return true; }
+#if defined(__x86_64__) || defined(__i386__)
+static bool SHA1_SHANI_Supported(void) { return hlGetCpuFeatures().sha; }
+#endif
+
+static const SHA1_Kernel_Entry sha1_kernels[] =
+{
+#if defined(__x86_64__) || defined(__i386__)
+	{ "sha-ni",   SHA1_Transform_SHANI,    SHA1_SHANI_Supported },
+#endif
+	{ "portable", SHA1_Transform_Portable, SHA1_Always_Supported }
+};
+
+/**
+ *  @brief 	Returns the fastest kernel supported by the cpu
+ */  
+static const SHA1_Kernel_Entry* SHA1_Select_Kernel(void)
+{
+	for(const SHA1_Kernel_Entry& kernel : sha1_kernels)
 	{
-		temp = SHA1CircularShift(5,A) + (B ^ C ^ D) + E + W[t] + K[3];
-		E = D;
-		D = C;
-		C = SHA1CircularShift(30,B);
-		B = A;
-		A = temp;
+		if(kernel.supported())
+		{
+			return &kernel;
+		}
 	}
+	return &sha1_kernels[0];
+}
 
-	context->Intermediate_Hash[0] += A;
-	context->Intermediate_Hash[1] += B;
-	context->Intermediate_Hash[2] += C;
-	context->Intermediate_Hash[3] += D;
-	context->Intermediate_Hash[4] += E;
+/*
+ * The kernel in use, chosen once at startup
+ */
+static const SHA1_Kernel_Entry* sha1_kernel = SHA1_Select_Kernel();
 
+/**
+ *  @brief      This member-function will process the next 512 bits of the
+ *  		message stored in the Message_Block array.
+ *
+ *  @param	context The context to process
+ */  
+void SHA1::SHA1ProcessMessageBlock(HL_SHA1_CTX *context)
+{
+	sha1_kernel->function(context->Intermediate_Hash, context->Message_Block, 1);
 	context->Message_Block_Index = 0;
 }
 
@@ -311,33 +467,110 @@ int SHA1::SHA1Input(    HL_SHA1_CTX    *context,
 	{
 		return context->Corrupted;
 	}
-	while(length-- && !context->Corrupted)
-	{
-		context->Message_Block[context->Message_Block_Index++] =
-			(*message_array & 0xFF);
 
-		context->Length_Low += 8;
-		if (context->Length_Low == 0)
+	/*
+	 *  Whole blocks are transformed directly from the message,
+	 *  once the pending bytes of the last call are processed
+	 */
+	while(length && context->Message_Block_Index != 0)
+	{
+		if(SHA1InputByte(context, *message_array++))
 		{
-			context->Length_High++;
-			if (context->Length_High == 0)
-			{
-				/* Message is too long */
-				context->Corrupted = 1;
-			}
+			return shaSuccess;
 		}
+		length--;
+	}
 
-		if (context->Message_Block_Index == 64)
+	if(length >= 64)
+	{
+		const unsigned int blocks = length / 64;
+		const hl_uint64 bits = (hl_uint64) blocks * 512;
+		const hl_uint64 total = (((hl_uint64) context->Length_High << 32) | context->Length_Low) + bits;
+
+		if(total < bits)
 		{
-			SHA1ProcessMessageBlock(context);
+			/* Message is too long */
+			context->Corrupted = 1;
+			return shaSuccess;
 		}
 
-		message_array++;
+		sha1_kernel->function(context->Intermediate_Hash, message_array, blocks);
+		context->Length_Low = (hl_uint32) total;
+		context->Length_High = (hl_uint32) (total >> 32);
+		message_array += blocks * 64;
+		length -= blocks * 64;
+	}
+
+	while(length--)
+	{
+		if(SHA1InputByte(context, *message_array++))
+		{
+			break;
+		}
 	}
 
 	return shaSuccess;
 }
 
+/**
+ *  @brief 	Adds one byte to the context, processing the
+ *  		message block when it gets full
+ *
+ *  @param	context The context to add the byte to
+ *  @param	byte The byte to add
+ *  @return	true if the message got too long
+ */  
+bool SHA1::SHA1InputByte(HL_SHA1_CTX *context, hl_uint8 byte)
+{
+	context->Message_Block[context->Message_Block_Index++] = byte;
+
+	context->Length_Low += 8;
+	if (context->Length_Low == 0)
+	{
+		context->Length_High++;
+		if (context->Length_High == 0)
+		{
+			/* Message is too long */
+			context->Corrupted = 1;
+			return true;
+		}
+	}
+
+	if (context->Message_Block_Index == 64)
+	{
+		SHA1ProcessMessageBlock(context);
+	}
+
+	return false;
+}
+
+/**
+ *  @brief 	Returns the name of the transformation kernel in use
+ */  
+const char* SHA1::SHA1Kernel(void)
+{
+	return sha1_kernel->name;
+}
+
+/**
+ *  @brief 	Changes the transformation kernel in use
+ *  @param	name The name of the kernel to use
+ *  @return	false if there is no such kernel or the cpu
+ *  		doesn't support it
+ */  
+bool SHA1::SHA1UseKernel(const char* name)
+{
+	for(const SHA1_Kernel_Entry& kernel : sha1_kernels)
+	{
+		if(strcmp(name, kernel.name) == 0 && kernel.supported())
+		{
+			sha1_kernel = &kernel;
+			return true;
+		}
+	}
+	return false;
+}
+
 /**
  *  @brief 	This ends the sha operation, zeroizing the context
  *  		and returning the computed hash.
@@ -173,6 +173,16 @@ class SHA1
 			 */  
 			void SHA1ProcessMessageBlock(HL_SHA1_CTX *context);
 
+			/**
+			 *  @brief 	Adds one byte to the context, processing the
+			 *  		message block when it gets full
+			 *
+			 *  @param	context The context to add the byte to
+			 *  @param	byte The byte to add
+			 *  @return	true if the message got too long
+			 */  
+			bool SHA1InputByte(HL_SHA1_CTX *context, hl_uint8 byte);
+
 	public:
 
 		/**
@@ -208,6 +218,21 @@ class SHA1
 		 */  
 		int SHA1Result( HL_SHA1_CTX *context,
 				hl_uint8     Message_Digest[SHA1HashSize]);
+
+		/**
+		 *  @brief 	Returns the name of the transformation kernel
+		 *  		in use: "sha-ni" or "portable". The fastest one
+		 *  		supported by the cpu is chosen at startup.
+		 */  
+		static const char* SHA1Kernel(void);
+
+		/**
+		 *  @brief 	Changes the transformation kernel in use
+		 *  @param	name The name of the kernel to use
+		 *  @return	false if there is no such kernel or the cpu
+		 *  		doesn't support it
+		 */  
+		static bool SHA1UseKernel(const char* name);
 };
 
 //----------------------------------------------------------------------
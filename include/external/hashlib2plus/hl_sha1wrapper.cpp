@@ -62,6 +62,19 @@ std::string sha1wrapper::hashIt(void)
 	return convToString(Message_Digest);
 }
 
+/**
+ *  @brief 	This method ends the hash process
+ *  		and writes the digest as bytes.
+ *
+ *  @param 	digest Receives the digest
+ *  @return 	the length of the digest
+ */  
+unsigned int sha1wrapper::digestIt(unsigned char *digest)
+{
+	sha1->SHA1Result(&context, digest);
+	return SHA1HashSize;
+}
+
 /**
  *  @brief 	This internal member-function
  *  		convertes the hash-data to a
@@ -82,6 +82,14 @@
 //---------------------------------------------------------------------- 
 #include "hl_sha2mac.h"
 
+//---------------------------------------------------------------------- 
+//cpu dispatch includes
+#include "hl_cpuid.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 //---------------------------------------------------------------------- 
 
 /*
@@ -180,61 +188,66 @@ void SHA256::SHA256_Init(HL_SHA256_CTX* context) {
 	j++
 
 /**
- *  @brief 	Internal data transformation
- *  @param	context The context to use
- *  @param	data The data to transform	
+ *  @brief 	Portable data transformation
+ *  @param	state The intermediate hash value to update
+ *  @param	block The data to transform
+ *  @param	blocks The number of 64 byte blocks to transform
  */  
-void SHA256::SHA256_Transform(HL_SHA256_CTX* context, const sha2_word32* data) {
+static void SHA256_Transform_Portable(sha2_word32 state[8], const sha2_byte* block, size_t blocks) {
 	sha2_word32	a, b, c, d, e, f, g, h, s0, s1;
-	sha2_word32	T1, *W256;
+	sha2_word32	T1, W256[16];
+	const sha2_word32 *data;
 	int		j;
 
-	W256 = (sha2_word32*)context->buffer;
-
-	/* Initialize registers with the prev. intermediate value */
-	a = context->state[0];
-	b = context->state[1];
-	c = context->state[2];
-	d = context->state[3];
-	e = context->state[4];
-	f = context->state[5];
-	g = context->state[6];
-	h = context->state[7];
-
-	j = 0;
-	do {
-		/* Rounds 0 to 15 (unrolled): */
-		ROUND256_0_TO_15(a,b,c,d,e,f,g,h);
-		ROUND256_0_TO_15(h,a,b,c,d,e,f,g);
-		ROUND256_0_TO_15(g,h,a,b,c,d,e,f);
-		ROUND256_0_TO_15(f,g,h,a,b,c,d,e);
-		ROUND256_0_TO_15(e,f,g,h,a,b,c,d);
-		ROUND256_0_TO_15(d,e,f,g,h,a,b,c);
-		ROUND256_0_TO_15(c,d,e,f,g,h,a,b);
-		ROUND256_0_TO_15(b,c,d,e,f,g,h,a);
-	} while (j < 16);
-
-	/* Now for the remaining rounds to 64: */
-	do {
-		ROUND256(a,b,c,d,e,f,g,h);
-		ROUND256(h,a,b,c,d,e,f,g);
-		ROUND256(g,h,a,b,c,d,e,f);
-		ROUND256(f,g,h,a,b,c,d,e);
-		ROUND256(e,f,g,h,a,b,c,d);
-		ROUND256(d,e,f,g,h,a,b,c);
-		ROUND256(c,d,e,f,g,h,a,b);
-		ROUND256(b,c,d,e,f,g,h,a);
-	} while (j < 64);
-
-	/* Compute the current intermediate hash value */
-	context->state[0] += a;
-	context->state[1] += b;
-	context->state[2] += c;
-	context->state[3] += d;
-	context->state[4] += e;
-	context->state[5] += f;
-	context->state[6] += g;
-	context->state[7] += h;
+	for (; blocks > 0; blocks--, block += SHA256_BLOCK_LENGTH) {
+		data = (const sha2_word32*)block;
+
+		/* Initialize registers with the prev. intermediate value */
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+		f = state[5];
+		g = state[6];
+		h = state[7];
+
+		j = 0;
+		do {
+			/* Rounds 0 to 15 (unrolled): */
+			ROUND256_0_TO_15(a,b,c,d,e,f,g,h);
+			ROUND256_0_TO_15(h,a,b,c,d,e,f,g);
+			ROUND256_0_TO_15(g,h,a,b,c,d,e,f);
+			ROUND256_0_TO_15(f,g,h,a,b,c,d,e);
+			ROUND256_0_TO_15(e,f,g,h,a,b,c,d);
+			ROUND256_0_TO_15(d,e,f,g,h,a,b,c);
+			ROUND256_0_TO_15(c,d,e,f,g,h,a,b);
+			ROUND256_0_TO_15(b,c,d,e,f,g,h,a);
+		} while (j < 16);
+
+		/* Now for the remaining rounds to 64: */
+		do {
+			ROUND256(a,b,c,d,e,f,g,h);
+			ROUND256(h,a,b,c,d,e,f,g);
+			ROUND256(g,h,a,b,c,d,e,f);
+			ROUND256(f,g,h,a,b,c,d,e);
+			ROUND256(e,f,g,h,a,b,c,d);
+			ROUND256(d,e,f,g,h,a,b,c);
+			ROUND256(c,d,e,f,g,h,a,b);
+			ROUND256(b,c,d,e,f,g,h,a);
+		} while (j < 64);
+
+		/* Compute the current intermediate hash value */
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+
+	}
 
 	/* Clean up */
 	a = b = c = d = e = f = g = h = T1 = 0;
@@ -243,83 +256,88 @@ void SHA256::SHA256_Transform(HL_SHA256_CTX* context, const sha2_word32* data) {
 #else /* SHA2_UNROLL_TRANSFORM */
 
 /**
- *  @brief 	Internal data transformation
- *  @param	context The context to use
- *  @param	data The data to transform	
+ *  @brief 	Portable data transformation
+ *  @param	state The intermediate hash value to update
+ *  @param	block The data to transform
+ *  @param	blocks The number of 64 byte blocks to transform
  */  
-void SHA256::SHA256_Transform(HL_SHA256_CTX* context, const sha2_word32* data) {
+static void SHA256_Transform_Portable(sha2_word32 state[8], const sha2_byte* block, size_t blocks) {
 	sha2_word32	a, b, c, d, e, f, g, h, s0, s1;
-	sha2_word32	T1, T2, *W256;
+	sha2_word32	T1, T2, W256[16];
+	const sha2_word32 *data;
 	int		j;
 
-	W256 = (sha2_word32*)context->buffer;
+	for (; blocks > 0; blocks--, block += SHA256_BLOCK_LENGTH) {
+		data = (const sha2_word32*)block;
+
+		/* Initialize registers with the prev. intermediate value */
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+		f = state[5];
+		g = state[6];
+		h = state[7];
+
+		j = 0;
+		do {
+	#if BYTE_ORDER == LITTLE_ENDIAN
+			/* Copy data while converting to host byte order */
+			REVERSE32(*data++,W256[j]);
+			/* Apply the SHA-256 compression function to update a..h */
+			T1 = h + Sigma1_256(e) + Ch(e, f, g) + K256[j] + W256[j];
+	#else /* BYTE_ORDER == LITTLE_ENDIAN */
+			/* Apply the SHA-256 compression function to update a..h with copy */
+			T1 = h + Sigma1_256(e) + Ch(e, f, g) + K256[j] + (W256[j] = *data++);
+	#endif /* BYTE_ORDER == LITTLE_ENDIAN */
+			T2 = Sigma0_256(a) + Maj(a, b, c);
+			h = g;
+			g = f;
+			f = e;
+			e = d + T1;
+			d = c;
+			c = b;
+			b = a;
+			a = T1 + T2;
+
+			j++;
+		} while (j < 16);
+
+		do {
+			/* Part of the message block expansion: */
+			s0 = W256[(j+1)&0x0f];
+			s0 = sigma0_256(s0);
+			s1 = W256[(j+14)&0x0f];	
+			s1 = sigma1_256(s1);
+
+			/* Apply the SHA-256 compression function to update a..h */
+			T1 = h + Sigma1_256(e) + Ch(e, f, g) + K256[j] + 
+			     (W256[j&0x0f] += s1 + W256[(j+9)&0x0f] + s0);
+			T2 = Sigma0_256(a) + Maj(a, b, c);
+			h = g;
+			g = f;
+			f = e;
+			e = d + T1;
+			d = c;
+			c = b;
+			b = a;
+			a = T1 + T2;
+
+			j++;
+		} while (j < 64);
+
+		/* Compute the current intermediate hash value */
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
 
-	/* Initialize registers with the prev. intermediate value */
-	a = context->state[0];
-	b = context->state[1];
-	c = context->state[2];
-	d = context->state[3];
-	e = context->state[4];
-	f = context->state[5];
-	g = context->state[6];
-	h = context->state[7];
-
-	j = 0;
-	do {
-#if BYTE_ORDER == LITTLE_ENDIAN
-		/* Copy data while converting to host byte order */
-		REVERSE32(*data++,W256[j]);
-		/* Apply the SHA-256 compression function to update a..h */
-		T1 = h + Sigma1_256(e) + Ch(e, f, g) + K256[j] + W256[j];
-#else /* BYTE_ORDER == LITTLE_ENDIAN */
-		/* Apply the SHA-256 compression function to update a..h with copy */
-		T1 = h + Sigma1_256(e) + Ch(e, f, g) + K256[j] + (W256[j] = *data++);
-#endif /* BYTE_ORDER == LITTLE_ENDIAN */
-		T2 = Sigma0_256(a) + Maj(a, b, c);
-		h = g;
-		g = f;
-		f = e;
-		e = d + T1;
-		d = c;
-		c = b;
-		b = a;
-		a = T1 + T2;
-
-		j++;
-	} while (j < 16);
-
-	do {
-		/* Part of the message block expansion: */
-		s0 = W256[(j+1)&0x0f];
-		s0 = sigma0_256(s0);
-		s1 = W256[(j+14)&0x0f];	
-		s1 = sigma1_256(s1);
-
-		/* Apply the SHA-256 compression function to update a..h */
-		T1 = h + Sigma1_256(e) + Ch(e, f, g) + K256[j] + 
-		     (W256[j&0x0f] += s1 + W256[(j+9)&0x0f] + s0);
-		T2 = Sigma0_256(a) + Maj(a, b, c);
-		h = g;
-		g = f;
-		f = e;
-		e = d + T1;
-		d = c;
-		c = b;
-		b = a;
-		a = T1 + T2;
-
-		j++;
-	} while (j < 64);
-
-	/* Compute the current intermediate hash value */
-	context->state[0] += a;
-	context->state[1] += b;
-	context->state[2] += c;
-	context->state[3] += d;
-	context->state[4] += e;
-	context->state[5] += f;
-	context->state[6] += g;
-	context->state[7] += h;
+	}
 
 	/* Clean up */
 	a = b = c = d = e = f = g = h = T1 = T2 = 0;
@@ -327,6 +345,146 @@ void SHA256::SHA256_Transform(HL_SHA256_CTX* context, const sha2_word32* data) {
 
 #endif /* SHA2_UNROLL_TRANSFORM */
 
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ *  @brief 	Data transformation with the SHA extensions (SHA-NI)
+ *  @param	state The intermediate hash value to update
+ *  @param	block The data to transform
+ *  @param	blocks The number of 64 byte blocks to transform
+ */  
+__attribute__((target("sha,sse4.1,ssse3")))
+static void SHA256_Transform_SHANI(sha2_word32 state[8], const sha2_byte* block, size_t blocks) {
+	const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	__m128i STATE0, STATE1, MSG, TMP, ABEF_SAVE, CDGH_SAVE;
+	__m128i M[4];
+	int g;
+
+	/* The instructions work on the state as ABEF and CDGH */
+	TMP = _mm_loadu_si128((const __m128i*)&state[0]);
+	STATE1 = _mm_loadu_si128((const __m128i*)&state[4]);
+	TMP = _mm_shuffle_epi32(TMP, 0xb1);
+	STATE1 = _mm_shuffle_epi32(STATE1, 0x1b);
+	STATE0 = _mm_alignr_epi8(TMP, STATE1, 8);
+	STATE1 = _mm_blend_epi16(STATE1, TMP, 0xf0);
+
+	for (; blocks > 0; blocks--, block += SHA256_BLOCK_LENGTH) {
+		ABEF_SAVE = STATE0;
+		CDGH_SAVE = STATE1;
+
+		/* 16 groups of 4 rounds, M[g % 4] holds the words of group g */
+#pragma GCC unroll 16
+		for (g = 0; g < 16; g++) {
+			if (g < 4) {
+				M[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(block + g * 16)), MASK);
+			}
+
+			MSG = _mm_add_epi32(M[g % 4], _mm_loadu_si128((const __m128i*)&K256[g * 4]));
+			STATE1 = _mm_sha256rnds2_epu32(STATE1, STATE0, MSG);
+
+			if (g >= 3 && g < 15) {
+				/* Finish the words of the group g + 1 */
+				TMP = _mm_alignr_epi8(M[g % 4], M[(g + 3) % 4], 4);
+				M[(g + 1) % 4] = _mm_add_epi32(M[(g + 1) % 4], TMP);
+				M[(g + 1) % 4] = _mm_sha256msg2_epu32(M[(g + 1) % 4], M[g % 4]);
+			}
+
+			MSG = _mm_shuffle_epi32(MSG, 0x0e);
+			STATE0 = _mm_sha256rnds2_epu32(STATE0, STATE1, MSG);
+
+			if (g >= 1 && g < 13) {
+				/* Start the words of the group g + 3 */
+				M[(g + 3) % 4] = _mm_sha256msg1_epu32(M[(g + 3) % 4], M[g % 4]);
+			}
+		}
+
+		STATE0 = _mm_add_epi32(STATE0, ABEF_SAVE);
+		STATE1 = _mm_add_epi32(STATE1, CDGH_SAVE);
+	}
+
+	/* Back from ABEF and CDGH to the ABCDEFGH order */
+	TMP = _mm_shuffle_epi32(STATE0, 0x1b);
+	STATE1 = _mm_shuffle_epi32(STATE1, 0xb1);
+	STATE0 = _mm_blend_epi16(TMP, STATE1, 0xf0);
+	STATE1 = _mm_alignr_epi8(STATE1, TMP, 8);
+	_mm_storeu_si128((__m128i*)&state[0], STATE0);
+	_mm_storeu_si128((__m128i*)&state[4], STATE1);
+}
+
+#endif /* __x86_64__ || __i386__ */
+
+/*
+ * The transformation kernels, from the fastest to the portable one
+ */
+typedef void (*SHA256_Kernel_Function)(sha2_word32 state[8], const sha2_byte* block, size_t blocks);
+
+typedef struct SHA256_Kernel_Entry {
+	const char*		name;
+	SHA256_Kernel_Function	function;
+	bool			(*supported)(void);
+} SHA256_Kernel_Entry;
+
+static bool SHA256_Always_Supported(void) { return true; }
+#if defined(__x86_64__) || defined(__i386__)
+static bool SHA256_SHANI_Supported(void) { return hlGetCpuFeatures().sha; }
+#endif
+
+static const SHA256_Kernel_Entry sha256_kernels[] = {
+#if defined(__x86_64__) || defined(__i386__)
+	{ "sha-ni",   SHA256_Transform_SHANI,    SHA256_SHANI_Supported },
+#endif
+	{ "portable", SHA256_Transform_Portable, SHA256_Always_Supported }
+};
+
+/**
+ *  @brief 	Returns the fastest kernel supported by the cpu
+ */  
+static const SHA256_Kernel_Entry* SHA256_Select_Kernel(void) {
+	for (const SHA256_Kernel_Entry& kernel : sha256_kernels) {
+		if (kernel.supported()) {
+			return &kernel;
+		}
+	}
+	return &sha256_kernels[0];
+}
+
+/*
+ * The kernel in use, chosen once at startup
+ */
+static const SHA256_Kernel_Entry* sha256_kernel = SHA256_Select_Kernel();
+
+/**
+ *  @brief 	Internal data transformation
+ *  @param	context The context to use
+ *  @param	data The data to transform	
+ */  
+void SHA256::SHA256_Transform(HL_SHA256_CTX* context, const sha2_word32* data) {
+	sha256_kernel->function(context->state, (const sha2_byte*)data, 1);
+}
+
+/**
+ *  @brief 	Returns the name of the transformation kernel in use
+ */  
+const char* SHA256::SHA256_Kernel(void) {
+	return sha256_kernel->name;
+}
+
+/**
+ *  @brief 	Changes the transformation kernel in use
+ *  @param	name The name of the kernel to use
+ *  @return	false if there is no such kernel or the cpu
+ *  		doesn't support it
+ */  
+bool SHA256::SHA256_Use_Kernel(const char* name) {
+	for (const SHA256_Kernel_Entry& kernel : sha256_kernels) {
+		if (strcmp(name, kernel.name) == 0 && kernel.supported()) {
+			sha256_kernel = &kernel;
+			return true;
+		}
+	}
+	return false;
+}
+
 /**
  *  @brief	Updates the context 
  *  @param	context The context to update.
@@ -365,12 +523,13 @@ void SHA256::SHA256_Update(HL_SHA256_CTX* context, const sha2_byte *data, unsign
 			return;
 		}
 	}
-	while (len >= SHA256_BLOCK_LENGTH) {
+	if (len >= SHA256_BLOCK_LENGTH) {
 		/* Process as many complete blocks as we can */
-		SHA256_Transform(context, (sha2_word32*)data);
-		context->bitcount += SHA256_BLOCK_LENGTH << 3;
-		len -= SHA256_BLOCK_LENGTH;
-		data += SHA256_BLOCK_LENGTH;
+		const unsigned int blocks = len / SHA256_BLOCK_LENGTH;
+		sha256_kernel->function(context->state, data, blocks);
+		context->bitcount += (sha2_word64)blocks * SHA256_BLOCK_LENGTH << 3;
+		len -= blocks * SHA256_BLOCK_LENGTH;
+		data += blocks * SHA256_BLOCK_LENGTH;
 	}
 	if (len > 0) {
 		/* There's left-overs, so save 'em */
@@ -139,14 +139,6 @@ class SHA256
 	private:
 
 
-		/**
-		 *  @brief 	Finalize the sha256 operation
-		 *  @param	digest The digest to finalize the operation with.
-		 *  @param	context The context to finalize.
-		 */  
-		void SHA256_Final(hl_uint8 digest[SHA256_DIGEST_LENGTH],
-			          HL_SHA256_CTX* context);
-
 		/**
 		 *  @brief 	Internal data transformation
 		 *  @param	context The context to use
@@ -157,6 +149,14 @@ class SHA256
 
 	public:
 
+		/**
+		 *  @brief 	Finalize the sha256 operation
+		 *  @param	digest The digest to finalize the operation with.
+		 *  @param	context The context to finalize.
+		 */  
+		void SHA256_Final(hl_uint8 digest[SHA256_DIGEST_LENGTH],
+			          HL_SHA256_CTX* context);
+
 		/**
 		 *  @brief 	Initialize the context
 		 *  @param	context The context to init.
@@ -183,6 +183,22 @@ class SHA256
 		char* SHA256_End(HL_SHA256_CTX* context,
 			         char buffer[SHA256_DIGEST_STRING_LENGTH]);
 
+		/**
+		 *  @brief 	Returns the name of the transformation kernel
+		 *  		in use: "sha-ni" or "portable". The
+		 *  		fastest one supported by the cpu is chosen at
+		 *  		startup.
+		 */  
+		static const char* SHA256_Kernel(void);
+
+		/**
+		 *  @brief 	Changes the transformation kernel in use
+		 *  @param	name The name of the kernel to use
+		 *  @return	false if there is no such kernel or the cpu
+		 *  		doesn't support it
+		 */  
+		static bool SHA256_Use_Kernel(const char* name);
+
 };
 
 //----------------------------------------------------------------------
@@ -62,6 +62,19 @@ std::string sha256wrapper::hashIt(void)
 	return convToString(buff);
 }
 
+/**
+ *  @brief 	This method ends the hash process
+ *  		and writes the digest as bytes.
+ *
+ *  @param 	digest Receives the digest
+ *  @return 	the length of the digest
+ */  
+unsigned int sha256wrapper::digestIt(unsigned char *digest)
+{
+	sha256->SHA256_Final(digest,&context);
+	return SHA256_DIGEST_LENGTH;
+}
+
 /**
  *  @brief 	This internal member-function
  *  		convertes the hash-data to a
@@ -138,22 +138,6 @@ class SHA2ext
 {
 	private:
 
-		/**
-		 *  @brief 	Finalize the sha384 operation
-		 *  @param	digest The digest to finalize the operation with.
-		 *  @param	context The context to finalize.
-		 */  
-		void SHA384_Final(hl_uint8 digest[SHA384_DIGEST_LENGTH],
-			          HL_SHA_384_CTX* context);
-
-		/**
-		 *  @brief 	Finalize the sha512 operation
-		 *  @param	digest The digest to finalize the operation with.
-		 *  @param	context The context to finalize.
-		 */  
-		void SHA512_Final(hl_uint8 digest[SHA512_DIGEST_LENGTH],
-			       	  HL_SHA512_CTX* context);
-
 		/**
 		 *  @brief 	Internal method
 		 *
@@ -174,6 +158,22 @@ class SHA2ext
 
 	public:
 
+		/**
+		 *  @brief 	Finalize the sha384 operation
+		 *  @param	digest The digest to finalize the operation with.
+		 *  @param	context The context to finalize.
+		 */  
+		void SHA384_Final(hl_uint8 digest[SHA384_DIGEST_LENGTH],
+			          HL_SHA_384_CTX* context);
+
+		/**
+		 *  @brief 	Finalize the sha512 operation
+		 *  @param	digest The digest to finalize the operation with.
+		 *  @param	context The context to finalize.
+		 */  
+		void SHA512_Final(hl_uint8 digest[SHA512_DIGEST_LENGTH],
+			       	  HL_SHA512_CTX* context);
+
 		/**
 		 *  @brief 	Initialize the SHA384 context
 		 *  @param	context The context to init.
@@ -57,6 +57,19 @@ std::string sha384wrapper::hashIt(void)
 	return convToString(buff);
 }
 
+/**
+ *  @brief 	This method ends the hash process
+ *  		and writes the digest as bytes.
+ *
+ *  @param 	digest Receives the digest
+ *  @return 	the length of the digest
+ */  
+unsigned int sha384wrapper::digestIt(unsigned char *digest)
+{
+	sha384->SHA384_Final(digest,&context);
+	return SHA384_DIGEST_LENGTH;
+}
+
 /**
  *  @brief 	This internal member-function
  *  		convertes the hash-data to a
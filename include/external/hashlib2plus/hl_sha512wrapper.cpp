@@ -59,6 +59,19 @@ std::string sha512wrapper::hashIt(void)
 	return convToString(buff);
 }
 
+/**
+ *  @brief 	This method ends the hash process
+ *  		and writes the digest as bytes.
+ *
+ *  @param 	digest Receives the digest
+ *  @return 	the length of the digest
+ */  
+unsigned int sha512wrapper::digestIt(unsigned char *digest)
+{
+	sha512->SHA512_Final(digest,&context);
+	return SHA512_DIGEST_LENGTH;
+}
+
 /**
  *  @brief 	This internal member-function
  *  		convertes the hash-data to a
@@ -73,6 +73,22 @@ hashwrapper* wrapperfactory::create(HL_Wrappertype type)
 	{
 		return new sha512wrapper();
 	}
+	else if(type == HL_BLAKE2B)
+	{
+		return new blake2bwrapper();
+	}
+	else if(type == HL_BLAKE3)
+	{
+		return new blake3wrapper();
+	}
+	else if(type == HL_XXH3)
+	{
+		return new xxh3wrapper();
+	}
+	else if(type == HL_XXH128)
+	{
+		return new xxh128wrapper();
+	}
 
 	throw hlException(HL_UNKNOWN_HASH_TYPE,"Unknown hashtype");
 }
@@ -106,6 +122,22 @@ hashwrapper* wrapperfactory::create(std::string type)
 	{
 		return new sha512wrapper();
 	}
+	else if(type == "BLAKE2B")
+	{
+		return new blake2bwrapper();
+	}
+	else if(type == "BLAKE3")
+	{
+		return new blake3wrapper();
+	}
+	else if(type == "XXH3")
+	{
+		return new xxh3wrapper();
+	}
+	else if(type == "XXH128")
+	{
+		return new xxh128wrapper();
+	}
 	return NULL;
 }
 
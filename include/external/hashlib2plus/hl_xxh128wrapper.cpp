@@ -0,0 +1,127 @@
+/*
+ * hashlib++ - a simple hash library for C++
+ *
+ * This file is an addition to hashlib++ and is distributed under
+ * the same license, see hl_hashwrapper.h for the full text.
+ */
+
+//----------------------------------------------------------------------
+
+/**
+ *  @file 	hl_xxh128wrapper.cpp
+ *  @brief	This file contains the implementation of the xxh128wrapper
+ *  		class.
+ */
+
+//----------------------------------------------------------------------
+//hashlib++ includes
+#include "hl_xxh128wrapper.h"
+#include "hl_xxhash.h"
+
+//----------------------------------------------------------------------
+//STL includes
+#include <sstream>
+#include <string>
+
+//----------------------------------------------------------------------
+//private memberfunctions
+
+/**
+ *  @brief 	This method ends the hash process
+ *  		and returns the hash as string.
+ *
+ *  @return 	a hash as std::string
+ */
+std::string xxh128wrapper::hashIt(void)
+{
+	hl_uint8 buff[XXH128_DIGEST_LENGTH];
+	xxh3->XXH3_128_Final(buff,&context);
+
+	return convToString(buff);
+}
+
+/**
+ *  @brief 	This method ends the hash process
+ *  		and writes the digest as bytes.
+ *
+ *  @param 	digest Receives the digest
+ *  @return 	the length of the digest
+ */
+unsigned int xxh128wrapper::digestIt(unsigned char *digest)
+{
+	xxh3->XXH3_128_Final(digest,&context);
+	return XXH128_DIGEST_LENGTH;
+}
+
+/**
+ *  @brief 	This internal member-function
+ *  		convertes the hash-data to a
+ *  		std::string (HEX).
+ *
+ *  @param 	data The hash-data to covert into HEX
+ *  @return	the converted data as std::string
+ */
+std::string xxh128wrapper::convToString(unsigned char *data)
+{
+	std::ostringstream os;
+	for(int i=0; i<XXH128_DIGEST_LENGTH; ++i)
+	{
+		os.width(2);
+		os.fill('0');
+		os << std::hex << static_cast<unsigned int>(data[i]);
+	}
+	return os.str();
+}
+
+/**
+ *  @brief 	This method adds the given data to the
+ *  		current hash context
+ *
+ *  @param 	data The data to add to the current context
+ *  @param 	len The length of the data to add
+ */
+void xxh128wrapper::updateContext(unsigned char *data, unsigned int len)
+{
+	this->xxh3->XXH3_Update(&context,data,len);
+}
+
+/**
+ *  @brief 	This method resets the current hash context.
+ *  		In other words: It starts a new hash process.
+ */
+void xxh128wrapper::resetContext(void)
+{
+	xxh3->XXH3_Init(&context);
+}
+
+/**
+ * @brief 	This method should return the hash of the
+ * 		test-string "The quick brown fox jumps over the lazy
+ * 		dog"
+ */
+std::string xxh128wrapper::getTestHash(void)
+{
+	return "ddd650205ca3e7fa24a1cc2e3a8a7651";
+}
+
+//----------------------------------------------------------------------
+//public memberfunctions
+
+/**
+ *  @brief 	default constructor
+ */
+xxh128wrapper::xxh128wrapper()
+{
+	this->xxh3 = new XXH3();
+}
+
+/**
+ *  @brief 	default destructor
+ */
+xxh128wrapper::~xxh128wrapper()
+{
+	delete xxh3;
+}
+
+//----------------------------------------------------------------------
+//EOF
@@ -0,0 +1,598 @@
+/*
+ * hashlib++ - a simple hash library for C++
+ *
+ * This file is an addition to hashlib++ and is distributed under
+ * the same license, see hl_hashwrapper.h for the full text.
+ */
+
+//----------------------------------------------------------------------
+
+/**
+ *  @file 	hl_xxhash.cpp
+ *  @brief	This file contains the implementation of the XXH3 class
+ */
+
+//----------------------------------------------------------------------
+//hashlib++ includes
+#include "hl_xxhash.h"
+
+//----------------------------------------------------------------------
+//C includes
+#include <string.h>
+
+//----------------------------------------------------------------------
+//constants
+
+static const hl_uint64 XXH_PRIME32_1 = 0x9E3779B1U;
+static const hl_uint64 XXH_PRIME32_2 = 0x85EBCA77U;
+static const hl_uint64 XXH_PRIME32_3 = 0xC2B2AE3DU;
+static const hl_uint64 XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const hl_uint64 XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const hl_uint64 XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+static const hl_uint64 XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const hl_uint64 XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+static const hl_uint64 XXH_PRIME_MX1 = 0x165667919E3779F9ULL;
+static const hl_uint64 XXH_PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+/*
+ * Length of the secret and stripes accumulated between two scrambles
+ */
+#define XXH3_SECRET_LENGTH		192
+#define XXH3_STRIPES_PER_BLOCK		((XXH3_SECRET_LENGTH - XXH3_STRIPE_LENGTH) / 8)
+
+/*
+ * Inputs up to this length are hashed at once, without the stripes
+ */
+#define XXH3_MIDSIZE_MAX		240
+
+/*
+ * The default secret
+ */
+static const hl_uint8 XXH3_SECRET[XXH3_SECRET_LENGTH] = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+};
+
+//----------------------------------------------------------------------
+//helpers
+
+/**
+ *  @brief 	A 128 bit value as two 64 bit halves
+ */
+typedef struct XXH3_Pair
+{
+	hl_uint64 low;
+	hl_uint64 high;
+} XXH3_Pair;
+
+/**
+ *  @brief 	Reads a little endian 32 bit word
+ */
+static inline hl_uint32 XXH_Read32(const hl_uint8* p)
+{
+	return (hl_uint32) p[0] | ((hl_uint32) p[1] << 8) | ((hl_uint32) p[2] << 16) | ((hl_uint32) p[3] << 24);
+}
+
+/**
+ *  @brief 	Reads a little endian 64 bit word
+ */
+static inline hl_uint64 XXH_Read64(const hl_uint8* p)
+{
+	return (hl_uint64) XXH_Read32(p) | ((hl_uint64) XXH_Read32(p + 4) << 32);
+}
+
+/**
+ *  @brief 	Writes a 64 bit word in big endian order
+ */
+static inline void XXH_Write64BE(hl_uint8* p, hl_uint64 word)
+{
+	for(int i = 0; i < 8; i++)
+	{
+		p[i] = (hl_uint8) (word >> (56 - 8 * i));
+	}
+}
+
+static inline hl_uint64 XXH_Rotl64(hl_uint64 x, int bits)
+{
+	return (x << bits) | (x >> (64 - bits));
+}
+
+static inline hl_uint32 XXH_Rotl32(hl_uint32 x, int bits)
+{
+	return (x << bits) | (x >> (32 - bits));
+}
+
+/**
+ *  @brief 	Returns the full 128 bit product of a and b
+ */
+static inline XXH3_Pair XXH_Mult64to128(hl_uint64 a, hl_uint64 b)
+{
+	const unsigned __int128 product = (unsigned __int128) a * b;
+	XXH3_Pair result = { (hl_uint64) product, (hl_uint64) (product >> 64) };
+	return result;
+}
+
+/**
+ *  @brief 	Returns the halves of the 128 bit product of a and b
+ *  		xored together
+ */
+static inline hl_uint64 XXH_Mul128Fold64(hl_uint64 a, hl_uint64 b)
+{
+	const XXH3_Pair product = XXH_Mult64to128(a, b);
+	return product.low ^ product.high;
+}
+
+static inline hl_uint64 XXH64_Avalanche(hl_uint64 h)
+{
+	h ^= h >> 33;
+	h *= XXH_PRIME64_2;
+	h ^= h >> 29;
+	h *= XXH_PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+static inline hl_uint64 XXH3_Avalanche(hl_uint64 h)
+{
+	h ^= h >> 37;
+	h *= XXH_PRIME_MX1;
+	h ^= h >> 32;
+	return h;
+}
+
+static inline hl_uint64 XXH3_Rrmxmx(hl_uint64 h, hl_uint64 len)
+{
+	h ^= XXH_Rotl64(h, 49) ^ XXH_Rotl64(h, 24);
+	h *= XXH_PRIME_MX2;
+	h ^= (h >> 35) + len;
+	h *= XXH_PRIME_MX2;
+	return h ^ (h >> 28);
+}
+
+static inline hl_uint64 XXH3_Mix16B(const hl_uint8* input, const hl_uint8* secret)
+{
+	return XXH_Mul128Fold64(XXH_Read64(input) ^ XXH_Read64(secret),
+				XXH_Read64(input + 8) ^ XXH_Read64(secret + 8));
+}
+
+static inline void XXH128_Mix32B(XXH3_Pair& acc, const hl_uint8* input1, const hl_uint8* input2,
+				 const hl_uint8* secret)
+{
+	acc.low += XXH3_Mix16B(input1, secret);
+	acc.low ^= XXH_Read64(input2) + XXH_Read64(input2 + 8);
+	acc.high += XXH3_Mix16B(input2, secret + 16);
+	acc.high ^= XXH_Read64(input1) + XXH_Read64(input1 + 8);
+}
+
+//----------------------------------------------------------------------
+//short inputs
+
+/**
+ *  @brief 	XXH3-64 of up to XXH3_MIDSIZE_MAX bytes
+ */
+static hl_uint64 XXH3_64_Short(const hl_uint8* input, size_t len)
+{
+	const hl_uint8* secret = XXH3_SECRET;
+
+	if(len == 0)
+	{
+		return XXH64_Avalanche(XXH_Read64(secret + 56) ^ XXH_Read64(secret + 64));
+	}
+
+	if(len <= 3)
+	{
+		const hl_uint32 combined = ((hl_uint32) input[0] << 16) | ((hl_uint32) input[len >> 1] << 24)
+					 | (hl_uint32) input[len - 1] | ((hl_uint32) len << 8);
+		const hl_uint64 bitflip = XXH_Read32(secret) ^ XXH_Read32(secret + 4);
+		return XXH64_Avalanche((hl_uint64) combined ^ bitflip);
+	}
+
+	if(len <= 8)
+	{
+		const hl_uint64 bitflip = XXH_Read64(secret + 8) ^ XXH_Read64(secret + 16);
+		const hl_uint64 input64 = XXH_Read32(input + len - 4) + ((hl_uint64) XXH_Read32(input) << 32);
+		return XXH3_Rrmxmx(input64 ^ bitflip, len);
+	}
+
+	if(len <= 16)
+	{
+		const hl_uint64 low = XXH_Read64(input) ^ (XXH_Read64(secret + 24) ^ XXH_Read64(secret + 32));
+		const hl_uint64 high = XXH_Read64(input + len - 8) ^ (XXH_Read64(secret + 40) ^ XXH_Read64(secret + 48));
+		return XXH3_Avalanche(len + __builtin_bswap64(low) + high + XXH_Mul128Fold64(low, high));
+	}
+
+	hl_uint64 acc = len * XXH_PRIME64_1;
+
+	if(len <= 128)
+	{
+		if(len > 32)
+		{
+			if(len > 64)
+			{
+				if(len > 96)
+				{
+					acc += XXH3_Mix16B(input + 48, secret + 96);
+					acc += XXH3_Mix16B(input + len - 64, secret + 112);
+				}
+				acc += XXH3_Mix16B(input + 32, secret + 64);
+				acc += XXH3_Mix16B(input + len - 48, secret + 80);
+			}
+			acc += XXH3_Mix16B(input + 16, secret + 32);
+			acc += XXH3_Mix16B(input + len - 32, secret + 48);
+		}
+		acc += XXH3_Mix16B(input, secret);
+		acc += XXH3_Mix16B(input + len - 16, secret + 16);
+		return XXH3_Avalanche(acc);
+	}
+
+	const size_t rounds = len / 16;
+
+	for(size_t i = 0; i < 8; i++)
+	{
+		acc += XXH3_Mix16B(input + 16 * i, secret + 16 * i);
+	}
+
+	acc = XXH3_Avalanche(acc);
+
+	for(size_t i = 8; i < rounds; i++)
+	{
+		acc += XXH3_Mix16B(input + 16 * i, secret + 16 * (i - 8) + 3);
+	}
+
+	acc += XXH3_Mix16B(input + len - 16, secret + 136 - 17);
+	return XXH3_Avalanche(acc);
+}
+
+/**
+ *  @brief 	XXH128 of up to XXH3_MIDSIZE_MAX bytes
+ */
+static XXH3_Pair XXH128_Short(const hl_uint8* input, size_t len)
+{
+	const hl_uint8* secret = XXH3_SECRET;
+	XXH3_Pair h;
+
+	if(len == 0)
+	{
+		h.low = XXH64_Avalanche(XXH_Read64(secret + 64) ^ XXH_Read64(secret + 72));
+		h.high = XXH64_Avalanche(XXH_Read64(secret + 80) ^ XXH_Read64(secret + 88));
+		return h;
+	}
+
+	if(len <= 3)
+	{
+		const hl_uint32 combinedLow = ((hl_uint32) input[0] << 16) | ((hl_uint32) input[len >> 1] << 24)
+					    | (hl_uint32) input[len - 1] | ((hl_uint32) len << 8);
+		const hl_uint32 combinedHigh = XXH_Rotl32(__builtin_bswap32(combinedLow), 13);
+		const hl_uint64 bitflipLow = XXH_Read32(secret) ^ XXH_Read32(secret + 4);
+		const hl_uint64 bitflipHigh = XXH_Read32(secret + 8) ^ XXH_Read32(secret + 12);
+		h.low = XXH64_Avalanche((hl_uint64) combinedLow ^ bitflipLow);
+		h.high = XXH64_Avalanche((hl_uint64) combinedHigh ^ bitflipHigh);
+		return h;
+	}
+
+	if(len <= 8)
+	{
+		const hl_uint64 input64 = XXH_Read32(input) + ((hl_uint64) XXH_Read32(input + len - 4) << 32);
+		const hl_uint64 bitflip = XXH_Read64(secret + 16) ^ XXH_Read64(secret + 24);
+		XXH3_Pair m = XXH_Mult64to128(input64 ^ bitflip, XXH_PRIME64_1 + (len << 2));
+
+		m.high += m.low << 1;
+		m.low ^= m.high >> 3;
+		m.low ^= m.low >> 35;
+		m.low *= XXH_PRIME_MX2;
+		m.low ^= m.low >> 28;
+		m.high = XXH3_Avalanche(m.high);
+		return m;
+	}
+
+	if(len <= 16)
+	{
+		const hl_uint64 bitflipLow = XXH_Read64(secret + 32) ^ XXH_Read64(secret + 40);
+		const hl_uint64 bitflipHigh = XXH_Read64(secret + 48) ^ XXH_Read64(secret + 56);
+		const hl_uint64 low = XXH_Read64(input);
+		hl_uint64 high = XXH_Read64(input + len - 8);
+		XXH3_Pair m = XXH_Mult64to128(low ^ high ^ bitflipLow, XXH_PRIME64_1);
+
+		m.low += (hl_uint64) (len - 1) << 54;
+		high ^= bitflipHigh;
+		m.high += high + (hl_uint64) (hl_uint32) high * (XXH_PRIME32_2 - 1);
+		m.low ^= __builtin_bswap64(m.high);
+
+		h = XXH_Mult64to128(m.low, XXH_PRIME64_2);
+		h.high += m.high * XXH_PRIME64_2;
+		h.low = XXH3_Avalanche(h.low);
+		h.high = XXH3_Avalanche(h.high);
+		return h;
+	}
+
+	XXH3_Pair acc = { len * XXH_PRIME64_1, 0 };
+
+	if(len <= 128)
+	{
+		if(len > 32)
+		{
+			if(len > 64)
+			{
+				if(len > 96)
+				{
+					XXH128_Mix32B(acc, input + 48, input + len - 64, secret + 96);
+				}
+				XXH128_Mix32B(acc, input + 32, input + len - 48, secret + 64);
+			}
+			XXH128_Mix32B(acc, input + 16, input + len - 32, secret + 32);
+		}
+		XXH128_Mix32B(acc, input, input + len - 16, secret);
+	}
+	else
+	{
+		const size_t rounds = len / 32;
+
+		for(size_t i = 0; i < 4; i++)
+		{
+			XXH128_Mix32B(acc, input + 32 * i, input + 32 * i + 16, secret + 32 * i);
+		}
+
+		acc.low = XXH3_Avalanche(acc.low);
+		acc.high = XXH3_Avalanche(acc.high);
+
+		for(size_t i = 4; i < rounds; i++)
+		{
+			XXH128_Mix32B(acc, input + 32 * i, input + 32 * i + 16, secret + 3 + 32 * (i - 4));
+		}
+
+		XXH128_Mix32B(acc, input + len - 16, input + len - 32, secret + 136 - 17 - 16);
+	}
+
+	h.low = XXH3_Avalanche(acc.low + acc.high);
+	h.high = 0 - XXH3_Avalanche(acc.low * XXH_PRIME64_1 + acc.high * XXH_PRIME64_4 + len * XXH_PRIME64_2);
+	return h;
+}
+
+//----------------------------------------------------------------------
+//long inputs
+
+/**
+ *  @brief 	Accumulates a stripe with the secret at the given position
+ */
+static inline void XXH3_Accumulate512(hl_uint64 acc[8], const hl_uint8* stripe, const hl_uint8* secret)
+{
+	for(int i = 0; i < 8; i++)
+	{
+		const hl_uint64 value = XXH_Read64(stripe + 8 * i);
+		const hl_uint64 key = value ^ XXH_Read64(secret + 8 * i);
+
+		acc[i ^ 1] += value;
+		acc[i] += (hl_uint64) (hl_uint32) key * (key >> 32);
+	}
+}
+
+/**
+ *  @brief 	Scrambles the accumulators at the end of a block
+ */
+static inline void XXH3_Scramble(hl_uint64 acc[8])
+{
+	const hl_uint8* secret = XXH3_SECRET + XXH3_SECRET_LENGTH - XXH3_STRIPE_LENGTH;
+
+	for(int i = 0; i < 8; i++)
+	{
+		hl_uint64 value = acc[i];
+		value ^= value >> 47;
+		value ^= XXH_Read64(secret + 8 * i);
+		acc[i] = value * XXH_PRIME32_1;
+	}
+}
+
+/**
+ *  @brief 	Accumulates whole stripes, scrambling the accumulators
+ *  		after every block of them
+ */
+static void XXH3_Accumulate_Stripes(hl_uint64 acc[8], size_t& stripes, const hl_uint8* data, size_t count)
+{
+	for(size_t i = 0; i < count; i++, data += XXH3_STRIPE_LENGTH)
+	{
+		XXH3_Accumulate512(acc, data, XXH3_SECRET + 8 * stripes);
+
+		if(++stripes == XXH3_STRIPES_PER_BLOCK)
+		{
+			XXH3_Scramble(acc);
+			stripes = 0;
+		}
+	}
+}
+
+/**
+ *  @brief 	Merges the accumulators into a 64 bit hash
+ */
+static hl_uint64 XXH3_Merge(const hl_uint64 acc[8], const hl_uint8* secret, hl_uint64 start)
+{
+	hl_uint64 result = start;
+
+	for(int i = 0; i < 4; i++)
+	{
+		result += XXH_Mul128Fold64(acc[2 * i] ^ XXH_Read64(secret + 16 * i),
+					   acc[2 * i + 1] ^ XXH_Read64(secret + 16 * i + 8));
+	}
+
+	return XXH3_Avalanche(result);
+}
+
+//----------------------------------------------------------------------
+//private member functions
+
+/**
+ *  @brief 	Accumulates whole stripes
+ *  @param	context The context to use
+ *  @param	data The stripes
+ *  @param	count The number of stripes
+ */
+void XXH3::XXH3_Accumulate(HL_XXH3_CTX* context, const hl_uint8* data, size_t count)
+{
+	XXH3_Accumulate_Stripes(context->acc, context->stripes, data, count);
+}
+
+/**
+ *  @brief 	Accumulates the stripes left and the last one
+ *  		into acc, leaving the context alone
+ *  @param	context The context to finish
+ *  @param	acc This OUT-Parameter receives the accumulators
+ */
+void XXH3::XXH3_Finish_Long(const HL_XXH3_CTX* context, hl_uint64 acc[8])
+{
+	hl_uint8 last[XXH3_STRIPE_LENGTH];
+	const hl_uint8* lastStripe = last;
+	size_t stripes = context->stripes;
+
+	memcpy(acc, context->acc, sizeof(context->acc));
+
+	if(context->buflen >= XXH3_STRIPE_LENGTH)
+	{
+		/*
+		 * the last stripe, even if whole, is left for
+		 * the different secret at the end
+		 */
+		XXH3_Accumulate_Stripes(acc, stripes, context->buffer, (context->buflen - 1) / XXH3_STRIPE_LENGTH);
+		lastStripe = context->buffer + context->buflen - XXH3_STRIPE_LENGTH;
+	}
+	else
+	{
+		/*
+		 * the last stripe starts in the one accumulated
+		 * before, kept at the end of the buffer
+		 */
+		const size_t before = XXH3_STRIPE_LENGTH - context->buflen;
+		memcpy(last, context->buffer + XXH3_BUFFER_LENGTH - before, before);
+		memcpy(last + before, context->buffer, context->buflen);
+	}
+
+	XXH3_Accumulate512(acc, lastStripe, XXH3_SECRET + XXH3_SECRET_LENGTH - XXH3_STRIPE_LENGTH - 7);
+}
+
+//----------------------------------------------------------------------
+//public member functions
+
+/**
+ *  @brief 	Initialize the context
+ *  @param	context The context to init.
+ */
+void XXH3::XXH3_Init(HL_XXH3_CTX* context)
+{
+	context->acc[0] = XXH_PRIME32_3;
+	context->acc[1] = XXH_PRIME64_1;
+	context->acc[2] = XXH_PRIME64_2;
+	context->acc[3] = XXH_PRIME64_3;
+	context->acc[4] = XXH_PRIME64_4;
+	context->acc[5] = XXH_PRIME32_2;
+	context->acc[6] = XXH_PRIME64_5;
+	context->acc[7] = XXH_PRIME32_1;
+	context->stripes = 0;
+	context->total = 0;
+	context->buflen = 0;
+}
+
+/**
+ *  @brief	Updates the context
+ *  @param	context The context to update.
+ *  @param	data The data for updating the context.
+ *  @param	len The length of the given data.
+ */
+void XXH3::XXH3_Update(HL_XXH3_CTX* context, const hl_uint8* data, size_t len)
+{
+	context->total += len;
+
+	/*
+	 * the whole input stays in the buffer while it may
+	 * still be hashed as a short one
+	 */
+	if(context->buflen + len <= XXH3_BUFFER_LENGTH)
+	{
+		memcpy(context->buffer + context->buflen, data, len);
+		context->buflen += len;
+		return;
+	}
+
+	/*
+	 * stripes are only accumulated when more data follows
+	 * them, since the last one is accumulated differently
+	 */
+	if(context->buflen > 0)
+	{
+		const size_t fill = XXH3_BUFFER_LENGTH - context->buflen;
+		memcpy(context->buffer + context->buflen, data, fill);
+		data += fill;
+		len -= fill;
+
+		XXH3_Accumulate(context, context->buffer, XXH3_BUFFER_LENGTH / XXH3_STRIPE_LENGTH);
+		context->buflen = 0;
+	}
+
+	if(len > XXH3_BUFFER_LENGTH)
+	{
+		const size_t count = (len - XXH3_BUFFER_LENGTH + XXH3_STRIPE_LENGTH - 1) / XXH3_STRIPE_LENGTH;
+		XXH3_Accumulate(context, data, count);
+		data += count * XXH3_STRIPE_LENGTH;
+		len -= count * XXH3_STRIPE_LENGTH;
+
+		memcpy(context->buffer + XXH3_BUFFER_LENGTH - XXH3_STRIPE_LENGTH, data - XXH3_STRIPE_LENGTH,
+		       XXH3_STRIPE_LENGTH);
+	}
+
+	memcpy(context->buffer, data, len);
+	context->buflen = len;
+}
+
+/**
+ *  @brief 	Finalize the operation with a XXH3-64 digest
+ *  @param	digest This OUT-Parameter receives the digest
+ *  @param	context The context to finalize.
+ */
+void XXH3::XXH3_64_Final(hl_uint8 digest[XXH3_DIGEST_LENGTH], HL_XXH3_CTX* context)
+{
+	if(context->total <= XXH3_MIDSIZE_MAX)
+	{
+		XXH_Write64BE(digest, XXH3_64_Short(context->buffer, context->buflen));
+		return;
+	}
+
+	hl_uint64 acc[8];
+	XXH3_Finish_Long(context, acc);
+	XXH_Write64BE(digest, XXH3_Merge(acc, XXH3_SECRET + 11, context->total * XXH_PRIME64_1));
+}
+
+/**
+ *  @brief 	Finalize the operation with a XXH128 digest
+ *  @param	digest This OUT-Parameter receives the digest
+ *  @param	context The context to finalize.
+ */
+void XXH3::XXH3_128_Final(hl_uint8 digest[XXH128_DIGEST_LENGTH], HL_XXH3_CTX* context)
+{
+	XXH3_Pair h;
+
+	if(context->total <= XXH3_MIDSIZE_MAX)
+	{
+		h = XXH128_Short(context->buffer, context->buflen);
+	}
+	else
+	{
+		hl_uint64 acc[8];
+		XXH3_Finish_Long(context, acc);
+		h.low = XXH3_Merge(acc, XXH3_SECRET + 11, context->total * XXH_PRIME64_1);
+		h.high = XXH3_Merge(acc, XXH3_SECRET + XXH3_SECRET_LENGTH - XXH3_STRIPE_LENGTH - 11,
+				    ~(context->total * XXH_PRIME64_2));
+	}
+
+	XXH_Write64BE(digest, h.high);
+	XXH_Write64BE(digest + 8, h.low);
+}
+
+//----------------------------------------------------------------------
+//EOF
@@ -0,0 +1,148 @@
+/*
+ * hashlib++ - a simple hash library for C++
+ *
+ * This file is an addition to hashlib++ and is distributed under
+ * the same license, see hl_hashwrapper.h for the full text.
+ */
+
+//----------------------------------------------------------------------
+
+/**
+ *  @file 	hl_xxhash.h
+ *  @brief	This file contains the declaration of the XXH3 class,
+ *  		which calculates XXH3-64 and XXH128
+ */
+
+//----------------------------------------------------------------------
+//include protection
+#ifndef XXHASH_H
+#define XXHASH_H
+
+//----------------------------------------------------------------------
+//length defines
+#define XXH3_DIGEST_LENGTH		8
+#define XXH128_DIGEST_LENGTH		16
+#define XXH3_STRIPE_LENGTH		64
+#define XXH3_BUFFER_LENGTH		256
+
+//----------------------------------------------------------------------
+//hashlib++ includes
+#include "hl_types.h"
+
+//----------------------------------------------------------------------
+//C includes
+#include <stddef.h>
+
+//----------------------------------------------------------------------
+
+/**
+ * @brief This struct represents a XXH3-hash context, the same
+ * 	  for both lengths of digest
+ */
+typedef struct HL_XXH3_CTX
+{
+	/**
+	 * accumulators of the stripes
+	 */
+	hl_uint64	acc[8];
+
+	/**
+	 * number of stripes accumulated since the last scramble
+	 */
+	size_t		stripes;
+
+	/**
+	 * number of bytes hashed
+	 */
+	hl_uint64	total;
+
+	/**
+	 * the bytes not accumulated yet. Its end keeps the last
+	 * stripe accumulated, needed when the input ends less
+	 * than a stripe after it.
+	 */
+	hl_uint8	buffer[XXH3_BUFFER_LENGTH];
+
+	/**
+	 * number of bytes in the buffer
+	 */
+	size_t		buflen;
+} HL_XXH3_CTX;
+
+//----------------------------------------------------------------------
+
+/**
+ *  @brief 	This class represents the implementation of the
+ *   		non-cryptographic XXH3 hashes of xxHash, with the
+ *   		default secret and seed, as xxhsum -H3 and -H2.
+ *
+ *   		Both digests are written in the canonical big
+ *   		endian order, XXH128 with its high half first.
+ *   		If you want to create a hash based on a string or
+ *   		file quickly you should use the xxh3wrapper and
+ *   		xxh128wrapper classes instead of XXH3.
+ */
+class XXH3
+{
+	private:
+
+		/**
+		 *  @brief 	Accumulates whole stripes
+		 *  @param	context The context to use
+		 *  @param	data The stripes
+		 *  @param	count The number of stripes
+		 */
+		void XXH3_Accumulate(HL_XXH3_CTX* context,
+				     const hl_uint8* data,
+				     size_t count);
+
+		/**
+		 *  @brief 	Accumulates the stripes left and the last one
+		 *  		into acc, leaving the context alone
+		 *  @param	context The context to finish
+		 *  @param	acc This OUT-Parameter receives the accumulators
+		 */
+		void XXH3_Finish_Long(const HL_XXH3_CTX* context,
+				      hl_uint64 acc[8]);
+
+	public:
+
+		/**
+		 *  @brief 	Initialize the context
+		 *  @param	context The context to init.
+		 */
+		void XXH3_Init(HL_XXH3_CTX* context);
+
+		/**
+		 *  @brief	Updates the context
+		 *  @param	context The context to update.
+		 *  @param	data The data for updating the context.
+		 *  @param	len The length of the given data.
+		 */
+		void XXH3_Update(HL_XXH3_CTX* context,
+				 const hl_uint8* data,
+				 size_t len);
+
+		/**
+		 *  @brief 	Finalize the operation with a XXH3-64 digest
+		 *  @param	digest This OUT-Parameter receives the digest
+		 *  @param	context The context to finalize.
+		 */
+		void XXH3_64_Final(hl_uint8 digest[XXH3_DIGEST_LENGTH],
+				   HL_XXH3_CTX* context);
+
+		/**
+		 *  @brief 	Finalize the operation with a XXH128 digest
+		 *  @param	digest This OUT-Parameter receives the digest
+		 *  @param	context The context to finalize.
+		 */
+		void XXH3_128_Final(hl_uint8 digest[XXH128_DIGEST_LENGTH],
+				    HL_XXH3_CTX* context);
+};
+
+//----------------------------------------------------------------------
+//end of include protection
+#endif
+
+//----------------------------------------------------------------------
+//EOF
@@ -9,6 +9,7 @@
 #include <iostream>
 #include <cassert>
 #include <memory>
+#include <vector>
 
 namespace ap = argparse;
 
@@ -38,14 +39,59 @@ namespace shazam {
         /* Setups the argument parser. */
         void setupArgparser();
 
-        /* Returns the hash sum type chosen by the user. */
-        std::string getHashType();
+        /* Returns the hash sum types chosen by the user. If `required`
+         * is true, exits with an error message when none was chosen. */
+        std::vector<std::string> getHashTypes(bool required = true);
+
+        /* Returns the options used to walk directories, chosen by the user. */
+        WalkOptions getWalkOptions();
+
+        /* Returns the io mode chosen by the user. */
+        EIOMode getIOMode();
+
+        /* Returns the number of buffers per file of the pipelined
+         * reads chosen by the user, exiting with an error message
+         * if it is out of range. */
+        std::size_t getReadBuffers();
+
+        /* Returns the number of requests in flight of the io_uring reads
+         * chosen by the user, exiting with an error message if it is out
+         * of range. */
+        unsigned int getQueueDepth();
+
+        /* Returns how the reads should use the page cache, as chosen by the user. */
+        EPageCacheMode getPageCacheMode();
+
+        /* Displays the cpu features detected and the hash
+         * kernels chosen for them. */
+        void displayCpuFeatures();
+
+        /* Displays the statistics of the run asked by the user, as text
+         * in the standard error and/or as JSON. The cache may be null. */
+        void displayStats(std::shared_ptr<HashCache> cache);
+
+        /* Verifies the files listed in the manifest at `path`, or in the
+         * standard input if it is "-", and returns the exit status. */
+        int verifyManifest(const std::string& path);
 
         /* Activates the argument parser to parse the arguments. */
         void parseArguments(const int& argc, const char* const*& argv);
 
-        /* Gets the files given by the user and adds them to the checker. */
-        void getAndRegisterInputFiles(std::string hashType);
+        /* Returns the files given by the user, exiting with an error
+         * message if there are none and no list of files was given. */
+        std::vector<std::string> getInputFiles();
+
+        /* Adds the files given by the user to the checker. */
+        void registerInputFiles(const std::vector<std::string>& files, std::vector<std::string> hashTypes);
+
+        /* Opens the file of --tee, which the only input file given is copied
+         * to while hashed, and returns its descriptor, or -1 if there is none.
+         * Exits with an error message if it can't be used. */
+        int openTee(const std::vector<std::string>& files, const std::vector<std::string>& hashTypes);
+
+        /* Hashes the given files, followed by the ones listed in the file
+         * of --files-from, if any, which are read while being hashed. */
+        void hashInputFiles(const std::vector<std::string>& files, const std::vector<std::string>& hashTypes);
     };
 }
 
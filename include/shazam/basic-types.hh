@@ -1,7 +1,11 @@
 #ifndef _SHAZAM_BASIC_TYPES_HEADER
 #define _SHAZAM_BASIC_TYPES_HEADER
 
+#include "./digest.hh"
+
 #include <string>
+#include <array>
+#include <cstddef>
 #include <memory>
 
 namespace shazam {
@@ -23,24 +27,39 @@ namespace shazam {
     struct HashSum {
       const std::string filename;
       const std::string hashType;
-      const std::string hashSum;
+      const Digest hashSum;
     };
 
     /* The result of the hash sum comparation */
     struct FileHashSumComparationResult {
         const std::string filename;
         const std::string hashType;
-        const std::string originalHashSum;
-        const std::string currentHashSum;
+        const Digest originalHashSum;
+        const Digest currentHashSum;
         const ComparationResult result;
     };
 
     /* Constant array with the types of hash sums supported
      * by this program.
      * */
-    constexpr std::array<const char*, 5> HASH_TYPES = {
-        "MD5",  "SHA1",  "SHA256", "SHA384",  "SHA512"
+    constexpr std::array<const char*, 10> HASH_TYPES = {
+        "MD5",  "SHA1",  "SHA256", "SHA384",  "SHA512",
+        "BLAKE2B", "BLAKE3", "XXH3", "XXH128", "SHA256-TREE"
+    };
+
+    /* Size in bytes of the digests of each hash type, in the
+     * same order as HASH_TYPES.
+     * */
+    constexpr std::array<std::size_t, 10> HASH_DIGEST_SIZES = {
+        16,  20,  32,  48,  64,
+        64,  32,  8,   16,  32
     };
+
+    /* Number of hash types, at the start of HASH_TYPES, calculated by
+     * reading the file from its start to its end. The ones after them
+     * are the tree hashes, whose chunks are hashed in parallel.
+     * */
+    constexpr std::size_t STREAM_HASH_TYPES = 9;
 };
 
 #endif /* _SHAZAM_BASIC_TYPES_HEADER */
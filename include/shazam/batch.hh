@@ -0,0 +1,49 @@
+#ifndef _SHAZAM_BATCH_HEADER
+#define _SHAZAM_BATCH_HEADER
+
+#include "./hash.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace shazam {
+    /* Files up to this size can be hashed by BatchHasher. */
+    constexpr std::uintmax_t BATCH_MAX_FILE_SIZE = 16 * 1024;
+
+    /* Number of lane groups hashed by each batch task, so that a
+     * task is big enough to amortize its scheduling. */
+    constexpr std::size_t BATCH_GROUPS_PER_TASK = 4;
+
+    /* Hashes small files together, one file per lane of the vector
+     * registers, instead of one after the other. For files of a few
+     * kilobytes the time goes to the serial compression of each
+     * block, which the multi-buffer kernels spread over the lanes.
+     * */
+    class BatchHasher {
+    public:
+        /* Returns true if the calculator can be part of a batch, that is,
+         * its file is small and all of its hash types are faster when
+         * calculated together with other files. Streams and the files
+         * copied to a tee are read on their own. */
+        static bool accepts(HashCalculator& hash);
+
+        /* Returns true if a file of the given size and hash types can be
+         * part of a batch. */
+        static bool accepts(std::uintmax_t size, const std::vector<std::string>& types);
+
+        /* Returns the number of files hashed at once. */
+        static std::size_t lanes(void);
+
+        /* Calculates the hash sums of the given calculators, which must
+         * all have the same hash types, unless they are in the cache. Each
+         * file is read whole into memory. Throws std::runtime_error if a
+         * file can't be read.
+         * */
+        static void calculate(const std::vector<std::shared_ptr<HashCalculator>>& batch);
+    };
+};
+
+#endif /* _SHAZAM_BATCH_HEADER */
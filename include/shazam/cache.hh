@@ -0,0 +1,120 @@
+#ifndef _SHAZAM_CACHE_HEADER
+#define _SHAZAM_CACHE_HEADER
+
+#include "./digest.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace shazam {
+    /* A record of the cache file. The records have a fixed size and are
+     * stored in the native byte order right after the header, so the
+     * file can be mapped and read in place. The checksum covers the whole
+     * record, with the checksum itself set to zero, so a record torn by
+     * a crash during an append is detected and ignored.
+     * */
+    struct CacheRecord {
+        std::uint64_t device;
+        std::uint64_t inode;
+        std::uint64_t size;
+        std::int64_t mtimeNs;
+        std::int64_t ctimeNs;
+        std::uint8_t algorithm;
+        std::uint8_t digestSize;
+        std::uint8_t reserved[2];
+        std::uint32_t checksum;
+        unsigned char digest[64];
+    };
+
+    /* The header at the start of the cache file. */
+    struct CacheHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t recordSize;
+    };
+
+    /* Minimum number of superseded records before the cache file is compacted. */
+    constexpr std::size_t CACHE_MIN_DEAD_RECORDS = 1024;
+
+    /* Persistent cache of hash sums, keyed by the device, inode, size,
+     * modification and change times of the files and the hash type. A
+     * file whose attributes didn't change since it was hashed gets its
+     * hash sum from the cache, which only costs a stat call.
+     *
+     * New hash sums are appended to the file. When the superseded records
+     * outnumber the live ones, or the file is damaged, it is rewritten to
+     * a temporary file which replaces it atomically.
+     * */
+    class HashCache {
+        struct Key {
+            std::uint64_t device;
+            std::uint64_t inode;
+            std::uint8_t algorithm;
+
+            bool operator==(const Key& other) const;
+        };
+
+        struct KeyHash {
+            std::size_t operator()(const Key& key) const;
+        };
+
+        const std::string path;
+        std::mutex mutex;
+        std::unordered_map<Key, CacheRecord, KeyHash> records;
+        std::vector<CacheRecord> appended;
+        std::size_t deadRecords;
+        bool needsRewrite;
+
+        std::atomic<std::size_t> hits;
+        std::atomic<std::size_t> misses;
+
+    public:
+        /* Loads the cache at `path`. A missing or damaged file is not an
+         * error, the cache is then created or rewritten on save(). */
+        explicit HashCache(std::string path);
+
+        HashCache(const HashCache&) = delete;
+        HashCache& operator=(const HashCache&) = delete;
+
+        /* Looks up the digest of the hash type at the position `algorithm`
+         * of HASH_TYPES for the file with the given attributes, returning
+         * false if it isn't cached. */
+        bool lookup(const struct stat& filestat, std::size_t algorithm, Digest& digest);
+
+        /* Stores the digest for the file with the given attributes, under
+         * the hash type it is tagged with. */
+        void store(const struct stat& filestat, const Digest& digest);
+
+        /* Writes the new hash sums to the cache file. Throws
+         * std::runtime_error if the file can't be written. */
+        void save();
+
+        /* Returns the number of lookups that found a hash sum. */
+        std::size_t getHits() const;
+
+        /* Returns the number of lookups that didn't find a hash sum. */
+        std::size_t getMisses() const;
+
+    private:
+        /* Maps the cache file and loads its records. */
+        void load();
+
+        /* Adds a record, replacing the older one for the same file. */
+        void insert(const CacheRecord& record);
+
+        /* Appends the new records to the cache file. */
+        void append();
+
+        /* Writes all the live records to a new cache file. */
+        void rewrite();
+    };
+};
+
+#endif /* _SHAZAM_CACHE_HEADER */
@@ -2,27 +2,78 @@
 #define _SHAZAM_CHECKER_HEADER
 
 #include "./common.hh"
+#include "./device.hh"
 #include "./files.hh"
 #include "./hash.hh"
+#include "./output.hh"
+#include "./pool.hh"
+#include "./walker.hh"
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <list>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
 
 namespace shazam {
+    /* Number of groups of files per thread that can be waiting to run or
+     * to be written, which bounds the memory used while streaming. */
+    constexpr std::size_t STREAM_TASKS_PER_THREAD = 8;
+
+    /* Gives the paths to be hashed one at a time, writing the next one
+     * into its argument and returning false once there are no more. */
+    using PathSource = std::function<bool(std::string&)>;
+
     /* The hash checker. */
     class Checker {
+        /* A directory tree to be walked, whose files are placed in the
+         * results at the position the tree was added. */
+        struct Tree {
+            std::string root;
+            std::vector<std::string> hashtypes;
+            std::size_t position;
+        };
+
+        /* A task reading from the device numbered as in st_dev. */
+        using DeviceTask = std::pair<std::uint64_t, std::function<void(void)>>;
+
         bool showProgressBar;
         bool showInvalidFiles;
+        bool unordered;
+        unsigned int jobs;
+        unsigned int rotationalJobs;
         const std::shared_ptr<ProgressObserver> progress;
-        std::list<std::shared_ptr<HashCalculator>> validFilesHashes;
+        /* The valid files, one row each, with the hash types and the
+         * digests of every row kept in flat arrays along the table. The
+         * digests of a row are stored one after the other, in the order
+         * of its types. */
+        FileTable validFiles;
+        std::vector<std::vector<std::string>> typeSets;
+        std::vector<std::vector<std::size_t>> typeSetIndexes;
+        std::vector<std::uint16_t> fileTypes;
+        std::vector<unsigned char> digests;
+        std::vector<std::size_t> digestOffsets;
+        std::vector<std::uint8_t> failedRows;
+        std::size_t calculatedRows;
+        /* The rows in the order they are displayed, empty while it is
+         * the order of the table. */
+        std::vector<std::size_t> displayOrder;
         std::list<std::shared_ptr<File>> invalidFilesList;
         HashFactory hashFactory;
+        std::vector<Tree> trees;
+        WalkOptions walkOptions;
+        std::mutex listsMutex;
 
     public:
         Checker(bool showProgressBar, bool showInvalidFiles)
         : showProgressBar(showProgressBar), showInvalidFiles(showInvalidFiles),
-        progress(std::make_shared<ProgressObserver>(40)) {  }
+        unordered(false), jobs(onlineCpus()), rotationalJobs(ROTATIONAL_DEVICE_JOBS), progress(std::make_shared<ProgressObserver>(40)),
+        calculatedRows(0) {  }
 
         Checker(): Checker(false, true) {  }
 
@@ -35,9 +86,85 @@ namespace shazam {
         /* Adds a new file to the checker. */
         void add(std::shared_ptr<File> file, std::string hashtype);
 
-        /* Calcultes the hash sums.  */
+        /* Adds a new file to the checker, to calculate all the given
+         * hash types while reading it only once. */
+        void add(std::shared_ptr<File> file, std::vector<std::string> hashtypes);
+
+        /* Adds a directory tree to the checker. The tree is walked by
+         * calculateHashSums, and its files are hashed while the walk
+         * goes on. They are placed in the results sorted by path.
+         * */
+        void addTree(std::string root, std::vector<std::string> hashtypes);
+
+        /* Sets the options used to walk the trees. */
+        void setWalkOptions(WalkOptions options);
+
+        /* Calcultes the hash sums, using up to `jobs` threads.
+         * Each device has its own queue: the files of a spinning disk
+         * are read one at a time, in the order they are laid out on
+         * it, while the other devices read `jobs` of them at once, the
+         * bigger files first, so that one huge file doesn't end up
+         * being the last one calculated. Small files are left to the
+         * end and hashed in batches. The chunks of the tree hash are
+         * and the subtrees of BLAKE3 are hashed by `jobs` threads
+         * only when there is a single file, or batch, to hash, as
+         * otherwise the threads are busy with the other files.
+         * */
         void calculateHashSums();
 
+        /* Calculates the hash sums of the files at the given paths, walking
+         * them if `recursive`, and writes them to `out` as soon as they are
+         * ready, in the order of the paths unless unordered. Only a window
+         * of groups is kept in memory, so it doesn't grow with the number
+         * of files. The files of a walked tree are sorted by path, so when
+         * ordered they are written once the whole tree is hashed.
+         *
+         * The files are validated as they are given, the small ones put
+         * in groups and the others alone. Half a window of groups at a
+         * time is hashed in the order of calculateHashSums, the files of
+         * the spinning disks as laid out on them and the biggest first on
+         * the other devices, through one queue per device.
+         *
+         * Each file is hashed by a single thread, tree hash and BLAKE3
+         * included, as the others are busy with the rest of the window.
+         *
+         * The invalid files are kept, to be shown by displayResults.
+         * */
+        void streamHashSums(const std::vector<std::string>& paths, std::vector<std::string> hashtypes,
+                            bool recursive, std::ostream& out);
+
+        /* Same as above, with the paths taken from `nextPath` while the
+         * files already given are hashed. The next paths are only asked
+         * for while the window of groups has room, so a list of any length
+         * can be hashed, as it is read, with bounded memory.
+         * */
+        void streamHashSums(const PathSource& nextPath, std::vector<std::string> hashtypes,
+                            bool recursive, std::ostream& out);
+
+        /* If set to true, streamHashSums writes the hash sums in the
+         * order they are calculated. */
+        void setUnordered(bool value);
+
+        /* Sets the number of threads used to calculate the hash sums. */
+        void setJobs(unsigned int value);
+
+        /* Sets the number of files read at once from each spinning disk. */
+        void setRotationalJobs(unsigned int value);
+
+        /* Sets the strategy used to read the files added from now on, the
+         * number of buffers of the pipelined reads and the requests in
+         * flight of the io_uring reads, and how the reads use the page cache. */
+        void setIOMode(EIOMode mode, std::size_t buffers = PIPELINE_DEFAULT_BUFFERS,
+                       unsigned int queueDepth = URING_DEFAULT_DEPTH, EPageCacheMode pageCache = PAGE_CACHE_KEEP);
+
+        /* Sets the cache of hash sums used by the files added from now on. */
+        void setCache(std::shared_ptr<HashCache> cache);
+
+        /* Sets the descriptor the files added from now on are copied to
+         * while they are read, or -1 for none. The caller keeps it open
+         * until they are hashed. */
+        void setTee(int descriptor);
+
         /* Changes the showProgressBar attr definition.
          * If set to true, the progress bar will be shown to the
          * user during the execution, if false, it won't be shown.
@@ -54,11 +181,63 @@ namespace shazam {
         void displayResults();
 
     private:
-        /* Displays the valid hashes as a result. */
+        /* Displays the valid hashes as a result. When more than one
+         * type of hash sum was calculated, they are displayed in
+         * separated sections, one per type. */
         void displayValidHashes();
 
         /* Displays invalid files, if showInvalidFiles is true. */
         void displayInvalidFiles();
+
+        /* Sets the number of threads that hash the parts of a single
+         * file, the chunks of the tree hash and the subtrees of BLAKE3. */
+        void setFileThreads(unsigned int threads);
+
+        /* Runs the tasks and walks the trees on a thread pool, hashing the
+         * files found as tasks of the same pool. */
+        void calculateWithTrees(std::vector<DeviceTask>& tasks);
+
+        /* Calculates the hash sums of a file, returning false and adding
+         * it to the invalid files if it can't be read. */
+        bool calculateHash(std::shared_ptr<HashCalculator> hash);
+
+        /* Calculates the hash sums of a file, adding them to `results`, or
+         * the file to the invalid ones if it can't be read. */
+        void collectHashSums(std::shared_ptr<HashCalculator> hash, ResultGroup& results);
+
+        /* Hashes the given files, the small ones together, returning their
+         * results in order. The invalid ones are returned as they are. */
+        ResultGroup hashGroup(const std::vector<std::shared_ptr<File>>& files, const std::vector<std::string>& hashtypes);
+
+        /* Walks the tree at `root` on the pool, writing the hash sums of its
+         * files as group number `group`, sorted by path, or as they come
+         * when unordered. Its files are read through the queue of `device`.
+         * Returns at once, `written` is called once the group is written.
+         * The walker is added to `walkers`, which must outlive the pool tasks. */
+        void streamTree(WorkStealingPool& pool, DeviceScheduler& scheduler, std::uint64_t device,
+                        ResultWriter& writer, std::size_t group, const std::string& root,
+                        const std::vector<std::string>& hashtypes, std::vector<std::unique_ptr<TreeWalker>>& walkers,
+                        std::function<void(void)> written);
+
+        /* Hashes the files of the given rows, all with the same hash
+         * types, storing their digests. Several rows are hashed together
+         * by the batch hasher. */
+        void hashRows(const std::vector<std::size_t>& rows);
+
+        /* Returns the index of the given hash types in typeSets, adding
+         * them if needed. Throws std::invalid_argument if a type is unknown. */
+        std::size_t typeSetIndex(const std::vector<std::string>& hashtypes);
+
+        /* Adds the types and room for the digests of the row just added
+         * to the file table. */
+        void addRow(std::size_t types);
+
+        /* Stores the hash sums calculated for a row. */
+        void storeHashSums(std::size_t row, HashCalculator& hash);
+
+        /* Calls `visit` with the rows of the files that could be hashed,
+         * in the order they are displayed. */
+        void forEachValidFile(const std::function<void(std::size_t)>& visit);
     };
 };
 
@@ -1,17 +1,34 @@
 #ifndef _SHAZAM_COMMON_HEADER
 #define _SHAZAM_COMMON_HEADER
 
-#include "../external/ProgressBar.hpp"
+#include "./basic-types.hh"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <memory>
-
-namespace pgs = progresscpp;
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace shazam {
     /* Converts and hexadecimal value to integer. */
     unsigned long long hexaToInt(std::string hexadecimalString);
 
+    /* Decodes an hexadecimal string into `bytes`, returning false
+     * if it has an odd length or a non hexadecimal character. */
+    bool hexToBytes(const std::string& hexadecimalString, std::vector<unsigned char>& bytes);
+
+    /* Encodes `len` bytes as a lowercase hexadecimal string. */
+    std::string bytesToHex(const unsigned char* bytes, std::size_t len);
+
+    /* Returns the position of the hash type with the given name in
+     * HASH_TYPES, ignoring the case, or HASH_TYPES.size() if unknown. */
+    std::size_t hashTypeIndex(const std::string& name);
+
     /* Returns the input str as an uppercase output. */
     std::string toUpperCase(std::string str);
 
@@ -21,24 +38,50 @@ namespace shazam {
     /* Prints an error message and exits. */
     void printErrMessage(const std::string& message);
 
-    /* Observes the progress of the tasks being completed. */
+    /* Time between two redraws of the progress bar, in milliseconds. */
+    constexpr int PROGRESS_REFRESH_MS = 100;
+
+    /* Observes the progress of the tasks being completed, in tasks and in
+     * bytes. Its counters are atomic, so the hashing threads update them
+     * without locks, even from inside their read loops, and the bar is
+     * redrawn by a ticker thread at a fixed rate, not on every update.
+     * */
     class ProgressObserver {
     private:
         const int progressWidth;
 
-        int activeObservables;
+        std::atomic<int> activeObservables;
+
+        std::atomic<int> completedObservables;
+
+        std::atomic<std::uint64_t> expectedBytes;
+
+        std::atomic<std::uint64_t> processedBytes;
+
+        std::chrono::steady_clock::time_point startTime;
+
+        std::mutex tickerMutex;
 
-        std::unique_ptr<pgs::ProgressBar>
-        progressBar;
+        std::condition_variable tickerStop;
+
+        std::thread ticker;
+
+        bool stopping;
 
     public:
-        /* Initializes the progress bar. */
+        /* Initializes the progress bar and starts redrawing it. */
         void init();
 
-        /* Updates the progress bar. */
+        /* Marks one of the observed tasks as completed. */
         void update();
 
-        /* Terminates the progress bar. */
+        /* Adds bytes processed by the observed tasks. */
+        void advance(std::uint64_t bytes);
+
+        /* Adds an observed task, which will process `bytes`. */
+        void expect(std::uint64_t bytes);
+
+        /* Stops redrawing and terminates the progress bar. */
         void done();
 
         /* Increases the number of observables tasks. */
@@ -47,25 +90,43 @@ namespace shazam {
         /* Returns the current number of observables tasks. */
         int getObservablesNumber();
 
+        /* Returns the number of bytes processed so far. */
+        std::uint64_t getProcessedBytes();
+
         /* Receives the `progressWidth` param which represents
          * the width of the progress bar that is shown to the user.
          * */
         ProgressObserver(int progressWidth)
-        : progressWidth(progressWidth), activeObservables(0) {  }
+        : progressWidth(progressWidth), activeObservables(0), completedObservables(0),
+        expectedBytes(0), processedBytes(0), stopping(false) {  }
+
+        /* Stops the ticker, if it is still running. */
+        ~ProgressObserver();
 
     private:
         /* Decreases the number of observables tasks. */
         void decreaseObervableCounter();
+
+        /* Draws the progress bar, with the throughput and the
+         * estimated time left. */
+        void display();
+
+        /* Stops the ticker thread and waits for it. */
+        void stopTicker();
     };
 
     class IAmObservable {
         std::shared_ptr<ProgressObserver> observer;
     public:
-        /* Sets the observer for this observable class. */
+        /* Sets the observer for this observable class. The observer
+         * must have been told to expect() it. */
         virtual void setObserver(std::shared_ptr<ProgressObserver> observer);
 
         /* Notifies the observer about a change on the state. */
         virtual void notifyObserver(void);
+
+        /* Notifies the observer that `bytes` more were processed. */
+        virtual void notifyProgress(std::uint64_t bytes);
     };
 };
 
@@ -0,0 +1,85 @@
+#ifndef _SHAZAM_DEVICE_HEADER
+#define _SHAZAM_DEVICE_HEADER
+
+#include "./pool.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace shazam {
+    /* Default number of files read at once from a spinning disk. Reading
+     * more of them in parallel moves the head back and forth between them,
+     * which is slower than reading them one after the other. */
+    constexpr unsigned int ROTATIONAL_DEVICE_JOBS = 1;
+
+    /* Position given to the files whose place on the disk is unknown. */
+    constexpr std::uint64_t UNKNOWN_PHYSICAL_OFFSET = UINT64_MAX;
+
+    /* Returns true if the block device numbered `device`, as in st_dev,
+     * is a spinning disk, as told by its queue/rotational in /sys/dev/block,
+     * or the one of the disk holding it when it is a partition. The devices
+     * without one, such as tmpfs, network file systems or btrfs volumes,
+     * are taken as not rotational. The answers are cached.
+     * */
+    bool isRotationalDevice(std::uint64_t device);
+
+    /* Returns the physical offset of the first extent of the open file,
+     * found out through FIEMAP, or UNKNOWN_PHYSICAL_OFFSET if the file
+     * system doesn't tell or the file has no extents. */
+    std::uint64_t physicalOffset(int descriptor);
+
+    /* Runs tasks on a shared thread pool with one queue per device, each
+     * running at most a given number of its tasks at once: `rotationalJobs`
+     * for the spinning disks and `jobs` for the others. The tasks of a
+     * device are started in the order they were submitted.
+     *
+     * A device has as many lanes in the pool as the tasks it runs at once.
+     * A lane runs one task and then goes back to the end of the pool with
+     * the next one, so the workers are shared by every device and a slow
+     * disk never keeps them from reading the others.
+     *
+     * The scheduler has to outlive the pool tasks it submits.
+     * */
+    class DeviceScheduler {
+        using Task = std::function<void(void)>;
+
+        struct Queue {
+            unsigned int limit;
+            unsigned int lanes;
+            std::deque<Task> tasks;
+        };
+
+        const unsigned int jobs;
+        const unsigned int rotationalJobs;
+        std::mutex mutex;
+        std::unordered_map<std::uint64_t, Queue> queues;
+
+    public:
+        explicit DeviceScheduler(unsigned int jobs, unsigned int rotationalJobs = ROTATIONAL_DEVICE_JOBS);
+
+        DeviceScheduler(const DeviceScheduler&) = delete;
+        DeviceScheduler& operator=(const DeviceScheduler&) = delete;
+
+        /* Schedules a task reading from `device` to be run by `pool`. */
+        void submit(WorkStealingPool& pool, std::uint64_t device, Task task);
+
+        /* Sets the number of tasks of `device` run at once, instead of
+         * the one chosen from the kind of the device. */
+        void setLimit(std::uint64_t device, unsigned int limit);
+
+    private:
+        /* Returns the queue of `device`, creating it if needed. Must be
+         * called with the mutex locked. */
+        Queue& queue(std::uint64_t device);
+
+        /* Runs a task of `device` on one of its lanes, then hands the
+         * lane over to the next task queued, if there is one. */
+        void runLane(WorkStealingPool& pool, std::uint64_t device, const Task& task);
+    };
+};
+
+#endif /* _SHAZAM_DEVICE_HEADER */
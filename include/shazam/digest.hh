@@ -0,0 +1,96 @@
+#ifndef _SHAZAM_DIGEST_HEADER
+#define _SHAZAM_DIGEST_HEADER
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+
+namespace shazam {
+    /* A digest kept as bytes, tagged with the position of its hash type
+     * in HASH_TYPES. It is only converted to hexadecimal when written,
+     * so that comparing, caching and storing digests never goes through
+     * strings. The bytes past size() are always zero.
+     * */
+    class Digest {
+    public:
+        /* Length of the longest digest, the one of SHA512. */
+        static constexpr std::size_t MAX_SIZE = 64;
+
+        /* The tag of the digests whose hash type isn't known. */
+        static constexpr std::uint8_t UNKNOWN_TYPE = 0xff;
+
+    private:
+        std::array<unsigned char, MAX_SIZE> bytes;
+        std::uint8_t length;
+        std::uint8_t algorithm;
+
+    public:
+        /* An empty digest, which matches no other digest. */
+        Digest(): bytes{}, length(0), algorithm(UNKNOWN_TYPE) {  }
+
+        /* Copies `len` bytes of `data`. Throws std::invalid_argument if
+         * they are more than MAX_SIZE. */
+        Digest(std::size_t algorithm, const unsigned char* data, std::size_t len);
+
+        /* Decodes a digest written in hexadecimal, in either case. Returns
+         * an empty digest if it is malformed or too long. */
+        static Digest fromHex(std::size_t algorithm, const std::string& hex);
+
+        /* Writes `len` bytes as lowercase hexadecimal into `hex`, which
+         * must have room for 2 * len characters. */
+        static void writeHex(const unsigned char* data, std::size_t len, char* hex);
+
+        /* Returns the position of the hash type in HASH_TYPES. */
+        std::size_t type() const { return algorithm; }
+
+        /* Returns the bytes of the digest. */
+        const unsigned char* data() const { return bytes.data(); }
+
+        /* Returns the number of bytes of the digest. */
+        std::size_t size() const { return length; }
+
+        /* Returns true if the digest has no bytes. */
+        bool empty() const { return length == 0; }
+
+        /* Writes the digest as lowercase hexadecimal into `hex`, which
+         * must have room for 2 * size() characters. */
+        void toHex(char* hex) const { writeHex(bytes.data(), length, hex); }
+
+        /* Returns the digest as a lowercase hexadecimal string. */
+        std::string toHex() const;
+
+        /* Digests are equal when they have the same type and bytes. */
+        bool operator==(const Digest& other) const
+        {
+            return algorithm == other.algorithm && length == other.length
+                && std::memcmp(bytes.data(), other.bytes.data(), length) == 0;
+        }
+
+        bool operator!=(const Digest& other) const { return !(*this == other); }
+
+        /* Orders the digests by type, then by their bytes. */
+        bool operator<(const Digest& other) const;
+
+        /* Returns the hash of the digest, to be used as a key. The bytes
+         * of a digest are already uniformly distributed, so its first
+         * word is as good as any mix of them. */
+        std::size_t hash() const
+        {
+            std::size_t value;
+            std::memcpy(&value, bytes.data(), sizeof(value));
+            return value ^ algorithm;
+        }
+    };
+};
+
+namespace std {
+    template <>
+    struct hash<shazam::Digest> {
+        std::size_t operator()(const shazam::Digest& digest) const noexcept { return digest.hash(); }
+    };
+};
+
+#endif /* _SHAZAM_DIGEST_HEADER */
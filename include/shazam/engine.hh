@@ -0,0 +1,242 @@
+#ifndef _SHAZAM_ENGINE_HEADER
+#define _SHAZAM_ENGINE_HEADER
+
+#include "./basic-types.hh"
+
+#include "../external/hashlib2plus/hl_blake2b.h"
+#include "../external/hashlib2plus/hl_blake3.h"
+#include "../external/hashlib2plus/hl_md5.h"
+#include "../external/hashlib2plus/hl_sha1.h"
+#include "../external/hashlib2plus/hl_sha256.h"
+#include "../external/hashlib2plus/hl_sha2ext.h"
+#include "../external/hashlib2plus/hl_xxhash.h"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <variant>
+
+namespace shazam {
+    /* The hash engines hold the hashlib2plus implementation of an algorithm
+     * and its context, with the start(), update() and finish() of hashwrapper
+     * but none of them virtual. Code templated on an engine calls the
+     * implementation directly, so nothing is dispatched per block, and
+     * the engines live on the stack of the code that hashes.
+     *
+     * TYPE is the position of the algorithm in HASH_TYPES, and DIGEST_SIZE
+     * the number of bytes written by finish().
+     * */
+    class MD5Engine {
+        MD5 md5;
+        HL_MD5_CTX context;
+
+    public:
+        static constexpr std::size_t TYPE = 0;
+        static constexpr std::size_t DIGEST_SIZE = 16;
+
+        void start() { md5.MD5Init(&context); }
+
+        void update(const unsigned char* data, std::size_t len)
+        {
+            md5.MD5Update(&context, const_cast<unsigned char*>(data), len);
+        }
+
+        std::size_t finish(unsigned char* digest)
+        {
+            md5.MD5Final(digest, &context);
+            return DIGEST_SIZE;
+        }
+    };
+
+    class SHA1Engine {
+        SHA1 sha1;
+        HL_SHA1_CTX context;
+
+    public:
+        static constexpr std::size_t TYPE = 1;
+        static constexpr std::size_t DIGEST_SIZE = SHA1HashSize;
+
+        void start() { sha1.SHA1Reset(&context); }
+
+        void update(const unsigned char* data, std::size_t len) { sha1.SHA1Input(&context, data, len); }
+
+        std::size_t finish(unsigned char* digest)
+        {
+            sha1.SHA1Result(&context, digest);
+            return DIGEST_SIZE;
+        }
+    };
+
+    class SHA256Engine {
+        SHA256 sha256;
+        HL_SHA256_CTX context;
+
+    public:
+        static constexpr std::size_t TYPE = 2;
+        static constexpr std::size_t DIGEST_SIZE = SHA256_DIGEST_LENGTH;
+
+        void start() { sha256.SHA256_Init(&context); }
+
+        void update(const unsigned char* data, std::size_t len) { sha256.SHA256_Update(&context, data, len); }
+
+        std::size_t finish(unsigned char* digest)
+        {
+            sha256.SHA256_Final(digest, &context);
+            return DIGEST_SIZE;
+        }
+    };
+
+    class SHA384Engine {
+        SHA2ext sha2;
+        HL_SHA_384_CTX context;
+
+    public:
+        static constexpr std::size_t TYPE = 3;
+        static constexpr std::size_t DIGEST_SIZE = SHA384_DIGEST_LENGTH;
+
+        void start() { sha2.SHA384_Init(&context); }
+
+        void update(const unsigned char* data, std::size_t len) { sha2.SHA384_Update(&context, data, len); }
+
+        std::size_t finish(unsigned char* digest)
+        {
+            sha2.SHA384_Final(digest, &context);
+            return DIGEST_SIZE;
+        }
+    };
+
+    class SHA512Engine {
+        SHA2ext sha2;
+        HL_SHA512_CTX context;
+
+    public:
+        static constexpr std::size_t TYPE = 4;
+        static constexpr std::size_t DIGEST_SIZE = SHA512_DIGEST_LENGTH;
+
+        void start() { sha2.SHA512_Init(&context); }
+
+        void update(const unsigned char* data, std::size_t len) { sha2.SHA512_Update(&context, data, len); }
+
+        std::size_t finish(unsigned char* digest)
+        {
+            sha2.SHA512_Final(digest, &context);
+            return DIGEST_SIZE;
+        }
+    };
+
+    class Blake2bEngine {
+        BLAKE2b blake2b;
+        HL_BLAKE2B_CTX context;
+
+    public:
+        static constexpr std::size_t TYPE = 5;
+        static constexpr std::size_t DIGEST_SIZE = BLAKE2B_DIGEST_LENGTH;
+
+        void start() { blake2b.BLAKE2b_Init(&context); }
+
+        void update(const unsigned char* data, std::size_t len) { blake2b.BLAKE2b_Update(&context, data, len); }
+
+        std::size_t finish(unsigned char* digest)
+        {
+            blake2b.BLAKE2b_Final(digest, &context);
+            return DIGEST_SIZE;
+        }
+    };
+
+    class Blake3Engine {
+        BLAKE3 blake3;
+        HL_BLAKE3_CTX context;
+
+    public:
+        static constexpr std::size_t TYPE = 6;
+        static constexpr std::size_t DIGEST_SIZE = BLAKE3_DIGEST_LENGTH;
+
+        void start() { blake3.BLAKE3_Init(&context); }
+
+        void update(const unsigned char* data, std::size_t len) { blake3.BLAKE3_Update(&context, data, len); }
+
+        std::size_t finish(unsigned char* digest)
+        {
+            blake3.BLAKE3_Final(digest, &context);
+            return DIGEST_SIZE;
+        }
+    };
+
+    class XXH3Engine {
+        XXH3 xxh3;
+        HL_XXH3_CTX context;
+
+    public:
+        static constexpr std::size_t TYPE = 7;
+        static constexpr std::size_t DIGEST_SIZE = XXH3_DIGEST_LENGTH;
+
+        void start() { xxh3.XXH3_Init(&context); }
+
+        void update(const unsigned char* data, std::size_t len) { xxh3.XXH3_Update(&context, data, len); }
+
+        std::size_t finish(unsigned char* digest)
+        {
+            xxh3.XXH3_64_Final(digest, &context);
+            return DIGEST_SIZE;
+        }
+    };
+
+    class XXH128Engine {
+        XXH3 xxh3;
+        HL_XXH3_CTX context;
+
+    public:
+        static constexpr std::size_t TYPE = 8;
+        static constexpr std::size_t DIGEST_SIZE = XXH128_DIGEST_LENGTH;
+
+        void start() { xxh3.XXH3_Init(&context); }
+
+        void update(const unsigned char* data, std::size_t len) { xxh3.XXH3_Update(&context, data, len); }
+
+        std::size_t finish(unsigned char* digest)
+        {
+            xxh3.XXH3_128_Final(digest, &context);
+            return DIGEST_SIZE;
+        }
+    };
+
+    /* An engine of any of the hash types, for when several types are
+     * calculated together. The engine is picked at run time, by a jump
+     * table, but each of them is still updated by a direct call. */
+    using AnyEngine = std::variant<MD5Engine, SHA1Engine, SHA256Engine, SHA384Engine, SHA512Engine,
+                                   Blake2bEngine, Blake3Engine, XXH3Engine, XXH128Engine>;
+
+    static_assert(std::variant_size_v<AnyEngine> == STREAM_HASH_TYPES, "One engine per streamed hash type");
+
+    /* Calls `run` with a new engine of the hash type at the position `type`
+     * of HASH_TYPES, the type of the engine being known at compile time
+     * inside `run`, and returns its result. Throws std::invalid_argument
+     * if the type is unknown.
+     * */
+    template <typename Function>
+    auto withEngine(std::size_t type, Function&& run)
+    {
+        switch (type) {
+            case MD5Engine::TYPE: { MD5Engine engine; return run(engine); }
+            case SHA1Engine::TYPE: { SHA1Engine engine; return run(engine); }
+            case SHA256Engine::TYPE: { SHA256Engine engine; return run(engine); }
+            case SHA384Engine::TYPE: { SHA384Engine engine; return run(engine); }
+            case SHA512Engine::TYPE: { SHA512Engine engine; return run(engine); }
+            case Blake2bEngine::TYPE: { Blake2bEngine engine; return run(engine); }
+            case Blake3Engine::TYPE: { Blake3Engine engine; return run(engine); }
+            case XXH3Engine::TYPE: { XXH3Engine engine; return run(engine); }
+            case XXH128Engine::TYPE: { XXH128Engine engine; return run(engine); }
+        }
+
+        throw std::invalid_argument("Unknown hash type number " + std::to_string(type) + ".");
+    }
+
+    /* Returns an engine of the hash type at the position `type` of
+     * HASH_TYPES. Throws std::invalid_argument if the type is unknown. */
+    inline AnyEngine makeEngine(std::size_t type)
+    {
+        return withEngine(type, [](auto& engine) { return AnyEngine(engine); });
+    }
+};
+
+#endif /* _SHAZAM_ENGINE_HEADER */
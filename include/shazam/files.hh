@@ -3,20 +3,79 @@
 
 #include "./basic-types.hh"
 
+#include <atomic>
 #include <string>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <istream>
+#include <memory>
+#include <vector>
+
+#include <sys/stat.h>
 
 namespace fs = std::filesystem;
 
 namespace shazam {
+    /* Maximum number of files kept open between their validation and
+     * their hashing. The files created after that are closed once
+     * validated and opened again to be hashed. */
+    constexpr int MAX_KEPT_DESCRIPTORS = 1024;
+
+    /* Path standing for the standard input. */
+    constexpr const char* STDIN_PATH = "-";
+
+    /* Returns the file status matching the error of a failed open or stat. */
+    EFileStatus fileStatusFromErrno(int error);
+
     /* Represents as file in the program. */
     class File {
         const EFileStatus _status;
         const std::string _path;
+        std::atomic<int> _descriptor;
+        struct stat _stat;
+        const bool _hasStat;
 
     public:
         File(std::string path, EFileStatus status)
-        : _status(status), _path(path) { }
+        : _status(status), _path(path), _descriptor(-1), _stat(), _hasStat(false) { }
+
+        /* A file validated by opening it, where `descriptor` is the open
+         * file, or -1 if it was closed, and `filestat` its attributes. */
+        File(std::string path, EFileStatus status, int descriptor, const struct stat& filestat)
+        : _status(status), _path(path), _descriptor(descriptor), _stat(filestat), _hasStat(true) { }
+
+        /* Closes the file if it is still open. */
+        ~File();
+
+        File(const File&) = delete;
+        File& operator=(const File&) = delete;
+
+        /* Returns a descriptor to read the file from its start, and its
+         * attributes in `filestat`. The file kept open by the validation
+         * is handed over the first time, after that, or if there is none,
+         * the file is opened again. The caller must close the descriptor.
+         * Throws std::runtime_error if the file can't be opened.
+         * */
+        int open(struct stat& filestat);
+
+        /* Hands over the descriptor kept open by the validation like open(),
+         * but returns -1 instead of opening the file again if there is none. */
+        int takeDescriptor(struct stat& filestat);
+
+        /* Hands over the descriptor kept open by the validation, which
+         * stays counted as kept, and sets `filestat` to the attributes of
+         * the file. Returns -1 if there is none, without opening it.
+         * */
+        int release(struct stat& filestat);
+
+        /* Returns the descriptor kept open by the validation, which the file
+         * keeps, or -1 if there is none. */
+        int descriptor() const;
+
+        /* Sets `filestat` to the attributes read when the file was validated,
+         * returning false if it wasn't validated by opening it. */
+        bool attributes(struct stat& filestat) const;
 
         /* Returns the path to the file. */
         std::string path() const;
@@ -30,33 +89,125 @@ namespace shazam {
         /* Returns true if this file is a valid file. */
         bool isValid() const;
 
+        /* Returns true if the file isn't a regular one, such as a pipe or
+         * a character device, so its size isn't known and it can only be
+         * read once, from its start to its end. */
+        bool isStream() const;
+
         /* Returns the size of the file. */
-        int size();
+        std::uintmax_t size();
     };
 
 
-    class FileFactory {
-    private:
-        /* Returns true if the file exists. */
-        bool fileExists(fs::file_status filestatus);
+    /* A compact table of valid files, with one column per attribute and
+     * the paths stored one after the other in a single buffer, so that
+     * keeping millions of files costs a few allocations instead of
+     * several per file. The files are turned into File objects only
+     * while they are being hashed.
+     * */
+    class FileTable {
+        /* The attributes of the files used to hash and cache them. */
+        struct Attributes {
+            std::uint64_t device;
+            std::uint64_t inode;
+            std::uint64_t size;
+            std::uint64_t blocks;
+            std::int64_t mtimeNs;
+            std::int64_t ctimeNs;
+            std::uint32_t mode;
+        };
+
+        std::vector<char> paths;
+        std::vector<std::size_t> pathOffsets;
+        std::vector<int> descriptors;
+        std::vector<Attributes> attributes;
+        std::vector<bool> attributesKnown;
+
+    public:
+        FileTable() = default;
+
+        /* Closes the files still kept open. */
+        ~FileTable();
 
-        /* Returns true if the file is not a directory. */
-        bool fileIsNotDirectory(fs::file_status filestatus);
+        FileTable(const FileTable&) = delete;
+        FileTable& operator=(const FileTable&) = delete;
 
-        /* Returns true if the user has permission to read the files. */
-        bool fileIsPermissive(fs::file_status filestatus);
+        /* Adds a valid file, taking over the descriptor it keeps open,
+         * and returns its row. */
+        std::size_t add(File& file);
 
-        /* Returns true if the file can be read. */
-        bool fileIsReadable(std::string path);
+        /* Adds a valid file whose attributes are unknown. */
+        std::size_t add(const std::string& path);
 
+        /* Returns the number of files. */
+        std::size_t size() const;
+
+        /* Returns the path of the file at `row`. */
+        std::string path(std::size_t row) const;
+
+        /* Returns the size of the file at `row`, as it was validated. */
+        std::uintmax_t fileSize(std::size_t row) const;
+
+        /* Returns the device holding the file at `row`, as in st_dev,
+         * or 0 if its attributes are unknown. */
+        std::uint64_t device(std::size_t row) const;
+
+        /* Returns the inode of the file at `row`, or 0 if its attributes
+         * are unknown. */
+        std::uint64_t inode(std::size_t row) const;
+
+        /* Returns true if the file at `row` is a stream, as File::isStream. */
+        bool stream(std::size_t row) const;
+
+        /* Returns the descriptor kept open for the file at `row`, which
+         * stays owned by the table, or -1 if there is none. */
+        int descriptor(std::size_t row) const;
+
+        /* Returns the file at `row`, handing it over the descriptor
+         * kept open, if there is one. */
+        std::shared_ptr<File> file(std::size_t row);
+
+    private:
+        /* Appends a path to the buffer of paths. */
+        void addPath(const std::string& path);
+    };
+
+    /* Creates the files, validating them with a single open and fstat
+     * whose descriptor is later used to hash them. STDIN_PATH stands for
+     * the standard input. The descriptors of the streams are always kept,
+     * as they can't be opened again. */
+    class FileFactory {
     protected:
-        /* Returns a enum value corresponding to the state of the file. */
-        EFileStatus fileValidStatus(std::string path);
+        /* Opens the file and returns a enum value corresponding to its
+         * state. If it is valid, `descriptor` is left open and `filestat`
+         * has its attributes, otherwise `descriptor` is -1.
+         * */
+        EFileStatus fileValidStatus(std::string path, int& descriptor, struct stat& filestat);
 
     public:
         /* Returns a shared pointer to a File instance. */
         std::shared_ptr<File> create(std::string path);
     };
+
+    /* Reads the paths of a list of files, one per line or separated by
+     * NUL characters, as written by `find -print0`. The paths are read as
+     * they are asked for, so the list can be as long as wanted and still
+     * be written while it is read. The paths are kept byte for byte, so a
+     * '\r' ending a line is part of the path; only the empty paths, which
+     * can't name a file, are skipped.
+     * */
+    class PathListReader {
+        std::istream& input;
+        const char delimiter;
+
+    public:
+        PathListReader(std::istream& input, char delimiter = '\n')
+        : input(input), delimiter(delimiter) {  }
+
+        /* Reads the next path into `path`, returning false at the end
+         * of the list. */
+        bool next(std::string& path);
+    };
 };
 
 #endif /* _SHAZAM_FILES_HEADER */
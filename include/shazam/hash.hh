@@ -2,42 +2,133 @@
 #define _SHAZAM_HASH_HEADER
 
 #include "./basic-types.hh"
+#include "./cache.hh"
 #include "./common.hh"
 #include "./files.hh"
+#include "./reader.hh"
 
 #include "../external/hashlib2plus/hl_hashwrapper.h"
-#include "../external/hashlib2plus/hl_wrapperfactory.h"
 
 #include <string>
 #include <memory>
+#include <vector>
+
+#include <sys/stat.h>
 
 namespace shazam {
-    /* Calcultes the hash sum. */
+    /* Calcultes the hash sums of a file. When more than one type of hash
+     * sum is requested, the file is read only once and every block read
+     * is used to update all of them, except for the tree hash, which reads
+     * its chunks in a pass of its own. Unless it is given its own hashers,
+     * it hashes with the engines of its types, on the stack. */
     class HashCalculator: public IAmObservable {
-        const std::string hashName;
+        const std::vector<std::string> hashNames;
+        const std::vector<std::size_t> hashTypes;
         const std::shared_ptr<File> file;
-        const std::unique_ptr<hashwrapper> hasher;
-        std::string hashSum = "";
+        const std::vector<std::unique_ptr<hashwrapper>> hashers;
+        const ReaderFactory readers;
+        std::shared_ptr<HashCache> cache;
+        unsigned int treeThreads = 1;
+        std::vector<Digest> hashSums;
 
     public:
-        HashCalculator(std::string hashname, std::unique_ptr<hashwrapper> wrapper, std::shared_ptr<File> file_ptr)
-        : hashName(hashname), file(file_ptr), hasher(std::move(wrapper)) {}
-
-        /* Calculates the hash sum. */
+        HashCalculator(std::string hashname, std::unique_ptr<hashwrapper> wrapper, std::shared_ptr<File> file_ptr,
+                       ReaderFactory readers = ReaderFactory())
+        : HashCalculator(std::vector<std::string>{hashname}, makeHashers(std::move(wrapper)), file_ptr, readers) {}
+
+        HashCalculator(std::vector<std::string> hashnames, std::vector<std::unique_ptr<hashwrapper>> wrappers,
+                       std::shared_ptr<File> file_ptr, ReaderFactory readers = ReaderFactory())
+        : hashNames(hashnames), hashTypes(typeIndexes(hashnames)), file(file_ptr), hashers(std::move(wrappers)),
+        readers(readers) {}
+
+        /* A calculator that hashes with the engines of its types.
+         * Throws std::invalid_argument if a hash type is unknown. */
+        HashCalculator(std::vector<std::string> hashnames, std::shared_ptr<File> file_ptr,
+                       ReaderFactory readers = ReaderFactory())
+        : hashNames(hashnames), hashTypes(typeIndexes(hashnames, true)), file(file_ptr), readers(readers) {}
+
+        /* Calculates the hash sums, unless they are all in the cache. The
+         * sums of the files that aren't regular, such as pipes, are never
+         * cached, as the same inode gives a different content every time. */
         void calculate(void);
 
-        /* Returns the type of hash sum being calculated. */
+        /* Takes the hash sums from the cache, returning false if they
+         * are not all there. */
+        bool calculateFromCache(void);
+
+        /* Sets hash sums calculated elsewhere, in the same order as
+         * types(). Throws std::invalid_argument if their number differs. */
+        void setHashSums(std::vector<Digest> sums);
+
+        /* Sets hash sums calculated elsewhere, from the file with the given
+         * attributes, and stores them in the cache. */
+        void setHashSums(std::vector<Digest> sums, const struct stat& filestat);
+
+        /* Sets the cache consulted before calculating the hash sums. */
+        void setCache(std::shared_ptr<HashCache> value);
+
+        /* Sets the number of threads, counting the calling one, that hash
+         * the chunks of the tree hash, 1 by default. */
+        void setTreeThreads(unsigned int value);
+
+        /* Returns the type of the first hash sum being calculated. */
         std::string type(void);
 
-        /* Returns the calculated hash sum. */
+        /* Returns the types of hash sums being calculated. */
+        std::vector<std::string> types(void);
+
+        /* Returns the first calculated hash sum. */
         HashSum get(void);
 
+        /* Returns the calculated hash sum at the given position. */
+        HashSum get(std::size_t index);
+
+        /* Returns all the calculated hash sums. */
+        std::vector<HashSum> getAll(void);
+
+        /* Returns the digest at the given position, without copying it
+         * nor the name of the file. */
+        const Digest& digest(std::size_t index);
+
         /* Returns the path of the file being used. */
         std::string getFilePath(void);
 
+        /* Returns the file being used. */
+        std::shared_ptr<File> getFile(void);
+
+        /* Returns the size of the file being used. */
+        std::uintmax_t getFileSize(void);
+
+        /* Returns the factory of the readers of the file. */
+        const ReaderFactory& getReaders(void) const;
+
     private:
-        /* Makes the calculation of the hash sum and returns the result. */
-        std::string calculateHashSum(void);
+        /* Makes the calculation of the hash sums and returns the results.
+         * The file is read once, by the reader chosen for its size, and
+         * `filestat` receives its attributes from before the read. */
+        std::vector<Digest> calculateHashSum(struct stat& filestat);
+
+        /* Reads the file `fd`, with the attributes `filestat`, with one
+         * engine, whose updates are inlined into the loop that consumes
+         * the blocks. */
+        template <typename Engine>
+        Digest hashWithEngine(Engine& engine, int fd, const struct stat& filestat);
+
+        /* Reads the file `fd` with the engines of several types, and
+         * the tree hash, if it is one of them. Throws std::runtime_error
+         * if the tree hash is asked for a stream, which can't be read by
+         * chunks. */
+        std::vector<Digest> hashWithEngines(int fd, const struct stat& filestat);
+
+        /* Reads the file `fd` with the hashers given to the calculator. */
+        std::vector<Digest> hashWithHashers(int fd, const struct stat& filestat);
+
+        /* Wraps a single hasher into a list of hashers. */
+        static std::vector<std::unique_ptr<hashwrapper>> makeHashers(std::unique_ptr<hashwrapper> wrapper);
+
+        /* Returns the positions of the hash types in HASH_TYPES. If `known`,
+         * throws std::invalid_argument when one of them isn't there. */
+        static std::vector<std::size_t> typeIndexes(const std::vector<std::string>& names, bool known = false);
     };
 
     class HashComparator: public IAmObservable {
@@ -52,14 +143,48 @@ namespace shazam {
         FileHashSumComparationResult compareHashes(void);
 
     private:
-        /* Makes the comparation and returns the result. */
-        ComparationResult makeComparation(std::string original, std::string current);
+        /* Makes the comparation and returns the result. Empty digests,
+         * which is what malformed ones are read as, never match. */
+        ComparationResult makeComparation(const Digest& original, const Digest& current);
     };
 
-    class HashFactory: protected wrapperfactory {
+    class HashFactory {
+        EIOMode ioMode = IO_AUTO;
+        std::size_t buffers = PIPELINE_DEFAULT_BUFFERS;
+        unsigned int queueDepth = URING_DEFAULT_DEPTH;
+        EPageCacheMode pageCache = PAGE_CACHE_KEEP;
+        int tee = -1;
+        std::shared_ptr<HashCache> cache;
+        unsigned int treeThreads = 1;
+
     public:
         /* Creates an hash calculator class for the given file, depending on the given hash type. */
         std::shared_ptr<HashCalculator> hashFile(std::string hashtype, std::shared_ptr<File> file);
+
+        /* Creates an hash calculator class that calculates all the given hash types in one pass. */
+        std::shared_ptr<HashCalculator> hashFile(std::vector<std::string> hashtypes, std::shared_ptr<File> file);
+
+        /* Sets the strategy used by the created calculators to read the
+         * files, the number of buffers of the pipelined reads, the
+         * requests in flight of the io_uring reads and how the reads use
+         * the page cache. Throws std::invalid_argument if they are out
+         * of range. */
+        void setIOMode(EIOMode mode, std::size_t buffers = PIPELINE_DEFAULT_BUFFERS,
+                       unsigned int queueDepth = URING_DEFAULT_DEPTH, EPageCacheMode pageCache = PAGE_CACHE_KEEP);
+
+        /* Sets the cache used by the created calculators, none by default. */
+        void setCache(std::shared_ptr<HashCache> value);
+
+        /* Sets the descriptor the files read by the created calculators
+         * are copied to, or -1 for none, the default. */
+        void setTee(int descriptor);
+
+        /* Returns the descriptor the files are copied to, or -1 if none. */
+        int getTee() const;
+
+        /* Sets the number of threads that hash the chunks of the tree
+         * hash of each file, 1 by default. */
+        void setTreeThreads(unsigned int value);
     };
 };
 
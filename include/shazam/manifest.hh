@@ -0,0 +1,77 @@
+#ifndef _SHAZAM_MANIFEST_HEADER
+#define _SHAZAM_MANIFEST_HEADER
+
+#include "./digest.hh"
+
+#include <cstddef>
+#include <istream>
+#include <string>
+
+namespace shazam {
+    /* An entry of a manifest: a file and its expected hash sum. */
+    struct ManifestEntry {
+        std::string filename;
+        std::string hashType;
+        Digest hashSum;
+        std::size_t line;
+    };
+
+    /* Returns the hash type whose hexadecimal digests have the given
+     * number of digits, or an empty string if there is none. */
+    std::string hashTypeFromDigestLength(std::size_t digits);
+
+    /* Returns the `# <TYPE>` header of the section with the sums of a hash
+     * type. The one of the tree hash also has the chunk size, in bytes, as
+     * in `# SHA256-TREE 1048576`. */
+    std::string sectionHeader(const std::string& hashType);
+
+    /* Returns true if the sums of the hash type are always written under
+     * the header of their section, even when it is the only type, so that
+     * they can't be taken for the sums of the type guessed from their length,
+     * as BLAKE3 sums would be for SHA256 ones. */
+    bool alwaysInSection(const std::string& hashType);
+
+    /* Reads the entries of a manifest one line at a time, so manifests
+     * of any size can be verified without loading them. Understands the
+     * GNU format (`<digest>  <file>` or `<digest> *<file>`, with the
+     * backslash escaped names of coreutils and the `XXH3_` prefix that
+     * xxhsum gives to the XXH3 digests), the BSD format
+     * (`SHA256 (<file>) = <digest>`) and the output of shazam itself,
+     * whose `# <TYPE>` headers set the type of the entries below them,
+     * the one of the tree hash being followed by its chunk size.
+     * Empty lines and other lines starting with '#' are skipped.
+     * */
+    class ManifestReader {
+        std::istream& input;
+        const std::string forcedType;
+        std::string sectionType;
+        std::size_t lineNumber;
+        std::size_t malformedLines;
+
+    public:
+        /* When `hashType` is given, it is used for all the GNU format
+         * entries instead of guessing it from the length of the digests. */
+        ManifestReader(std::istream& input, std::string hashType = "")
+        : input(input), forcedType(hashType), lineNumber(0), malformedLines(0) {  }
+
+        /* Reads the next entry into `entry`, returning false at the end
+         * of the manifest. Malformed lines are counted and skipped. */
+        bool next(ManifestEntry& entry);
+
+        /* Returns the number of malformed lines found so far. */
+        std::size_t getMalformedLines() const;
+
+    private:
+        /* Parses a line, returning false if it has no entry. Sets
+         * `malformed` if the line isn't empty, a comment or an entry. */
+        bool parseLine(std::string line, ManifestEntry& entry, bool& malformed);
+
+        /* Parses a `SHA256 (<file>) = <digest>` line. */
+        bool parseBSDLine(const std::string& line, ManifestEntry& entry);
+
+        /* Parses a `<digest>  <file>` line. */
+        bool parseGNULine(const std::string& line, ManifestEntry& entry);
+    };
+};
+
+#endif /* _SHAZAM_MANIFEST_HEADER */
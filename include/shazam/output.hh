@@ -0,0 +1,103 @@
+#ifndef _SHAZAM_OUTPUT_HEADER
+#define _SHAZAM_OUTPUT_HEADER
+
+#include "./basic-types.hh"
+#include "./files.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace shazam {
+    /* Size of the sums of a section kept in memory, past which they are
+     * moved to a temporary file until the section is written. */
+    constexpr std::size_t SECTION_SPILL_SIZE = 1024 * 1024;
+
+    /* The results of a group of files, in the order of the files. */
+    struct ResultGroup {
+        std::vector<HashSum> sums;
+        std::vector<std::shared_ptr<File>> invalid;
+    };
+
+    /* Writes the hash sums as soon as they are calculated. The groups
+     * of results are numbered in the input order and, unless unordered,
+     * written in that order: a group done before the ones ahead of it
+     * waits for them in the reorder window.
+     *
+     * When more than one type of hash sum is calculated, every type has
+     * its own section, so only the sums of the first type are written as
+     * they come, the others are kept until finish(), in temporary files
+     * once they grow past SECTION_SPILL_SIZE.
+     * */
+    class ResultWriter {
+        struct FileCloser {
+            void operator()(std::FILE* file) const { std::fclose(file); }
+        };
+
+        /* The sums of a type written after the first. */
+        struct Section {
+            std::string lines;
+            std::unique_ptr<std::FILE, FileCloser> spill;
+        };
+
+        std::ostream& out;
+        const std::vector<std::string> types;
+        const bool unordered;
+
+        std::mutex mutex;
+        std::map<std::size_t, ResultGroup> waiting;
+        std::size_t nextGroup;
+        std::atomic<std::size_t> writtenGroups;
+        bool started;
+        std::vector<Section> sections;
+        std::vector<std::shared_ptr<File>> invalidFiles;
+
+    public:
+        ResultWriter(std::ostream& out, std::vector<std::string> types, bool unordered)
+        : out(out), types(types), unordered(unordered), nextGroup(0), writtenGroups(0),
+        started(false), sections(types.size()) {  }
+
+        /* Writes the results of the group number `group`, or keeps
+         * them until the groups before it are written. */
+        void write(std::size_t group, ResultGroup results);
+
+        /* Writes results that belong to a group still being gathered,
+         * which is then written with write() and only counted there.
+         * Only unordered writers take them, the others throw
+         * std::logic_error. */
+        void writePart(ResultGroup results);
+
+        /* Writes the groups still waiting, whatever their number, and
+         * the sections of the other hash types. */
+        void finish();
+
+        /* Returns the number of groups written so far. */
+        std::size_t getWrittenGroups() const;
+
+        /* Returns the invalid files of the groups written, in their order. */
+        std::vector<std::shared_ptr<File>> getInvalidFiles() const;
+
+    private:
+        /* Writes a group of results, with the mutex held. */
+        void writeGroup(const ResultGroup& results);
+
+        /* Writes results without counting them as a group, with the
+         * mutex held. */
+        void writeResults(const ResultGroup& results);
+
+        /* Moves the sums kept in memory for a section to its temporary
+         * file, or keeps them there if no file can be made. */
+        void spillSection(Section& section);
+
+        /* Writes a section of the sums of the type `index`. */
+        void writeSection(std::size_t index);
+    };
+};
+
+#endif /* _SHAZAM_OUTPUT_HEADER */
@@ -0,0 +1,91 @@
+#ifndef _SHAZAM_POOL_HEADER
+#define _SHAZAM_POOL_HEADER
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace shazam {
+    /* Returns the number of online CPUs, at least one. */
+    unsigned int onlineCpus();
+
+    /* A fixed size thread pool where every worker owns a task queue.
+     * The tasks submitted by a worker go to its own queue, the ones
+     * submitted from other threads are spread over the queues in turn.
+     * Workers consume their own queue from the front and, when it is
+     * empty, steal from the front of the other queues, so each queue
+     * is started in the order it was filled.
+     *
+     * Submitting and taking a task only lock the queue involved. The
+     * pool mutex is only taken by the workers going to sleep, to wake
+     * them up, and when the last pending task is done.
+     * */
+    class WorkStealingPool {
+        using Task = std::function<void(void)>;
+
+        struct Worker {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread> threads;
+
+        std::mutex stateMutex;
+        std::condition_variable taskAvailable;
+        std::condition_variable allDone;
+        /* The tasks in the queues, counted along with the queue changed. */
+        std::atomic<std::size_t> queuedTasks;
+        /* The tasks submitted and not finished yet. */
+        std::atomic<std::size_t> pendingTasks;
+        /* The workers waiting for a task, or about to. */
+        std::atomic<std::size_t> sleepingWorkers;
+        std::atomic<std::size_t> nextWorker;
+        bool stopping;
+        std::exception_ptr firstError;
+
+    public:
+        /* Starts `size` worker threads (at least one). */
+        explicit WorkStealingPool(unsigned int size);
+
+        /* Waits for the submitted tasks and joins the workers. */
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        /* Schedules a task to be run by one of the workers. */
+        void submit(Task task);
+
+        /* Blocks until every submitted task has finished. If a task
+         * threw, the first exception is rethrown here.
+         * */
+        void wait();
+
+        /* Returns the number of workers. */
+        std::size_t size() const;
+
+    private:
+        /* The loop run by each worker thread. */
+        void work(std::size_t index);
+
+        /* Takes the next task for the worker `index`, stealing it from
+         * the other workers if its own queue is empty. Returns false if
+         * every queue was empty when it was looked at.
+         * */
+        bool takeTask(std::size_t index, Task& task);
+
+        /* Puts the calling worker to sleep until there are queued tasks,
+         * returning false if the pool is stopping instead. */
+        bool waitForTasks();
+    };
+};
+
+#endif /* _SHAZAM_POOL_HEADER */
@@ -0,0 +1,255 @@
+#ifndef _SHAZAM_READER_HEADER
+#define _SHAZAM_READER_HEADER
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <sys/stat.h>
+
+namespace shazam {
+    /* The strategies that can be used to read the files. */
+    enum EIOMode {
+        IO_AUTO,
+        IO_BUFFER,
+        IO_MMAP,
+        IO_READ,
+        IO_PIPELINE,
+        IO_URING
+    };
+
+    /* Constant array with the names of the io modes, in the
+     * same order as the EIOMode values.
+     * */
+    constexpr std::array<const char*, 6> IO_MODES = {
+        "auto", "buffer", "mmap", "read", "pipeline", "uring"
+    };
+
+    /* Returns the io mode with the given name, throwing
+     * std::invalid_argument if there is none. */
+    EIOMode ioModeFromName(std::string name);
+
+    /* How the reads use the page cache. */
+    enum EPageCacheMode {
+        /* The pages read stay cached, as usual. */
+        PAGE_CACHE_KEEP,
+        /* The pages are given back to the kernel once they are read, so
+         * that hashing doesn't evict what the other programs keep cached. */
+        PAGE_CACHE_DROP,
+        /* The files are read with O_DIRECT, from the disk into the
+         * buffers, without going through the page cache. */
+        PAGE_CACHE_BYPASS
+    };
+
+    /* Receives the blocks of data read from a file. */
+    using BlockConsumer = std::function<void(const unsigned char* data, std::size_t len)>;
+
+    /* Reads the content of a file, block by block. */
+    class FileReader {
+    protected:
+        const EPageCacheMode pageCache;
+
+    public:
+        explicit FileReader(EPageCacheMode pageCache = PAGE_CACHE_KEEP): pageCache(pageCache) {  }
+
+        virtual ~FileReader() = default;
+
+        /* Reads the opened file `fd` until its end, passing every
+         * block read to `consume`. The `size` is only a hint, the
+         * file is always read until the end. Throws std::runtime_error
+         * if the file can't be read.
+         * */
+        virtual void read(int fd, std::uintmax_t size, const BlockConsumer& consume) = 0;
+    };
+
+    /* Reads the file with read(2) into a small buffer. As the buffer is
+     * not aligned, PAGE_CACHE_BYPASS reads like BufferedReader. */
+    class SyscallReader: public FileReader {
+    public:
+        using FileReader::FileReader;
+
+        void read(int fd, std::uintmax_t size, const BlockConsumer& consume) override;
+    };
+
+    /* Reads the file with read(2) into a large page aligned buffer,
+     * reused by all the reads made by the same thread. */
+    class BufferedReader: public FileReader {
+    public:
+        using FileReader::FileReader;
+
+        void read(int fd, std::uintmax_t size, const BlockConsumer& consume) override;
+    };
+
+    /* Maps the file into memory, advising the kernel that it will be read
+     * sequentially. The mapped pages can't be given back while they are
+     * mapped, so unless PAGE_CACHE_KEEP it reads like BufferedReader.
+     *
+     * A file truncated while it is read would raise SIGBUS, which is
+     * caught while the mapping is read: the rest of it is read as zeros
+     * and std::runtime_error is thrown, instead of the run being killed.
+     * */
+    class MappedReader: public FileReader {
+    public:
+        using FileReader::FileReader;
+
+        void read(int fd, std::uintmax_t size, const BlockConsumer& consume) override;
+    };
+
+    /* Reads the file with read(2) on a thread of its own, into a ring of
+     * page aligned buffers, while the blocks already read are consumed
+     * by the calling thread. The disk and the hashing overlap, and the
+     * memory used is bounded by the number of buffers.
+     * */
+    class PipelinedReader: public FileReader {
+        const std::size_t buffers;
+
+    public:
+        /* Uses `buffers` buffers. With less than two, or for the files
+         * that fit in a single one, it reads like BufferedReader. */
+        explicit PipelinedReader(std::size_t buffers, EPageCacheMode pageCache = PAGE_CACHE_KEEP)
+        : FileReader(pageCache), buffers(buffers) {  }
+
+        void read(int fd, std::uintmax_t size, const BlockConsumer& consume) override;
+    };
+
+    /* Reads a sparse file one data extent at a time, as found with
+     * SEEK_DATA and SEEK_HOLE, and passes its holes to the consumer as
+     * blocks of zeros, without reading them. The blocks are the same as
+     * the ones read from the file, so are the hash sums. The extents are
+     * read with pread(2) into the large buffer, and unless the page cache
+     * is kept their pages are given back once read. Where the file system
+     * can't tell the holes apart, the file is read like BufferedReader.
+     * */
+    class SparseReader: public FileReader {
+    public:
+        using FileReader::FileReader;
+
+        void read(int fd, std::uintmax_t size, const BlockConsumer& consume) override;
+    };
+
+    /* Reads a stream, such as a pipe or a character device, whose size
+     * isn't known, into the large buffer until its end, so the size it
+     * is given is ignored. The capacity of a
+     * pipe is raised to STREAM_PIPE_SIZE, so that each read takes more of
+     * it. The page cache modes don't apply to streams.
+     *
+     * With a `tee` descriptor, everything read is also written there. From
+     * a pipe, the data is first duplicated with tee(2) and spliced into it,
+     * without being copied, then read. From anything else, or when the
+     * output can't be spliced into, the buffer is written instead. Throws
+     * std::runtime_error if the output can't be written.
+     * */
+    class StreamReader: public FileReader {
+        const int tee;
+
+    public:
+        explicit StreamReader(int tee = -1): tee(tee) {  }
+
+        void read(int fd, std::uintmax_t size, const BlockConsumer& consume) override;
+    };
+
+    /* Default number of buffers of PipelinedReader. */
+    constexpr std::size_t PIPELINE_DEFAULT_BUFFERS = 2;
+
+    /* Maximum number of buffers of PipelinedReader, which bounds the
+     * memory used for each file to PIPELINE_MAX_BUFFERS * LARGE_BUFFER_SIZE. */
+    constexpr std::size_t PIPELINE_MAX_BUFFERS = 16;
+
+    /* Default number of requests kept in flight by the io_uring reads. */
+    constexpr unsigned int URING_DEFAULT_DEPTH = 64;
+
+    /* Maximum number of requests kept in flight by the io_uring reads. */
+    constexpr unsigned int URING_MAX_DEPTH = 4096;
+
+    /* Creates the reader used for each file. */
+    class ReaderFactory {
+        const EIOMode mode;
+        const std::size_t buffers;
+        const unsigned int queueDepth;
+        const EPageCacheMode pageCache;
+        const int tee;
+
+    public:
+        /* The `buffers` are the ones used by PipelinedReader, the
+         * `queueDepth` the requests in flight of the io_uring reads, and
+         * `tee` the descriptor the files are copied to while read, if any.
+         * Throws std::invalid_argument if the buffers or the requests are
+         * more than PIPELINE_MAX_BUFFERS or URING_MAX_DEPTH. */
+        ReaderFactory(EIOMode mode, std::size_t buffers = PIPELINE_DEFAULT_BUFFERS,
+                      unsigned int queueDepth = URING_DEFAULT_DEPTH, EPageCacheMode pageCache = PAGE_CACHE_KEEP,
+                      int tee = -1);
+
+        ReaderFactory(): ReaderFactory(IO_AUTO) {  }
+
+        /* Returns the reader for a file of the given size. When
+         * the mode is IO_AUTO, small files are read directly, medium
+         * ones through the large buffer and big ones are mapped. The
+         * files read alone in IO_URING mode are read as in IO_AUTO, it
+         * is only used by the batches of small files. Unless the page
+         * cache is kept, the files are never mapped. */
+        std::unique_ptr<FileReader> create(std::uintmax_t size) const;
+
+        /* Returns the reader for the file with the given attributes: a
+         * StreamReader for the files that aren't regular, or for all of
+         * them when they are copied to a tee, a SparseReader for the big
+         * files with fewer blocks allocated than their size needs, and
+         * otherwise the one for their size. */
+        std::unique_ptr<FileReader> create(const struct stat& filestat) const;
+
+        /* Returns the mode used to choose the readers. */
+        EIOMode getMode() const;
+
+        /* Returns the number of buffers of the PipelinedReader. */
+        std::size_t getBuffers() const;
+
+        /* Returns the number of requests in flight of the io_uring reads. */
+        unsigned int getQueueDepth() const;
+
+        /* Returns how the reads use the page cache. */
+        EPageCacheMode getPageCacheMode() const;
+
+        /* Returns the descriptor the files are copied to, or -1 if none. */
+        int getTee() const;
+    };
+
+    /* Size of the buffer used by SyscallReader. */
+    constexpr std::size_t SMALL_BUFFER_SIZE = 64 * 1024;
+
+    /* Size of the buffer used by BufferedReader, of the ones of the ring
+     * of PipelinedReader, and of the blocks passed to the consumer by
+     * MappedReader. */
+    constexpr std::size_t LARGE_BUFFER_SIZE = 8 * 1024 * 1024;
+
+    /* Files up to this size are read by SyscallReader in IO_AUTO mode. */
+    constexpr std::uintmax_t AUTO_READ_MAX_SIZE = 256 * 1024;
+
+    /* Files from this size on are read by MappedReader in IO_AUTO mode. */
+    constexpr std::uintmax_t AUTO_MMAP_MIN_SIZE = 64 * 1024 * 1024;
+
+    /* Files bigger than this are advised to be read sequentially, which
+     * doubles the readahead of the kernel for them. For the smaller ones
+     * it isn't worth the system call. */
+    constexpr std::uintmax_t SEQUENTIAL_HINT_MIN_SIZE = AUTO_READ_MAX_SIZE;
+
+    /* Number of bytes read between each time the pages behind the reads
+     * are given back, with PAGE_CACHE_DROP. */
+    constexpr std::uintmax_t DROP_BEHIND_SIZE = LARGE_BUFFER_SIZE;
+
+    /* Files from this size on, with fewer blocks allocated than their size
+     * needs, are read by SparseReader. Below it, the holes aren't worth the
+     * system calls looking for them. */
+    constexpr std::uintmax_t SPARSE_MIN_SIZE = AUTO_READ_MAX_SIZE;
+
+    /* Size of the blocks of zeros passed for the holes by SparseReader. */
+    constexpr std::size_t SPARSE_ZERO_BLOCK_SIZE = 1024 * 1024;
+
+    /* Capacity asked for the pipes read by StreamReader, the most an
+     * unprivileged process can ask for by default. A pipe holds 64 KiB
+     * otherwise, which is all a read can get from it. */
+    constexpr std::size_t STREAM_PIPE_SIZE = 1024 * 1024;
+};
+
+#endif /* _SHAZAM_READER_HEADER */
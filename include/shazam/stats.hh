@@ -0,0 +1,149 @@
+#ifndef _SHAZAM_STATS_HEADER
+#define _SHAZAM_STATS_HEADER
+
+#include "./basic-types.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace shazam {
+    class HashCache;
+
+    /* The phases in which the time of a run is spent. */
+    enum EStatsPhase {
+        PHASE_VALIDATE,
+        PHASE_OPEN,
+        PHASE_READ,
+        PHASE_HASH,
+        PHASE_OUTPUT
+    };
+
+    /* Constant array with the names of the phases, in the
+     * same order as the EStatsPhase values.
+     * */
+    constexpr std::array<const char*, 5> STATS_PHASES = {
+        "validate", "open", "read", "hash", "output"
+    };
+
+    /* Number of buckets of the file latency histogram. The bucket `i`
+     * counts the files that took less than 2^i microseconds, the last
+     * one all the slower files. */
+    constexpr std::size_t STATS_LATENCY_BUCKETS = 24;
+
+    /* The counters of a run, or of one of its threads. */
+    struct StatsCounters {
+        std::uint64_t phaseNanos[STATS_PHASES.size()];
+        std::uint64_t phaseCalls[STATS_PHASES.size()];
+        std::uint64_t files;
+        std::uint64_t bytes;
+        std::uint64_t reads;
+        std::uint64_t syscalls;
+        std::uint64_t droppedBytes;
+        std::uint64_t directBytes;
+        std::uint64_t holeBytes;
+        std::uint64_t latency[STATS_LATENCY_BUCKETS];
+        std::uint64_t algorithmBytes[HASH_TYPES.size()];
+        std::uint64_t algorithmNanos[HASH_TYPES.size()];
+
+        /* Adds the counters of `other` to these. */
+        void add(const StatsCounters& other);
+    };
+
+    /* Statistics of the run, for when it takes longer than it should.
+     *
+     * Every thread updates its own counters, without locks nor atomics,
+     * and they are only added together by total(), once the threads are
+     * done. While disabled, which they are by default, the statistics
+     * cost one branch on every update.
+     *
+     * The counters of a thread that ends are added to a retired total,
+     * so that the threads started for a single file, by the tree hash
+     * and by BLAKE3, don't leave their counters behind.
+     * */
+    class Stats {
+        static bool active;
+
+    public:
+        /* Returns true if the statistics are being collected. */
+        static bool enabled() { return active; }
+
+        /* Starts or stops collecting the statistics. Must be called
+         * before the threads that update them are started. */
+        static void setEnabled(bool value);
+
+        /* Zeroes the counters of every thread, and restarts the clock. */
+        static void reset();
+
+        /* Returns the counters of the calling thread. */
+        static StatsCounters& local();
+
+        /* Returns the counters of all the threads added together. */
+        static StatsCounters total();
+
+        /* Returns the monotonic time in nanoseconds. */
+        static std::uint64_t now();
+
+        /* Adds time spent in a phase. */
+        static void addPhase(EStatsPhase phase, std::uint64_t nanos);
+
+        /* Adds `count` system calls made on the files. */
+        static void addSyscalls(std::uint64_t count);
+
+        /* Adds a read(2) call that took `nanos`. */
+        static void addRead(std::uint64_t nanos);
+
+        /* Adds `bytes` given back to the page cache once read. */
+        static void addDropped(std::uint64_t bytes);
+
+        /* Adds `bytes` read with O_DIRECT, around the page cache. */
+        static void addDirect(std::uint64_t bytes);
+
+        /* Adds `bytes` of holes of sparse files, hashed without being read. */
+        static void addHoles(std::uint64_t bytes);
+
+        /* Returns how much the page cache of the system grew, in bytes,
+         * since the statistics started to be collected, as told by the
+         * Cached line of /proc/meminfo. It counts the other programs too. */
+        static std::int64_t pageCacheGrowth();
+
+        /* Adds `bytes` hashed with the given hash type in `nanos`. */
+        static void addHash(std::size_t algorithm, std::uint64_t bytes, std::uint64_t nanos);
+
+        /* Adds a file of `bytes` that took `nanos` to be opened, read and hashed. */
+        static void addFile(std::uint64_t bytes, std::uint64_t nanos);
+
+        /* Returns the position of the hash type in HASH_TYPES, or
+         * HASH_TYPES.size() if it is unknown. */
+        static std::size_t algorithmIndex(const std::string& hashType);
+
+        /* Writes the statistics as text. The cache may be null. */
+        static void writeText(std::ostream& out, const HashCache* cache);
+
+        /* Writes the statistics as a JSON object. The cache may be null. */
+        static void writeJson(std::ostream& out, const HashCache* cache);
+    };
+
+    /* Adds the time from its creation to its destruction to a phase,
+     * when the statistics are enabled. */
+    class StatsTimer {
+        const EStatsPhase phase;
+        const std::uint64_t start;
+
+    public:
+        explicit StatsTimer(EStatsPhase phase)
+        : phase(phase), start(Stats::enabled() ? Stats::now() : 0) {  }
+
+        ~StatsTimer() {
+            if (start != 0)
+                Stats::addPhase(phase, Stats::now() - start);
+        }
+
+        StatsTimer(const StatsTimer&) = delete;
+        StatsTimer& operator=(const StatsTimer&) = delete;
+    };
+};
+
+#endif /* _SHAZAM_STATS_HEADER */
@@ -0,0 +1,64 @@
+#ifndef _SHAZAM_TREE_HEADER
+#define _SHAZAM_TREE_HEADER
+
+#include "./basic-types.hh"
+#include "./digest.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace shazam {
+    /* Position of SHA256-TREE in HASH_TYPES. */
+    constexpr std::size_t TREE_HASH_TYPE = 9;
+
+    static_assert(TREE_HASH_TYPE == STREAM_HASH_TYPES, "The tree hash comes after the streamed ones");
+
+    /* Size of the chunks of the tree hash. It is part of the format, so
+     * it is written in the header of the sections of tree sums. */
+    constexpr std::size_t TREE_CHUNK_SIZE = 1024 * 1024;
+
+    /* Files with less chunks than these are tree hashed by the calling
+     * thread alone, as starting the others would take longer. */
+    constexpr std::uintmax_t TREE_PARALLEL_MIN_CHUNKS = 8;
+
+    /* Calculates SHA256-TREE, a SHA256 Merkle tree over the chunks of a file,
+     * whose chunks are hashed in parallel. Its format is:
+     *
+     *  - The file is split into chunks of TREE_CHUNK_SIZE bytes, the last one
+     *    possibly shorter. An empty file has a single, empty, chunk.
+     *  - Each leaf is SHA256(0x00 || chunk).
+     *  - Each level is made by hashing the nodes of the level below in pairs,
+     *    from left to right, as SHA256(0x01 || left || right). The last node
+     *    of a level with an odd number of them goes up as it is.
+     *  - The digest is the root, the only node of the last level.
+     *
+     * The prefixes keep the leaves apart from the inner nodes, and every
+     * digest apart from the SHA256 of the same file.
+     * */
+    class TreeHasher {
+        const unsigned int threads;
+
+    public:
+        /* Hashes the chunks with up to `threads` threads, counting the calling one. */
+        explicit TreeHasher(unsigned int threads): threads(threads) {  }
+
+        /* Hashes the first `size` bytes of the file `fd`, read with pread(2),
+         * so that its offset is left alone. `progress` is called, from any of
+         * the threads, with the length of every chunk hashed. Throws
+         * std::runtime_error if the file can't be read or is shorter.
+         * */
+        Digest hash(int fd, std::uintmax_t size, const std::function<void(std::size_t)>& progress) const;
+
+        /* Hashes `len` bytes in memory, on the calling thread. */
+        static Digest hash(const unsigned char* data, std::size_t len);
+
+    private:
+        /* Returns the root of the tree with the given leaves. */
+        static Digest root(std::vector<unsigned char>& nodes, std::size_t leaves);
+    };
+};
+
+#endif /* _SHAZAM_TREE_HEADER */
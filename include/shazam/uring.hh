@@ -0,0 +1,87 @@
+#ifndef _SHAZAM_URING_HEADER
+#define _SHAZAM_URING_HEADER
+
+#include "./files.hh"
+#include "./reader.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <sys/stat.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace shazam {
+    /* Reads many small files whole through io_uring, with the system
+     * calls made directly, as there is no liburing to build against.
+     *
+     * Instead of an open, a stat, a read and a close per file, the opens
+     * of a group of files are submitted together, and then, for each of
+     * them, a stat, a read and a close linked one after the other. A group
+     * of files costs two io_uring_enter calls, and its requests are all
+     * in flight at once, which keeps the queue of fast disks busy.
+     * */
+    class UringBatchReader {
+        int ringFd;
+        unsigned int entries;
+        void* sqRing;
+        std::size_t sqRingSize;
+        void* cqRing;
+        std::size_t cqRingSize;
+        io_uring_sqe* sqes;
+        std::size_t sqesSize;
+
+        unsigned int* sqTail;
+        unsigned int* sqMask;
+        unsigned int* sqArray;
+        unsigned int* cqHead;
+        unsigned int* cqTail;
+        unsigned int* cqMask;
+        io_uring_cqe* cqes;
+
+        unsigned int pending = 0;
+
+    public:
+        /* Sets up a ring for `depth` requests in flight. Throws
+         * std::runtime_error if io_uring can't be used. */
+        explicit UringBatchReader(unsigned int depth);
+
+        ~UringBatchReader();
+
+        UringBatchReader(const UringBatchReader&) = delete;
+        UringBatchReader& operator=(const UringBatchReader&) = delete;
+
+        /* Returns true if the kernel lets this process use io_uring. */
+        static bool available();
+
+        /* Returns the reader of the calling thread, set up the first time
+         * with `depth` requests in flight, or null if io_uring can't be used. */
+        static UringBatchReader* local(unsigned int depth);
+
+        /* Reads the files, none bigger than `maxSize`, whole into `contents`,
+         * and their attributes from before the read into `filestats`. The
+         * files read are marked in `done`, the ones that couldn't be, or
+         * that changed size, are left to be read some other way.
+         * */
+        void read(const std::vector<std::shared_ptr<File>>& files, std::uintmax_t maxSize,
+                  std::vector<std::vector<unsigned char>>& contents, std::vector<struct stat>& filestats,
+                  std::vector<std::uint8_t>& done);
+
+    private:
+        /* Unmaps the queues and closes the ring. */
+        void release();
+
+        /* Returns a cleared entry of the submission queue. */
+        io_uring_sqe* nextEntry();
+
+        /* Submits the queued entries and waits for all of their completions,
+         * passing the user data and result of each one to `complete`. */
+        template <typename Function>
+        void submitAndWait(Function&& complete);
+    };
+};
+
+#endif /* _SHAZAM_URING_HEADER */
@@ -0,0 +1,93 @@
+#ifndef _SHAZAM_VERIFIER_HEADER
+#define _SHAZAM_VERIFIER_HEADER
+
+#include "./hash.hh"
+#include "./manifest.hh"
+#include "./pool.hh"
+#include "./reader.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace shazam {
+    /* Number of manifest entries verified by each task. */
+    constexpr std::size_t VERIFY_ENTRIES_PER_TASK = 32;
+
+    /* Number of tasks per thread that can be waiting to run, which
+     * bounds the memory used while reading a manifest. */
+    constexpr std::size_t VERIFY_TASKS_PER_THREAD = 8;
+
+    /* The counters of a manifest verification. */
+    struct VerificationSummary {
+        std::size_t matched;
+        std::size_t mismatched;
+        std::size_t unreadable;
+        std::size_t malformed;
+
+        /* Returns true if every entry matched. */
+        bool ok() const;
+    };
+
+    /* Verifies the files listed in a manifest against their expected
+     * hash sums. The manifest is read as a stream while the entries
+     * already read are being verified by the thread pool, and every
+     * failure is reported as soon as it is found, like coreutils does:
+     *
+     *     <file>: FAILED
+     *     <file>: FAILED open or read
+     * */
+    class Verifier {
+        unsigned int jobs;
+        bool failFast;
+        HashFactory hashFactory;
+        std::ostream& output;
+
+        std::mutex outputMutex;
+        std::mutex slotsMutex;
+        std::condition_variable slotFreed;
+        std::size_t queuedTasks;
+
+        std::atomic<bool> failed;
+        std::atomic<std::size_t> matched;
+        std::atomic<std::size_t> mismatched;
+        std::atomic<std::size_t> unreadable;
+
+    public:
+        Verifier(std::ostream& output = std::cout)
+        : jobs(onlineCpus()), failFast(false), output(output), queuedTasks(0),
+        failed(false), matched(0), mismatched(0), unreadable(0) {  }
+
+        /* Verifies the entries of the manifest. If `hashType` is given,
+         * it is used for the entries with no type of their own. */
+        VerificationSummary verify(std::istream& manifest, std::string hashType = "");
+
+        /* Sets the number of threads used to verify the files. */
+        void setJobs(unsigned int value);
+
+        /* If set to true, the verification stops at the first failure. */
+        void setFailFast(bool value);
+
+        /* Sets the strategy used to read the files, the number of buffers
+         * of the pipelined reads and the requests in flight of the
+         * io_uring reads, and how the reads use the page cache. */
+        void setIOMode(EIOMode mode, std::size_t buffers = PIPELINE_DEFAULT_BUFFERS,
+                       unsigned int queueDepth = URING_DEFAULT_DEPTH, EPageCacheMode pageCache = PAGE_CACHE_KEEP);
+
+    private:
+        /* Verifies a group of entries. */
+        void verifyEntries(const std::vector<ManifestEntry>& entries);
+
+        /* Verifies a single entry, returning false if it failed. */
+        bool verifyEntry(const ManifestEntry& entry);
+
+        /* Writes a failure report. */
+        void report(const std::string& filename, const std::string& message);
+    };
+};
+
+#endif /* _SHAZAM_VERIFIER_HEADER */
@@ -0,0 +1,122 @@
+#ifndef _SHAZAM_WALKER_HEADER
+#define _SHAZAM_WALKER_HEADER
+
+#include "./basic-types.hh"
+#include "./pool.hh"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace shazam {
+    /* When the walker follows symbolic links. */
+    enum ESymlinkPolicy {
+        SYMLINKS_NEVER,
+        SYMLINKS_ROOTS,
+        SYMLINKS_ALWAYS
+    };
+
+    /* Constant array with the names of the symlink policies, in the
+     * same order as the ESymlinkPolicy values.
+     * */
+    constexpr std::array<const char*, 3> SYMLINK_POLICIES = {
+        "never", "roots", "always"
+    };
+
+    /* Returns the symlink policy with the given name, throwing
+     * std::invalid_argument if there is none. */
+    ESymlinkPolicy symlinkPolicyFromName(std::string name);
+
+    /* The options of a tree walk. */
+    struct WalkOptions {
+        /* Which symbolic links are followed, by default only the ones
+         * given as roots, like `find -H`. */
+        ESymlinkPolicy symlinks = SYMLINKS_ROOTS;
+
+        /* If true, directories in other file systems are skipped. */
+        bool oneFileSystem = false;
+
+        /* If not empty, only the files matching one of these globs
+         * are visited. */
+        std::vector<std::string> include;
+
+        /* Files and directories matching one of these globs are skipped. */
+        std::vector<std::string> exclude;
+    };
+
+    /* Receives the files found by the walker, from the pool threads.
+     * Regular files are VALID_FILE, the entries that can't be visited
+     * have the reason as status. */
+    using FileVisitor = std::function<void(const std::string& path, EFileStatus status)>;
+
+    /* Called once the walks of a walker are done, from the thread that
+     * listed the last directory. */
+    using WalkDone = std::function<void(void)>;
+
+    /* Walks directory trees in parallel on a thread pool, where every
+     * directory is a task. Directories are listed with getdents64 and
+     * their subdirectories are opened relative to the directory fd. The
+     * entries whose type getdents64 doesn't tell, and the followed links,
+     * are stat'ed relative to it too. The files are passed to the visitor
+     * by their full path, as soon as they are found, so they can be
+     * hashed on the same pool while the walk goes on, and are opened by
+     * that path when hashed.
+     *
+     * The globs are matched against the name of the entries and their
+     * path relative to the root, so both `*.o` and `build/obj*` work.
+     *
+     * A directory is skipped when it is one of its own ancestors, which
+     * happens when symbolic links or bind mounts make loops. A directory
+     * reached by two paths that don't loop is listed under both.
+     * */
+    class TreeWalker {
+        struct Directory;
+
+        WorkStealingPool& pool;
+        const WalkOptions options;
+        const FileVisitor visit;
+        const WalkDone done;
+        std::atomic<std::size_t> pendingDirectories;
+
+    public:
+        TreeWalker(WorkStealingPool& pool, WalkOptions options, FileVisitor visit, WalkDone done = nullptr)
+        : pool(pool), options(options), visit(visit), done(done), pendingDirectories(0) {  }
+
+        TreeWalker(const TreeWalker&) = delete;
+        TreeWalker& operator=(const TreeWalker&) = delete;
+
+        /* Schedules the walk of the tree at `root`. The walk is done when
+         * `done` is called, or the pool has no more tasks. If `root` is a
+         * file, it is visited. */
+        void walk(const std::string& root);
+
+        /* Returns true if a file should be visited given the globs. */
+        bool included(const std::string& name, const std::string& relativePath) const;
+
+        /* Returns true if a file or directory is excluded by the globs. */
+        bool excluded(const std::string& name, const std::string& relativePath) const;
+
+    private:
+        /* Submits the task that lists the directory `name` of `parent`. */
+        void submitDirectory(std::shared_ptr<Directory> parent, std::string name, bool follow);
+
+        /* Lists the directory `name` of `parent`, or the root when
+         * `parent` is null, visiting its files and submitting its
+         * subdirectories. */
+        void listDirectory(std::shared_ptr<Directory> parent, const std::string& name, bool follow);
+
+        /* Handles an entry found in `directory`. */
+        void visitEntry(const std::shared_ptr<Directory>& directory, const char* name, unsigned char type);
+
+        /* Counts a directory listed, or the walk started, calling `done`
+         * when it was the last one. */
+        void directoryDone();
+    };
+};
+
+#endif /* _SHAZAM_WALKER_HEADER */
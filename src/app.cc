@@ -1,18 +1,37 @@
 #include "../include/shazam/app.hh"
 #include "../include/shazam/basic-types.hh"
+#include "../include/shazam/cache.hh"
 #include "../include/shazam/common.hh"
+#include "../include/shazam/device.hh"
 #include "../include/shazam/files.hh"
 #include "../include/shazam/hash.hh"
+#include "../include/shazam/manifest.hh"
 #include "../include/shazam/checker.hh"
+#include "../include/shazam/pool.hh"
+#include "../include/shazam/reader.hh"
+#include "../include/shazam/stats.hh"
+#include "../include/shazam/tree.hh"
+#include "../include/shazam/verifier.hh"
+#include "../include/shazam/walker.hh"
 
 #include "../include/external/argparse.hpp"
+#include "../include/external/hashlib2plus/hl_blake3.h"
+#include "../include/external/hashlib2plus/hl_cpuid.h"
+#include "../include/external/hashlib2plus/hl_multibuffer.h"
+#include "../include/external/hashlib2plus/hl_sha1.h"
+#include "../include/external/hashlib2plus/hl_sha256.h"
 
+#include <algorithm>
 #include <iostream>
 #include <filesystem>
+#include <fstream>
 #include <cassert>
 #include <memory>
 #include <sstream>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace fs = std::filesystem;
 namespace ap = argparse;
 
@@ -25,13 +44,95 @@ void shazam::App::setupArgparser()
     for (auto& htype : HASH_TYPES) {
         const std::string lower = toLowerCase(htype);
         args->add_argument("-" + lower, "--" + lower + "sum")
-                .help("use this to calculate the " + lower + " hash sum")
+                .help("use this to calculate the " + lower + " hash sum (can be combined)")
                 .default_value(false)
                 .implicit_value(true);
     }
 
+    args->add_argument("--files-from")
+            .help("also hash the files listed in this file, one per line (- for stdin), as the list is read");
+
+    args->add_argument("--null", "-0")
+            .help("the paths of the --files-from list are separated by NUL characters, as written by find -print0")
+            .default_value(false)
+            .implicit_value(true);
+
+    args->add_argument("--tee")
+            .help("copy the only file given, such as - for stdin, to this file while hashing it");
+
+    args->add_argument("--recursive", "-r")
+            .help("hash the files inside the given directories and their subdirectories")
+            .default_value(false)
+            .implicit_value(true);
+
+    args->add_argument("--symlinks")
+            .help("symbolic links followed when recursive: never, roots or always")
+            .default_value(std::string(SYMLINK_POLICIES[SYMLINKS_ROOTS]));
+
+    args->add_argument("--one-file-system", "-x")
+            .help("when recursive, don't descend into directories on other file systems")
+            .default_value(false)
+            .implicit_value(true);
+
+    args->add_argument("--include")
+            .help("when recursive, only hash the files matching this glob (can be repeated)")
+            .default_value(std::vector<std::string>())
+            .append();
+
+    args->add_argument("--exclude")
+            .help("when recursive, skip the files and directories matching this glob (can be repeated)")
+            .default_value(std::vector<std::string>())
+            .append();
+
     args->add_argument("--progress", "-P")
-            .help("show progress bars when calculating hashsums")
+            .help("show progress bars when calculating hashsums (the hash sums are shown at the end)")
+            .default_value(false)
+            .implicit_value(true);
+
+    args->add_argument("--unordered")
+            .help("show the hash sums as soon as they are calculated, not in the order of the files")
+            .default_value(false)
+            .implicit_value(true);
+
+    args->add_argument("--jobs", "-j")
+            .help("number of files hashed in parallel (default: online cpus)")
+            .default_value(onlineCpus())
+            .scan<'u', unsigned int>();
+
+    args->add_argument("--disk-jobs")
+            .help("number of files read at once from each spinning disk, while the other devices read --jobs of them")
+            .default_value(ROTATIONAL_DEVICE_JOBS)
+            .scan<'u', unsigned int>();
+
+    args->add_argument("--io-mode")
+            .help("how files are read: auto, buffer, mmap, read, pipeline or uring")
+            .default_value(std::string(IO_MODES[IO_AUTO]));
+
+    args->add_argument("--buffers")
+            .help("number of 8 MiB buffers per file of the pipelined reads, which overlap reading and hashing (1 to "
+                  + std::to_string(PIPELINE_MAX_BUFFERS) + ")")
+            .default_value((unsigned int) PIPELINE_DEFAULT_BUFFERS)
+            .scan<'u', unsigned int>();
+
+    args->add_argument("--queue-depth")
+            .help("number of requests kept in flight by each thread with the uring io mode (1 to "
+                  + std::to_string(URING_MAX_DEPTH) + ")")
+            .default_value(URING_DEFAULT_DEPTH)
+            .scan<'u', unsigned int>();
+
+    args->add_argument("--no-cache-pollution")
+            .help("give the pages of the files back to the page cache once they are read, so that what the "
+                  "other programs keep cached isn't evicted")
+            .default_value(false)
+            .implicit_value(true);
+
+    args->add_argument("--direct-io")
+            .help("read the files with O_DIRECT, around the page cache, where the file system allows it")
+            .default_value(false)
+            .implicit_value(true);
+
+    args->add_argument("--cpu-features")
+            .help("show the cpu features detected and the hash kernels in use, then exit")
             .default_value(false)
             .implicit_value(true);
 
@@ -40,38 +141,54 @@ void shazam::App::setupArgparser()
             .default_value(false)
             .implicit_value(true);
 
-    /* TODO: Implement the check sum option
+    args->add_argument("--cache")
+            .help("keep the hash sums in this file, to skip the files unchanged since the last run");
+
+    args->add_argument("--stats")
+            .help("show statistics about the run, such as the time spent reading and hashing")
+            .default_value(false)
+            .implicit_value(true);
+
+    args->add_argument("--stats-json")
+            .help("write the statistics about the run as JSON to this file (- for stderr)");
+
     args->add_argument("-c", "--check")
-            .help("Use this to check the hash sum")
+            .help("verify the files listed in a GNU or BSD style manifest (- for stdin)");
+
+    args->add_argument("--fail-fast")
+            .help("stop verifying at the first file that fails")
             .default_value(false)
             .implicit_value(true);
-    */
 }
 
-std::string shazam::App::getHashType()
+std::vector<std::string> shazam::App::getHashTypes(bool required)
 {
-    std::string hashType;
+    std::vector<std::string> hashTypes;
 
-    int counter = 0;
-    // Searching for all hash types to see if one was used
+    // Searching for all hash types to see which ones were used
     for (auto& htype : HASH_TYPES) {
-        if (args->is_used("-" + toLowerCase(htype)) && ++counter)
-            hashType = htype;
-
-        if (counter > 1) // If more than one were used show this error message
-            printErrMessage("You can chose only one hash type each time!");
+        if (args->is_used("-" + toLowerCase(htype)))
+            hashTypes.push_back(htype);
     }
 
-    if (counter == 0) // If no hash sum was indicated them print err message
+    if (hashTypes.empty() && required) // If no hash sum was indicated them print err message
         printErrMessage("Must specify the type of hash sum!\n\n" + args->help().str() + "\n");
 
-    return hashType;
+    return hashTypes;
 }
 
 void shazam::App::parseArguments(const int& argc, const char* const*& argv)
 {
+    std::vector<std::string> arguments(argv, argv + argc);
+
+    // The parser takes "-0" for a negative number, and so for a file
+    for (auto& argument : arguments) {
+        if (argument == "-0")
+            argument = "--null";
+    }
+
     try {
-        args->parse_args(argc, argv);
+        args->parse_args(arguments);
     } catch (const std::runtime_error &err) {
         std::stringstream sstrm;
         sstrm << *( args );
@@ -80,25 +197,284 @@ void shazam::App::parseArguments(const int& argc, const char* const*& argv)
     }
 }
 
-void shazam::App::getAndRegisterInputFiles(std::string hashType)
+std::vector<std::string> shazam::App::getInputFiles()
 {
     try {
-        const auto files = args->get<std::vector<std::string>>("files");
-
-        for (auto& file : files)
-            checker->add(fileFactory.create(file), hashType);
+        return args->get<std::vector<std::string>>("files");
     } catch (const std::logic_error &err) {
-        printErrMessage("No files were provided" + args->help().str() + "\n");
+        if (!args->is_used("--files-from"))
+            printErrMessage("No files were provided" + args->help().str() + "\n");
+    }
+
+    return {};
+}
+
+void shazam::App::registerInputFiles(const std::vector<std::string>& files, std::vector<std::string> hashTypes)
+{
+    const bool recursive = args->get<bool>("--recursive");
+
+    for (auto& file : files) {
+        if (recursive)
+            checker->addTree(file, hashTypes);
+        else
+            checker->add(fileFactory.create(file), hashTypes);
+    }
+}
+
+int shazam::App::openTee(const std::vector<std::string>& files, const std::vector<std::string>& hashTypes)
+{
+    if (!args->is_used("--tee"))
+        return -1;
+
+    if (files.size() != 1 || args->is_used("--files-from") || args->get<bool>("--recursive"))
+        printErrMessage("Only one file can be copied with --tee, and no directory nor list of files.\n");
+
+    // Its chunks are read apart from the other hash types, which are the ones copied
+    if (std::find(hashTypes.begin(), hashTypes.end(), HASH_TYPES[TREE_HASH_TYPE]) != hashTypes.end())
+        printErrMessage("The " + std::string(HASH_TYPES[TREE_HASH_TYPE]) + " hash sum can't be used with --tee.\n");
+
+    const std::string path = args->get<std::string>("--tee");
+    const int descriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+
+    if (descriptor < 0)
+        printErrMessage("Cannot write the copy to \"" + path + "\".\n");
+
+    return descriptor;
+}
+
+void shazam::App::hashInputFiles(const std::vector<std::string>& files, const std::vector<std::string>& hashTypes)
+{
+    const bool recursive = args->get<bool>("--recursive");
+    std::ifstream file;
+    std::istream* list = nullptr;
+
+    if (args->is_used("--files-from")) {
+        const std::string path = args->get<std::string>("--files-from");
+
+        if (path != "-") {
+            file.open(path);
+
+            if (!file)
+                printErrMessage("Cannot read the list of files \"" + path + "\".\n");
+        }
+
+        list = path == "-" ? &std::cin : &file;
+    }
+
+    PathListReader listed(list != nullptr ? *list : file, args->get<bool>("--null") ? '\0' : '\n');
+    auto next = files.begin();
+
+    const PathSource nextPath = [&](std::string& path) {
+        if (next != files.end()) {
+            path = *next++;
+            return true;
+        }
+
+        return list != nullptr && listed.next(path);
+    };
+
+    // The progress bar would be mixed with the hash sums, so they are
+    // only streamed without it. It needs every file before starting, so
+    // the whole list is read first.
+    if (args->get<bool>("--progress")) {
+        std::vector<std::string> paths;
+        std::string path;
+
+        while (nextPath(path))
+            paths.push_back(path);
+
+        this->registerInputFiles(paths, hashTypes);
+        checker->calculateHashSums();
+    } else {
+        checker->streamHashSums(nextPath, hashTypes, recursive, std::cout);
+    }
+}
+
+shazam::WalkOptions shazam::App::getWalkOptions()
+{
+    WalkOptions options;
+
+    try {
+        options.symlinks = symlinkPolicyFromName(args->get<std::string>("--symlinks"));
+    } catch (const std::invalid_argument& err) {
+        printErrMessage(std::string(err.what()) + "\n\n" + args->help().str() + "\n");
+    }
+
+    options.oneFileSystem = args->get<bool>("--one-file-system");
+    options.include = args->get<std::vector<std::string>>("--include");
+    options.exclude = args->get<std::vector<std::string>>("--exclude");
+    return options;
+}
+
+shazam::EIOMode shazam::App::getIOMode()
+{
+    try {
+        return ioModeFromName(args->get<std::string>("--io-mode"));
+    } catch (const std::invalid_argument& err) {
+        printErrMessage(std::string(err.what()) + "\n\n" + args->help().str() + "\n");
     }
+
+    return IO_AUTO;
+}
+
+std::size_t shazam::App::getReadBuffers()
+{
+    const unsigned int buffers = args->get<unsigned int>("--buffers");
+
+    if (buffers < 1 || buffers > PIPELINE_MAX_BUFFERS)
+        printErrMessage("The number of buffers must be between 1 and " + std::to_string(PIPELINE_MAX_BUFFERS) + ".\n");
+
+    return buffers;
+}
+
+unsigned int shazam::App::getQueueDepth()
+{
+    const unsigned int depth = args->get<unsigned int>("--queue-depth");
+
+    if (depth < 1 || depth > URING_MAX_DEPTH)
+        printErrMessage("The queue depth must be between 1 and " + std::to_string(URING_MAX_DEPTH) + ".\n");
+
+    return depth;
+}
+
+shazam::EPageCacheMode shazam::App::getPageCacheMode()
+{
+    if (args->get<bool>("--direct-io"))
+        return PAGE_CACHE_BYPASS;
+
+    if (args->get<bool>("--no-cache-pollution"))
+        return PAGE_CACHE_DROP;
+
+    return PAGE_CACHE_KEEP;
+}
+
+void shazam::App::displayCpuFeatures()
+{
+    std::cout << "CPU features: " << hlCpuFeaturesString() << "\n";
+    std::cout << "SHA1 kernel: " << SHA1::SHA1Kernel() << "\n";
+    std::cout << "SHA256 kernel: " << SHA256::SHA256_Kernel() << "\n";
+    std::cout << "BLAKE3 kernel: " << BLAKE3::BLAKE3_Kernel() << "\n";
+    std::cout << "Multi-buffer kernel: " << multibuffer::kernel()
+              << " (" << multibuffer::lanes() << " lanes)\n";
+}
+
+void shazam::App::displayStats(std::shared_ptr<HashCache> cache)
+{
+    if (args->get<bool>("--stats"))
+        Stats::writeText(std::cerr, cache.get());
+
+    if (!args->is_used("--stats-json"))
+        return;
+
+    const std::string path = args->get<std::string>("--stats-json");
+
+    if (path == "-") {
+        Stats::writeJson(std::cerr, cache.get());
+        return;
+    }
+
+    std::ofstream file(path);
+    Stats::writeJson(file, cache.get());
+
+    if (!file.flush())
+        printErrMessage("Cannot write the statistics to \"" + path + "\".\n");
+}
+
+int shazam::App::verifyManifest(const std::string& path)
+{
+    const auto hashTypes = this->getHashTypes(false);
+
+    if (hashTypes.size() > 1)
+        printErrMessage("Only one type of hash sum can be used to verify a manifest!\n");
+
+    Verifier verifier;
+    verifier.setIOMode(this->getIOMode(), this->getReadBuffers(), this->getQueueDepth(),
+                       this->getPageCacheMode());
+    verifier.setJobs(args->get<unsigned int>("--jobs"));
+    verifier.setFailFast(args->get<bool>("--fail-fast"));
+
+    std::ifstream file;
+
+    if (path != "-") {
+        file.open(path);
+
+        if (!file)
+            printErrMessage("Cannot read the manifest \"" + path + "\".\n");
+    }
+
+    const auto summary = verifier.verify(path == "-" ? std::cin : file, hashTypes.empty() ? "" : hashTypes.front());
+
+    if (summary.malformed > 0)
+        std::cerr << "WARNING: " << summary.malformed << " line(s) improperly formatted\n";
+    if (summary.unreadable > 0)
+        std::cerr << "WARNING: " << summary.unreadable << " listed file(s) could not be read\n";
+    if (summary.mismatched > 0)
+        std::cerr << "WARNING: " << summary.mismatched << " computed checksum(s) did NOT match\n";
+    if (summary.matched + summary.mismatched + summary.unreadable == 0)
+        std::cerr << "WARNING: no properly formatted checksum lines found\n";
+
+    return summary.ok() && summary.matched > 0 ? 0 : 1;
 }
 
 int shazam::App::run(const int& argc, const char* const*& argv)
 {
     this->parseArguments(argc, argv);
-    this->getAndRegisterInputFiles(this->getHashType());
+
+    if (args->get<bool>("--cpu-features")) {
+        this->displayCpuFeatures();
+        return 0;
+    }
+
+    Stats::setEnabled(args->get<bool>("--stats") || args->is_used("--stats-json"));
+
+    if (args->is_used("--check")) {
+        const int status = this->verifyManifest(args->get<std::string>("--check"));
+        this->displayStats(nullptr);
+        return status;
+    }
+
+    std::shared_ptr<HashCache> cache;
+
+    if (args->is_used("--cache"))
+        cache = std::make_shared<HashCache>(args->get<std::string>("--cache"));
+
+    const auto hashTypes = this->getHashTypes();
+    const auto files = this->getInputFiles();
+
+    checker->setIOMode(this->getIOMode(), this->getReadBuffers(), this->getQueueDepth(),
+                        this->getPageCacheMode());
+    checker->setCache(cache);
+    checker->setWalkOptions(this->getWalkOptions());
     checker->setShowProgressBar(args->get<bool>("--progress"));
     checker->setShowInvalidFiles(!args->get<bool>("--hide-invalid"));
-    checker->calculateHashSums();
-    checker->displayResults();
+    checker->setJobs(args->get<unsigned int>("--jobs"));
+    checker->setRotationalJobs(args->get<unsigned int>("--disk-jobs"));
+    checker->setUnordered(args->get<bool>("--unordered"));
+
+    const int tee = this->openTee(files, hashTypes);
+    checker->setTee(tee);
+
+    this->hashInputFiles(files, hashTypes);
+
+    {
+        const StatsTimer timer(PHASE_OUTPUT);
+        checker->displayResults();
+        std::cout.flush();
+    }
+
+    // A file that couldn't be read, or written, left the copy incomplete
+    if (tee >= 0 && (close(tee) != 0 || !checker->getInvalidFilesList().empty()))
+        printErrMessage("The copy in \"" + args->get<std::string>("--tee") + "\" is incomplete.\n");
+
+    this->displayStats(cache);
+
+    if (cache != nullptr) {
+        try {
+            cache->save();
+        } catch (const std::runtime_error& err) {
+            printErrMessage(std::string(err.what()) + "\n");
+        }
+    }
+
     return 0;
 }
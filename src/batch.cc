@@ -0,0 +1,197 @@
+#include "../include/shazam/batch.hh"
+#include "../include/shazam/basic-types.hh"
+#include "../include/shazam/files.hh"
+#include "../include/shazam/hash.hh"
+#include "../include/shazam/stats.hh"
+#include "../include/shazam/uring.hh"
+
+#include "../include/external/hashlib2plus/hl_multibuffer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Returns the hashlib type with the given name, HASH_TYPES being
+ * in the same order as HL_Wrappertype. */
+static bool wrapperTypeFromName(const std::string& name, HL_Wrappertype& type)
+{
+    const std::size_t index = shazam::hashTypeIndex(name);
+    type = (HL_Wrappertype) index;
+    return index < shazam::HASH_TYPES.size();
+}
+
+/* Reads the whole file into `content`, and its attributes from before the read into `filestat`.
+ * Unless the page cache is kept, its pages are given back once read. */
+static void readWholeFile(shazam::File& file, std::vector<unsigned char>& content, struct stat& filestat,
+                          shazam::EPageCacheMode pageCache)
+{
+    const int fd = file.open(filestat);
+
+    // One more byte than expected, to notice files that grew
+    content.resize(filestat.st_size + 1);
+    std::size_t used = 0;
+    const bool timed = shazam::Stats::enabled();
+
+    while (true) {
+        if (used == content.size())
+            content.resize(content.size() * 2);
+
+        const std::uint64_t start = timed ? shazam::Stats::now() : 0;
+        const ssize_t n = ::read(fd, content.data() + used, content.size() - used);
+
+        if (timed)
+            shazam::Stats::addRead(shazam::Stats::now() - start);
+
+        if (n == 0)
+            break;
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+
+            close(fd);
+            throw std::runtime_error("Cannot read file \"" + file.path() + "\".");
+        }
+
+        used += n;
+    }
+
+    if (pageCache != shazam::PAGE_CACHE_KEEP) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        shazam::Stats::addSyscalls(1);
+        shazam::Stats::addDropped(used);
+    }
+
+    close(fd);
+    shazam::Stats::addSyscalls(1);
+    content.resize(used);
+}
+
+bool shazam::BatchHasher::accepts(HashCalculator& hash)
+{
+    if (hash.getFile()->isStream() || hash.getReaders().getTee() >= 0)
+        return false;
+
+    return accepts(hash.getFileSize(), hash.types());
+}
+
+bool shazam::BatchHasher::accepts(std::uintmax_t size, const std::vector<std::string>& types)
+{
+    if (size > BATCH_MAX_FILE_SIZE)
+        return false;
+
+    for (auto& name : types) {
+        HL_Wrappertype type;
+
+        if (!wrapperTypeFromName(name, type) || !multibuffer::preferred(type))
+            return false;
+    }
+
+    return true;
+}
+
+std::size_t shazam::BatchHasher::lanes(void)
+{
+    return multibuffer::lanes();
+}
+
+void shazam::BatchHasher::calculate(const std::vector<std::shared_ptr<HashCalculator>>& batch)
+{
+    std::vector<std::shared_ptr<HashCalculator>> hashes;
+
+    for (auto& hash : batch) {
+        if (!hash->calculateFromCache())
+            hashes.push_back(hash);
+    }
+
+    if (hashes.empty())
+        return;
+
+    const std::size_t count = hashes.size();
+    std::vector<std::vector<unsigned char>> contents(count);
+    std::vector<struct stat> filestats(count);
+    std::vector<const hl_uint8*> messages(count);
+    std::vector<std::size_t> lengths(count);
+
+    // Every file is charged with its own read and an even share of the hashing
+    const bool timed = Stats::enabled();
+    std::vector<std::uint64_t> latencies(count);
+    std::uint64_t bytes = 0;
+
+    // With io_uring the files are read together, and each one is charged an even share.
+    // Their pages can't be given back, as they are closed by the ring, so then they are
+    // read one by one
+    std::vector<std::uint8_t> read(count, 0);
+    const ReaderFactory& readers = hashes.front()->getReaders();
+    UringBatchReader* uring = readers.getMode() == IO_URING && readers.getPageCacheMode() == PAGE_CACHE_KEEP
+                            ? UringBatchReader::local(readers.getQueueDepth()) : nullptr;
+
+    if (uring != nullptr) {
+        std::vector<std::shared_ptr<File>> files;
+
+        for (auto& hash : hashes)
+            files.push_back(hash->getFile());
+
+        const std::uint64_t start = timed ? Stats::now() : 0;
+        uring->read(files, BATCH_MAX_FILE_SIZE, contents, filestats, read);
+
+        if (timed) {
+            for (auto& latency : latencies)
+                latency = (Stats::now() - start) / count;
+        }
+    }
+
+    for (std::size_t i = 0; i < count; i++) {
+        const std::uint64_t start = timed ? Stats::now() : 0;
+
+        if (!read[i])
+            readWholeFile(*hashes[i]->getFile(), contents[i], filestats[i], readers.getPageCacheMode());
+
+        messages[i] = contents[i].data();
+        lengths[i] = contents[i].size();
+        bytes += lengths[i];
+        hashes[i]->notifyProgress(lengths[i]);
+
+        if (timed)
+            latencies[i] += Stats::now() - start;
+    }
+
+    const std::vector<std::string> names = hashes.front()->types();
+    std::vector<std::vector<Digest>> sums(count);
+    std::vector<unsigned char> results(count * Digest::MAX_SIZE);
+
+    for (std::size_t t = 0; t < names.size(); t++) {
+        HL_Wrappertype type;
+
+        if (!wrapperTypeFromName(names[t], type))
+            throw std::runtime_error("Unknown hash type \"" + names[t] + "\".");
+
+        const std::uint64_t start = timed ? Stats::now() : 0;
+        const std::size_t len = multibuffer::hash(type, messages.data(), lengths.data(), count,
+                                                  results.data(), Digest::MAX_SIZE);
+
+        if (timed) {
+            const std::uint64_t nanos = Stats::now() - start;
+            Stats::addHash(Stats::algorithmIndex(names[t]), bytes, nanos);
+
+            for (auto& latency : latencies)
+                latency += nanos / count;
+        }
+
+        for (std::size_t i = 0; i < count; i++)
+            sums[i].emplace_back((std::size_t) type, results.data() + i * Digest::MAX_SIZE, len);
+    }
+
+    for (std::size_t i = 0; i < count; i++) {
+        hashes[i]->setHashSums(sums[i], filestats[i]);
+        Stats::addFile(lengths[i], latencies[i]);
+    }
+}
@@ -0,0 +1,268 @@
+#include "../include/shazam/cache.hh"
+#include "../include/shazam/basic-types.hh"
+#include "../include/shazam/common.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char CACHE_MAGIC[8] = {'S', 'H', 'A', 'Z', 'C', 'A', 'C', 'H'};
+/* Version 2 moved SHA256-TREE after the hash types added before it,
+ * so the positions kept in the records of version 1 are stale. */
+static const std::uint32_t CACHE_VERSION = 2;
+
+/* FNV-1a hash of the record, with the checksum field taken as zero. */
+static std::uint32_t recordChecksum(shazam::CacheRecord record)
+{
+    record.checksum = 0;
+    const unsigned char* bytes = (const unsigned char*) &record;
+    std::uint32_t hash = 2166136261u;
+
+    for (std::size_t i = 0; i < sizeof(record); i++)
+        hash = (hash ^ bytes[i]) * 16777619u;
+
+    return hash;
+}
+
+static std::int64_t nanoseconds(const struct timespec& time)
+{
+    return (std::int64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+/* Writes the whole buffer, retrying on short writes. */
+static bool writeAll(int fd, const void* data, std::size_t len)
+{
+    const char* bytes = (const char*) data;
+
+    while (len > 0) {
+        const ssize_t n = write(fd, bytes, len);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+
+        bytes += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+bool shazam::HashCache::Key::operator==(const Key& other) const
+{
+    return device == other.device && inode == other.inode && algorithm == other.algorithm;
+}
+
+std::size_t shazam::HashCache::KeyHash::operator()(const Key& key) const
+{
+    return std::hash<std::uint64_t>()(key.inode * 31 + key.device) ^ key.algorithm;
+}
+
+shazam::HashCache::HashCache(std::string path)
+: path(path), deadRecords(0), needsRewrite(false), hits(0), misses(0)
+{
+    load();
+}
+
+bool shazam::HashCache::lookup(const struct stat& filestat, std::size_t algorithm, Digest& digest)
+{
+    if (algorithm < HASH_TYPES.size()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = records.find(Key { (std::uint64_t) filestat.st_dev, (std::uint64_t) filestat.st_ino,
+                                           (std::uint8_t) algorithm });
+
+        if (it != records.end()
+                && it->second.size == (std::uint64_t) filestat.st_size
+                && it->second.mtimeNs == nanoseconds(filestat.st_mtim)
+                && it->second.ctimeNs == nanoseconds(filestat.st_ctim)) {
+            digest = Digest(algorithm, it->second.digest, it->second.digestSize);
+            hits++;
+            return true;
+        }
+    }
+
+    misses++;
+    return false;
+}
+
+void shazam::HashCache::store(const struct stat& filestat, const Digest& digest)
+{
+    if (digest.type() >= HASH_TYPES.size() || digest.empty() || digest.size() > sizeof(CacheRecord::digest))
+        return;
+
+    CacheRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.device = filestat.st_dev;
+    record.inode = filestat.st_ino;
+    record.size = filestat.st_size;
+    record.mtimeNs = nanoseconds(filestat.st_mtim);
+    record.ctimeNs = nanoseconds(filestat.st_ctim);
+    record.algorithm = digest.type();
+    record.digestSize = digest.size();
+    std::memcpy(record.digest, digest.data(), digest.size());
+    record.checksum = recordChecksum(record);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    insert(record);
+    appended.push_back(record);
+}
+
+void shazam::HashCache::save()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (needsRewrite || (deadRecords >= CACHE_MIN_DEAD_RECORDS && deadRecords > records.size()))
+        rewrite();
+    else if (!appended.empty())
+        append();
+}
+
+std::size_t shazam::HashCache::getHits() const
+{
+    return hits;
+}
+
+std::size_t shazam::HashCache::getMisses() const
+{
+    return misses;
+}
+
+void shazam::HashCache::load()
+{
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) {
+        // A missing cache is created on save
+        needsRewrite = true;
+        return;
+    }
+
+    struct stat filestat;
+
+    if (fstat(fd, &filestat) != 0 || (std::size_t) filestat.st_size < sizeof(CacheHeader)) {
+        close(fd);
+        needsRewrite = true;
+        return;
+    }
+
+    const std::size_t size = filestat.st_size;
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        needsRewrite = true;
+        return;
+    }
+
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    const auto* header = (const CacheHeader*) data;
+
+    if (std::memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+            || header->version != CACHE_VERSION
+            || header->recordSize != sizeof(CacheRecord)) {
+        munmap(data, size);
+        needsRewrite = true;
+        return;
+    }
+
+    const std::size_t count = (size - sizeof(CacheHeader)) / sizeof(CacheRecord);
+    const auto* first = (const CacheRecord*) ((const char*) data + sizeof(CacheHeader));
+
+    for (std::size_t i = 0; i < count; i++) {
+        if (recordChecksum(first[i]) != first[i].checksum || first[i].digestSize > sizeof(CacheRecord::digest)) {
+            // Everything after a torn record is dropped by the next save
+            needsRewrite = true;
+            break;
+        }
+
+        insert(first[i]);
+    }
+
+    // A partial record at the end would misalign the next appends
+    if (sizeof(CacheHeader) + count * sizeof(CacheRecord) != size)
+        needsRewrite = true;
+
+    munmap(data, size);
+}
+
+void shazam::HashCache::insert(const CacheRecord& record)
+{
+    const auto result = records.insert_or_assign(Key { record.device, record.inode, record.algorithm }, record);
+
+    if (!result.second)
+        deadRecords++;
+}
+
+void shazam::HashCache::append()
+{
+    const int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+
+    if (fd < 0)
+        throw std::runtime_error("Cannot write the cache \"" + path + "\".");
+
+    const bool written = writeAll(fd, appended.data(), appended.size() * sizeof(CacheRecord));
+    close(fd);
+
+    if (!written)
+        throw std::runtime_error("Cannot write the cache \"" + path + "\".");
+
+    appended.clear();
+}
+
+void shazam::HashCache::rewrite()
+{
+    const std::string temporary = path + ".tmp." + std::to_string(getpid());
+    const int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    if (fd < 0)
+        throw std::runtime_error("Cannot write the cache \"" + path + "\".");
+
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.recordSize = sizeof(CacheRecord);
+
+    std::vector<CacheRecord> live;
+    live.reserve(records.size());
+
+    for (auto& entry : records)
+        live.push_back(entry.second);
+
+    // The new file must be complete on disk before it replaces the old one
+    const bool written = writeAll(fd, &header, sizeof(header))
+        && writeAll(fd, live.data(), live.size() * sizeof(CacheRecord))
+        && fsync(fd) == 0;
+
+    close(fd);
+
+    if (!written || rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+        throw std::runtime_error("Cannot write the cache \"" + path + "\".");
+    }
+
+    // Make the rename itself durable
+    const std::size_t slash = path.rfind('/');
+    const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    const int dirfd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (dirfd >= 0) {
+        fsync(dirfd);
+        close(dirfd);
+    }
+
+    appended.clear();
+    deadRecords = 0;
+    needsRewrite = false;
+}
@@ -1,19 +1,133 @@
 #include "../include/shazam/checker.hh"
+#include "../include/shazam/batch.hh"
+#include "../include/shazam/device.hh"
 #include "../include/shazam/hash.hh"
 #include "../include/shazam/files.hh"
+#include "../include/shazam/manifest.hh"
+#include "../include/shazam/output.hh"
+#include "../include/shazam/walker.hh"
+
+#include "../include/external/hashlib2plus/hl_blake3.h"
 
 #include <list>
 #include <string>
 #include <memory>
 #include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    /* A row of the file table waiting to be hashed. */
+    struct ScheduledRow {
+        std::size_t row;
+        std::uintmax_t size;
+        std::uint64_t device;
+        /* Whether the device is a spinning disk, whose files are read in
+         * the order of their position on it, and then of their inodes. */
+        bool sequential;
+        std::uint64_t position;
+        std::uint64_t inode;
+    };
+
+    /* Places the files of the spinning disks first, as they are laid out
+     * on them, and then the others, the bigger files first. */
+    bool scheduledBefore(const ScheduledRow& a, const ScheduledRow& b)
+    {
+        if (a.sequential != b.sequential)
+            return a.sequential;
+
+        if (!a.sequential)
+            return a.size > b.size;
+
+        return std::tie(a.device, a.position, a.inode) < std::tie(b.device, b.position, b.inode);
+    }
+
+    /* Returns where the file at `row` starts on its disk, opening it for
+     * a moment if the table doesn't keep it open. */
+    std::uint64_t physicalPosition(const shazam::FileTable& files, std::size_t row)
+    {
+        if (files.descriptor(row) >= 0)
+            return shazam::physicalOffset(files.descriptor(row));
+
+        const int descriptor = open(files.path(row).c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (descriptor < 0)
+            return shazam::UNKNOWN_PHYSICAL_OFFSET;
+
+        const std::uint64_t position = shazam::physicalOffset(descriptor);
+        close(descriptor);
+        return position;
+    }
+
+    /* Returns where `file` starts on its disk, through the descriptor kept
+     * by its validation, or opening it for a moment if there is none. */
+    std::uint64_t physicalPosition(const shazam::File& file)
+    {
+        if (file.descriptor() >= 0)
+            return shazam::physicalOffset(file.descriptor());
+
+        const int descriptor = open(file.path().c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (descriptor < 0)
+            return shazam::UNKNOWN_PHYSICAL_OFFSET;
+
+        const std::uint64_t position = shazam::physicalOffset(descriptor);
+        close(descriptor);
+        return position;
+    }
+
+    /* Returns the device of the file system holding `root`, or 0 if
+     * it can't be found out. */
+    std::uint64_t deviceOf(const std::string& root)
+    {
+        struct stat rootstat;
+        return stat(root.c_str(), &rootstat) == 0 ? (std::uint64_t) rootstat.st_dev : 0;
+    }
+}
 
 void shazam::Checker::displayValidHashes()
 {
-    if (!validFilesHashes.empty()) {
-        for (auto& hash : validFilesHashes) {
-            std::cout << hash->get().hashSum << " ";
-            std::cout << hash->getFilePath() << "\n";
+    std::vector<std::string> types;
+
+    forEachValidFile([&](std::size_t row) {
+        for (auto& type : typeSets[fileTypes[row]]) {
+            if (std::find(types.begin(), types.end(), type) == types.end())
+                types.push_back(type);
         }
+    });
+
+    for (auto& type : types) {
+        if (types.size() > 1 || alwaysInSection(type))
+            std::cout << (type == types.front() ? "" : "\n") << sectionHeader(type) << "\n";
+
+        const std::size_t algorithm = hashTypeIndex(type);
+        char hex[2 * Digest::MAX_SIZE];
+
+        forEachValidFile([&](std::size_t row) {
+            std::size_t offset = digestOffsets[row];
+
+            for (auto rowType : typeSetIndexes[fileTypes[row]]) {
+                const std::size_t size = HASH_DIGEST_SIZES[rowType];
+
+                if (rowType == algorithm) {
+                    Digest::writeHex(digests.data() + offset, size, hex);
+                    std::cout.write(hex, 2 * size) << " " << validFiles.path(row) << "\n";
+                }
+
+                offset += size;
+            }
+        });
     }
 }
 
@@ -33,33 +147,636 @@ void shazam::Checker::displayInvalidFiles()
 
 void shazam::Checker::add(std::shared_ptr<shazam::File> file, std::string hashtype)
 {
-    if (file->isValid()) {
-        auto hash = hashFactory.hashFile(hashtype, file);
-        hash->setObserver(progress);
-        validFilesHashes.push_front(hash);
-    } else
-        invalidFilesList.push_front(file);
+    add(file, std::vector<std::string>{hashtype});
+}
+
+void shazam::Checker::add(std::shared_ptr<shazam::File> file, std::vector<std::string> hashtypes)
+{
+    if (!file->isValid()) {
+        invalidFilesList.push_back(file);
+        return;
+    }
+
+    const std::size_t types = typeSetIndex(hashtypes);
+    const std::size_t row = validFiles.add(*file);
+    addRow(types);
+    progress->expect(validFiles.fileSize(row));
 }
 
 void shazam::Checker::calculateHashSums()
 {
-    if (showProgressBar) {
-        // add observer for the init operation
-        progress->increaseObervableCounter();
-        // initialize the progress bar
+    if (showProgressBar)
         progress->init();
-        // after calling init, update the progress bar
-        progress->update();
+
+    // The results are kept in the input order, only the order
+    // in which they are calculated changes
+    std::vector<ScheduledRow> schedule;
+    schedule.reserve(validFiles.size() - calculatedRows);
+
+    for (std::size_t row = calculatedRows; row < validFiles.size(); row++) {
+        const std::uint64_t device = validFiles.device(row);
+        const bool sequential = isRotationalDevice(device);
+
+        schedule.push_back(ScheduledRow {
+            row, validFiles.fileSize(row), device, sequential,
+            sequential ? physicalPosition(validFiles, row) : 0, validFiles.inode(row)
+        });
+    }
+
+    calculatedRows = validFiles.size();
+    std::stable_sort(schedule.begin(), schedule.end(), scheduledBefore);
+
+    // Small files are hashed together by the batch hasher, in groups
+    // on the same device and sharing the same hash types, after all
+    // the bigger files of their device
+    std::vector<DeviceTask> tasks;
+    std::map<std::pair<std::uint64_t, std::size_t>, std::vector<std::size_t>> batches;
+    const std::size_t batchSize = BatchHasher::lanes() * BATCH_GROUPS_PER_TASK;
+
+    for (auto& entry : schedule) {
+        const std::size_t row = entry.row;
+        auto& batch = batches[{entry.device, fileTypes[row]}];
+
+        if (validFiles.stream(row) || hashFactory.getTee() >= 0
+            || !BatchHasher::accepts(entry.size, typeSets[fileTypes[row]])) {
+            tasks.emplace_back(entry.device, [this, row]() { hashRows({row}); });
+            continue;
+        }
+
+        batch.push_back(row);
+
+        if (batch.size() == batchSize) {
+            tasks.emplace_back(entry.device, [this, rows = std::move(batch)]() { hashRows(rows); });
+            batch.clear();
+        }
+    }
+
+    for (auto& batch : batches) {
+        if (!batch.second.empty())
+            tasks.emplace_back(batch.first.first, [this, rows = std::move(batch.second)]() { hashRows(rows); });
+    }
+
+    const auto threads = std::min<std::size_t>(jobs, tasks.size());
+
+    // The pool already keeps the threads busy with several files, so
+    // only a lone file has its parts hashed by all of them
+    setFileThreads(trees.empty() && threads <= 1 ? jobs : 1);
+
+    if (!trees.empty()) {
+        calculateWithTrees(tasks);
+    } else if (threads <= 1) {
+        for (auto& task : tasks)
+            task.second();
+    } else {
+        // The scheduler is used by the pool tasks, so the pool has to
+        // be gone before it
+        DeviceScheduler scheduler(threads, rotationalJobs);
+        WorkStealingPool pool(threads);
+
+        for (auto& task : tasks)
+            scheduler.submit(pool, task.first, std::move(task.second));
+
+        pool.wait();
+    }
+}
+
+bool shazam::Checker::calculateHash(std::shared_ptr<HashCalculator> hash)
+{
+    try {
+        hash->calculate();
+        return true;
+    } catch (const std::runtime_error& err) {
+        std::lock_guard<std::mutex> lock(listsMutex);
+        invalidFilesList.push_back(std::make_shared<File>(hash->getFilePath(), NON_READABLE));
+        return false;
+    }
+}
+
+void shazam::Checker::setFileThreads(unsigned int threads)
+{
+    hashFactory.setTreeThreads(threads);
+    BLAKE3::BLAKE3_Set_Threads(threads);
+}
+
+void shazam::Checker::calculateWithTrees(std::vector<DeviceTask>& tasks)
+{
+    std::vector<std::vector<std::shared_ptr<HashCalculator>>> found(trees.size());
+    std::vector<std::unique_ptr<TreeWalker>> walkers;
+    DeviceScheduler scheduler(jobs, rotationalJobs);
+
+    {
+        // The walkers and the scheduler are used by the pool tasks, so
+        // the pool has to be gone before them
+        WorkStealingPool pool(jobs);
+
+        for (std::size_t i = 0; i < trees.size(); i++) {
+            const std::uint64_t device = deviceOf(trees[i].root);
+
+            walkers.push_back(std::make_unique<TreeWalker>(pool, walkOptions,
+                [this, i, device, &pool, &scheduler, &found](const std::string& path, EFileStatus status) {
+                    auto file = std::make_shared<File>(path, status);
+
+                    if (!file->isValid()) {
+                        std::lock_guard<std::mutex> lock(listsMutex);
+                        invalidFilesList.push_back(file);
+                        return;
+                    }
+
+                    auto hash = hashFactory.hashFile(trees[i].hashtypes, file);
+
+                    // The sizes are only needed by the progress bar
+                    if (showProgressBar) {
+                        progress->expect(hash->getFileSize());
+                        hash->setObserver(progress);
+                    }
+
+                    scheduler.submit(pool, device, [this, i, hash, &found]() {
+                        if (calculateHash(hash)) {
+                            std::lock_guard<std::mutex> lock(listsMutex);
+                            found[i].push_back(hash);
+                        }
+
+                        hash->notifyObserver();
+                    });
+                }
+            ));
+
+            walkers.back()->walk(trees[i].root);
+        }
+
+        for (auto& task : tasks)
+            scheduler.submit(pool, task.first, std::move(task.second));
+
+        pool.wait();
+    }
+
+    // The files of the trees go to the end of the table, and the display
+    // order places them where their trees were added
+    std::vector<std::size_t> previous = std::move(displayOrder);
+    std::vector<std::size_t> order;
+    std::size_t position = 0;
+
+    displayOrder.clear();
+
+    if (previous.empty()) {
+        for (std::size_t row = 0; row < validFiles.size(); row++)
+            previous.push_back(row);
+    }
+
+    for (std::size_t i = 0; i < trees.size(); i++) {
+        auto& hashes = found[i];
+
+        std::sort(hashes.begin(), hashes.end(),
+            [](const auto& a, const auto& b) { return a->getFilePath() < b->getFilePath(); });
+
+        for (; position < trees[i].position; position++)
+            order.push_back(previous[position]);
+
+        const std::size_t types = typeSetIndex(trees[i].hashtypes);
+
+        for (auto& hash : hashes) {
+            order.push_back(validFiles.add(hash->getFilePath()));
+            addRow(types);
+            storeHashSums(order.back(), *hash);
+        }
+
+        hashes.clear();
+    }
+
+    order.insert(order.end(), previous.begin() + position, previous.end());
+    displayOrder = std::move(order);
+    calculatedRows = validFiles.size();
+    trees.clear();
+}
+
+void shazam::Checker::hashRows(const std::vector<std::size_t>& rows)
+{
+    std::vector<std::shared_ptr<HashCalculator>> hashes;
+
+    for (auto row : rows) {
+        hashes.push_back(hashFactory.hashFile(typeSets[fileTypes[row]], validFiles.file(row)));
+        hashes.back()->setObserver(progress);
+    }
+
+    if (hashes.size() > 1) {
+        try {
+            BatchHasher::calculate(hashes);
+        } catch (const std::runtime_error& err) {
+            // Find out below which files failed, the ones calculated are kept
+        }
+    }
+
+    for (std::size_t i = 0; i < rows.size(); i++) {
+        if (calculateHash(hashes[i]))
+            storeHashSums(rows[i], *hashes[i]);
+        else
+            failedRows[rows[i]] = 1;
+
+        hashes[i]->notifyObserver();
+    }
+}
+
+std::size_t shazam::Checker::typeSetIndex(const std::vector<std::string>& hashtypes)
+{
+    const auto found = std::find(typeSets.begin(), typeSets.end(), hashtypes);
+
+    if (found != typeSets.end())
+        return found - typeSets.begin();
+
+    std::vector<std::size_t> indexes;
+
+    for (auto& type : hashtypes) {
+        indexes.push_back(hashTypeIndex(type));
+
+        if (indexes.back() == HASH_TYPES.size())
+            throw std::invalid_argument("Unknown hash type \"" + type + "\".");
+    }
+
+    typeSets.push_back(hashtypes);
+    typeSetIndexes.push_back(indexes);
+    return typeSets.size() - 1;
+}
+
+void shazam::Checker::addRow(std::size_t types)
+{
+    std::size_t size = 0;
+
+    for (auto type : typeSetIndexes[types])
+        size += HASH_DIGEST_SIZES[type];
+
+    fileTypes.push_back((std::uint16_t) types);
+    digestOffsets.push_back(digests.size());
+    digests.resize(digests.size() + size);
+    failedRows.push_back(0);
+
+    if (!displayOrder.empty())
+        displayOrder.push_back(validFiles.size() - 1);
+}
+
+void shazam::Checker::storeHashSums(std::size_t row, HashCalculator& hash)
+{
+    std::size_t offset = digestOffsets[row];
+
+    for (std::size_t i = 0; i < typeSets[fileTypes[row]].size(); i++) {
+        const Digest& digest = hash.digest(i);
+        std::copy(digest.data(), digest.data() + digest.size(), digests.begin() + offset);
+        offset += digest.size();
+    }
+}
+
+void shazam::Checker::forEachValidFile(const std::function<void(std::size_t)>& visit)
+{
+    for (std::size_t i = 0; i < validFiles.size(); i++) {
+        const std::size_t row = displayOrder.empty() ? i : displayOrder[i];
+
+        if (!failedRows[row])
+            visit(row);
     }
+}
+
+void shazam::Checker::streamHashSums(const std::vector<std::string>& paths, std::vector<std::string> hashtypes,
+                                     bool recursive, std::ostream& out)
+{
+    auto next = paths.begin();
+
+    const PathSource nextPath = [&](std::string& path) {
+        if (next == paths.end())
+            return false;
+
+        path = *next++;
+        return true;
+    };
+
+    streamHashSums(nextPath, std::move(hashtypes), recursive, out);
+}
+
+void shazam::Checker::streamHashSums(const PathSource& nextPath, std::vector<std::string> hashtypes,
+                                     bool recursive, std::ostream& out)
+{
+    const std::size_t groupSize = BatchHasher::lanes() * BATCH_GROUPS_PER_TASK;
+    const std::size_t window = (std::size_t) jobs * STREAM_TASKS_PER_THREAD;
+    const std::size_t sortWindow = std::max<std::size_t>(1, window / 2);
+    std::mutex slotsMutex;
+    std::condition_variable slotFreed;
+    std::size_t nextGroup = 0;
+    FileFactory fileFactory;
+
+    // The small files waiting for their group to be full, and the groups
+    // waiting to be sorted, numbered in the input order
+    std::vector<std::shared_ptr<File>> group;
+    std::uint64_t groupDevice = 0;
+    std::uintmax_t groupBytes = 0;
+    std::vector<std::vector<std::shared_ptr<File>>> staged;
+    std::vector<std::size_t> stagedNumbers;
+    std::vector<ScheduledRow> schedule;
+
+    setFileThreads(1);
+
+    // The walkers, the scheduler and the writer are used by the pool
+    // tasks, so the pool has to be gone before them
+    std::vector<std::unique_ptr<TreeWalker>> walkers;
+    DeviceScheduler scheduler(jobs, rotationalJobs);
+    ResultWriter writer(out, hashtypes, unordered);
+
+    {
+        WorkStealingPool pool(jobs);
+
+        // Don't hash further ahead than the writer can keep
+        const auto waitForSlots = [&](std::size_t groups) {
+            std::unique_lock<std::mutex> lock(slotsMutex);
+            slotFreed.wait(lock, [&] { return nextGroup + groups <= writer.getWrittenGroups() + window; });
+        };
+
+        const auto groupWritten = [&]() {
+            std::lock_guard<std::mutex> lock(slotsMutex);
+            slotFreed.notify_one();
+        };
+
+        // Sends the staged groups to the pool, in the order of calculateHashSums
+        const auto submitStaged = [&]() {
+            if (staged.empty())
+                return;
+
+            waitForSlots(0);
+            std::stable_sort(schedule.begin(), schedule.end(), scheduledBefore);
+
+            for (auto& entry : schedule) {
+                scheduler.submit(pool, entry.device,
+                    [&, files = std::move(staged[entry.row]), number = stagedNumbers[entry.row]]() {
+                        writer.write(number, hashGroup(files, hashtypes));
+                        groupWritten();
+                    }
+                );
+            }
+
+            staged.clear();
+            stagedNumbers.clear();
+            schedule.clear();
+        };
+
+        // Numbers a group and keeps it until half a window can be sorted
+        const auto stage = [&](std::vector<std::shared_ptr<File>> files, std::uint64_t device, std::uintmax_t bytes) {
+            // A group is placed by its first valid file, which costs one
+            // lookup of the position for all its files
+            const bool sequential = isRotationalDevice(device);
+            const auto first = std::find_if(files.begin(), files.end(), [](auto& file) { return file->isValid(); });
+            struct stat filestat = {};
+
+            if (first != files.end())
+                (*first)->attributes(filestat);
+
+            schedule.push_back(ScheduledRow {
+                staged.size(), bytes, device, sequential,
+                sequential && first != files.end() ? physicalPosition(**first) : 0, (std::uint64_t) filestat.st_ino
+            });
+
+            staged.push_back(std::move(files));
+            stagedNumbers.push_back(nextGroup++);
+
+            if (staged.size() == sortWindow)
+                submitStaged();
+        };
 
-    std::for_each(
-        validFilesHashes.begin(),
-        validFilesHashes.end(),
-        [](std::shared_ptr<HashCalculator>& hash) {
-            hash->calculate();
-            hash->notifyObserver();
+        const auto stageGroup = [&]() {
+            if (!group.empty())
+                stage(std::move(group), groupDevice, groupBytes);
+
+            group.clear();
+            groupBytes = 0;
+        };
+
+        std::string path;
+
+        while (nextPath(path)) {
+            struct stat filestat;
+            const bool follow = walkOptions.symlinks != SYMLINKS_NEVER;
+            const bool found = recursive
+                && (follow ? stat(path.c_str(), &filestat) : lstat(path.c_str(), &filestat)) == 0;
+
+            if (found && S_ISDIR(filestat.st_mode)) {
+                stageGroup();
+                submitStaged();
+
+                waitForSlots(1);
+                streamTree(pool, scheduler, filestat.st_dev, writer, nextGroup++, path, hashtypes, walkers, groupWritten);
+                continue;
+            }
+
+            auto file = fileFactory.create(path);
+
+            // The invalid files go with the group, to be shown in their place
+            if (!file->isValid()) {
+                group.push_back(file);
+
+                if (group.size() == groupSize)
+                    stageGroup();
+                continue;
+            }
+
+            file->attributes(filestat);
+            const std::uint64_t device = filestat.st_dev;
+            const std::uintmax_t size = file->size();
+
+            // A group only holds the small files of one device
+            if (!group.empty() && device != groupDevice)
+                stageGroup();
+
+            if (file->isStream() || hashFactory.getTee() >= 0 || !BatchHasher::accepts(size, hashtypes)) {
+                stageGroup();
+                stage({file}, device, size);
+                continue;
+            }
+
+            groupDevice = device;
+            groupBytes += size;
+            group.push_back(file);
+
+            if (group.size() == groupSize)
+                stageGroup();
         }
-    );
+
+        stageGroup();
+        submitStaged();
+
+        pool.wait();
+    }
+
+    writer.finish();
+
+    const auto invalid = writer.getInvalidFiles();
+    invalidFilesList.insert(invalidFilesList.end(), invalid.begin(), invalid.end());
+}
+
+void shazam::Checker::collectHashSums(std::shared_ptr<HashCalculator> hash, ResultGroup& results)
+{
+    try {
+        hash->calculate();
+
+        for (auto& sum : hash->getAll())
+            results.sums.push_back(sum);
+    } catch (const std::runtime_error& err) {
+        results.invalid.push_back(std::make_shared<File>(hash->getFilePath(), NON_READABLE));
+    }
+}
+
+shazam::ResultGroup
+shazam::Checker::hashGroup(const std::vector<std::shared_ptr<File>>& files, const std::vector<std::string>& hashtypes)
+{
+    ResultGroup results;
+    std::vector<std::shared_ptr<HashCalculator>> hashes;
+    std::vector<std::shared_ptr<HashCalculator>> batch;
+
+    for (auto& file : files) {
+        if (!file->isValid()) {
+            results.invalid.push_back(file);
+            continue;
+        }
+
+        hashes.push_back(hashFactory.hashFile(hashtypes, file));
+
+        if (BatchHasher::accepts(*hashes.back()))
+            batch.push_back(hashes.back());
+    }
+
+    if (!batch.empty()) {
+        try {
+            BatchHasher::calculate(batch);
+        } catch (const std::runtime_error& err) {
+            // The files that failed are found out one by one below
+        }
+    }
+
+    for (auto& hash : hashes)
+        collectHashSums(hash, results);
+
+    return results;
+}
+
+void shazam::Checker::streamTree(WorkStealingPool& pool, DeviceScheduler& scheduler, std::uint64_t device,
+                                 ResultWriter& writer, std::size_t group, const std::string& root,
+                                 const std::vector<std::string>& hashtypes,
+                                 std::vector<std::unique_ptr<TreeWalker>>& walkers,
+                                 std::function<void(void)> written)
+{
+    // The files found and the work left, the walk counting as one until
+    // it is done, shared by the tasks of the tree
+    struct TreeState {
+        std::mutex mutex;
+        std::vector<ResultGroup> found;
+        std::size_t pending = 1;
+    };
+
+    auto state = std::make_shared<TreeState>();
+
+    // Called by the last task of the tree, when the whole tree is hashed
+    const auto finished = [this, &writer, group, state, written]() {
+        ResultGroup results;
+
+        if (!unordered) {
+            std::sort(state->found.begin(), state->found.end(), [](const ResultGroup& a, const ResultGroup& b) {
+                return (a.sums.empty() ? "" : a.sums.front().filename) < (b.sums.empty() ? "" : b.sums.front().filename);
+            });
+        }
+
+        for (auto& file : state->found) {
+            for (auto& sum : file.sums)
+                results.sums.push_back(sum);
+
+            results.invalid.insert(results.invalid.end(), file.invalid.begin(), file.invalid.end());
+        }
+
+        state->found.clear();
+        writer.write(group, std::move(results));
+        written();
+    };
+
+    const auto taskDone = [state, finished]() {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+
+            if (--state->pending > 0)
+                return;
+        }
+
+        finished();
+    };
+
+    walkers.push_back(std::make_unique<TreeWalker>(pool, walkOptions,
+        [this, &pool, &scheduler, device, &writer, hashtypes, state, taskDone](const std::string& path,
+                                                                                EFileStatus status) {
+            auto file = std::make_shared<File>(path, status);
+
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->pending++;
+            }
+
+            scheduler.submit(pool, device, [this, &writer, hashtypes, state, taskDone, file]() {
+                ResultGroup results;
+
+                if (file->isValid())
+                    collectHashSums(hashFactory.hashFile(hashtypes, file), results);
+                else
+                    results.invalid.push_back(file);
+
+                // Unordered, the files are written as they come and the
+                // group of the tree is only counted once it is done
+                if (unordered) {
+                    writer.writePart(std::move(results));
+                } else {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->found.push_back(std::move(results));
+                }
+
+                taskDone();
+            });
+        },
+        taskDone
+    ));
+
+    walkers.back()->walk(root);
+}
+
+void shazam::Checker::addTree(std::string root, std::vector<std::string> hashtypes)
+{
+    typeSetIndex(hashtypes);
+    trees.push_back(Tree { root, hashtypes, validFiles.size() });
+}
+
+void shazam::Checker::setWalkOptions(WalkOptions options)
+{
+    walkOptions = options;
+}
+
+void shazam::Checker::setUnordered(bool value)
+{
+    unordered = value;
+}
+
+void shazam::Checker::setJobs(unsigned int value)
+{
+    jobs = std::max(1u, value);
+}
+
+void shazam::Checker::setRotationalJobs(unsigned int value)
+{
+    rotationalJobs = std::max(1u, value);
+}
+
+void shazam::Checker::setIOMode(EIOMode mode, std::size_t buffers, unsigned int queueDepth,
+                               EPageCacheMode pageCache)
+{
+    hashFactory.setIOMode(mode, buffers, queueDepth, pageCache);
+}
+
+void shazam::Checker::setCache(std::shared_ptr<HashCache> cache)
+{
+    hashFactory.setCache(cache);
+}
+
+void shazam::Checker::setTee(int descriptor)
+{
+    hashFactory.setTee(descriptor);
 }
 
 void shazam::Checker::setShowProgressBar(bool value)
@@ -83,7 +800,28 @@ void shazam::Checker::displayResults()
 
 std::list<std::shared_ptr<shazam::HashCalculator>> shazam::Checker::getValidHashesList()
 {
-    return validFilesHashes;
+    std::list<std::shared_ptr<HashCalculator>> hashes;
+
+    forEachValidFile([&](std::size_t row) {
+        const auto& types = typeSets[fileTypes[row]];
+        hashes.push_back(hashFactory.hashFile(types, std::make_shared<File>(validFiles.path(row), VALID_FILE)));
+
+        // The rows not calculated yet are left to be calculated when asked
+        if (row >= calculatedRows)
+            return;
+
+        std::vector<Digest> sums;
+        std::size_t offset = digestOffsets[row];
+
+        for (auto type : typeSetIndexes[fileTypes[row]]) {
+            sums.emplace_back(type, digests.data() + offset, HASH_DIGEST_SIZES[type]);
+            offset += HASH_DIGEST_SIZES[type];
+        }
+
+        hashes.back()->setHashSums(sums);
+    });
+
+    return hashes;
 }
 
 std::list<std::shared_ptr<shazam::File>> shazam::Checker::getInvalidFilesList()
@@ -1,19 +1,71 @@
 #include "../include/shazam/common.hh"
 
-#include "../include/external/ProgressBar.hpp"
-
 #include <string>
 #include <algorithm>
+#include <chrono>
+#include <iomanip>
 #include <memory>
 #include <iostream>
-
-namespace pgs = progresscpp;
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 unsigned long long shazam::hexaToInt(std::string hexadecimalString)
 {
     return std::stoull(hexadecimalString, 0, 16);
 }
 
+/* Returns the value of an hexadecimal digit, or -1. */
+static int hexDigitValue(char digit)
+{
+    if (digit >= '0' && digit <= '9')
+        return digit - '0';
+    if (digit >= 'a' && digit <= 'f')
+        return digit - 'a' + 10;
+    if (digit >= 'A' && digit <= 'F')
+        return digit - 'A' + 10;
+    return -1;
+}
+
+bool shazam::hexToBytes(const std::string& hexadecimalString, std::vector<unsigned char>& bytes)
+{
+    if (hexadecimalString.size() % 2 != 0)
+        return false;
+
+    bytes.resize(hexadecimalString.size() / 2);
+
+    for (std::size_t i = 0; i < bytes.size(); i++) {
+        const int high = hexDigitValue(hexadecimalString[2 * i]);
+        const int low = hexDigitValue(hexadecimalString[2 * i + 1]);
+
+        if (high < 0 || low < 0)
+            return false;
+
+        bytes[i] = (unsigned char) (high << 4 | low);
+    }
+
+    return true;
+}
+
+std::string shazam::bytesToHex(const unsigned char* bytes, std::size_t len)
+{
+    std::string hex(2 * len, '0');
+    Digest::writeHex(bytes, len, &hex[0]);
+    return hex;
+}
+
+std::size_t shazam::hashTypeIndex(const std::string& name)
+{
+    const std::string upper = toUpperCase(name);
+    std::size_t i = 0;
+
+    while (i < HASH_TYPES.size() && upper != HASH_TYPES[i])
+        i++;
+
+    return i;
+}
+
 std::string shazam::toUpperCase(std::string str)
 {
     std::transform(str.begin(), str.end(), str.begin(), ::toupper);
@@ -34,27 +86,47 @@ void shazam::printErrMessage(const std::string& message)
 
 void shazam::ProgressObserver::init()
 {
-    const int observables = getObservablesNumber();
-    if (observables > 0) {
-        progressBar = std::make_unique<pgs::ProgressBar>(observables, progressWidth);
-    }
+    std::lock_guard<std::mutex> lock(tickerMutex);
+
+    if (ticker.joinable())
+        return;
+
+    startTime = std::chrono::steady_clock::now();
+    stopping = false;
+
+    ticker = std::thread([this]() {
+        std::unique_lock<std::mutex> lock(tickerMutex);
+
+        while (!tickerStop.wait_for(lock, std::chrono::milliseconds(PROGRESS_REFRESH_MS), [this] { return stopping; }))
+            display();
+    });
 }
 
 void shazam::ProgressObserver::update()
 {
     decreaseObervableCounter();
-    if (progressBar != nullptr) {
-        ++( *progressBar );
-        progressBar->display();
-    }
+    completedObservables++;
+}
+
+void shazam::ProgressObserver::advance(std::uint64_t bytes)
+{
+    processedBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void shazam::ProgressObserver::expect(std::uint64_t bytes)
+{
+    increaseObervableCounter();
+    expectedBytes.fetch_add(bytes, std::memory_order_relaxed);
 }
 
 void shazam::ProgressObserver::done()
 {
-    if (progressBar != nullptr) {
-        progressBar->done();
-        std::cout << std::endl;
-    }
+    if (!ticker.joinable())
+        return;
+
+    stopTicker();
+    display();
+    std::cout << std::endl;
 }
 
 void shazam::ProgressObserver::increaseObervableCounter()
@@ -72,10 +144,66 @@ int shazam::ProgressObserver::getObservablesNumber()
     return activeObservables;
 }
 
+std::uint64_t shazam::ProgressObserver::getProcessedBytes()
+{
+    return processedBytes.load(std::memory_order_relaxed);
+}
+
+shazam::ProgressObserver::~ProgressObserver()
+{
+    stopTicker();
+}
+
+void shazam::ProgressObserver::stopTicker()
+{
+    {
+        std::lock_guard<std::mutex> lock(tickerMutex);
+        stopping = true;
+    }
+
+    tickerStop.notify_all();
+
+    if (ticker.joinable())
+        ticker.join();
+}
+
+void shazam::ProgressObserver::display()
+{
+    const std::uint64_t expected = expectedBytes.load(std::memory_order_relaxed);
+    const std::uint64_t processed = std::min(expected, processedBytes.load(std::memory_order_relaxed));
+    const int completed = completedObservables;
+    const int total = completed + activeObservables;
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    // Empty files only count as tasks
+    double progress = expected > 0 ? (double) processed / expected : 0;
+
+    if (expected == 0 && total > 0)
+        progress = (double) completed / total;
+
+    const int position = (int) (progressWidth * progress);
+    const double rate = seconds > 0 ? processed / seconds : 0;
+    std::ostringstream line;
+
+    line << "[";
+
+    for (int i = 0; i < progressWidth; i++)
+        line << (i < position ? '=' : i == position ? '>' : ' ');
+
+    line << "] " << (int) (progress * 100) << "% " << completed << "/" << total << " files "
+         << std::fixed << std::setprecision(1) << rate / 1e6 << " MB/s";
+
+    if (rate > 0 && processed < expected)
+        line << " ETA " << (int) ((expected - processed) / rate + 0.5) << "s";
+
+    // Padded to clear what is left of a longer previous line
+    std::cout << std::left << std::setw(progressWidth + 48) << line.str() << std::right << "\r";
+    std::cout.flush();
+}
+
 void shazam::IAmObservable::setObserver(std::shared_ptr<ProgressObserver> observer)
 {
     this->observer = observer;
-    this->observer->increaseObervableCounter();
 }
 
 void shazam::IAmObservable::notifyObserver()
@@ -83,3 +211,9 @@ void shazam::IAmObservable::notifyObserver()
     if (observer != nullptr)
         observer->update();
 }
+
+void shazam::IAmObservable::notifyProgress(std::uint64_t bytes)
+{
+    if (observer != nullptr)
+        observer->advance(bytes);
+}
@@ -0,0 +1,125 @@
+#include "../include/shazam/device.hh"
+#include "../include/shazam/stats.hh"
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sysmacros.h>
+
+bool shazam::isRotationalDevice(std::uint64_t device)
+{
+    static std::mutex cacheMutex;
+    static std::map<std::uint64_t, bool> cache;
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    const auto found = cache.find(device);
+
+    if (found != cache.end())
+        return found->second;
+
+    const std::string sysfs = "/sys/dev/block/" + std::to_string(major((dev_t) device))
+                            + ":" + std::to_string(minor((dev_t) device));
+
+    // A partition has no queue of its own, it is the one of its disk, a level above
+    std::ifstream file(sysfs + "/queue/rotational");
+
+    if (!file.is_open())
+        file.open(sysfs + "/../queue/rotational");
+
+    int rotational = 0;
+    file >> rotational;
+    return cache[device] = rotational == 1;
+}
+
+std::uint64_t shazam::physicalOffset(int descriptor)
+{
+    alignas(struct fiemap) unsigned char request[sizeof(struct fiemap) + sizeof(struct fiemap_extent)] = {};
+    auto map = (struct fiemap*) request;
+
+    map->fm_start = 0;
+    map->fm_length = FIEMAP_MAX_OFFSET;
+    map->fm_extent_count = 1;
+
+    Stats::addSyscalls(1);
+
+    if (ioctl(descriptor, FS_IOC_FIEMAP, map) != 0 || map->fm_mapped_extents == 0
+        || (map->fm_extents[0].fe_flags & FIEMAP_EXTENT_UNKNOWN) != 0)
+        return UNKNOWN_PHYSICAL_OFFSET;
+
+    return map->fm_extents[0].fe_physical;
+}
+
+shazam::DeviceScheduler::DeviceScheduler(unsigned int jobs, unsigned int rotationalJobs)
+: jobs(std::max(1u, jobs)), rotationalJobs(std::max(1u, rotationalJobs))
+{
+}
+
+void shazam::DeviceScheduler::submit(WorkStealingPool& pool, std::uint64_t device, Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Queue& tasks = queue(device);
+        tasks.tasks.push_back(std::move(task));
+
+        if (tasks.lanes >= tasks.limit)
+            return;
+
+        tasks.lanes++;
+        task = std::move(tasks.tasks.front());
+        tasks.tasks.pop_front();
+    }
+
+    pool.submit([this, &pool, device, task]() { runLane(pool, device, task); });
+}
+
+void shazam::DeviceScheduler::setLimit(std::uint64_t device, unsigned int limit)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    queue(device).limit = std::max(1u, limit);
+}
+
+shazam::DeviceScheduler::Queue& shazam::DeviceScheduler::queue(std::uint64_t device)
+{
+    const auto found = queues.find(device);
+
+    if (found != queues.end())
+        return found->second;
+
+    const unsigned int limit = isRotationalDevice(device) ? rotationalJobs : jobs;
+    return queues.emplace(device, Queue { limit, 0, {} }).first->second;
+}
+
+void shazam::DeviceScheduler::runLane(WorkStealingPool& pool, std::uint64_t device, const Task& task)
+{
+    std::exception_ptr error = nullptr;
+
+    try {
+        task();
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Queue& tasks = queues.at(device);
+
+        if (tasks.tasks.empty()) {
+            tasks.lanes--;
+        } else {
+            pool.submit([this, &pool, device, next = std::move(tasks.tasks.front())]() { runLane(pool, device, next); });
+            tasks.tasks.pop_front();
+        }
+    }
+
+    // The pool keeps the error, the next tasks of the device still run
+    if (error)
+        std::rethrow_exception(error);
+}
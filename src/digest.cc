@@ -0,0 +1,92 @@
+#include "../include/shazam/digest.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    /* The two hexadecimal digits of every byte value. */
+    constexpr std::array<std::array<char, 2>, 256> HEX_PAIRS = [] {
+        constexpr const char* digits = "0123456789abcdef";
+        std::array<std::array<char, 2>, 256> pairs{};
+
+        for (std::size_t i = 0; i < pairs.size(); i++)
+            pairs[i] = { digits[i >> 4], digits[i & 0x0f] };
+
+        return pairs;
+    }();
+
+    /* The value of every hexadecimal digit, in either case, or -1
+     * for the characters that aren't one. */
+    constexpr std::array<signed char, 256> HEX_VALUES = [] {
+        std::array<signed char, 256> values{};
+
+        for (std::size_t i = 0; i < values.size(); i++) {
+            if (i >= '0' && i <= '9')
+                values[i] = i - '0';
+            else if (i >= 'a' && i <= 'f')
+                values[i] = i - 'a' + 10;
+            else if (i >= 'A' && i <= 'F')
+                values[i] = i - 'A' + 10;
+            else
+                values[i] = -1;
+        }
+
+        return values;
+    }();
+}
+
+shazam::Digest::Digest(std::size_t algorithm, const unsigned char* data, std::size_t len)
+: bytes{}, length(len), algorithm(algorithm)
+{
+    if (len > MAX_SIZE)
+        throw std::invalid_argument("Digests can't be longer than " + std::to_string(MAX_SIZE) + " bytes.");
+
+    std::memcpy(bytes.data(), data, len);
+}
+
+shazam::Digest shazam::Digest::fromHex(std::size_t algorithm, const std::string& hex)
+{
+    Digest digest;
+
+    if (hex.size() % 2 != 0 || hex.size() / 2 > MAX_SIZE)
+        return digest;
+
+    for (std::size_t i = 0; i < hex.size() / 2; i++) {
+        const int high = HEX_VALUES[(unsigned char) hex[2 * i]];
+        const int low = HEX_VALUES[(unsigned char) hex[2 * i + 1]];
+
+        if (high < 0 || low < 0)
+            return Digest();
+
+        digest.bytes[i] = (unsigned char) (high << 4 | low);
+    }
+
+    digest.length = hex.size() / 2;
+    digest.algorithm = algorithm;
+    return digest;
+}
+
+void shazam::Digest::writeHex(const unsigned char* data, std::size_t len, char* hex)
+{
+    for (std::size_t i = 0; i < len; i++)
+        std::memcpy(hex + 2 * i, HEX_PAIRS[data[i]].data(), 2);
+}
+
+std::string shazam::Digest::toHex() const
+{
+    std::string hex(2 * length, '0');
+    toHex(&hex[0]);
+    return hex;
+}
+
+bool shazam::Digest::operator<(const Digest& other) const
+{
+    if (algorithm != other.algorithm)
+        return algorithm < other.algorithm;
+
+    return std::lexicographical_compare(bytes.begin(), bytes.begin() + length,
+                                        other.bytes.begin(), other.bytes.begin() + other.length);
+}
@@ -1,12 +1,125 @@
 #include "../include/shazam/files.hh"
 #include "../include/shazam/basic-types.hh"
 #include "../include/shazam/common.hh"
+#include "../include/shazam/stats.hh"
 
 #include <string>
 #include <algorithm>
 #include <memory>
 #include <filesystem>
-#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Number of files kept open by the files created by FileFactory. */
+static std::atomic<int> keptDescriptors(0);
+
+/* Returns the number of files that can be kept open, leaving most of
+ * the descriptors allowed to the process for everything else. */
+static int keptDescriptorsLimit()
+{
+    static const int limit = [] {
+        struct rlimit rlim;
+
+        if (getrlimit(RLIMIT_NOFILE, &rlim) != 0 || rlim.rlim_cur == RLIM_INFINITY)
+            return shazam::MAX_KEPT_DESCRIPTORS;
+
+        return std::min<int>(shazam::MAX_KEPT_DESCRIPTORS, rlim.rlim_cur / 4);
+    }();
+
+    return limit;
+}
+
+/* Opens the file at `path`, or a copy of the standard input for STDIN_PATH. */
+static int openPath(const std::string& path, int flags)
+{
+    if (path == shazam::STDIN_PATH)
+        return fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 0);
+
+    return ::open(path.c_str(), flags | O_CLOEXEC);
+}
+
+shazam::EFileStatus shazam::fileStatusFromErrno(int error)
+{
+    switch (error) {
+        case ENOENT:
+        case ENOTDIR:
+            return NON_EXISTENT;
+        case EACCES:
+        case EPERM:
+            return NON_PERMISSIVE;
+        case EISDIR:
+            return IS_DIRECTORY;
+        default:
+            return NON_READABLE;
+    }
+}
+
+shazam::File::~File()
+{
+    const int descriptor = _descriptor.exchange(-1);
+
+    if (descriptor >= 0) {
+        close(descriptor);
+        keptDescriptors--;
+    }
+}
+
+int shazam::File::open(struct stat& filestat)
+{
+    const StatsTimer timer(PHASE_OPEN);
+    int descriptor = takeDescriptor(filestat);
+
+    if (descriptor >= 0)
+        return descriptor;
+
+    descriptor = openPath(path(), O_RDONLY);
+    Stats::addSyscalls(2);
+
+    if (descriptor < 0 || fstat(descriptor, &filestat) != 0) {
+        if (descriptor >= 0)
+            close(descriptor);
+        throw std::runtime_error("Cannot read file \"" + path() + "\".");
+    }
+
+    return descriptor;
+}
+
+int shazam::File::takeDescriptor(struct stat& filestat)
+{
+    const int descriptor = _descriptor.exchange(-1);
+
+    if (descriptor >= 0) {
+        keptDescriptors--;
+        filestat = _stat;
+    }
+
+    return descriptor;
+}
+
+int shazam::File::release(struct stat& filestat)
+{
+    attributes(filestat);
+    return _descriptor.exchange(-1);
+}
+
+int shazam::File::descriptor() const
+{
+    return _descriptor;
+}
+
+bool shazam::File::attributes(struct stat& filestat) const
+{
+    if (_hasStat)
+        filestat = _stat;
+
+    return _hasStat;
+}
 
 std::string shazam::File::path() const
 {
@@ -23,8 +136,16 @@ bool shazam::File::isValid() const
     return status() == VALID_FILE;
 }
 
-int shazam::File::size()
+bool shazam::File::isStream() const
+{
+    return _hasStat && !S_ISREG(_stat.st_mode);
+}
+
+std::uintmax_t shazam::File::size()
 {
+    if (_hasStat)
+        return _stat.st_size;
+
     return isValid() ? fs::file_size(path()) : 0;
 }
 
@@ -46,60 +167,193 @@ std::string shazam::File::explainStatus() const
     }
 }
 
-bool shazam::FileFactory::fileExists(fs::file_status filestatus)
+shazam::FileTable::~FileTable()
 {
-    return fs::exists(filestatus);
+    for (auto descriptor : descriptors) {
+        if (descriptor >= 0) {
+            close(descriptor);
+            keptDescriptors--;
+        }
+    }
 }
 
-bool shazam::FileFactory::fileIsNotDirectory(fs::file_status filestatus)
+std::size_t shazam::FileTable::add(File& file)
 {
-    return !fs::is_directory(filestatus);
+    struct stat filestat;
+    const int descriptor = file.release(filestat);
+    const bool known = file.attributes(filestat);
+
+    addPath(file.path());
+    descriptors.push_back(descriptor);
+    attributesKnown.push_back(known);
+    attributes.push_back(known ? Attributes {
+        .device = (std::uint64_t) filestat.st_dev,
+        .inode = (std::uint64_t) filestat.st_ino,
+        .size = (std::uint64_t) filestat.st_size,
+        .blocks = (std::uint64_t) filestat.st_blocks,
+        .mtimeNs = (std::int64_t) filestat.st_mtim.tv_sec * 1000000000 + filestat.st_mtim.tv_nsec,
+        .ctimeNs = (std::int64_t) filestat.st_ctim.tv_sec * 1000000000 + filestat.st_ctim.tv_nsec,
+        .mode = (std::uint32_t) filestat.st_mode
+    } : Attributes { 0, 0, (std::uint64_t) file.size(), 0, 0, 0, S_IFREG });
+
+    return size() - 1;
 }
 
-bool shazam::FileFactory::fileIsPermissive(fs::file_status filestatus)
+std::size_t shazam::FileTable::add(const std::string& path)
 {
-    return (filestatus.permissions() & fs::perms::owner_read) != fs::perms::none;
+    addPath(path);
+    descriptors.push_back(-1);
+    attributesKnown.push_back(false);
+    attributes.push_back(Attributes { 0, 0, 0, 0, 0, 0, S_IFREG });
+    return size() - 1;
 }
 
-bool shazam::FileFactory::fileIsReadable(std::string path)
+std::size_t shazam::FileTable::size() const
 {
-    bool isReadable = false;
+    return pathOffsets.size();
+}
 
-    std::fstream f;
-    f.open(path, std::ios::in | std::ios::binary);
+std::string shazam::FileTable::path(std::size_t row) const
+{
+    return std::string(paths.data() + pathOffsets[row]);
+}
 
-    if(f) {
-        char byt;
-        try {
-            f.read(&byt, 1);
-            isReadable = true;
-        } catch(const std::exception& e) {
-            // TODO: do something here!
-        }
-    }
+std::uintmax_t shazam::FileTable::fileSize(std::size_t row) const
+{
+    return attributes[row].size;
+}
+
+std::uint64_t shazam::FileTable::device(std::size_t row) const
+{
+    return attributes[row].device;
+}
+
+std::uint64_t shazam::FileTable::inode(std::size_t row) const
+{
+    return attributes[row].inode;
+}
+
+bool shazam::FileTable::stream(std::size_t row) const
+{
+    return !S_ISREG(attributes[row].mode);
+}
+
+int shazam::FileTable::descriptor(std::size_t row) const
+{
+    return descriptors[row];
+}
+
+std::shared_ptr<shazam::File> shazam::FileTable::file(std::size_t row)
+{
+    if (!attributesKnown[row])
+        return std::make_shared<File>(path(row), VALID_FILE);
 
-    f.close();
-    return isReadable;
+    // Only the attributes used to read and cache the file are kept
+    const Attributes& kept = attributes[row];
+    struct stat filestat = {};
+    filestat.st_mode = (mode_t) kept.mode;
+    filestat.st_dev = (dev_t) kept.device;
+    filestat.st_ino = (ino_t) kept.inode;
+    filestat.st_size = (off_t) kept.size;
+    filestat.st_blocks = (blkcnt_t) kept.blocks;
+    filestat.st_mtim = { (time_t) (kept.mtimeNs / 1000000000), (long) (kept.mtimeNs % 1000000000) };
+    filestat.st_ctim = { (time_t) (kept.ctimeNs / 1000000000), (long) (kept.ctimeNs % 1000000000) };
+
+    const int descriptor = descriptors[row];
+    descriptors[row] = -1;
+    return std::make_shared<File>(path(row), VALID_FILE, descriptor, filestat);
+}
+
+void shazam::FileTable::addPath(const std::string& path)
+{
+    pathOffsets.push_back(paths.size());
+    paths.insert(paths.end(), path.begin(), path.end());
+    paths.push_back('\0');
 }
 
-shazam::EFileStatus shazam::FileFactory::fileValidStatus(std::string path)
+/* Opens a fifo again in blocking mode, which waits for its writer: read
+ * from the non blocking descriptor, a fifo without a writer yet looks
+ * empty. Fails if the path no longer names the same fifo. */
+static shazam::EFileStatus reopenFifo(const std::string& path, int& descriptor, const struct stat& filestat)
 {
-    fs::file_status filestatus = fs::status(path);
+    const int blocking = openPath(path, O_RDONLY);
+    const int error = errno;
+    struct stat blockingstat;
+    shazam::Stats::addSyscalls(3);
+
+    close(descriptor);
+    descriptor = blocking;
+
+    if (blocking < 0)
+        return shazam::fileStatusFromErrno(error);
+
+    if (fstat(blocking, &blockingstat) != 0
+        || blockingstat.st_dev != filestat.st_dev || blockingstat.st_ino != filestat.st_ino)
+        return shazam::NON_READABLE;
+
+    return shazam::VALID_FILE;
+}
+
+shazam::EFileStatus shazam::FileFactory::fileValidStatus(std::string path, int& descriptor, struct stat& filestat)
+{
+    // Non blocking, so that opening a fifo doesn't wait for a writer before
+    // its type is known. The standard input is shared with the parent, so
+    // its flags are left alone
+    const bool standardInput = path == STDIN_PATH;
+    descriptor = openPath(path, O_RDONLY | O_NONBLOCK);
+    Stats::addSyscalls(1);
+
+    if (descriptor < 0)
+        return fileStatusFromErrno(errno);
+
+    Stats::addSyscalls(1);
 
-    if (fileExists(filestatus) == false) {
-        return NON_EXISTENT;
-    } else if (fileIsNotDirectory(filestatus) == false) {
-        return IS_DIRECTORY;
-    } else if (fileIsPermissive(filestatus) == false) {
-        return NON_PERMISSIVE;
-    } else if (fileIsReadable(path) == false) {
-        return NON_READABLE;
-    } else {
-        return VALID_FILE;
+    EFileStatus status = VALID_FILE;
+
+    if (fstat(descriptor, &filestat) != 0)
+        status = NON_READABLE;
+    else if (S_ISDIR(filestat.st_mode))
+        status = IS_DIRECTORY;
+    else if ((filestat.st_mode & S_IRUSR) == 0) // Even if root can read it
+        status = NON_PERMISSIVE;
+    else if (S_ISFIFO(filestat.st_mode) && !standardInput)
+        status = reopenFifo(path, descriptor, filestat);
+    else if (!S_ISREG(filestat.st_mode) && !standardInput && fcntl(descriptor, F_SETFL, 0) != 0)
+        status = NON_READABLE;
+
+    if (status != VALID_FILE) {
+        close(descriptor);
+        descriptor = -1;
     }
+
+    return status;
 }
 
 std::shared_ptr<shazam::File> shazam::FileFactory::create(std::string path)
 {
-    return std::make_shared<shazam::File>(path, fileValidStatus(path));
+    const StatsTimer timer(PHASE_VALIDATE);
+    int descriptor;
+    struct stat filestat;
+    const EFileStatus status = fileValidStatus(path, descriptor, filestat);
+
+    if (status != VALID_FILE)
+        return std::make_shared<shazam::File>(path, status);
+
+    if (keptDescriptors.fetch_add(1) >= keptDescriptorsLimit() && S_ISREG(filestat.st_mode)) {
+        keptDescriptors--;
+        close(descriptor);
+        descriptor = -1;
+    }
+
+    return std::make_shared<shazam::File>(path, status, descriptor, filestat);
+}
+
+bool shazam::PathListReader::next(std::string& path)
+{
+    while (std::getline(input, path, delimiter)) {
+        if (!path.empty())
+            return true;
+    }
+
+    return false;
 }
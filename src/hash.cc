@@ -1,76 +1,384 @@
 #include "../include/shazam/common.hh"
 #include "../include/shazam/basic-types.hh"
+#include "../include/shazam/engine.hh"
 #include "../include/shazam/hash.hh"
+#include "../include/shazam/stats.hh"
+#include "../include/shazam/tree.hh"
 
 #include "../include/external/hashlib2plus/hl_hashwrapper.h"
 
+#include <algorithm>
 #include <string>
 #include <memory>
+#include <stdexcept>
+#include <variant>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Updates an engine with a block, timing the update when the statistics are enabled. */
+template <typename Engine>
+static inline void updateEngine(Engine& engine, const unsigned char* data, std::size_t len, bool timed)
+{
+    if (!timed) {
+        engine.update(data, len);
+        return;
+    }
+
+    const std::uint64_t start = shazam::Stats::now();
+    engine.update(data, len);
+    shazam::Stats::addHash(Engine::TYPE, len, shazam::Stats::now() - start);
+}
 
 void shazam::HashCalculator::calculate(void)
 {
-    if (hashSum == "")
-        hashSum = calculateHashSum();
+    if (!hashSums.empty() || calculateFromCache())
+        return;
+
+    const std::uint64_t start = Stats::enabled() ? Stats::now() : 0;
+    struct stat filestat;
+    setHashSums(calculateHashSum(filestat), filestat);
+
+    if (start != 0)
+        Stats::addFile(filestat.st_size, Stats::now() - start);
+}
+
+bool shazam::HashCalculator::calculateFromCache(void)
+{
+    struct stat filestat;
+
+    if (cache == nullptr)
+        return false;
+
+    // The attributes read by the validation are as good as a new stat
+    if (!file->attributes(filestat) && stat(file->path().c_str(), &filestat) != 0)
+        return false;
+
+    if (!S_ISREG(filestat.st_mode))
+        return false;
+
+    std::vector<Digest> sums(hashNames.size());
+
+    for (std::size_t i = 0; i < hashNames.size(); i++) {
+        if (!cache->lookup(filestat, hashTypes[i], sums[i]))
+            return false;
+    }
+
+    hashSums = std::move(sums);
+    notifyProgress(filestat.st_size);
+    return true;
+}
+
+void shazam::HashCalculator::setHashSums(std::vector<Digest> sums)
+{
+    if (sums.size() != hashNames.size())
+        throw std::invalid_argument("Expected one hash sum per hash type.");
+
+    hashSums = std::move(sums);
+}
+
+void shazam::HashCalculator::setHashSums(std::vector<Digest> sums, const struct stat& filestat)
+{
+    setHashSums(std::move(sums));
+
+    if (cache != nullptr && S_ISREG(filestat.st_mode)) {
+        for (auto& sum : hashSums)
+            cache->store(filestat, sum);
+    }
+}
+
+void shazam::HashCalculator::setCache(std::shared_ptr<HashCache> value)
+{
+    cache = value;
+}
+
+void shazam::HashCalculator::setTreeThreads(unsigned int value)
+{
+    treeThreads = std::max(1u, value);
 }
 
 std::string shazam::HashCalculator::type(void)
 {
-    return hashName;
+    return hashNames.front();
+}
+
+std::vector<std::string> shazam::HashCalculator::types(void)
+{
+    return hashNames;
 }
 
 shazam::HashSum shazam::HashCalculator::get(void)
 {
-    if (hashSum == "")
-        calculate();
+    return get(0);
+}
 
+shazam::HashSum shazam::HashCalculator::get(std::size_t index)
+{
     return HashSum {
         .filename = file->path(),
-        .hashType = hashName,
-        .hashSum = hashSum
+        .hashType = hashNames.at(index),
+        .hashSum = digest(index)
     };
 }
 
+std::vector<shazam::HashSum> shazam::HashCalculator::getAll(void)
+{
+    std::vector<HashSum> sums;
+
+    for (std::size_t i = 0; i < hashNames.size(); i++)
+        sums.push_back(get(i));
+
+    return sums;
+}
+
+const shazam::Digest& shazam::HashCalculator::digest(std::size_t index)
+{
+    if (hashSums.empty())
+        calculate();
+
+    return hashSums.at(index);
+}
+
 std::string shazam::HashCalculator::getFilePath(void)
 {
     return file->path();
 }
 
-std::string shazam::HashCalculator::calculateHashSum(void)
+std::shared_ptr<shazam::File> shazam::HashCalculator::getFile(void)
+{
+    return file;
+}
+
+std::uintmax_t shazam::HashCalculator::getFileSize(void)
 {
-    return hasher->getHashFromFile(file->path());
+    return file->size();
+}
+
+const shazam::ReaderFactory& shazam::HashCalculator::getReaders(void) const
+{
+    return readers;
+}
+
+std::vector<shazam::Digest> shazam::HashCalculator::calculateHashSum(struct stat& filestat)
+{
+    const int fd = file->open(filestat);
+    std::vector<Digest> sums;
+
+    try {
+        if (!hashers.empty()) {
+            sums = hashWithHashers(fd, filestat);
+        } else if (hashTypes.size() == 1 && hashTypes.front() != TREE_HASH_TYPE) {
+            // The common case, where the type of the engine is known all the way down
+            sums.push_back(withEngine(hashTypes.front(), [this, fd, &filestat](auto& engine) {
+                return hashWithEngine(engine, fd, filestat);
+            }));
+        } else {
+            sums = hashWithEngines(fd, filestat);
+        }
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+
+    close(fd);
+    Stats::addSyscalls(1);
+    return sums;
+}
+
+template <typename Engine>
+shazam::Digest shazam::HashCalculator::hashWithEngine(Engine& engine, int fd, const struct stat& filestat)
+{
+    const bool timed = Stats::enabled();
+    unsigned char digest[Engine::DIGEST_SIZE];
+
+    engine.start();
+
+    readers.create(filestat)->read(fd, filestat.st_size, [this, &engine, timed](const unsigned char* data, std::size_t len) {
+        updateEngine(engine, data, len, timed);
+        notifyProgress(len);
+    });
+
+    return Digest(Engine::TYPE, digest, engine.finish(digest));
+}
+
+std::vector<shazam::Digest> shazam::HashCalculator::hashWithEngines(int fd, const struct stat& filestat)
+{
+    const bool timed = Stats::enabled();
+    const std::uintmax_t size = filestat.st_size;
+    std::vector<AnyEngine> engines;
+    bool tree = false;
+
+    for (auto type : hashTypes) {
+        if (type == TREE_HASH_TYPE) {
+            tree = true;
+            continue;
+        }
+
+        engines.push_back(makeEngine(type));
+        std::visit([](auto& engine) { engine.start(); }, engines.back());
+    }
+
+    // The tree hash reads with pread, in a pass of its own, which
+    // only counts for the progress when it is the only one
+    Digest treeDigest;
+
+    if (tree && !S_ISREG(filestat.st_mode))
+        throw std::runtime_error("Cannot calculate the tree hash of the stream \"" + file->path() + "\".");
+
+    if (tree) {
+        treeDigest = TreeHasher(treeThreads).hash(fd, size, [this, &engines](std::size_t len) {
+            if (engines.empty())
+                notifyProgress(len);
+        });
+
+        // Its chunks are read by several threads, so the pages are only given back at the end
+        if (readers.getPageCacheMode() != PAGE_CACHE_KEEP) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            Stats::addSyscalls(1);
+            Stats::addDropped(size);
+        }
+    }
+
+    if (!engines.empty()) {
+        readers.create(filestat)->read(fd, size, [this, &engines, timed](const unsigned char* data, std::size_t len) {
+            for (auto& engine : engines)
+                std::visit([data, len, timed](auto& engine) { updateEngine(engine, data, len, timed); }, engine);
+
+            notifyProgress(len);
+        });
+    }
+
+    std::vector<Digest> sums;
+    unsigned char digest[Digest::MAX_SIZE];
+    auto engine = engines.begin();
+
+    for (auto type : hashTypes) {
+        if (type == TREE_HASH_TYPE) {
+            sums.push_back(treeDigest);
+            continue;
+        }
+
+        std::visit([&sums, &digest](auto& engine) {
+            sums.emplace_back(engine.TYPE, digest, engine.finish(digest));
+        }, *engine++);
+    }
+
+    return sums;
+}
+
+std::vector<shazam::Digest> shazam::HashCalculator::hashWithHashers(int fd, const struct stat& filestat)
+{
+    // The time of each update is only taken when the statistics are enabled
+    const bool timed = Stats::enabled();
+
+    for (auto& hasher : hashers)
+        hasher->start();
+
+    readers.create(filestat)->read(fd, filestat.st_size, [this, timed](const unsigned char* data, std::size_t len) {
+        for (std::size_t i = 0; i < hashers.size(); i++) {
+            const std::uint64_t start = timed ? Stats::now() : 0;
+            hashers[i]->update(data, len);
+
+            if (timed)
+                Stats::addHash(hashTypes[i], len, Stats::now() - start);
+        }
+
+        notifyProgress(len);
+    });
+
+    std::vector<Digest> sums;
+    unsigned char digest[HL_MAX_DIGEST_LENGTH];
+
+    for (std::size_t i = 0; i < hashers.size(); i++) {
+        const std::size_t len = hashers[i]->finish(digest);
+        sums.emplace_back(hashTypes[i], digest, len);
+    }
+
+    return sums;
+}
+
+std::vector<std::unique_ptr<hashwrapper>>
+shazam::HashCalculator::makeHashers(std::unique_ptr<hashwrapper> wrapper)
+{
+    std::vector<std::unique_ptr<hashwrapper>> hashers;
+    hashers.push_back(std::move(wrapper));
+    return hashers;
+}
+
+std::vector<std::size_t>
+shazam::HashCalculator::typeIndexes(const std::vector<std::string>& names, bool known)
+{
+    std::vector<std::size_t> indexes;
+
+    for (auto& name : names) {
+        indexes.push_back(hashTypeIndex(name));
+
+        if (known && indexes.back() == HASH_TYPES.size())
+            throw std::invalid_argument("Unknown hash type \"" + name + "\".");
+    }
+
+    return indexes;
 }
 
 std::shared_ptr<shazam::HashCalculator>
 shazam::HashFactory::hashFile(std::string hashtype, std::shared_ptr<shazam::File> file)
 {
-    auto wrapper = std::unique_ptr<hashwrapper>(create(hashtype));
-    return std::make_shared<HashCalculator>(hashtype, std::move(wrapper), file);
+    return hashFile(std::vector<std::string>{hashtype}, file);
 }
 
-shazam::FileHashSumComparationResult shazam::HashComparator::compareHashes()
+std::shared_ptr<shazam::HashCalculator>
+shazam::HashFactory::hashFile(std::vector<std::string> hashtypes, std::shared_ptr<shazam::File> file)
 {
-    const std::string original = originalHashSum.hashSum;
-    const std::string current = currentHashSum.hashSum;
-    const ComparationResult result = makeComparation(original, current);
+    auto hash = std::make_shared<HashCalculator>(hashtypes, file, ReaderFactory(ioMode, buffers, queueDepth, pageCache, tee));
+    hash->setCache(cache);
+    hash->setTreeThreads(treeThreads);
+    return hash;
+}
 
+void shazam::HashFactory::setIOMode(EIOMode mode, std::size_t buffers, unsigned int queueDepth,
+                                    EPageCacheMode pageCache)
+{
+    ioMode = ReaderFactory(mode, buffers, queueDepth).getMode();
+    this->buffers = buffers;
+    this->queueDepth = queueDepth;
+    this->pageCache = pageCache;
+}
+
+void shazam::HashFactory::setCache(std::shared_ptr<HashCache> value)
+{
+    cache = value;
+}
+
+void shazam::HashFactory::setTee(int descriptor)
+{
+    tee = descriptor;
+}
+
+int shazam::HashFactory::getTee() const
+{
+    return tee;
+}
+
+void shazam::HashFactory::setTreeThreads(unsigned int value)
+{
+    treeThreads = std::max(1u, value);
+}
+
+shazam::FileHashSumComparationResult shazam::HashComparator::compareHashes()
+{
     return FileHashSumComparationResult {
         .filename = currentHashSum.filename,
         .hashType = originalHashSum.hashType,
-        .originalHashSum = original,
-        .currentHashSum = current,
-        .result = result
+        .originalHashSum = originalHashSum.hashSum,
+        .currentHashSum = currentHashSum.hashSum,
+        .result = makeComparation(originalHashSum.hashSum, currentHashSum.hashSum)
     };
 }
 
 shazam::ComparationResult
-shazam::HashComparator::makeComparation(std::string original, std::string current)
-{
-    /* Initially I wanted to convert the values to int, but I didn't make it that way,
-     * because the hexadecimal values are exceeding the maximum bound of value (unsigned long long).
-     * */
-    // TODO: update check algorithm to a more secure one
-    if (original != current)
-        return NOT_MATCH;
-    else
-        return MATCH;
-}
\ No newline at end of file
+shazam::HashComparator::makeComparation(const Digest& original, const Digest& current)
+{
+    return !original.empty() && original == current ? MATCH : NOT_MATCH;
+}
@@ -0,0 +1,196 @@
+#include "../include/shazam/manifest.hh"
+#include "../include/shazam/basic-types.hh"
+#include "../include/shazam/common.hh"
+#include "../include/shazam/tree.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <istream>
+#include <string>
+
+/* Returns true if the digest has the right number of hexadecimal digits for the type. */
+static bool validDigest(const std::string& digest, const std::string& type)
+{
+    const std::size_t index = shazam::hashTypeIndex(type);
+
+    if (index == shazam::HASH_TYPES.size() || digest.size() != 2 * shazam::HASH_DIGEST_SIZES[index])
+        return false;
+
+    return std::all_of(digest.begin(), digest.end(), [](unsigned char c) { return std::isxdigit(c); });
+}
+
+/* Undoes the escaping of coreutils, used for names with newlines or backslashes. */
+static bool unescapeFilename(std::string& filename)
+{
+    std::string unescaped;
+    unescaped.reserve(filename.size());
+
+    for (std::size_t i = 0; i < filename.size(); i++) {
+        if (filename[i] != '\\') {
+            unescaped.push_back(filename[i]);
+            continue;
+        }
+
+        if (++i == filename.size())
+            return false;
+
+        switch (filename[i]) {
+            case '\\': unescaped.push_back('\\'); break;
+            case 'n': unescaped.push_back('\n'); break;
+            case 'r': unescaped.push_back('\r'); break;
+            default: return false;
+        }
+    }
+
+    filename = unescaped;
+    return true;
+}
+
+std::string shazam::hashTypeFromDigestLength(std::size_t digits)
+{
+    for (std::size_t i = 0; i < HASH_DIGEST_SIZES.size(); i++) {
+        if (digits == 2 * HASH_DIGEST_SIZES[i])
+            return HASH_TYPES[i];
+    }
+
+    return "";
+}
+
+std::string shazam::sectionHeader(const std::string& hashType)
+{
+    if (hashTypeIndex(hashType) == TREE_HASH_TYPE)
+        return "# " + hashType + " " + std::to_string(TREE_CHUNK_SIZE);
+
+    return "# " + hashType;
+}
+
+bool shazam::alwaysInSection(const std::string& hashType)
+{
+    const std::size_t index = hashTypeIndex(hashType);
+    return index < HASH_TYPES.size() && hashTypeFromDigestLength(2 * HASH_DIGEST_SIZES[index]) != HASH_TYPES[index];
+}
+
+bool shazam::ManifestReader::next(ManifestEntry& entry)
+{
+    std::string line;
+
+    while (std::getline(input, line)) {
+        bool malformed = false;
+        lineNumber++;
+
+        if (parseLine(line, entry, malformed)) {
+            entry.line = lineNumber;
+            return true;
+        }
+
+        if (malformed)
+            malformedLines++;
+    }
+
+    return false;
+}
+
+std::size_t shazam::ManifestReader::getMalformedLines() const
+{
+    return malformedLines;
+}
+
+bool shazam::ManifestReader::parseLine(std::string line, ManifestEntry& entry, bool& malformed)
+{
+    if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+
+    if (line.empty())
+        return false;
+
+    if (line.front() == '#') {
+        // The section headers written by shazam, when hashing with many types
+        // or with the tree hash. The entries under the header of a tree hash
+        // with other chunks are left malformed, as they can't be verified.
+        const std::string type = line.size() > 2 && line[1] == ' ' ? toUpperCase(line.substr(2, line.find(' ', 2) - 2)) : "";
+
+        if (hashTypeIndex(type) == HASH_TYPES.size())
+            return false;
+
+        if (toUpperCase(line) == sectionHeader(type))
+            sectionType = type;
+        else if (alwaysInSection(type))
+            sectionType = line;
+
+        return false;
+    }
+
+    const bool escaped = line.front() == '\\';
+
+    if (escaped)
+        line.erase(0, 1);
+
+    if (!parseBSDLine(line, entry) && !parseGNULine(line, entry)) {
+        malformed = true;
+        return false;
+    }
+
+    if (escaped && !unescapeFilename(entry.filename)) {
+        malformed = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool shazam::ManifestReader::parseBSDLine(const std::string& line, ManifestEntry& entry)
+{
+    const std::size_t open = line.find(" (");
+    const std::size_t close = line.rfind(") = ");
+
+    if (open == std::string::npos || close == std::string::npos || close < open + 2)
+        return false;
+
+    const std::string type = line.substr(0, open);
+    const std::string digest = line.substr(close + 4);
+
+    if (!validDigest(digest, type))
+        return false;
+
+    entry.hashType = toUpperCase(type);
+    entry.filename = line.substr(open + 2, close - open - 2);
+    entry.hashSum = Digest::fromHex(hashTypeIndex(type), digest);
+    return !entry.filename.empty();
+}
+
+bool shazam::ManifestReader::parseGNULine(const std::string& line, ManifestEntry& entry)
+{
+    const std::size_t space = line.find(' ');
+
+    if (space == std::string::npos || space + 1 == line.size())
+        return false;
+
+    std::string digest = line.substr(0, space);
+    std::size_t nameStart = space + 1;
+    std::string type = forcedType;
+
+    // xxhsum marks its XXH3 sums, which would be taken for XXH64 ones
+    if (toUpperCase(digest.substr(0, 5)) == "XXH3_") {
+        digest.erase(0, 5);
+
+        if (type.empty())
+            type = "XXH3";
+    }
+
+    // Two spaces for text mode, " *" for binary mode and a single
+    // space in the output of shazam
+    if (line[nameStart] == ' ' || line[nameStart] == '*')
+        nameStart++;
+
+    if (type.empty())
+        type = !sectionType.empty() ? sectionType : hashTypeFromDigestLength(digest.size());
+
+    if (!validDigest(digest, type) || nameStart >= line.size())
+        return false;
+
+    entry.hashType = toUpperCase(type);
+    entry.filename = line.substr(nameStart);
+    entry.hashSum = Digest::fromHex(hashTypeIndex(type), digest);
+    return true;
+}
@@ -0,0 +1,152 @@
+#include "../include/shazam/output.hh"
+#include "../include/shazam/stats.hh"
+#include "../include/shazam/manifest.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/* Appends the `<digest> <file>` line of a hash sum, the digest being
+ * encoded right into the end of `lines`. */
+static void appendLine(std::string& lines, const shazam::HashSum& sum)
+{
+    const std::size_t start = lines.size();
+    lines.resize(start + 2 * sum.hashSum.size());
+    sum.hashSum.toHex(&lines[start]);
+    lines += ' ';
+    lines += sum.filename;
+    lines += '\n';
+}
+
+void shazam::ResultWriter::write(std::size_t group, ResultGroup results)
+{
+    const StatsTimer timer(PHASE_OUTPUT);
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (unordered || group == nextGroup) {
+        writeGroup(results);
+        nextGroup++;
+    } else {
+        waiting.emplace(group, std::move(results));
+    }
+
+    // The groups that were waiting for this one
+    for (auto next = waiting.begin(); next != waiting.end() && next->first == nextGroup; next = waiting.erase(next)) {
+        writeGroup(next->second);
+        nextGroup++;
+    }
+}
+
+void shazam::ResultWriter::writePart(ResultGroup results)
+{
+    if (!unordered)
+        throw std::logic_error("Only unordered results can be written in parts.");
+
+    const StatsTimer timer(PHASE_OUTPUT);
+    std::lock_guard<std::mutex> lock(mutex);
+    writeResults(results);
+}
+
+void shazam::ResultWriter::finish()
+{
+    const StatsTimer timer(PHASE_OUTPUT);
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto& group : waiting)
+        writeGroup(group.second);
+
+    waiting.clear();
+
+    for (std::size_t i = 1; i < types.size(); i++)
+        writeSection(i);
+
+    out.flush();
+}
+
+std::size_t shazam::ResultWriter::getWrittenGroups() const
+{
+    return writtenGroups;
+}
+
+std::vector<std::shared_ptr<shazam::File>> shazam::ResultWriter::getInvalidFiles() const
+{
+    return invalidFiles;
+}
+
+void shazam::ResultWriter::writeGroup(const ResultGroup& results)
+{
+    writeResults(results);
+    writtenGroups++;
+}
+
+void shazam::ResultWriter::writeResults(const ResultGroup& results)
+{
+    std::string lines;
+
+    for (auto& sum : results.sums) {
+        const auto type = std::find(types.begin(), types.end(), sum.hashType);
+
+        if (type == types.begin()) {
+            if (!started && (types.size() > 1 || alwaysInSection(types.front())))
+                lines += sectionHeader(types.front()) + "\n";
+
+            appendLine(lines, sum);
+            started = true;
+        } else if (type != types.end()) {
+            Section& section = sections[type - types.begin()];
+            appendLine(section.lines, sum);
+
+            if (section.lines.size() >= SECTION_SPILL_SIZE)
+                spillSection(section);
+        }
+    }
+
+    out << lines;
+
+    invalidFiles.insert(invalidFiles.end(), results.invalid.begin(), results.invalid.end());
+}
+
+void shazam::ResultWriter::spillSection(Section& section)
+{
+    if (section.spill == nullptr)
+        section.spill.reset(std::tmpfile());
+
+    // Without a temporary file the section stays in memory
+    if (section.spill == nullptr)
+        return;
+
+    if (std::fwrite(section.lines.data(), 1, section.lines.size(), section.spill.get()) != section.lines.size())
+        throw std::runtime_error("Cannot keep the hash sums in a temporary file.");
+
+    section.lines.clear();
+}
+
+void shazam::ResultWriter::writeSection(std::size_t index)
+{
+    Section& section = sections[index];
+
+    if (section.spill == nullptr && section.lines.empty())
+        return;
+
+    out << "\n" << sectionHeader(types[index]) << "\n";
+
+    if (section.spill != nullptr) {
+        std::vector<char> buffer(SECTION_SPILL_SIZE);
+        std::rewind(section.spill.get());
+
+        for (std::size_t len; (len = std::fread(buffer.data(), 1, buffer.size(), section.spill.get())) > 0; )
+            out.write(buffer.data(), len);
+
+        if (std::ferror(section.spill.get()))
+            throw std::runtime_error("Cannot read the hash sums back from a temporary file.");
+
+        section.spill.reset();
+    }
+
+    out << section.lines;
+    section.lines.clear();
+}
@@ -0,0 +1,154 @@
+#include "../include/shazam/pool.hh"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+    /* The pool and the queue of the worker running on this thread, so
+     * that the tasks it submits go to its own queue. */
+    thread_local const shazam::WorkStealingPool* currentPool = nullptr;
+    thread_local std::size_t currentWorker = 0;
+}
+
+unsigned int shazam::onlineCpus()
+{
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (cpus > 0)
+        return (unsigned int) cpus;
+
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+shazam::WorkStealingPool::WorkStealingPool(unsigned int size)
+: queuedTasks(0), pendingTasks(0), sleepingWorkers(0), nextWorker(0), stopping(false)
+{
+    size = std::max(1u, size);
+
+    for (unsigned int i = 0; i < size; i++)
+        workers.push_back(std::make_unique<Worker>());
+
+    for (unsigned int i = 0; i < size; i++)
+        threads.emplace_back(&WorkStealingPool::work, this, i);
+}
+
+shazam::WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        allDone.wait(lock, [this] { return pendingTasks == 0; });
+        stopping = true;
+    }
+
+    taskAvailable.notify_all();
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void shazam::WorkStealingPool::submit(Task task)
+{
+    const std::size_t index = currentPool == this ? currentWorker : nextWorker++ % workers.size();
+    Worker& worker = *workers[index];
+
+    pendingTasks++;
+
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+        queuedTasks++;
+    }
+
+    // A worker going to sleep counts itself before looking at the queued
+    // tasks, so either it sees this one or it is seen here
+    if (sleepingWorkers > 0) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        taskAvailable.notify_one();
+    }
+}
+
+void shazam::WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [this] { return pendingTasks == 0; });
+
+    if (firstError) {
+        std::exception_ptr error = firstError;
+        firstError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+std::size_t shazam::WorkStealingPool::size() const
+{
+    return workers.size();
+}
+
+bool shazam::WorkStealingPool::takeTask(std::size_t index, Task& task)
+{
+    for (std::size_t i = 0; i < workers.size(); i++) {
+        Worker& worker = *workers[(index + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+
+        if (!worker.tasks.empty()) {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+            queuedTasks--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool shazam::WorkStealingPool::waitForTasks()
+{
+    std::unique_lock<std::mutex> lock(stateMutex);
+    sleepingWorkers++;
+    taskAvailable.wait(lock, [this] { return queuedTasks > 0 || stopping; });
+    sleepingWorkers--;
+
+    return queuedTasks > 0;
+}
+
+void shazam::WorkStealingPool::work(std::size_t index)
+{
+    currentPool = this;
+    currentWorker = index;
+    Task task;
+
+    while (true) {
+        // Another worker may take the task seen by the wait first, then
+        // this one looks again
+        if (!takeTask(index, task)) {
+            if (!waitForTasks())
+                return;
+
+            continue;
+        }
+
+        std::exception_ptr error = nullptr;
+
+        try {
+            task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        task = nullptr;
+
+        if (error) {
+            std::lock_guard<std::mutex> lock(stateMutex);
+
+            if (!firstError)
+                firstError = error;
+        }
+
+        if (--pendingTasks == 0) {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            allDone.notify_all();
+        }
+    }
+}
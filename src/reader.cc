@@ -0,0 +1,795 @@
+#include "../include/shazam/reader.hh"
+#include "../include/shazam/common.hh"
+#include "../include/shazam/stats.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <csignal>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+    /* Frees the memory returned by aligned_alloc. */
+    struct FreeDeleter {
+        void operator()(unsigned char* data) const { std::free(data); }
+    };
+
+    /* Unmaps a memory mapped file when it goes out of scope. */
+    struct Mapping {
+        void* const data;
+        const std::size_t size;
+
+        ~Mapping() { if (data != MAP_FAILED) munmap(data, size); }
+    };
+
+    /* The mapping being read by the thread, for handleBusError. */
+    thread_local unsigned char* watchedData = nullptr;
+    thread_local std::size_t watchedSize = 0;
+    thread_local volatile sig_atomic_t watchedTruncated = 0;
+
+    struct sigaction previousBusAction;
+    std::size_t pageSize = 4096;
+
+    /* Handles the SIGBUS raised when a page of a mapped file past its
+     * end is touched, because the file was truncated after it was
+     * mapped. If the page is in the mapping read by the thread, the
+     * rest of the mapping is replaced by zeros, so the reads go on,
+     * and the mapping is marked as truncated. Otherwise the previous
+     * action is put back, and the fault happens again with it. */
+    void handleBusError(int, siginfo_t* info, void*)
+    {
+        unsigned char* const address = (unsigned char*) info->si_addr;
+
+        if (watchedData != nullptr && address >= watchedData && address < watchedData + watchedSize) {
+            unsigned char* const page = watchedData + (address - watchedData) / pageSize * pageSize;
+            const std::size_t rest = watchedData + watchedSize - page;
+
+            if (mmap(page, rest, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED) {
+                watchedTruncated = 1;
+                return;
+            }
+        }
+
+        sigaction(SIGBUS, &previousBusAction, nullptr);
+    }
+
+    /* Watches a mapping for the truncation of its file while it is
+     * being read by the thread. */
+    class TruncationWatch {
+    public:
+        explicit TruncationWatch(const Mapping& mapping)
+        {
+            // Installed once, the first time a file is mapped
+            static const bool installed = []() {
+                struct sigaction action = {};
+                action.sa_sigaction = handleBusError;
+                action.sa_flags = SA_SIGINFO;
+                sigemptyset(&action.sa_mask);
+                pageSize = (std::size_t) sysconf(_SC_PAGESIZE);
+                return sigaction(SIGBUS, &action, &previousBusAction) == 0;
+            }();
+
+            (void) installed;
+            watchedTruncated = 0;
+            watchedSize = mapping.size;
+            watchedData = (unsigned char*) mapping.data;
+        }
+
+        ~TruncationWatch() { watchedData = nullptr; }
+
+        /* Returns true if the file was found shorter than its mapping. */
+        bool truncated() const { return watchedTruncated != 0; }
+    };
+
+    /* A page aligned buffer of LARGE_BUFFER_SIZE bytes. */
+    using LargeBuffer = std::unique_ptr<unsigned char, FreeDeleter>;
+
+    LargeBuffer allocateLargeBuffer()
+    {
+        LargeBuffer buffer((unsigned char*) std::aligned_alloc(4096, shazam::LARGE_BUFFER_SIZE));
+
+        if (buffer == nullptr)
+            throw std::bad_alloc();
+
+        return buffer;
+    }
+
+    /* Reads a file from its descriptor, telling the kernel how: that it
+     * is read sequentially, for the big files, and, unless the page cache
+     * is kept, that the pages behind the reads aren't needed anymore.
+     * When the page cache is bypassed the file is read with O_DIRECT,
+     * until the file system or a read that isn't aligned, such as the
+     * one past the tail of the file, don't allow it, and then the pages
+     * are given back as they are read.
+     * */
+    class AdvisedFile {
+        const int fd;
+        const bool dropping;
+        bool direct;
+        std::uintmax_t dropped;
+        std::uintmax_t offset;
+
+    public:
+        /* Reads `fd`, of `size` bytes, from `start`, the offset it is at. */
+        AdvisedFile(int fd, std::uintmax_t size, shazam::EPageCacheMode pageCache, std::uintmax_t start = 0)
+        : fd(fd), dropping(pageCache != shazam::PAGE_CACHE_KEEP), direct(false), dropped(start), offset(start)
+        {
+            if (pageCache == shazam::PAGE_CACHE_BYPASS) {
+                direct = fcntl(fd, F_SETFL, O_DIRECT) == 0;
+                shazam::Stats::addSyscalls(1);
+            }
+
+            if (size > shazam::SEQUENTIAL_HINT_MIN_SIZE || (dropping && !direct)) {
+                posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                shazam::Stats::addSyscalls(1);
+            }
+        }
+
+        /* Gives back the pages read since the last time. */
+        ~AdvisedFile()
+        {
+            drop();
+        }
+
+        AdvisedFile(const AdvisedFile&) = delete;
+        AdvisedFile& operator=(const AdvisedFile&) = delete;
+
+        /* Reads like read(2), retrying when interrupted. */
+        ssize_t read(unsigned char* buffer, std::size_t size)
+        {
+            while (true) {
+                const ssize_t len = ::read(fd, buffer, size);
+
+                if (len < 0 && errno == EINTR)
+                    continue;
+
+                if (len < 0 && errno == EINVAL && direct) {
+                    direct = false;
+                    fcntl(fd, F_SETFL, 0);
+                    shazam::Stats::addSyscalls(1);
+                    continue;
+                }
+
+                if (len > 0)
+                    advance((std::size_t) len);
+
+                return len;
+            }
+        }
+
+    private:
+        /* Moves the offset past `len` bytes read. */
+        void advance(std::size_t len)
+        {
+            offset += len;
+
+            if (direct) {
+                // Nothing was cached, so there is nothing to give back
+                shazam::Stats::addDirect(len);
+                dropped = offset;
+            } else if (dropping && offset - dropped >= shazam::DROP_BEHIND_SIZE) {
+                drop();
+            }
+        }
+
+        /* Gives back the pages from the last ones given back to the offset. */
+        void drop()
+        {
+            if (!dropping || offset == dropped)
+                return;
+
+            posix_fadvise(fd, (off_t) dropped, (off_t) (offset - dropped), POSIX_FADV_DONTNEED);
+            shazam::Stats::addSyscalls(1);
+            shazam::Stats::addDropped(offset - dropped);
+            dropped = offset;
+        }
+    };
+
+    /* A buffer of the ring of PipelinedReader, with the block read into it. */
+    struct PipelineSlot {
+        unsigned char* data;
+        std::size_t len;
+        std::uint64_t readNanos;
+    };
+
+    /* The ring of buffers shared by the thread that reads a file and
+     * the one that consumes its blocks. The blocks are numbered from
+     * the start of the file, and the block `i` goes in the slot
+     * `i % slots.size()`, so the reader can be at most slots.size()
+     * blocks ahead of the consumer.
+     * */
+    struct Pipeline {
+        std::mutex mutex;
+        std::condition_variable filled;
+        std::condition_variable emptied;
+        std::vector<PipelineSlot> slots;
+        std::size_t produced = 0;
+        std::size_t consumed = 0;
+        bool finished = false;
+        bool stopped = false;
+        std::string error;
+
+        /* Reads the blocks of the file until its end, a read error
+         * or stop() being called. Runs on its own thread. */
+        void produce(AdvisedFile* file)
+        {
+            const bool timed = shazam::Stats::enabled();
+
+            while (true) {
+                std::unique_lock<std::mutex> lock(mutex);
+                emptied.wait(lock, [this] { return stopped || produced - consumed < slots.size(); });
+
+                if (stopped)
+                    return;
+
+                PipelineSlot& slot = slots[produced % slots.size()];
+                lock.unlock();
+
+                const std::uint64_t start = timed ? shazam::Stats::now() : 0;
+                const ssize_t len = file->read(slot.data, shazam::LARGE_BUFFER_SIZE);
+                const int readErrno = errno;
+                lock.lock();
+
+                if (len > 0) {
+                    slot.len = (std::size_t) len;
+                    slot.readNanos = timed ? shazam::Stats::now() - start : 0;
+                    produced++;
+                } else {
+                    if (len < 0)
+                        error = std::string("Cannot read file: ") + std::strerror(readErrno);
+
+                    finished = true;
+                }
+
+                filled.notify_one();
+
+                if (finished)
+                    return;
+            }
+        }
+
+        /* Waits for the next block, returning null once all of them
+         * were consumed. Throws std::runtime_error if the read failed. */
+        const PipelineSlot* next()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            filled.wait(lock, [this] { return finished || produced > consumed; });
+
+            if (produced > consumed)
+                return &slots[consumed % slots.size()];
+
+            if (!error.empty())
+                throw std::runtime_error(error);
+
+            return nullptr;
+        }
+
+        /* Gives the slot of the block returned by next() back to the reader. */
+        void release()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            consumed++;
+            emptied.notify_one();
+        }
+
+        /* Makes the reader stop before its next read. */
+        void stop()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = true;
+            emptied.notify_one();
+        }
+    };
+
+    /* Throws the error of the last failed system call. */
+    [[noreturn]] void throwReadError(const std::string& what)
+    {
+        throw std::runtime_error(what + ": " + std::strerror(errno));
+    }
+
+    /* Reads like read(2), retrying when interrupted. */
+    ssize_t readRetrying(int fd, unsigned char* buffer, std::size_t size)
+    {
+        while (true) {
+            const ssize_t len = ::read(fd, buffer, size);
+
+            if (len >= 0 || errno != EINTR)
+                return len;
+        }
+    }
+
+    /* Raises the capacity of the pipe `fd` to STREAM_PIPE_SIZE, returning
+     * false if it isn't a pipe. The capacity may stay lower, if the limits
+     * of the user don't allow it. */
+    bool widenPipe(int fd)
+    {
+        const int capacity = fcntl(fd, F_GETPIPE_SZ);
+        shazam::Stats::addSyscalls(1);
+
+        if (capacity < 0)
+            return false;
+
+        if ((std::size_t) capacity < shazam::STREAM_PIPE_SIZE) {
+            fcntl(fd, F_SETPIPE_SZ, (int) shazam::STREAM_PIPE_SIZE);
+            shazam::Stats::addSyscalls(1);
+        }
+
+        return true;
+    }
+
+    /* The copy of a stream written to the descriptor of --tee. The data
+     * of an input pipe is duplicated into a pipe of its own with tee(2),
+     * and spliced from there into the output, so it is never copied to
+     * and from the memory of the process. Where the output can't be
+     * spliced into, such as a file opened for appending, it falls back
+     * to writing the blocks read.
+     * */
+    class TeeOutput {
+        const int out;
+        int pipe[2];
+        bool splicing;
+
+    public:
+        /* Copies the stream read from `in`, a pipe if `fromPipe`, to `out`. */
+        TeeOutput(int out, bool fromPipe): out(out), pipe{-1, -1}, splicing(false)
+        {
+            if (fromPipe && pipe2(pipe, O_CLOEXEC) == 0) {
+                splicing = true;
+                widenPipe(pipe[1]);
+            }
+
+            shazam::Stats::addSyscalls(fromPipe ? 1 : 0);
+        }
+
+        ~TeeOutput()
+        {
+            if (pipe[0] >= 0) {
+                close(pipe[0]);
+                close(pipe[1]);
+            }
+        }
+
+        TeeOutput(const TeeOutput&) = delete;
+        TeeOutput& operator=(const TeeOutput&) = delete;
+
+        /* Returns true while the data is spliced, and so has to be copied
+         * with duplicate() before being read, instead of written after. */
+        bool isSplicing() const
+        {
+            return splicing;
+        }
+
+        /* Copies up to `size` bytes waiting in the pipe `in` to the output,
+         * without taking them out of it, and returns how many, 0 at the end
+         * of the stream or -1 if they can't be spliced, in which case they
+         * have to be written once read.
+         * */
+        ssize_t duplicate(int in, std::size_t size)
+        {
+            ssize_t len;
+
+            do {
+                len = ::tee(in, pipe[1], size, 0);
+                shazam::Stats::addSyscalls(1);
+            } while (len < 0 && errno == EINTR);
+
+            if (len < 0) {
+                stopSplicing();
+                return -1;
+            }
+
+            for (std::size_t moved = 0; moved < (std::size_t) len;) {
+                const ssize_t spliced = splice(pipe[0], nullptr, out, nullptr, (std::size_t) len - moved, SPLICE_F_MOVE);
+                shazam::Stats::addSyscalls(1);
+
+                if (spliced < 0 && errno == EINTR)
+                    continue;
+
+                // Nothing reached the output yet, so all of it can still be written instead
+                if (spliced < 0 && moved == 0 && errno == EINVAL) {
+                    stopSplicing();
+                    return -1;
+                }
+
+                if (spliced <= 0)
+                    throwWriteError();
+
+                moved += (std::size_t) spliced;
+            }
+
+            return len;
+        }
+
+        /* Writes a block read from the stream to the output. */
+        void write(const unsigned char* data, std::size_t len)
+        {
+            while (len > 0) {
+                const ssize_t written = ::write(out, data, len);
+                shazam::Stats::addSyscalls(1);
+
+                if (written < 0 && errno == EINTR)
+                    continue;
+
+                if (written <= 0)
+                    throwWriteError();
+
+                data += written;
+                len -= (std::size_t) written;
+            }
+        }
+
+    private:
+        /* Goes back to writing the blocks, dropping the copy made by tee(2). */
+        void stopSplicing()
+        {
+            splicing = false;
+            close(pipe[0]);
+            close(pipe[1]);
+            pipe[0] = pipe[1] = -1;
+            shazam::Stats::addSyscalls(2);
+        }
+
+        [[noreturn]] void throwWriteError()
+        {
+            throw std::runtime_error(std::string("Cannot write the copy of the stream: ") + std::strerror(errno));
+        }
+    };
+
+    /* Reads the file into the buffer until its end. */
+    void readInto(AdvisedFile& file, unsigned char* buffer, std::size_t size, const shazam::BlockConsumer& consume)
+    {
+        const bool timed = shazam::Stats::enabled();
+
+        while (true) {
+            const std::uint64_t start = timed ? shazam::Stats::now() : 0;
+            const ssize_t len = file.read(buffer, size);
+
+            if (timed)
+                shazam::Stats::addRead(shazam::Stats::now() - start);
+
+            if (len == 0)
+                return;
+
+            if (len < 0)
+                throwReadError("Cannot read file");
+
+            consume(buffer, (std::size_t) len);
+        }
+    }
+}
+
+shazam::EIOMode shazam::ioModeFromName(std::string name)
+{
+    name = toLowerCase(name);
+
+    for (std::size_t i = 0; i < IO_MODES.size(); i++) {
+        if (name == IO_MODES[i])
+            return (EIOMode) i;
+    }
+
+    throw std::invalid_argument("Unknown io mode '" + name + "'");
+}
+
+void shazam::SyscallReader::read(int fd, std::uintmax_t size, const BlockConsumer& consume)
+{
+    if (pageCache == PAGE_CACHE_BYPASS) {
+        BufferedReader(pageCache).read(fd, size, consume);
+        return;
+    }
+
+    unsigned char buffer[SMALL_BUFFER_SIZE];
+    AdvisedFile file(fd, size, pageCache);
+    readInto(file, buffer, sizeof(buffer), consume);
+}
+
+void shazam::BufferedReader::read(int fd, std::uintmax_t size, const BlockConsumer& consume)
+{
+    // Allocated once per thread, page aligned so the kernel can copy whole
+    // pages, and so that it can be read into with O_DIRECT
+    thread_local LargeBuffer buffer = allocateLargeBuffer();
+    AdvisedFile file(fd, size, pageCache);
+    readInto(file, buffer.get(), LARGE_BUFFER_SIZE, consume);
+}
+
+void shazam::PipelinedReader::read(int fd, std::uintmax_t size, const BlockConsumer& consume)
+{
+    // There is nothing to overlap when the whole file fits in one buffer
+    if (buffers < 2 || size <= LARGE_BUFFER_SIZE) {
+        BufferedReader(pageCache).read(fd, size, consume);
+        return;
+    }
+
+    // Like the one of BufferedReader, the ring is kept by the thread for its next files
+    thread_local std::vector<LargeBuffer> ring;
+
+    while (ring.size() < buffers)
+        ring.push_back(allocateLargeBuffer());
+
+    Pipeline pipeline;
+    AdvisedFile file(fd, size, pageCache);
+
+    for (std::size_t i = 0; i < buffers; i++)
+        pipeline.slots.push_back({ ring[i].get(), 0, 0 });
+
+    std::thread reader(&Pipeline::produce, &pipeline, &file);
+    Stats::addSyscalls(1);
+
+    // Also when consume throws, the reader must be gone before the ring is reused
+    struct Joiner {
+        Pipeline& pipeline;
+        std::thread& reader;
+
+        ~Joiner()
+        {
+            pipeline.stop();
+            reader.join();
+        }
+    } joiner { pipeline, reader };
+
+    while (const PipelineSlot* slot = pipeline.next()) {
+        Stats::addRead(slot->readNanos);
+        consume(slot->data, slot->len);
+        pipeline.release();
+    }
+}
+
+void shazam::MappedReader::read(int fd, std::uintmax_t size, const BlockConsumer& consume)
+{
+    if (pageCache != PAGE_CACHE_KEEP) {
+        BufferedReader(pageCache).read(fd, size, consume);
+        return;
+    }
+
+    // Empty files, and files like the ones on procfs, can't be mapped
+    if (size == 0) {
+        SyscallReader().read(fd, size, consume);
+        return;
+    }
+
+    {
+        const Mapping mapping { mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0), size };
+        Stats::addSyscalls(1);
+
+        if (mapping.data == MAP_FAILED) {
+            BufferedReader().read(fd, size, consume);
+            return;
+        }
+
+        madvise(mapping.data, size, MADV_SEQUENTIAL);
+        Stats::addSyscalls(2); // And the munmap
+
+        const TruncationWatch watch(mapping);
+        const unsigned char* bytes = (const unsigned char*) mapping.data;
+
+        for (std::uintmax_t offset = 0; offset < size && !watch.truncated(); offset += LARGE_BUFFER_SIZE)
+            consume(bytes + offset, (std::size_t) std::min<std::uintmax_t>(LARGE_BUFFER_SIZE, size - offset));
+
+        if (watch.truncated())
+            throw std::runtime_error("Cannot read file: it is shorter than it was.");
+    }
+
+    // Whatever was appended to the file after it was mapped
+    Stats::addSyscalls(1);
+
+    if (lseek(fd, (off_t) size, SEEK_SET) >= 0)
+        SyscallReader().read(fd, size, consume);
+}
+
+void shazam::SparseReader::read(int fd, std::uintmax_t size, const BlockConsumer& consume)
+{
+    // Never written, so its pages are all the zero page of the kernel
+    static const unsigned char zeros[SPARSE_ZERO_BLOCK_SIZE] = {};
+    thread_local LargeBuffer buffer = allocateLargeBuffer();
+    const bool timed = Stats::enabled();
+    off_t offset = 0;
+
+    while (true) {
+        off_t data = lseek(fd, offset, SEEK_DATA);
+        Stats::addSyscalls(1);
+
+        if (data < 0 && errno != ENXIO) {
+            // Holes can't be told apart, what is left is read as usual
+            Stats::addSyscalls(1);
+
+            if (lseek(fd, offset, SEEK_SET) < 0)
+                throwReadError("Cannot read file");
+
+            AdvisedFile file(fd, size, pageCache, (std::uintmax_t) offset);
+            readInto(file, buffer.get(), LARGE_BUFFER_SIZE, consume);
+            return;
+        }
+
+        // Past the last extent, the file is a hole until its end
+        if (data < 0)
+            data = std::max<off_t>(offset, (off_t) size);
+
+        for (off_t hole = offset; hole < data;) {
+            const std::size_t len = (std::size_t) std::min<off_t>(SPARSE_ZERO_BLOCK_SIZE, data - hole);
+            consume(zeros, len);
+            hole += (off_t) len;
+        }
+
+        Stats::addHoles((std::uint64_t) (data - offset));
+        offset = data;
+
+        off_t end = lseek(fd, offset, SEEK_HOLE);
+        Stats::addSyscalls(1);
+
+        // The end of a file is a hole, so this reads until the end once it is reached
+        if (end <= offset)
+            end = std::numeric_limits<off_t>::max();
+
+        const off_t start = offset;
+
+        while (offset < end) {
+            const std::size_t wanted = (std::size_t) std::min<off_t>(LARGE_BUFFER_SIZE, end - offset);
+            const std::uint64_t begin = timed ? Stats::now() : 0;
+            const ssize_t len = pread(fd, buffer.get(), wanted, offset);
+
+            if (timed)
+                Stats::addRead(Stats::now() - begin);
+
+            if (len < 0 && errno == EINTR)
+                continue;
+
+            if (len < 0)
+                throwReadError("Cannot read file");
+
+            if (len == 0)
+                break;
+
+            consume(buffer.get(), (std::size_t) len);
+            offset += len;
+        }
+
+        if (pageCache != PAGE_CACHE_KEEP && offset > start) {
+            posix_fadvise(fd, start, offset - start, POSIX_FADV_DONTNEED);
+            Stats::addSyscalls(1);
+            Stats::addDropped((std::uint64_t) (offset - start));
+        }
+
+        // The end of the file, which may be past the size it had
+        if (offset < end)
+            return;
+    }
+}
+
+void shazam::StreamReader::read(int fd, std::uintmax_t, const BlockConsumer& consume)
+{
+    // A stream has no size to go by: the one fstat gives for a pipe is
+    // what is waiting in it, if anything, so it is read until its end
+    thread_local LargeBuffer buffer = allocateLargeBuffer();
+    const bool pipe = widenPipe(fd);
+    const bool timed = Stats::enabled();
+    std::unique_ptr<TeeOutput> copy = tee >= 0 ? std::make_unique<TeeOutput>(tee, pipe) : nullptr;
+
+    while (true) {
+        std::size_t wanted = LARGE_BUFFER_SIZE;
+
+        // What was duplicated is waiting in the pipe, so it is all read at once
+        if (copy != nullptr && copy->isSplicing()) {
+            const ssize_t duplicated = copy->duplicate(fd, LARGE_BUFFER_SIZE);
+
+            if (duplicated == 0)
+                return;
+
+            if (duplicated > 0)
+                wanted = (std::size_t) duplicated;
+        }
+
+        const bool spliced = copy != nullptr && copy->isSplicing();
+        std::size_t len = 0;
+
+        do {
+            const std::uint64_t start = timed ? Stats::now() : 0;
+            const ssize_t got = readRetrying(fd, buffer.get() + len, wanted - len);
+
+            if (timed)
+                Stats::addRead(Stats::now() - start);
+
+            if (got < 0)
+                throwReadError("Cannot read file");
+
+            if (got == 0)
+                break;
+
+            len += (std::size_t) got;
+        } while (spliced && len < wanted);
+
+        if (len == 0)
+            return;
+
+        if (copy != nullptr && !spliced)
+            copy->write(buffer.get(), len);
+
+        consume(buffer.get(), len);
+    }
+}
+
+shazam::ReaderFactory::ReaderFactory(EIOMode mode, std::size_t buffers, unsigned int queueDepth,
+                                     EPageCacheMode pageCache, int tee)
+: mode(mode), buffers(buffers), queueDepth(queueDepth), pageCache(pageCache), tee(tee)
+{
+    if (buffers > PIPELINE_MAX_BUFFERS)
+        throw std::invalid_argument("Can't use more than " + std::to_string(PIPELINE_MAX_BUFFERS) + " buffers per file.");
+    if (queueDepth > URING_MAX_DEPTH)
+        throw std::invalid_argument("Can't keep more than " + std::to_string(URING_MAX_DEPTH) + " requests in flight.");
+}
+
+std::unique_ptr<shazam::FileReader> shazam::ReaderFactory::create(std::uintmax_t size) const
+{
+    EIOMode chosen = mode;
+
+    if (chosen == IO_AUTO || chosen == IO_URING) {
+        if (size <= AUTO_READ_MAX_SIZE)
+            chosen = IO_READ;
+        else if (size < AUTO_MMAP_MIN_SIZE || pageCache != PAGE_CACHE_KEEP)
+            chosen = IO_BUFFER;
+        else
+            chosen = IO_MMAP;
+    }
+
+    switch (chosen) {
+        case IO_BUFFER:
+            return std::make_unique<BufferedReader>(pageCache);
+        case IO_MMAP:
+            return std::make_unique<MappedReader>(pageCache);
+        case IO_PIPELINE:
+            return std::make_unique<PipelinedReader>(buffers, pageCache);
+        default:
+            return std::make_unique<SyscallReader>(pageCache);
+    }
+}
+
+std::unique_ptr<shazam::FileReader> shazam::ReaderFactory::create(const struct stat& filestat) const
+{
+    if (!S_ISREG(filestat.st_mode) || tee >= 0)
+        return std::make_unique<StreamReader>(tee);
+
+    // The blocks are counted in units of 512 bytes, whatever the file system
+    const std::uintmax_t size = filestat.st_size;
+
+    if (size >= SPARSE_MIN_SIZE && (std::uintmax_t) filestat.st_blocks * 512 < size)
+        return std::make_unique<SparseReader>(pageCache);
+
+    return create((std::uintmax_t) filestat.st_size);
+}
+
+shazam::EIOMode shazam::ReaderFactory::getMode() const
+{
+    return mode;
+}
+
+std::size_t shazam::ReaderFactory::getBuffers() const
+{
+    return buffers;
+}
+
+unsigned int shazam::ReaderFactory::getQueueDepth() const
+{
+    return queueDepth;
+}
+
+shazam::EPageCacheMode shazam::ReaderFactory::getPageCacheMode() const
+{
+    return pageCache;
+}
+
+int shazam::ReaderFactory::getTee() const
+{
+    return tee;
+}
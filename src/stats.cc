@@ -0,0 +1,344 @@
+#include "../include/shazam/stats.hh"
+#include "../include/shazam/basic-types.hh"
+#include "../include/shazam/cache.hh"
+#include "../include/shazam/common.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+bool shazam::Stats::active = false;
+
+namespace {
+    /* The counters of the running threads that updated them, and the sum
+     * of the counters of the threads that are gone. */
+    std::mutex registryMutex;
+    std::vector<shazam::StatsCounters*> registry;
+    shazam::StatsCounters retired;
+
+    /* When the statistics started to be collected. */
+    std::uint64_t startNanos = 0;
+
+    /* Returns the size of the page cache, in bytes, or 0 if unknown. */
+    std::int64_t pageCacheBytes()
+    {
+        std::ifstream meminfo("/proc/meminfo");
+        std::string field;
+        std::int64_t kilobytes;
+
+        while (meminfo >> field >> kilobytes) {
+            if (field == "Cached:")
+                return kilobytes * 1024;
+
+            meminfo.ignore(256, '\n');
+        }
+
+        return 0;
+    }
+
+    /* The size of the page cache when the statistics started to be collected. */
+    std::int64_t startPageCache = 0;
+
+    /* The counters of a thread, registered while it runs. When it ends
+     * they are added to the retired ones, so that the threads made for
+     * each file don't pile up counters. */
+    class ThreadCounters {
+    public:
+        shazam::StatsCounters counters;
+
+        ThreadCounters()
+        {
+            std::memset(&counters, 0, sizeof(counters));
+
+            std::lock_guard<std::mutex> lock(registryMutex);
+            registry.push_back(&counters);
+        }
+
+        ~ThreadCounters()
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            retired.add(counters);
+            registry.erase(std::find(registry.begin(), registry.end(), &counters));
+        }
+
+        ThreadCounters(const ThreadCounters&) = delete;
+        ThreadCounters& operator=(const ThreadCounters&) = delete;
+    };
+
+    /* Returns bytes per nanosecond as MB/s. */
+    double megabytesPerSecond(std::uint64_t bytes, std::uint64_t nanos)
+    {
+        return nanos > 0 ? bytes * 1e3 / nanos : 0;
+    }
+
+    /* Returns the upper bound of a latency bucket, in microseconds. */
+    std::uint64_t bucketLimit(std::size_t bucket)
+    {
+        return (std::uint64_t) 1 << bucket;
+    }
+}
+
+void shazam::StatsCounters::add(const StatsCounters& other)
+{
+    for (std::size_t i = 0; i < STATS_PHASES.size(); i++) {
+        phaseNanos[i] += other.phaseNanos[i];
+        phaseCalls[i] += other.phaseCalls[i];
+    }
+
+    files += other.files;
+    bytes += other.bytes;
+    reads += other.reads;
+    syscalls += other.syscalls;
+    droppedBytes += other.droppedBytes;
+    directBytes += other.directBytes;
+    holeBytes += other.holeBytes;
+
+    for (std::size_t i = 0; i < STATS_LATENCY_BUCKETS; i++)
+        latency[i] += other.latency[i];
+
+    for (std::size_t i = 0; i < HASH_TYPES.size(); i++) {
+        algorithmBytes[i] += other.algorithmBytes[i];
+        algorithmNanos[i] += other.algorithmNanos[i];
+    }
+}
+
+void shazam::Stats::setEnabled(bool value)
+{
+    if (value && !active) {
+        startNanos = now();
+        startPageCache = pageCacheBytes();
+    }
+
+    active = value;
+}
+
+void shazam::Stats::reset()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    for (auto counters : registry)
+        std::memset(counters, 0, sizeof(StatsCounters));
+
+    std::memset(&retired, 0, sizeof(retired));
+    startNanos = now();
+    startPageCache = pageCacheBytes();
+}
+
+shazam::StatsCounters& shazam::Stats::local()
+{
+    thread_local ThreadCounters owner;
+    return owner.counters;
+}
+
+shazam::StatsCounters shazam::Stats::total()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    StatsCounters sum = retired;
+
+    for (auto counters : registry)
+        sum.add(*counters);
+
+    return sum;
+}
+
+std::uint64_t shazam::Stats::now()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (std::uint64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+void shazam::Stats::addPhase(EStatsPhase phase, std::uint64_t nanos)
+{
+    if (!active)
+        return;
+
+    StatsCounters& counters = local();
+    counters.phaseNanos[phase] += nanos;
+    counters.phaseCalls[phase]++;
+}
+
+void shazam::Stats::addSyscalls(std::uint64_t count)
+{
+    if (active)
+        local().syscalls += count;
+}
+
+void shazam::Stats::addRead(std::uint64_t nanos)
+{
+    if (!active)
+        return;
+
+    StatsCounters& counters = local();
+    counters.reads++;
+    counters.syscalls++;
+    counters.phaseNanos[PHASE_READ] += nanos;
+    counters.phaseCalls[PHASE_READ]++;
+}
+
+void shazam::Stats::addDropped(std::uint64_t bytes)
+{
+    if (active)
+        local().droppedBytes += bytes;
+}
+
+void shazam::Stats::addDirect(std::uint64_t bytes)
+{
+    if (active)
+        local().directBytes += bytes;
+}
+
+void shazam::Stats::addHoles(std::uint64_t bytes)
+{
+    if (active)
+        local().holeBytes += bytes;
+}
+
+std::int64_t shazam::Stats::pageCacheGrowth()
+{
+    return pageCacheBytes() - startPageCache;
+}
+
+void shazam::Stats::addHash(std::size_t algorithm, std::uint64_t bytes, std::uint64_t nanos)
+{
+    if (!active)
+        return;
+
+    StatsCounters& counters = local();
+    counters.phaseNanos[PHASE_HASH] += nanos;
+    counters.phaseCalls[PHASE_HASH]++;
+
+    if (algorithm < HASH_TYPES.size()) {
+        counters.algorithmBytes[algorithm] += bytes;
+        counters.algorithmNanos[algorithm] += nanos;
+    }
+}
+
+void shazam::Stats::addFile(std::uint64_t bytes, std::uint64_t nanos)
+{
+    if (!active)
+        return;
+
+    StatsCounters& counters = local();
+    std::size_t bucket = 0;
+
+    while (bucket + 1 < STATS_LATENCY_BUCKETS && nanos >= bucketLimit(bucket) * 1000)
+        bucket++;
+
+    counters.files++;
+    counters.bytes += bytes;
+    counters.latency[bucket]++;
+}
+
+std::size_t shazam::Stats::algorithmIndex(const std::string& hashType)
+{
+    return hashTypeIndex(hashType);
+}
+
+void shazam::Stats::writeText(std::ostream& out, const HashCache* cache)
+{
+    const StatsCounters counters = total();
+    const std::uint64_t elapsed = now() - startNanos;
+
+    out << std::fixed << std::setprecision(3);
+    out << "Elapsed: " << elapsed / 1e9 << " s\n";
+    out << "Files: " << counters.files << " hashed, " << counters.bytes << " bytes ("
+        << megabytesPerSecond(counters.bytes, elapsed) << " MB/s)\n";
+    out << "System calls: " << counters.syscalls << ", of which " << counters.reads << " reads\n";
+    out << "Page cache: grew by " << pageCacheGrowth() << " bytes, " << counters.droppedBytes
+        << " bytes given back after being read, " << counters.directBytes << " bytes read directly\n";
+    out << "Sparse files: " << counters.holeBytes << " bytes of holes skipped\n";
+
+    if (cache != nullptr)
+        out << "Cache: " << cache->getHits() << " hits, " << cache->getMisses() << " misses\n";
+    else
+        out << "Cache: disabled\n";
+
+    out << "Phases (summed over the threads):\n";
+
+    for (std::size_t i = 0; i < STATS_PHASES.size(); i++) {
+        out << "  " << std::left << std::setw(9) << STATS_PHASES[i] << std::right
+            << counters.phaseNanos[i] / 1e9 << " s in " << counters.phaseCalls[i] << " calls\n";
+    }
+
+    out << "Algorithms:\n";
+
+    for (std::size_t i = 0; i < HASH_TYPES.size(); i++) {
+        if (counters.algorithmBytes[i] > 0) {
+            out << "  " << std::left << std::setw(9) << HASH_TYPES[i] << std::right << counters.algorithmBytes[i]
+                << " bytes, " << megabytesPerSecond(counters.algorithmBytes[i], counters.algorithmNanos[i]) << " MB/s\n";
+        }
+    }
+
+    out << "File latency:\n";
+
+    for (std::size_t i = 0; i < STATS_LATENCY_BUCKETS; i++) {
+        if (counters.latency[i] == 0)
+            continue;
+
+        if (i + 1 < STATS_LATENCY_BUCKETS)
+            out << "  < " << std::setw(8) << bucketLimit(i) << " us: " << counters.latency[i] << "\n";
+        else
+            out << "  >= " << std::setw(7) << bucketLimit(i - 1) << " us: " << counters.latency[i] << "\n";
+    }
+
+    out << std::defaultfloat;
+}
+
+void shazam::Stats::writeJson(std::ostream& out, const HashCache* cache)
+{
+    const StatsCounters counters = total();
+    const std::uint64_t elapsed = now() - startNanos;
+
+    out << "{\"elapsed_ns\": " << elapsed
+        << ", \"files\": " << counters.files
+        << ", \"bytes\": " << counters.bytes
+        << ", \"syscalls\": " << counters.syscalls
+        << ", \"reads\": " << counters.reads
+        << ", \"page_cache\": {\"growth_bytes\": " << pageCacheGrowth()
+        << ", \"dropped_bytes\": " << counters.droppedBytes
+        << ", \"direct_bytes\": " << counters.directBytes << "}"
+        << ", \"hole_bytes\": " << counters.holeBytes;
+
+    if (cache != nullptr)
+        out << ", \"cache\": {\"hits\": " << cache->getHits() << ", \"misses\": " << cache->getMisses() << "}";
+    else
+        out << ", \"cache\": null";
+
+    out << ", \"phases\": {";
+
+    for (std::size_t i = 0; i < STATS_PHASES.size(); i++) {
+        out << (i > 0 ? ", " : "") << "\"" << STATS_PHASES[i] << "\": {\"ns\": " << counters.phaseNanos[i]
+            << ", \"calls\": " << counters.phaseCalls[i] << "}";
+    }
+
+    out << "}, \"algorithms\": {";
+
+    for (std::size_t i = 0; i < HASH_TYPES.size(); i++) {
+        out << (i > 0 ? ", " : "") << "\"" << HASH_TYPES[i] << "\": {\"bytes\": " << counters.algorithmBytes[i]
+            << ", \"ns\": " << counters.algorithmNanos[i] << "}";
+    }
+
+    // Upper bounds of the buckets, in microseconds, the last one unbounded
+    out << "}, \"latency_us\": [";
+
+    for (std::size_t i = 0; i < STATS_LATENCY_BUCKETS; i++) {
+        out << (i > 0 ? ", " : "") << "{\"below\": ";
+
+        if (i + 1 < STATS_LATENCY_BUCKETS)
+            out << bucketLimit(i);
+        else
+            out << "null";
+
+        out << ", \"files\": " << counters.latency[i] << "}";
+    }
+
+    out << "]}\n";
+}
@@ -0,0 +1,161 @@
+#include "../include/shazam/tree.hh"
+#include "../include/shazam/engine.hh"
+#include "../include/shazam/stats.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+    constexpr std::size_t NODE_SIZE = shazam::SHA256Engine::DIGEST_SIZE;
+
+    constexpr unsigned char LEAF_PREFIX = 0x00;
+    constexpr unsigned char NODE_PREFIX = 0x01;
+
+    /* Writes the leaf of a chunk into `node`. */
+    void hashLeaf(const unsigned char* chunk, std::size_t len, unsigned char* node)
+    {
+        shazam::SHA256Engine engine;
+        engine.start();
+        engine.update(&LEAF_PREFIX, 1);
+        engine.update(chunk, len);
+        engine.finish(node);
+    }
+
+    /* Reads `len` bytes at `offset`, throwing std::runtime_error if
+     * the file can't be read or ends before them. */
+    void readChunk(int fd, unsigned char* chunk, std::size_t len, std::uintmax_t offset)
+    {
+        std::size_t done = 0;
+
+        while (done < len) {
+            const ssize_t n = pread(fd, chunk + done, len - done, (off_t) (offset + done));
+
+            if (n < 0 && errno == EINTR)
+                continue;
+
+            if (n < 0)
+                throw std::runtime_error(std::string("Cannot read file: ") + std::strerror(errno));
+
+            if (n == 0)
+                throw std::runtime_error("Cannot read file: it is shorter than it was.");
+
+            done += n;
+        }
+    }
+}
+
+shazam::Digest shazam::TreeHasher::hash(int fd, std::uintmax_t size,
+                                        const std::function<void(std::size_t)>& progress) const
+{
+    const std::size_t chunks = std::max<std::uintmax_t>(1, (size + TREE_CHUNK_SIZE - 1) / TREE_CHUNK_SIZE);
+    const std::size_t workers = chunks < TREE_PARALLEL_MIN_CHUNKS ? 1 : std::min<std::size_t>(threads, chunks);
+    std::vector<unsigned char> nodes(chunks * NODE_SIZE);
+
+    // The chunks are taken in order by whichever thread is free, so the
+    // file is still read mostly from its start to its end
+    std::atomic<std::size_t> nextChunk(0);
+    std::atomic<bool> failed(false);
+    std::mutex errorMutex;
+    std::string error;
+
+    // The statistics are added up by each thread and counted once at the end
+    std::atomic<std::uint64_t> readNanos(0);
+    std::atomic<std::uint64_t> hashNanos(0);
+    const bool timed = Stats::enabled();
+
+    auto work = [&]() {
+        std::vector<unsigned char> chunk(std::min<std::uintmax_t>(size, TREE_CHUNK_SIZE));
+        std::uint64_t reading = 0;
+        std::uint64_t hashing = 0;
+
+        try {
+            for (std::size_t i = nextChunk++; i < chunks && !failed; i = nextChunk++) {
+                const std::uintmax_t offset = (std::uintmax_t) i * TREE_CHUNK_SIZE;
+                const std::size_t len = (std::size_t) std::min<std::uintmax_t>(TREE_CHUNK_SIZE, size - offset);
+                const std::uint64_t start = timed ? Stats::now() : 0;
+
+                readChunk(fd, chunk.data(), len, offset);
+                const std::uint64_t read = timed ? Stats::now() : 0;
+
+                hashLeaf(chunk.data(), len, nodes.data() + i * NODE_SIZE);
+
+                if (timed) {
+                    reading += read - start;
+                    hashing += Stats::now() - read;
+                }
+
+                progress(len);
+            }
+        } catch (const std::runtime_error& err) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+
+            if (!failed.exchange(true))
+                error = err.what();
+        }
+
+        readNanos += reading;
+        hashNanos += hashing;
+    };
+
+    std::vector<std::thread> helpers;
+
+    for (std::size_t i = 1; i < workers; i++)
+        helpers.emplace_back(work);
+
+    work();
+
+    for (auto& helper : helpers)
+        helper.join();
+
+    if (failed)
+        throw std::runtime_error(error);
+
+    if (timed) {
+        Stats::addPhase(PHASE_READ, readNanos);
+        Stats::addSyscalls(chunks);
+        Stats::addHash(TREE_HASH_TYPE, size, hashNanos);
+    }
+
+    return root(nodes, chunks);
+}
+
+shazam::Digest shazam::TreeHasher::hash(const unsigned char* data, std::size_t len)
+{
+    const std::size_t chunks = std::max<std::size_t>(1, (len + TREE_CHUNK_SIZE - 1) / TREE_CHUNK_SIZE);
+    std::vector<unsigned char> nodes(chunks * NODE_SIZE);
+
+    for (std::size_t i = 0; i < chunks; i++) {
+        const std::size_t offset = i * TREE_CHUNK_SIZE;
+        hashLeaf(data + offset, std::min(TREE_CHUNK_SIZE, len - offset), nodes.data() + i * NODE_SIZE);
+    }
+
+    return root(nodes, chunks);
+}
+
+shazam::Digest shazam::TreeHasher::root(std::vector<unsigned char>& nodes, std::size_t leaves)
+{
+    // Every level is written over the start of the one below it
+    for (std::size_t count = leaves; count > 1; count = (count + 1) / 2) {
+        for (std::size_t i = 0; i < count / 2; i++) {
+            SHA256Engine engine;
+            engine.start();
+            engine.update(&NODE_PREFIX, 1);
+            engine.update(nodes.data() + 2 * i * NODE_SIZE, 2 * NODE_SIZE);
+            engine.finish(nodes.data() + i * NODE_SIZE);
+        }
+
+        if (count % 2 != 0)
+            std::memmove(nodes.data() + count / 2 * NODE_SIZE, nodes.data() + (count - 1) * NODE_SIZE, NODE_SIZE);
+    }
+
+    return Digest(TREE_HASH_TYPE, nodes.data(), NODE_SIZE);
+}
@@ -0,0 +1,321 @@
+#include "../include/shazam/uring.hh"
+#include "../include/shazam/files.hh"
+#include "../include/shazam/stats.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+namespace {
+    /* The requests made for each file, kept in the low bits of the user data. */
+    enum ERequest {
+        REQUEST_OPEN,
+        REQUEST_STAT,
+        REQUEST_READ,
+        REQUEST_CLOSE
+    };
+
+    constexpr unsigned int REQUEST_BITS = 2;
+
+    std::uint64_t userData(std::size_t file, ERequest request)
+    {
+        return (std::uint64_t) file << REQUEST_BITS | request;
+    }
+
+    /* Copies the attributes of statx into the ones of stat, which are
+     * the ones the cache and the rest of the code know. */
+    void toStat(const struct statx& attributes, struct stat& filestat)
+    {
+        std::memset(&filestat, 0, sizeof(filestat));
+        filestat.st_dev = makedev(attributes.stx_dev_major, attributes.stx_dev_minor);
+        filestat.st_ino = attributes.stx_ino;
+        filestat.st_mode = attributes.stx_mode;
+        filestat.st_nlink = attributes.stx_nlink;
+        filestat.st_uid = attributes.stx_uid;
+        filestat.st_gid = attributes.stx_gid;
+        filestat.st_size = attributes.stx_size;
+        filestat.st_atim = { attributes.stx_atime.tv_sec, attributes.stx_atime.tv_nsec };
+        filestat.st_mtim = { attributes.stx_mtime.tv_sec, attributes.stx_mtime.tv_nsec };
+        filestat.st_ctim = { attributes.stx_ctime.tv_sec, attributes.stx_ctime.tv_nsec };
+    }
+
+    /* Returns a pointer at `offset` bytes of a mapped ring. */
+    template <typename T>
+    T* at(void* ring, std::uint32_t offset)
+    {
+        return (T*) ((char*) ring + offset);
+    }
+}
+
+shazam::UringBatchReader::UringBatchReader(unsigned int depth)
+: ringFd(-1), sqRing(MAP_FAILED), cqRing(MAP_FAILED), sqes((io_uring_sqe*) MAP_FAILED)
+{
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    // Room for the three requests of a file at least
+    ringFd = (int) syscall(__NR_io_uring_setup, std::max(3u, depth), &params);
+
+    if (ringFd < 0)
+        throw std::runtime_error(std::string("Cannot set up io_uring: ") + std::strerror(errno));
+
+    entries = params.sq_entries;
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+    const bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+
+    if (single)
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    cqRing = single ? sqRing
+                    : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                           IORING_OFF_CQ_RING);
+    sqes = (io_uring_sqe*) mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                                IORING_OFF_SQES);
+
+    if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqes == MAP_FAILED) {
+        const std::string error = std::strerror(errno);
+        release();
+        throw std::runtime_error("Cannot map the io_uring queues: " + error);
+    }
+
+    sqTail = at<unsigned int>(sqRing, params.sq_off.tail);
+    sqMask = at<unsigned int>(sqRing, params.sq_off.ring_mask);
+    sqArray = at<unsigned int>(sqRing, params.sq_off.array);
+    cqHead = at<unsigned int>(cqRing, params.cq_off.head);
+    cqTail = at<unsigned int>(cqRing, params.cq_off.tail);
+    cqMask = at<unsigned int>(cqRing, params.cq_off.ring_mask);
+    cqes = at<io_uring_cqe>(cqRing, params.cq_off.cqes);
+}
+
+shazam::UringBatchReader::~UringBatchReader()
+{
+    release();
+}
+
+void shazam::UringBatchReader::release()
+{
+    if (sqes != MAP_FAILED)
+        munmap(sqes, sqesSize);
+    if (cqRing != MAP_FAILED && cqRing != sqRing)
+        munmap(cqRing, cqRingSize);
+    if (sqRing != MAP_FAILED)
+        munmap(sqRing, sqRingSize);
+    if (ringFd >= 0)
+        close(ringFd);
+
+    sqes = (io_uring_sqe*) MAP_FAILED;
+    sqRing = cqRing = MAP_FAILED;
+    ringFd = -1;
+}
+
+bool shazam::UringBatchReader::available()
+{
+    static const bool usable = [] {
+        try {
+            UringBatchReader probe(1);
+            return true;
+        } catch (const std::runtime_error& err) {
+            return false;
+        }
+    }();
+
+    return usable;
+}
+
+shazam::UringBatchReader* shazam::UringBatchReader::local(unsigned int depth)
+{
+    // Each thread has its own ring, so its queues are never shared
+    thread_local std::unique_ptr<UringBatchReader> reader;
+    thread_local bool failed = false;
+
+    if (reader == nullptr && !failed && available()) {
+        try {
+            reader = std::make_unique<UringBatchReader>(depth);
+        } catch (const std::runtime_error& err) {
+            // Out of locked memory, most likely, so this thread reads without it
+            failed = true;
+        }
+    }
+
+    return reader.get();
+}
+
+io_uring_sqe* shazam::UringBatchReader::nextEntry()
+{
+    const unsigned int tail = *sqTail + pending;
+    const unsigned int index = tail & *sqMask;
+    io_uring_sqe* entry = &sqes[index];
+
+    std::memset(entry, 0, sizeof(*entry));
+    sqArray[index] = index;
+    pending++;
+    return entry;
+}
+
+template <typename Function>
+void shazam::UringBatchReader::submitAndWait(Function&& complete)
+{
+    const unsigned int submitted = pending;
+    unsigned int completed = 0;
+
+    __atomic_store_n(sqTail, *sqTail + pending, __ATOMIC_RELEASE);
+    pending = 0;
+
+    unsigned int toSubmit = submitted;
+
+    while (completed < submitted) {
+        const int result = (int) syscall(__NR_io_uring_enter, ringFd, toSubmit, submitted - completed,
+                                         IORING_ENTER_GETEVENTS, nullptr, 0);
+        Stats::addSyscalls(1);
+
+        if (result < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                continue;
+
+            throw std::runtime_error(std::string("Cannot submit to io_uring: ") + std::strerror(errno));
+        }
+
+        toSubmit -= std::min<unsigned int>(toSubmit, result);
+
+        unsigned int head = *cqHead;
+        const unsigned int tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+        for (; head != tail; head++, completed++) {
+            const io_uring_cqe& entry = cqes[head & *cqMask];
+            complete(entry.user_data, entry.res);
+        }
+
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    }
+}
+
+void shazam::UringBatchReader::read(const std::vector<std::shared_ptr<File>>& files, std::uintmax_t maxSize,
+                                    std::vector<std::vector<unsigned char>>& contents,
+                                    std::vector<struct stat>& filestats, std::vector<std::uint8_t>& done)
+{
+    // A stat, a read and a close per file are in flight at once
+    const std::size_t group = std::max<std::size_t>(1, entries / 3);
+    std::vector<int> descriptors(files.size(), -1);
+    std::vector<std::uint8_t> attributesKnown(files.size(), 0);
+    std::vector<struct statx> attributes(group);
+    std::vector<int> lengths(files.size(), -1);
+    std::vector<std::string> paths(files.size());
+
+    for (std::size_t first = 0; first < files.size(); first += group) {
+        const std::size_t last = std::min(files.size(), first + group);
+
+        {
+            const StatsTimer timer(PHASE_OPEN);
+
+            for (std::size_t i = first; i < last; i++) {
+                descriptors[i] = files[i]->takeDescriptor(filestats[i]);
+                attributesKnown[i] = descriptors[i] >= 0;
+
+                if (descriptors[i] >= 0)
+                    continue;
+
+                // The path has to outlive the request
+                paths[i] = files[i]->path();
+
+                io_uring_sqe* entry = nextEntry();
+                entry->opcode = IORING_OP_OPENAT;
+                entry->fd = AT_FDCWD;
+                entry->addr = (std::uint64_t) paths[i].c_str();
+                entry->open_flags = O_RDONLY | O_CLOEXEC;
+                entry->user_data = userData(i, REQUEST_OPEN);
+            }
+
+            if (pending > 0) {
+                submitAndWait([&descriptors](std::uint64_t data, int result) {
+                    descriptors[data >> REQUEST_BITS] = result >= 0 ? result : -1;
+                });
+            }
+        }
+
+        const StatsTimer timer(PHASE_READ);
+
+        for (std::size_t i = first; i < last; i++) {
+            if (descriptors[i] < 0)
+                continue;
+
+            // One more byte than expected, to notice files that grew
+            const std::uintmax_t capacity = (attributesKnown[i] ? filestats[i].st_size : maxSize) + 1;
+            contents[i].resize(capacity);
+
+            // The close is hard linked so that it runs even if the read fails
+            if (!attributesKnown[i]) {
+                io_uring_sqe* stat = nextEntry();
+                stat->opcode = IORING_OP_STATX;
+                stat->fd = descriptors[i];
+                stat->addr = (std::uint64_t) "";
+                stat->statx_flags = AT_EMPTY_PATH;
+                stat->len = STATX_BASIC_STATS;
+                stat->off = (std::uint64_t) &attributes[i - first];
+                stat->flags = IOSQE_IO_HARDLINK;
+                stat->user_data = userData(i, REQUEST_STAT);
+            }
+
+            io_uring_sqe* read = nextEntry();
+            read->opcode = IORING_OP_READ;
+            read->fd = descriptors[i];
+            read->addr = (std::uint64_t) contents[i].data();
+            read->len = (std::uint32_t) capacity;
+            read->off = 0;
+            read->flags = IOSQE_IO_HARDLINK;
+            read->user_data = userData(i, REQUEST_READ);
+
+            io_uring_sqe* close = nextEntry();
+            close->opcode = IORING_OP_CLOSE;
+            close->fd = descriptors[i];
+            close->user_data = userData(i, REQUEST_CLOSE);
+        }
+
+        if (pending == 0)
+            continue;
+
+        submitAndWait([&](std::uint64_t data, int result) {
+            const std::size_t i = data >> REQUEST_BITS;
+
+            switch ((ERequest) (data & ((1 << REQUEST_BITS) - 1))) {
+                case REQUEST_STAT:
+                    if (result == 0) {
+                        toStat(attributes[i - first], filestats[i]);
+                        attributesKnown[i] = 1;
+                    }
+                    break;
+                case REQUEST_READ:
+                    lengths[i] = result;
+                    break;
+                default:
+                    break;
+            }
+        });
+
+        for (std::size_t i = first; i < last; i++) {
+            if (descriptors[i] < 0)
+                continue;
+
+            // A read that didn't get the whole file is redone the usual way
+            if (attributesKnown[i] && lengths[i] >= 0 && (std::uintmax_t) lengths[i] < contents[i].size()
+                    && lengths[i] == filestats[i].st_size) {
+                contents[i].resize(lengths[i]);
+                done[i] = 1;
+            }
+        }
+    }
+}
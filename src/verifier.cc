@@ -0,0 +1,134 @@
+#include "../include/shazam/verifier.hh"
+#include "../include/shazam/basic-types.hh"
+#include "../include/shazam/files.hh"
+#include "../include/shazam/hash.hh"
+#include "../include/shazam/manifest.hh"
+#include "../include/shazam/pool.hh"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+bool shazam::VerificationSummary::ok() const
+{
+    return mismatched == 0 && unreadable == 0 && (malformed == 0 || matched > 0);
+}
+
+shazam::VerificationSummary shazam::Verifier::verify(std::istream& manifest, std::string hashType)
+{
+    ManifestReader reader(manifest, hashType);
+    ManifestEntry entry;
+    std::vector<ManifestEntry> entries;
+
+    failed = false;
+    matched = mismatched = unreadable = 0;
+
+    if (jobs <= 1) {
+        while (!(failFast && failed) && reader.next(entry))
+            verifyEntry(entry);
+    } else {
+        const std::size_t maxQueuedTasks = (std::size_t) jobs * VERIFY_TASKS_PER_THREAD;
+        WorkStealingPool pool(jobs);
+
+        const auto submit = [&]() {
+            {
+                // Don't read the manifest faster than it can be verified
+                std::unique_lock<std::mutex> lock(slotsMutex);
+                slotFreed.wait(lock, [&] { return queuedTasks < maxQueuedTasks; });
+                queuedTasks++;
+            }
+
+            pool.submit([this, group = std::move(entries)]() {
+                verifyEntries(group);
+
+                std::lock_guard<std::mutex> lock(slotsMutex);
+                queuedTasks--;
+                slotFreed.notify_one();
+            });
+
+            entries.clear();
+        };
+
+        while (!(failFast && failed) && reader.next(entry)) {
+            entries.push_back(std::move(entry));
+
+            if (entries.size() == VERIFY_ENTRIES_PER_TASK)
+                submit();
+        }
+
+        if (!entries.empty())
+            submit();
+
+        pool.wait();
+    }
+
+    return VerificationSummary {
+        .matched = matched,
+        .mismatched = mismatched,
+        .unreadable = unreadable,
+        .malformed = reader.getMalformedLines()
+    };
+}
+
+void shazam::Verifier::setJobs(unsigned int value)
+{
+    jobs = std::max(1u, value);
+}
+
+void shazam::Verifier::setFailFast(bool value)
+{
+    failFast = value;
+}
+
+void shazam::Verifier::setIOMode(EIOMode mode, std::size_t buffers, unsigned int queueDepth,
+                                EPageCacheMode pageCache)
+{
+    hashFactory.setIOMode(mode, buffers, queueDepth, pageCache);
+}
+
+void shazam::Verifier::verifyEntries(const std::vector<ManifestEntry>& entries)
+{
+    for (auto& entry : entries) {
+        if (failFast && failed)
+            return;
+
+        verifyEntry(entry);
+    }
+}
+
+bool shazam::Verifier::verifyEntry(const ManifestEntry& entry)
+{
+    // The file is opened by the calculator, which reports the files
+    // that can't be read, so it doesn't need to be validated first
+    const auto file = std::make_shared<File>(entry.filename, VALID_FILE);
+    const auto hash = hashFactory.hashFile(entry.hashType, file);
+
+    try {
+        hash->calculate();
+    } catch (const std::runtime_error& err) {
+        unreadable++;
+        failed = true;
+        report(entry.filename, "FAILED open or read");
+        return false;
+    }
+
+    // Compared as bytes, without building the hash sums of the file
+    if (hash->digest(0) != entry.hashSum) {
+        mismatched++;
+        failed = true;
+        report(entry.filename, "FAILED");
+        return false;
+    }
+
+    matched++;
+    return true;
+}
+
+void shazam::Verifier::report(const std::string& filename, const std::string& message)
+{
+    std::lock_guard<std::mutex> lock(outputMutex);
+    output << filename << ": " << message << std::endl;
+}
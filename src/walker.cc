@@ -0,0 +1,241 @@
+#include "../include/shazam/walker.hh"
+#include "../include/shazam/basic-types.hh"
+#include "../include/shazam/common.hh"
+#include "../include/shazam/files.hh"
+#include "../include/shazam/pool.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* The record returned by getdents64, which glibc doesn't declare. */
+struct linux_dirent64 {
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+/* Size of the buffer used to list the directories. */
+constexpr std::size_t DIRENTS_BUFFER_SIZE = 32 * 1024;
+
+/* A directory being walked and the chain of the ones above it, which
+ * outlives their descriptors. */
+struct Ancestor {
+    const dev_t device;
+    const ino_t inode;
+    const std::shared_ptr<const Ancestor> parent;
+
+    Ancestor(dev_t device, ino_t inode, std::shared_ptr<const Ancestor> parent)
+    : device(device), inode(inode), parent(parent) {  }
+
+    /* Returns true if the directory is this one or one of its ancestors. */
+    bool contains(dev_t device, ino_t inode) const
+    {
+        for (const Ancestor* ancestor = this; ancestor != nullptr; ancestor = ancestor->parent.get()) {
+            if (ancestor->device == device && ancestor->inode == inode)
+                return true;
+        }
+
+        return false;
+    }
+};
+
+struct shazam::TreeWalker::Directory {
+    const int fd;
+    const std::string path;
+    const std::string relativePath;
+    const dev_t rootDevice;
+    const std::shared_ptr<const Ancestor> ancestors;
+
+    Directory(int fd, std::string path, std::string relativePath, dev_t rootDevice, std::shared_ptr<const Ancestor> ancestors)
+    : fd(fd), path(path), relativePath(relativePath), rootDevice(rootDevice), ancestors(ancestors) {  }
+
+    ~Directory() { close(fd); }
+};
+
+/* Joins a directory path and the name of one of its entries. */
+static std::string joinPath(const std::string& directory, const std::string& name)
+{
+    if (directory.empty())
+        return name;
+    if (directory.back() == '/')
+        return directory + name;
+    return directory + "/" + name;
+}
+
+shazam::ESymlinkPolicy shazam::symlinkPolicyFromName(std::string name)
+{
+    name = toLowerCase(name);
+
+    for (std::size_t i = 0; i < SYMLINK_POLICIES.size(); i++) {
+        if (name == SYMLINK_POLICIES[i])
+            return (ESymlinkPolicy) i;
+    }
+
+    throw std::invalid_argument("Unknown symlink policy \"" + name + "\", expected never, roots or always.");
+}
+
+void shazam::TreeWalker::walk(const std::string& root)
+{
+    const bool follow = options.symlinks != SYMLINKS_NEVER;
+    struct stat filestat;
+
+    // The walk itself counts until its root is handled, so that it isn't
+    // done before it starts
+    pendingDirectories++;
+
+    if ((follow ? stat(root.c_str(), &filestat) : lstat(root.c_str(), &filestat)) != 0)
+        visit(root, fileStatusFromErrno(errno));
+    else if (S_ISREG(filestat.st_mode))
+        visit(root, VALID_FILE);
+    else if (S_ISDIR(filestat.st_mode))
+        submitDirectory(nullptr, root, follow);
+
+    directoryDone();
+}
+
+bool shazam::TreeWalker::included(const std::string& name, const std::string& relativePath) const
+{
+    if (options.include.empty())
+        return true;
+
+    for (auto& glob : options.include) {
+        if (fnmatch(glob.c_str(), name.c_str(), 0) == 0 || fnmatch(glob.c_str(), relativePath.c_str(), FNM_PATHNAME) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+bool shazam::TreeWalker::excluded(const std::string& name, const std::string& relativePath) const
+{
+    for (auto& glob : options.exclude) {
+        if (fnmatch(glob.c_str(), name.c_str(), 0) == 0 || fnmatch(glob.c_str(), relativePath.c_str(), FNM_PATHNAME) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+void shazam::TreeWalker::submitDirectory(std::shared_ptr<Directory> parent, std::string name, bool follow)
+{
+    pendingDirectories++;
+
+    pool.submit([this, parent = std::move(parent), name = std::move(name), follow]() mutable {
+        listDirectory(std::move(parent), name, follow);
+        directoryDone();
+    });
+}
+
+void shazam::TreeWalker::directoryDone()
+{
+    if (--pendingDirectories == 0 && done)
+        done();
+}
+
+void shazam::TreeWalker::listDirectory(std::shared_ptr<Directory> parent, const std::string& name, bool follow)
+{
+    const std::string path = parent != nullptr ? joinPath(parent->path, name) : name;
+    const std::string relativePath = parent != nullptr ? joinPath(parent->relativePath, name) : "";
+    const int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC | (follow ? 0 : O_NOFOLLOW);
+
+    // Opening relative to the parent saves resolving the whole path again
+    int fd = parent != nullptr ? openat(parent->fd, name.c_str(), flags) : open(path.c_str(), flags);
+
+    if (fd < 0 && (errno == EMFILE || errno == ENFILE)) {
+        // The queued directories keep their parents open, if there are
+        // too many of them fall back to the full path
+        fd = open(path.c_str(), flags);
+    }
+
+    if (fd < 0) {
+        visit(path, fileStatusFromErrno(errno));
+        return;
+    }
+
+    struct stat filestat;
+
+    if (fstat(fd, &filestat) != 0) {
+        close(fd);
+        visit(path, NON_READABLE);
+        return;
+    }
+
+    const dev_t rootDevice = parent != nullptr ? parent->rootDevice : filestat.st_dev;
+    std::shared_ptr<const Ancestor> ancestors = parent != nullptr ? parent->ancestors : nullptr;
+    parent.reset();
+
+    // Only the chain of ancestors is checked, not every directory seen, so
+    // that the directories reached through several links are all listed
+    if ((options.oneFileSystem && filestat.st_dev != rootDevice)
+        || (ancestors != nullptr && ancestors->contains(filestat.st_dev, filestat.st_ino))) {
+        close(fd);
+        return;
+    }
+
+    ancestors = std::make_shared<const Ancestor>(filestat.st_dev, filestat.st_ino, std::move(ancestors));
+    const auto directory = std::make_shared<Directory>(fd, path, relativePath, rootDevice, std::move(ancestors));
+    alignas(linux_dirent64) char buffer[DIRENTS_BUFFER_SIZE];
+
+    while (true) {
+        const long read = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+
+        if (read < 0 && errno == EINTR)
+            continue;
+
+        if (read < 0) {
+            visit(path, NON_READABLE);
+            break;
+        }
+
+        if (read == 0)
+            break;
+
+        for (long offset = 0; offset < read; ) {
+            const auto* entry = (const linux_dirent64*) (buffer + offset);
+            offset += entry->d_reclen;
+
+            if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0)
+                visitEntry(directory, entry->d_name, entry->d_type);
+        }
+    }
+}
+
+void shazam::TreeWalker::visitEntry(const std::shared_ptr<Directory>& directory, const char* name, unsigned char type)
+{
+    const std::string relativePath = joinPath(directory->relativePath, name);
+
+    if (excluded(name, relativePath))
+        return;
+
+    const bool follow = options.symlinks == SYMLINKS_ALWAYS;
+
+    // Some file systems don't fill the type, and links are resolved here
+    if (type == DT_UNKNOWN || (type == DT_LNK && follow)) {
+        struct stat filestat;
+
+        if (fstatat(directory->fd, name, &filestat, follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0) {
+            visit(joinPath(directory->path, name), fileStatusFromErrno(errno));
+            return;
+        }
+
+        type = IFTODT(filestat.st_mode);
+    }
+
+    if (type == DT_DIR)
+        submitDirectory(directory, name, follow);
+    else if (type == DT_REG && included(name, relativePath))
+        visit(joinPath(directory->path, name), VALID_FILE);
+}
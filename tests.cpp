@@ -1,13 +1,47 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
 
 #include "./include/external/tinytest/tinytest.h"
+#include "./include/external/hashlib2plus/hl_blake3.h"
+#include "./include/external/hashlib2plus/hl_multibuffer.h"
+#include "./include/external/hashlib2plus/hl_sha1.h"
+#include "./include/external/hashlib2plus/hl_sha256.h"
 
+#include "./include/shazam/batch.hh"
+#include "./include/shazam/cache.hh"
 #include "./include/shazam/common.hh"
+#include "./include/shazam/device.hh"
+#include "./include/shazam/engine.hh"
 #include "./include/shazam/files.hh"
 #include "./include/shazam/hash.hh"
 #include "./include/shazam/checker.hh"
+#include "./include/shazam/pool.hh"
+#include "./include/shazam/manifest.hh"
+#include "./include/shazam/output.hh"
+#include "./include/shazam/reader.hh"
+#include "./include/shazam/stats.hh"
+#include "./include/shazam/tree.hh"
+#include "./include/shazam/uring.hh"
+#include "./include/shazam/verifier.hh"
+#include "./include/shazam/walker.hh"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 
 #define VALID_FILE_S_PATH       ".testfile.donotchange.txt"
@@ -18,6 +52,11 @@
 #define VALID_FILE_S_SHA512SUM  "eeabc1e01e9572a3cba059289486caedd372ef8bfc357c6e3b90290896c3f7eb3e940a3d5d88349533133d5c4f89482d3a9648d55228beef0c45b269f814faa9"
 
 
+/* Returns the digest of the given hash type written in hexadecimal. */
+shazam::Digest digestOf(const std::string& type, const std::string& hex) {
+    return shazam::Digest::fromHex(shazam::hashTypeIndex(type), hex);
+}
+
 
 // -------------- Testing File Factory -------------------------------------------------
 
@@ -61,6 +100,37 @@ void test_file_factory_on_non_permissive_files(void) {
 }
 
 
+void test_file_factory_keeps_the_file_open(void) {
+    shazam::FileFactory ffactory;
+    shazam::HashFactory hfactory;
+
+    std::filesystem::copy_file(VALID_FILE_S_PATH, ".filefortest.shazam.tmp");
+    const auto file = ffactory.create(".filefortest.shazam.tmp");
+    std::remove(".filefortest.shazam.tmp");
+
+    // Only the descriptor opened by the validation can still read it
+    ASSERT("Validated files are hashed through the same descriptor",
+        hfactory.hashFile("SHA1", file)->get().hashSum.toHex() == VALID_FILE_S_SHA1SUM);
+}
+
+void test_file_table_keeps_the_files(void) {
+    shazam::FileFactory ffactory;
+    shazam::HashFactory hfactory;
+    shazam::FileTable table;
+
+    std::filesystem::copy_file(VALID_FILE_S_PATH, ".filefortest.shazam.tmp");
+    const auto file = ffactory.create(".filefortest.shazam.tmp");
+    const std::size_t row = table.add(*file);
+    std::remove(".filefortest.shazam.tmp");
+
+    ASSERT("The table keeps the path", table.path(row) == ".filefortest.shazam.tmp");
+    ASSERT("The table keeps the size", table.fileSize(row) == std::filesystem::file_size(VALID_FILE_S_PATH));
+
+    // The descriptor taken over by the table can still read it
+    ASSERT("Files of the table are hashed through the kept descriptor",
+        hfactory.hashFile("SHA1", table.file(row))->get().hashSum.toHex() == VALID_FILE_S_SHA1SUM);
+}
+
 // -------------- END Testing File Factory ---------------------------------------------
 
 
@@ -72,17 +142,34 @@ void test_md5sum() {
     shazam::FileFactory ffactory;
 
     const auto hash = hfactory.hashFile("MD5", ffactory.create(VALID_FILE_S_PATH));
-    const std::string CALCULATED = hash->get().hashSum;
+    const std::string CALCULATED = hash->get().hashSum.toHex();
 
     ASSERT("Testing MD5 hash sum", VALID_FILE_S_MD5SUM == CALCULATED);
 }
 
+void test_md5sum_past_512_mib() {
+    // Past 2^29 bytes the count of bits no longer fits in 32 bits. The
+    // file is all holes, so that it takes no room on the disk
+    const std::string ZEROS_PATH = ".testzeros.sparse";
+    const std::string ZEROS_MD5SUM = "f3a8799d64129a6fd8a5aa56f199ac54"; // md5sum of 513 MiB of zeros
+    const int fd = open(ZEROS_PATH.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    ASSERT_EQUALS(ftruncate(fd, (off_t) 513 * 1024 * 1024), 0);
+    close(fd);
+
+    shazam::HashFactory hfactory;
+    shazam::FileFactory ffactory;
+    const std::string CALCULATED = hfactory.hashFile("MD5", ffactory.create(ZEROS_PATH))->get().hashSum.toHex();
+    std::remove(ZEROS_PATH.c_str());
+
+    ASSERT("The MD5 of more than 512 MiB counts every bit", ZEROS_MD5SUM == CALCULATED);
+}
+
 void test_sha1sum() {
     shazam::HashFactory hfactory;
     shazam::FileFactory ffactory;
 
     const auto hash = hfactory.hashFile("SHA1", ffactory.create(VALID_FILE_S_PATH));
-    const std::string CALCULATED = hash->get().hashSum;
+    const std::string CALCULATED = hash->get().hashSum.toHex();
 
     ASSERT("Testing SHA1 hash sum", VALID_FILE_S_SHA1SUM == CALCULATED);
 }
@@ -92,7 +179,7 @@ void test_sha256sum() {
     shazam::FileFactory ffactory;
 
     const auto hash = hfactory.hashFile("SHA256", ffactory.create(VALID_FILE_S_PATH));
-    const std::string CALCULATED = hash->get().hashSum;
+    const std::string CALCULATED = hash->get().hashSum.toHex();
 
     ASSERT("Testing SHA256 hash sum", VALID_FILE_S_SHA256SUM == CALCULATED);
 }
@@ -102,7 +189,7 @@ void test_sha384sum() {
     shazam::FileFactory ffactory;
 
     const auto hash = hfactory.hashFile("SHA384", ffactory.create(VALID_FILE_S_PATH));
-    const std::string CALCULATED = hash->get().hashSum;
+    const std::string CALCULATED = hash->get().hashSum.toHex();
 
     ASSERT("Testing SHA384 hash sum", VALID_FILE_S_SHA384SUM == CALCULATED);
 }
@@ -112,13 +199,568 @@ void test_sha512sum() {
     shazam::FileFactory ffactory;
 
     const auto hash = hfactory.hashFile("SHA512", ffactory.create(VALID_FILE_S_PATH));
-    const std::string CALCULATED = hash->get().hashSum;
+    const std::string CALCULATED = hash->get().hashSum.toHex();
 
     ASSERT("Testing SHA512 hash sum", VALID_FILE_S_SHA512SUM == CALCULATED);
 }
 
+void test_multiple_hash_sums_in_one_pass() {
+    shazam::HashFactory hfactory;
+    shazam::FileFactory ffactory;
+
+    const auto hash = hfactory.hashFile({"MD5", "SHA256", "SHA512"}, ffactory.create(VALID_FILE_S_PATH));
+    const auto sums = hash->getAll();
+
+    ASSERT_EQUALS(sums.size(), 3);
+    ASSERT("Testing MD5 in a multiple hash pass", sums[0].hashSum.toHex() == VALID_FILE_S_MD5SUM);
+    ASSERT("Testing SHA256 in a multiple hash pass", sums[1].hashSum.toHex() == VALID_FILE_S_SHA256SUM);
+    ASSERT("Testing SHA512 in a multiple hash pass", sums[2].hashSum.toHex() == VALID_FILE_S_SHA512SUM);
+    ASSERT("Testing the hash type of a multiple hash pass", sums[1].hashType == "SHA256");
+}
+
+void test_engines_match_the_wrappers() {
+    const std::string message = "The quick brown fox jumps over the lazy dog";
+
+    for (std::size_t type = 0; type < shazam::STREAM_HASH_TYPES; type++) {
+        std::unique_ptr<hashwrapper> wrapper(wrapperfactory().create(shazam::HASH_TYPES[type]));
+
+        // Fed one byte at a time, so that the blocks are put together by the engine
+        const auto digest = shazam::withEngine(type, [&message](auto& engine) {
+            unsigned char bytes[shazam::Digest::MAX_SIZE];
+            engine.start();
+
+            for (auto c : message)
+                engine.update((const unsigned char*) &c, 1);
+
+            return shazam::Digest(engine.TYPE, bytes, engine.finish(bytes));
+        });
+
+        ASSERT("Every engine calculates the hash sum of its wrapper",
+            digest.toHex() == wrapper->getHashFromString(message) && digest.type() == type);
+    }
+}
+
+/* Hashes the first len bytes of 0, 1, ..., 250, 0, 1, ... in pieces of irregular sizes. */
+std::string hash_counting_bytes(std::size_t type, std::size_t len) {
+    std::vector<unsigned char> content(len);
+
+    for (std::size_t i = 0; i < len; i++)
+        content[i] = (unsigned char) (i % 251);
+
+    return shazam::withEngine(type, [&content](auto& engine) {
+        unsigned char bytes[shazam::Digest::MAX_SIZE];
+        std::size_t offset = 0, piece = 1;
+        engine.start();
+
+        while (offset < content.size()) {
+            piece = std::min(piece * 3 + 1, content.size() - offset);
+            engine.update(content.data() + offset, piece);
+            offset += piece;
+        }
+
+        return shazam::Digest(engine.TYPE, bytes, engine.finish(bytes)).toHex();
+    });
+}
+
+void test_modern_hash_vectors() {
+    const std::size_t BLAKE2B = shazam::hashTypeIndex("BLAKE2B"), BLAKE3 = shazam::hashTypeIndex("BLAKE3");
+    const std::size_t XXH3 = shazam::hashTypeIndex("XXH3"), XXH128 = shazam::hashTypeIndex("XXH128");
+
+    std::unique_ptr<hashwrapper> blake2b(wrapperfactory().create("BLAKE2B"));
+    ASSERT("Testing BLAKE2b of abc", blake2b->getHashFromString("abc") ==
+        "ba80a53f981c4d0d6a2797b69f12f6e94c212f14685ac4b74b12bb6fdbffa2d1"
+        "7d87c5392aab792dc252d5de4533cc9518d38aa8dbf1925ab92386edd4009923");
+    ASSERT("Testing BLAKE2b of many blocks", hash_counting_bytes(BLAKE2B, 102400) ==
+        "cbd9d7d77a4d66c0a2ddea931b1e7d91271005545f56f444decea823f7adc9bb"
+        "0791bead840bdd341f04bc1baf1847248aa536baeafa40bda3a06229ae62ffd5");
+
+    // The inputs of the official BLAKE3 test vectors, around the chunks of 1024 bytes
+    const std::pair<std::size_t, const char*> blake3[] = {
+        {0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"},
+        {1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213"},
+        {1023, "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11"},
+        {1024, "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7"},
+        {1025, "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444"},
+        {2049, "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030"},
+        {8193, "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b"},
+        {102400, "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085"},
+    };
+
+    for (const auto& vector : blake3)
+        ASSERT("Testing BLAKE3", hash_counting_bytes(BLAKE3, vector.first) == vector.second);
+
+    // Every length range of XXH3 takes a different path
+    const std::tuple<std::size_t, const char*, const char*> xxh3[] = {
+        {0, "2d06800538d394c2", "99aa06d3014798d86001c324468d497f"},
+        {3, "5f4299fc161c9cbb", "e3b55f57945a17cf5f4299fc161c9cbb"},
+        {8, "3a1c2d7c85af88f8", "e1e4432a62217fe4cfd50c61c8bb98c1"},
+        {16, "8355e3a6f61770db", "72950631827607e2842812cc870dcae2"},
+        {128, "85c6174c7ff4c46b", "14792fc3af88dc6c05321a0b64d67b41"},
+        {240, "375a384d957fe865", "65b5be86da5540e7c92b68e16f83bbb6"},
+        {241, "02e8cd95421c6d02", "1da1cb61bcb8a2a102e8cd95421c6d02"},
+        {1025, "e95c42288f28186e", "2882ebca04ec915ce95c42288f28186e"},
+        {102400, "1428e17f1cac2837", "ecd387d36185351b1428e17f1cac2837"},
+    };
+
+    for (const auto& vector : xxh3) {
+        ASSERT("Testing XXH3", hash_counting_bytes(XXH3, std::get<0>(vector)) == std::get<1>(vector));
+        ASSERT("Testing XXH128", hash_counting_bytes(XXH128, std::get<0>(vector)) == std::get<2>(vector));
+    }
+}
+
+void test_blake3_kernels() {
+    const std::string initial = BLAKE3::BLAKE3_Kernel();
+    const std::size_t BLAKE3_TYPE = shazam::hashTypeIndex("BLAKE3"), LENGTH = 3 * 1024 * 1024 + 5;
+    const std::string EXPECTED = "a7bb55bed0c04f58879d1fc1cafb27e14e931f4411fe63baf5b2d5a60357bffb";
+
+    for (const char* kernel : {"avx512", "avx2", "vector", "portable"}) {
+        if (!BLAKE3::BLAKE3_Use_Kernel(kernel))
+            continue;
+
+        for (unsigned int threads : {1, 4}) {
+            BLAKE3::BLAKE3_Set_Threads(threads);
+            ASSERT("Every BLAKE3 kernel calculates the same hash sums with any threads",
+                hash_counting_bytes(BLAKE3_TYPE, LENGTH) == EXPECTED);
+        }
+    }
+
+    ASSERT("Unknown kernels are rejected", !BLAKE3::BLAKE3_Use_Kernel("abacus"));
+    BLAKE3::BLAKE3_Use_Kernel(initial.c_str());
+    BLAKE3::BLAKE3_Set_Threads(1);
+}
+
+#define TREE_FILE_PATH ".treehashfortest.shazam.tmp"
+
+void test_tree_hash() {
+    // SHA256 of the single byte 0x00, the leaf of the empty chunk
+    ASSERT("The tree hash of nothing is its only leaf", shazam::TreeHasher::hash(nullptr, 0).toHex() ==
+        "6e340b9cffb37a989ca544e6bb780a2c78901d3fb33738768511a30617afa01d");
+
+    // Enough chunks to be hashed in parallel, the last one shorter
+    std::vector<unsigned char> content(10 * shazam::TREE_CHUNK_SIZE + 12345);
+
+    for (std::size_t i = 0; i < content.size(); i++)
+        content[i] = (unsigned char) (i * 31 + i / 977);
+
+    std::ofstream(TREE_FILE_PATH, std::ios::binary).write((const char*) content.data(), content.size());
+
+    const shazam::Digest expected = shazam::TreeHasher::hash(content.data(), content.size());
+    const int fd = open(TREE_FILE_PATH, O_RDONLY);
+    std::atomic<std::size_t> progress(0);
+
+    for (unsigned int threads : {1, 3, 8}) {
+        progress = 0;
+        ASSERT("The tree hash doesn't depend on the threads",
+            shazam::TreeHasher(threads).hash(fd, content.size(), [&](std::size_t len) { progress += len; }) == expected);
+        ASSERT_EQUALS(progress.load(), content.size());
+    }
+
+    close(fd);
+
+    shazam::HashFactory hfactory;
+    shazam::FileFactory ffactory;
+    const auto sums = hfactory.hashFile(std::vector<std::string>{"SHA256", "SHA256-TREE"},
+                                        ffactory.create(TREE_FILE_PATH))->getAll();
+
+    ASSERT("The tree hash is calculated with the other types", sums[1].hashSum == expected);
+    ASSERT("The tree hash is never the SHA256 of the file", sums[0].hashSum.toHex() != sums[1].hashSum.toHex());
+
+    std::istringstream manifest(
+        "# SHA256-TREE 1048576\n" + expected.toHex() + " " TREE_FILE_PATH "\n"
+        "# SHA256-TREE 65536\n" + expected.toHex() + " " TREE_FILE_PATH "\n"
+    );
+
+    shazam::ManifestReader reader(manifest);
+    shazam::ManifestEntry entry;
+
+    ASSERT("The tree sums are read under their header", reader.next(entry) && entry.hashSum == expected);
+    ASSERT("The tree sums of other chunk sizes aren't verified", !reader.next(entry));
+    ASSERT_EQUALS(reader.getMalformedLines(), 1);
+
+    std::remove(TREE_FILE_PATH);
+}
+
+/* Hashes messages of many lengths, crossing the block boundaries, with the given wrapper. */
+std::string hash_many_lengths(const std::string& type) {
+    std::unique_ptr<hashwrapper> wrapper(wrapperfactory().create(type));
+    std::string message, hashes;
+
+    for (int len = 0; len < 1200; len += 7) {
+        while ((int) message.size() < len)
+            message.push_back((char) (message.size() * 131));
+        hashes += wrapper->getHashFromString(message);
+    }
+
+    return hashes;
+}
+
+void test_sha1_kernels() {
+    const std::string initial = SHA1::SHA1Kernel();
+
+    SHA1::SHA1UseKernel("portable");
+    const std::string EXPECTED = hash_many_lengths("SHA1");
+
+    for (const char* kernel : {"sha-ni", "portable"}) {
+        if (SHA1::SHA1UseKernel(kernel))
+            ASSERT("Every SHA1 kernel calculates the same hash sums", hash_many_lengths("SHA1") == EXPECTED);
+    }
+
+    ASSERT("Unknown kernels are rejected", !SHA1::SHA1UseKernel("abacus"));
+    SHA1::SHA1UseKernel(initial.c_str());
+    test_sha1sum();
+}
+
+void test_sha256_kernels() {
+    const std::string initial = SHA256::SHA256_Kernel();
+
+    SHA256::SHA256_Use_Kernel("portable");
+    const std::string EXPECTED = hash_many_lengths("SHA256");
+
+    for (const char* kernel : {"sha-ni", "portable"}) {
+        if (SHA256::SHA256_Use_Kernel(kernel))
+            ASSERT("Every SHA256 kernel calculates the same hash sums", hash_many_lengths("SHA256") == EXPECTED);
+    }
+
+    ASSERT("Unknown kernels are rejected", !SHA256::SHA256_Use_Kernel("abacus"));
+    SHA256::SHA256_Use_Kernel(initial.c_str());
+    test_sha256sum();
+}
+
+void test_multibuffer_kernels() {
+    const std::string initial = multibuffer::kernel();
+    std::vector<std::string> messages;
+    std::string message;
+
+    for (int len = 0; len < 1200; len += 7) {
+        while ((int) message.size() < len)
+            message.push_back((char) (message.size() * 131));
+        messages.push_back(message);
+    }
+
+    std::vector<const hl_uint8*> data;
+    std::vector<size_t> lengths;
+
+    for (auto& msg : messages) {
+        data.push_back((const hl_uint8*) msg.data());
+        lengths.push_back(msg.size());
+    }
+
+    for (const char* kernel : {"avx512", "avx2", "vector"}) {
+        if (!multibuffer::useKernel(kernel))
+            continue;
+
+        for (auto type : {HL_MD5, HL_SHA1, HL_SHA256}) {
+            std::vector<std::string> hashes(messages.size());
+            std::string joined;
+
+            multibuffer::hash(type, data.data(), lengths.data(), messages.size(), hashes.data());
+
+            for (auto& hash : hashes)
+                joined += hash;
+
+            ASSERT("Every multi-buffer kernel calculates the same hash sums",
+                joined == hash_many_lengths(shazam::HASH_TYPES[type]));
+        }
+    }
+
+    ASSERT("Unknown kernels are rejected", !multibuffer::useKernel("abacus"));
+    multibuffer::useKernel(initial.c_str());
+}
+
 // -------------- END Hash Sums --------------------------------------------------------
 
+// -------------- Testing Readers ------------------------------------------------------
+
+#define BIG_FILE_PATH ".bigfilefortest.shazam.tmp"
+
+/* Writes a file bigger than the large buffer, with a size that isn't a multiple of any block. */
+void write_big_test_file() {
+    std::ofstream out(BIG_FILE_PATH, std::ios::binary);
+
+    for (std::size_t i = 0; i < shazam::LARGE_BUFFER_SIZE + 4097; i++)
+        out.put((char) (i * 31 + i / 977));
+}
+
+void test_io_modes_match_the_file_hash() {
+    write_big_test_file();
+
+    shazam::FileFactory ffactory;
+    const auto file = ffactory.create(BIG_FILE_PATH);
+    const std::string EXPECTED = std::unique_ptr<hashwrapper>(wrapperfactory().create("SHA1"))->getHashFromFile(BIG_FILE_PATH);
+
+    for (auto mode : {shazam::IO_AUTO, shazam::IO_BUFFER, shazam::IO_MMAP, shazam::IO_READ, shazam::IO_PIPELINE,
+                      shazam::IO_URING}) {
+        shazam::HashFactory hfactory;
+        hfactory.setIOMode(mode);
+
+        ASSERT("Every io mode calculates the same hash sum",
+            hfactory.hashFile("SHA1", file)->get().hashSum.toHex() == EXPECTED
+        );
+    }
+
+    for (std::size_t buffers : {1, 3, 16}) {
+        shazam::HashFactory hfactory;
+        hfactory.setIOMode(shazam::IO_PIPELINE, buffers);
+
+        ASSERT("The pipelined reads calculate the same hash sum with any number of buffers",
+            hfactory.hashFile("SHA1", file)->get().hashSum.toHex() == EXPECTED
+        );
+    }
+
+    std::remove(BIG_FILE_PATH);
+}
+
+void test_page_cache_modes_match_the_file_hash() {
+    write_big_test_file();
+
+    shazam::FileFactory ffactory;
+    const std::uintmax_t size = std::filesystem::file_size(BIG_FILE_PATH);
+    const std::string EXPECTED = std::unique_ptr<hashwrapper>(wrapperfactory().create("SHA1"))->getHashFromFile(BIG_FILE_PATH);
+
+    for (auto pageCache : {shazam::PAGE_CACHE_KEEP, shazam::PAGE_CACHE_DROP, shazam::PAGE_CACHE_BYPASS}) {
+        for (auto mode : {shazam::IO_AUTO, shazam::IO_BUFFER, shazam::IO_MMAP, shazam::IO_READ, shazam::IO_PIPELINE}) {
+            shazam::HashFactory hfactory;
+            hfactory.setIOMode(mode, 3, shazam::URING_DEFAULT_DEPTH, pageCache);
+
+            shazam::Stats::setEnabled(true);
+            shazam::Stats::reset();
+            const std::string calculated = hfactory.hashFile("SHA1", ffactory.create(BIG_FILE_PATH))->get().hashSum.toHex();
+            shazam::Stats::setEnabled(false);
+
+            const auto counters = shazam::Stats::total();
+
+            ASSERT("Every page cache mode calculates the same hash sum", calculated == EXPECTED);
+
+            // Where O_DIRECT isn't allowed, the pages are given back instead
+            if (pageCache == shazam::PAGE_CACHE_KEEP)
+                ASSERT("The pages are kept", counters.droppedBytes == 0 && counters.directBytes == 0);
+            else if (pageCache == shazam::PAGE_CACHE_DROP)
+                ASSERT("The pages are given back once read", counters.droppedBytes == size && counters.directBytes == 0);
+            else
+                ASSERT("The file is read around the page cache", counters.droppedBytes + counters.directBytes == size);
+        }
+    }
+
+    std::remove(BIG_FILE_PATH);
+}
+
+void test_sparse_files_hash_like_their_data() {
+    const std::string SPARSE_PATH = BIG_FILE_PATH ".sparse";
+    const off_t size = 3 * shazam::LARGE_BUFFER_SIZE + 12345;
+    const int fd = open(SPARSE_PATH.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    // Data at the start, in the middle and at the end, with holes between them and none after
+    ASSERT_EQUALS(ftruncate(fd, size), 0);
+
+    for (off_t offset : {(off_t) 0, (off_t) shazam::LARGE_BUFFER_SIZE + 4097, size - 100}) {
+        std::vector<unsigned char> data(100);
+
+        for (std::size_t i = 0; i < data.size(); i++)
+            data[i] = (unsigned char) (offset + i * 7 + 1);
+
+        ASSERT_EQUALS(pwrite(fd, data.data(), data.size(), offset), (ssize_t) data.size());
+    }
+
+    close(fd);
+
+    struct stat filestat;
+    stat(SPARSE_PATH.c_str(), &filestat);
+    const bool sparse = (std::uintmax_t) filestat.st_blocks * 512 < (std::uintmax_t) size;
+    const std::string EXPECTED = std::unique_ptr<hashwrapper>(wrapperfactory().create("SHA1"))->getHashFromFile(SPARSE_PATH);
+    shazam::FileFactory ffactory;
+
+    for (auto pageCache : {shazam::PAGE_CACHE_KEEP, shazam::PAGE_CACHE_DROP}) {
+        shazam::HashFactory hfactory;
+        hfactory.setIOMode(shazam::IO_AUTO, shazam::PIPELINE_DEFAULT_BUFFERS, shazam::URING_DEFAULT_DEPTH, pageCache);
+
+        shazam::Stats::setEnabled(true);
+        shazam::Stats::reset();
+        const std::string calculated = hfactory.hashFile("SHA1", ffactory.create(SPARSE_PATH))->get().hashSum.toHex();
+        shazam::Stats::setEnabled(false);
+
+        ASSERT("The holes are hashed as the zeros read from them", calculated == EXPECTED);
+
+        // Where the file system has no holes, the file is read as usual
+        if (sparse)
+            ASSERT("The holes are skipped", shazam::Stats::total().holeBytes > 0);
+    }
+
+    std::remove(SPARSE_PATH.c_str());
+}
+
+void test_streams_are_hashed_and_copied() {
+    write_big_test_file();
+
+    const std::string EXPECTED = std::unique_ptr<hashwrapper>(wrapperfactory().create("SHA1"))->getHashFromFile(BIG_FILE_PATH);
+    const std::string COPY_PATH = BIG_FILE_PATH ".copy";
+    shazam::FileFactory ffactory;
+
+    // From a pipe the copy is spliced, from a regular file it is written
+    for (bool fromPipe : {true, false}) {
+        const int tee = open(COPY_PATH.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        int pipeFds[2] = {-1, -1};
+        std::thread writer;
+
+        if (fromPipe) {
+            ASSERT_EQUALS(pipe(pipeFds), 0);
+
+            writer = std::thread([&pipeFds]() {
+                std::ifstream in(BIG_FILE_PATH, std::ios::binary);
+                std::vector<char> block(100000);
+
+                while (in.read(block.data(), block.size()) || in.gcount() > 0) {
+                    for (std::streamsize written = 0; written < in.gcount();)
+                        written += write(pipeFds[1], block.data() + written, in.gcount() - written);
+                }
+
+                close(pipeFds[1]);
+            });
+        }
+
+        const auto file = ffactory.create(fromPipe ? "/dev/fd/" + std::to_string(pipeFds[0]) : BIG_FILE_PATH);
+        shazam::HashFactory hfactory;
+        hfactory.setTee(tee);
+        const auto hash = hfactory.hashFile(std::vector<std::string>{"MD5", "SHA1"}, file);
+
+        ASSERT_EQUALS(file->isStream(), fromPipe);
+        ASSERT("Streams and copied files are never batched", !shazam::BatchHasher::accepts(*hash));
+        ASSERT("A stream is hashed until its end", hash->get(1).hashSum.toHex() == EXPECTED);
+
+        if (writer.joinable())
+            writer.join();
+
+        if (fromPipe)
+            close(pipeFds[0]);
+
+        close(tee);
+        ASSERT("The copy has all the data read",
+            std::unique_ptr<hashwrapper>(wrapperfactory().create("SHA1"))->getHashFromFile(COPY_PATH) == EXPECTED
+        );
+    }
+
+    std::remove(COPY_PATH.c_str());
+    std::remove(BIG_FILE_PATH);
+}
+
+void test_fifos_wait_for_their_writer() {
+    const std::string FIFO_PATH = ".testfifo";
+    const std::string DATA = "Written after the fifo was opened";
+    const std::string EXPECTED = std::unique_ptr<hashwrapper>(wrapperfactory().create("MD5"))->getHashFromString(DATA);
+    std::remove(FIFO_PATH.c_str());
+    ASSERT_EQUALS(mkfifo(FIFO_PATH.c_str(), 0644), 0);
+
+    // The writer starts well after the fifo is opened for reading, and
+    // gives up rather than blocking if the reader is gone by then
+    std::thread writer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+        for (int attempt = 0; attempt < 50; attempt++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            const int fd = open(FIFO_PATH.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+
+            if (fd >= 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                write(fd, DATA.data(), DATA.size());
+                close(fd);
+                return;
+            }
+        }
+    });
+
+    shazam::FileFactory ffactory;
+    const auto file = ffactory.create(FIFO_PATH);
+    // The hash sums are calculated when first asked for
+    const std::string digest = shazam::HashFactory().hashFile(std::vector<std::string>{"MD5"}, file)->get(0).hashSum.toHex();
+    writer.join();
+    std::remove(FIFO_PATH.c_str());
+
+    ASSERT("A fifo is a stream", file->isStream());
+    ASSERT("A fifo is read from its writer", digest == EXPECTED);
+}
+
+void test_pipelined_reader_stops_with_the_consumer() {
+    write_big_test_file();
+
+    shazam::PipelinedReader reader(3);
+    const int fd = open(BIG_FILE_PATH, O_RDONLY);
+    bool thrown = false;
+
+    try {
+        reader.read(fd, shazam::LARGE_BUFFER_SIZE + 4097, [](const unsigned char*, std::size_t) {
+            throw std::runtime_error("consumer failed");
+        });
+    } catch (const std::runtime_error& err) {
+        thrown = std::string(err.what()) == "consumer failed";
+    }
+
+    ASSERT("The errors of the consumer reach the caller", thrown);
+
+    // The ring is reused by the next file of the thread
+    std::size_t total = 0;
+    lseek(fd, 0, SEEK_SET);
+    reader.read(fd, shazam::LARGE_BUFFER_SIZE + 4097, [&](const unsigned char*, std::size_t len) { total += len; });
+    close(fd);
+
+    ASSERT_EQUALS(total, shazam::LARGE_BUFFER_SIZE + 4097);
+
+    bool rejected = false;
+
+    try {
+        shazam::ReaderFactory(shazam::IO_PIPELINE, shazam::PIPELINE_MAX_BUFFERS + 1);
+    } catch (const std::invalid_argument& err) {
+        rejected = true;
+    }
+
+    ASSERT("The buffers are bounded", rejected);
+    std::remove(BIG_FILE_PATH);
+}
+
+void test_mapped_reader_survives_truncation() {
+    write_big_test_file();
+
+    const int fd = open(BIG_FILE_PATH, O_RDWR);
+    std::size_t total = 0;
+    unsigned int sum = 0;
+    bool thrown = false;
+
+    try {
+        // The second block is past the end of the file once it is truncated
+        shazam::MappedReader().read(fd, shazam::LARGE_BUFFER_SIZE + 4097, [&](const unsigned char* data, std::size_t len) {
+            if (total == 0 && ftruncate(fd, 0) != 0)
+                throw std::logic_error("Cannot truncate the test file");
+
+            for (std::size_t i = 0; i < len; i++)
+                sum += data[i];
+
+            total += len;
+        });
+    } catch (const std::runtime_error& err) {
+        thrown = true;
+    }
+
+    close(fd);
+    std::remove(BIG_FILE_PATH);
+
+    ASSERT("A file truncated while mapped fails to be read, without killing the run", thrown);
+}
+
+void test_io_mode_names() {
+    ASSERT_EQUALS(shazam::ioModeFromName("mmap"), shazam::IO_MMAP);
+    ASSERT_EQUALS(shazam::ioModeFromName("Buffer"), shazam::IO_BUFFER);
+
+    bool thrown = false;
+
+    try {
+        shazam::ioModeFromName("floppy");
+    } catch (const std::invalid_argument& err) {
+        thrown = true;
+    }
+
+    ASSERT("Unknown io modes are rejected", thrown);
+}
+
+// -------------- END Testing Readers --------------------------------------------------
+
 // -------------- File Size ------------------------------------------------------------
 
 void test_file_size() {
@@ -211,14 +853,497 @@ void test_checker_hash_sum_calculation() {
 
     const auto list = checker.getValidHashesList();
 
-    const auto sha256 = list.front();
-    const auto sha1 = list.back();
-    ASSERT("Testing Checker sha1sum result", sha1->get().hashSum == VALID_FILE_S_SHA1SUM);
-    ASSERT("Testing Checker sha256sum result", sha256->get().hashSum == VALID_FILE_S_SHA256SUM);
+    const auto sha1 = list.front();
+    const auto sha256 = list.back();
+    ASSERT("Testing Checker sha1sum result", sha1->get().hashSum.toHex() == VALID_FILE_S_SHA1SUM);
+    ASSERT("Testing Checker sha256sum result", sha256->get().hashSum.toHex() == VALID_FILE_S_SHA256SUM);
+}
+
+void test_checker_parallel_calculation() {
+    shazam::Checker checker;
+    shazam::FileFactory ffactory;
+
+    checker.setJobs(4);
+
+    for (int i = 0; i < 16; i++)
+        checker.add(ffactory.create(VALID_FILE_S_PATH), i % 2 ? "SHA256" : "MD5");
+
+    checker.calculateHashSums();
+
+    int i = 0;
+    for (auto& hash : checker.getValidHashesList()) {
+        const auto expected = i++ % 2 ? VALID_FILE_S_SHA256SUM : VALID_FILE_S_MD5SUM;
+        ASSERT("Parallel results keep the input order", hash->get().hashSum.toHex() == expected);
+    }
+}
+
+void test_checker_batch_calculation() {
+    shazam::FileFactory ffactory;
+    shazam::HashFactory hfactory;
+    std::vector<std::shared_ptr<shazam::HashCalculator>> hashes;
+
+    for (int i = 0; i < 40; i++)
+        hashes.push_back(hfactory.hashFile({"MD5", "SHA1", "SHA256"}, ffactory.create(VALID_FILE_S_PATH)));
+
+    shazam::BatchHasher::calculate(hashes);
+
+    for (auto& hash : hashes) {
+        ASSERT("Batch md5sum result", hash->get(0).hashSum.toHex() == VALID_FILE_S_MD5SUM);
+        ASSERT("Batch sha1sum result", hash->get(1).hashSum.toHex() == VALID_FILE_S_SHA1SUM);
+        ASSERT("Batch sha256sum result", hash->get(2).hashSum.toHex() == VALID_FILE_S_SHA256SUM);
+    }
+
+    ASSERT("Small files are accepted for md5 batches",
+        shazam::BatchHasher::accepts(*hfactory.hashFile("MD5", ffactory.create(VALID_FILE_S_PATH))));
+    ASSERT("SHA512 is not calculated in batches",
+        !shazam::BatchHasher::accepts(*hfactory.hashFile("SHA512", ffactory.create(VALID_FILE_S_PATH))));
+}
+
+void test_uring_batch_calculation() {
+    shazam::FileFactory ffactory;
+    shazam::HashFactory hfactory;
+    std::vector<std::shared_ptr<shazam::HashCalculator>> hashes;
+
+    // A small queue, so the files are read in several groups
+    hfactory.setIOMode(shazam::IO_URING, shazam::PIPELINE_DEFAULT_BUFFERS, 4);
+
+    for (int i = 0; i < 10; i++) {
+        // Half of the files kept open by the validation, half to be opened
+        auto file = i % 2 ? ffactory.create(VALID_FILE_S_PATH)
+                          : std::make_shared<shazam::File>(VALID_FILE_S_PATH, shazam::VALID_FILE);
+        hashes.push_back(hfactory.hashFile(std::vector<std::string>{"MD5", "SHA256"}, file));
+    }
+
+    shazam::BatchHasher::calculate(hashes);
+
+    for (auto& hash : hashes) {
+        ASSERT("io_uring batch md5sum result", hash->get(0).hashSum.toHex() == VALID_FILE_S_MD5SUM);
+        ASSERT("io_uring batch sha256sum result", hash->get(1).hashSum.toHex() == VALID_FILE_S_SHA256SUM);
+    }
+
+    if (!shazam::UringBatchReader::available())
+        return;
+
+    std::vector<std::shared_ptr<shazam::File>> files = {
+        std::make_shared<shazam::File>(VALID_FILE_S_PATH, shazam::VALID_FILE),
+        std::make_shared<shazam::File>(".nonexistentfile.shazam.tmp", shazam::VALID_FILE)
+    };
+    std::vector<std::vector<unsigned char>> contents(files.size());
+    std::vector<struct stat> filestats(files.size());
+    std::vector<std::uint8_t> done(files.size(), 0);
+
+    shazam::UringBatchReader(8).read(files, shazam::BATCH_MAX_FILE_SIZE, contents, filestats, done);
+
+    ASSERT("The files that exist are read", done[0] && contents[0].size() == (std::size_t) filestats[0].st_size);
+    ASSERT("The files that can't be read are left for the usual reads", !done[1]);
+}
+
+#define TREE_PATH ".treefortest.shazam.tmp"
+
+void test_checker_recursive_calculation() {
+    std::filesystem::remove_all(TREE_PATH);
+    std::filesystem::create_directories(TREE_PATH "/sub/deeper");
+    std::filesystem::create_directories(TREE_PATH "/skipped");
+
+    for (auto path : {TREE_PATH "/b.txt", TREE_PATH "/sub/a.txt", TREE_PATH "/sub/deeper/c.txt",
+                      TREE_PATH "/sub/ignored.o", TREE_PATH "/skipped/d.txt"})
+        std::filesystem::copy_file(VALID_FILE_S_PATH, path);
+
+    shazam::Checker checker;
+    shazam::FileFactory ffactory;
+    shazam::WalkOptions options;
+    options.exclude = {"*.o", "skipped"};
+
+    checker.setJobs(4);
+    checker.setWalkOptions(options);
+    checker.add(ffactory.create(VALID_FILE_S_PATH), "SHA1");
+    checker.addTree(TREE_PATH, {"SHA1"});
+    checker.add(ffactory.create(VALID_FILE_S_PATH), "SHA1");
+    checker.calculateHashSums();
+
+    std::vector<std::string> paths;
+
+    for (auto& hash : checker.getValidHashesList()) {
+        paths.push_back(hash->getFilePath());
+        ASSERT("Walked files are hashed", hash->get().hashSum.toHex() == VALID_FILE_S_SHA1SUM);
+    }
+
+    const std::vector<std::string> expected = {
+        VALID_FILE_S_PATH, TREE_PATH "/b.txt", TREE_PATH "/sub/a.txt", TREE_PATH "/sub/deeper/c.txt", VALID_FILE_S_PATH
+    };
+
+    ASSERT("Tree files are sorted in place of the tree", paths == expected);
+    std::filesystem::remove_all(TREE_PATH);
+}
+
+void test_walker_follows_every_link_but_the_loops() {
+    std::filesystem::remove_all(TREE_PATH);
+    std::filesystem::create_directories(TREE_PATH "/real");
+    std::filesystem::copy_file(VALID_FILE_S_PATH, TREE_PATH "/real/a.txt");
+    std::filesystem::create_directory_symlink("real", TREE_PATH "/link");
+    std::filesystem::create_directory_symlink("..", TREE_PATH "/real/loop");
+
+    std::mutex mutex;
+    std::vector<std::string> paths;
+    shazam::WalkOptions options;
+    options.symlinks = shazam::SYMLINKS_ALWAYS;
+
+    {
+        shazam::WorkStealingPool pool(4);
+        shazam::TreeWalker walker(pool, options, [&](const std::string& path, shazam::EFileStatus) {
+            std::lock_guard<std::mutex> lock(mutex);
+            paths.push_back(path);
+        });
+
+        walker.walk(TREE_PATH);
+        pool.wait();
+    }
+
+    std::sort(paths.begin(), paths.end());
+    const std::vector<std::string> expected = {TREE_PATH "/link/a.txt", TREE_PATH "/real/a.txt"};
+
+    ASSERT("A directory is listed under every link to it, but not inside itself", paths == expected);
+    std::filesystem::remove_all(TREE_PATH);
+}
+
+void test_checker_streams_in_order() {
+    std::filesystem::remove_all(TREE_PATH);
+    std::filesystem::create_directories(TREE_PATH "/sub");
+
+    for (auto path : {TREE_PATH "/b.txt", TREE_PATH "/sub/a.txt"})
+        std::filesystem::copy_file(VALID_FILE_S_PATH, path);
+
+    std::vector<std::string> paths = {VALID_FILE_S_PATH, "i_dont_exist.txt", TREE_PATH};
+
+    // More files than fit in a group, so that they are hashed by different tasks
+    for (std::size_t i = 0; i < 3 * shazam::BatchHasher::lanes() * shazam::BATCH_GROUPS_PER_TASK; i++)
+        paths.push_back(VALID_FILE_S_PATH);
+
+    std::ostringstream expected;
+    expected << "# MD5\n" << VALID_FILE_S_MD5SUM " " VALID_FILE_S_PATH "\n"
+             << VALID_FILE_S_MD5SUM " " TREE_PATH "/b.txt\n" << VALID_FILE_S_MD5SUM " " TREE_PATH "/sub/a.txt\n";
+
+    for (std::size_t i = 3; i < paths.size(); i++)
+        expected << VALID_FILE_S_MD5SUM " " VALID_FILE_S_PATH "\n";
+
+    expected << "\n# SHA1\n" << VALID_FILE_S_SHA1SUM " " VALID_FILE_S_PATH "\n"
+             << VALID_FILE_S_SHA1SUM " " TREE_PATH "/b.txt\n" << VALID_FILE_S_SHA1SUM " " TREE_PATH "/sub/a.txt\n";
+
+    for (std::size_t i = 3; i < paths.size(); i++)
+        expected << VALID_FILE_S_SHA1SUM " " VALID_FILE_S_PATH "\n";
+
+    shazam::Checker checker;
+    std::ostringstream output;
+    checker.setJobs(4);
+    checker.streamHashSums(paths, {"MD5", "SHA1"}, true, output);
+
+    ASSERT("The hash sums are written in the order of the files", output.str() == expected.str());
+    ASSERT_EQUALS(checker.getInvalidFilesList().size(), 1);
+    ASSERT_EQUALS(checker.getValidHashesList().size(), 0);
+
+    shazam::Checker unordered;
+    std::ostringstream unorderedOutput;
+    unordered.setJobs(4);
+    unordered.setUnordered(true);
+    unordered.streamHashSums(paths, {"MD5", "SHA1"}, true, unorderedOutput);
+
+    ASSERT_EQUALS(unorderedOutput.str().size(), expected.str().size());
+    std::filesystem::remove_all(TREE_PATH);
+}
+
+void test_checker_streams_big_files_in_their_place() {
+    write_big_test_file();
+
+    const std::string BIG_MD5SUM = std::unique_ptr<hashwrapper>(wrapperfactory().create("MD5"))->getHashFromFile(BIG_FILE_PATH);
+    std::vector<std::string> paths;
+    std::ostringstream expected;
+    std::size_t invalid = 0;
+
+    // The big file comes last, after more small groups than are sorted at
+    // once, so that it is hashed ahead of the ones before it
+    for (std::size_t i = 0; i < 40 * shazam::BatchHasher::lanes() * shazam::BATCH_GROUPS_PER_TASK; i++) {
+        paths.push_back(i % 50 == 7 ? "i_dont_exist.txt" : VALID_FILE_S_PATH);
+
+        if (i % 50 == 7)
+            invalid++;
+        else
+            expected << VALID_FILE_S_MD5SUM " " VALID_FILE_S_PATH "\n";
+    }
+
+    paths.push_back(BIG_FILE_PATH);
+    expected << BIG_MD5SUM << " " BIG_FILE_PATH "\n";
+
+    shazam::Checker checker;
+    std::ostringstream output;
+    checker.setJobs(2);
+    checker.streamHashSums(paths, {"MD5"}, false, output);
+    std::remove(BIG_FILE_PATH);
+
+    ASSERT("The files are written in their order whatever the order they are hashed in", output.str() == expected.str());
+    ASSERT_EQUALS(checker.getInvalidFilesList().size(), invalid);
+}
+
+void test_checker_streams_a_list_of_files() {
+    std::istringstream lines("a.txt\r\n\nb c.txt\n");
+    shazam::PathListReader lineList(lines);
+    std::vector<std::string> listed;
+    std::string path;
+
+    while (lineList.next(path))
+        listed.push_back(path);
+
+    ASSERT("The lines are paths, kept as they are, without the empty ones",
+        listed == std::vector<std::string>({"a.txt\r", "b c.txt"}));
+
+    std::istringstream names(std::string("new\nline\0 \r\0\0", 13));
+    shazam::PathListReader nameList(names, '\0');
+    listed.clear();
+
+    while (nameList.next(path))
+        listed.push_back(path);
+
+    ASSERT("NUL separated paths are kept byte for byte", listed == std::vector<std::string>({"new\nline", " \r"}));
+
+    std::vector<std::string> paths;
+    std::string nulSeparated;
+
+    for (std::size_t i = 0; i < 3 * shazam::BatchHasher::lanes() * shazam::BATCH_GROUPS_PER_TASK; i++) {
+        paths.push_back(i % 7 == 3 ? "i_dont_exist.txt" : VALID_FILE_S_PATH);
+        nulSeparated += paths.back() + '\0';
+    }
+
+    shazam::Checker fromVector;
+    std::ostringstream expected;
+    fromVector.setJobs(4);
+    fromVector.streamHashSums(paths, {"MD5"}, false, expected);
+
+    std::istringstream input(nulSeparated);
+    shazam::PathListReader list(input, '\0');
+
+    shazam::Checker fromList;
+    std::ostringstream output;
+    fromList.setJobs(4);
+    fromList.streamHashSums([&](std::string& path) { return list.next(path); }, {"MD5"}, false, output);
+
+    ASSERT("A NUL separated list is hashed as the same paths given at once", output.str() == expected.str());
+    ASSERT_EQUALS(fromList.getInvalidFilesList().size(), fromVector.getInvalidFilesList().size());
+}
+
+void test_result_writer_reorders_the_groups() {
+    std::ostringstream output;
+    shazam::ResultWriter writer(output, {"MD5"}, false);
+
+    shazam::ResultGroup second, first;
+    second.sums.push_back(shazam::HashSum { "b", "MD5", digestOf("MD5", "02") });
+    first.sums.push_back(shazam::HashSum { "a", "MD5", digestOf("MD5", "01") });
+
+    writer.write(1, std::move(second));
+    ASSERT("Groups wait for the ones before them", output.str().empty() && writer.getWrittenGroups() == 0);
+
+    writer.write(0, std::move(first));
+    writer.finish();
+    ASSERT("Groups are written in order", output.str() == "01 a\n02 b\n");
+    ASSERT_EQUALS(writer.getWrittenGroups(), 2);
+}
+
+void test_result_writer_spills_the_other_sections() {
+    std::ostringstream output;
+    std::ostringstream expected;
+    std::ostringstream section;
+    shazam::ResultWriter writer(output, {"MD5", "SHA1"}, false);
+    const std::string md5 = std::string(32, '0');
+    const std::string sha1 = std::string(40, '1');
+
+    // Enough SHA1 sums to spill them a few times
+    const std::size_t groups = 3 * shazam::SECTION_SPILL_SIZE / 50;
+    expected << shazam::sectionHeader("MD5") << "\n";
+
+    for (std::size_t i = 0; i < groups; i++) {
+        const std::string name = "file" + std::to_string(i);
+        shazam::ResultGroup results;
+        results.sums.push_back(shazam::HashSum { name, "MD5", digestOf("MD5", md5) });
+        results.sums.push_back(shazam::HashSum { name, "SHA1", digestOf("SHA1", sha1) });
+        writer.write(i, std::move(results));
+
+        expected << md5 << " " << name << "\n";
+        section << sha1 << " " << name << "\n";
+    }
+
+    ASSERT("The first section is written as it comes", output.str() == expected.str());
+
+    writer.finish();
+    expected << "\n" << shazam::sectionHeader("SHA1") << "\n" << section.str();
+    ASSERT("The other sections are written whole at the end", output.str() == expected.str());
+}
+
+void test_result_writer_counts_the_parts_of_a_group_once() {
+    std::ostringstream output;
+    shazam::ResultWriter writer(output, {"MD5"}, true);
+
+    for (const char* name : {"a", "b"}) {
+        shazam::ResultGroup part;
+        part.sums.push_back(shazam::HashSum { name, "MD5", digestOf("MD5", "01") });
+        writer.writePart(std::move(part));
+    }
+
+    ASSERT("Parts are written as they come", output.str() == "01 a\n01 b\n");
+    ASSERT_EQUALS(writer.getWrittenGroups(), 0);
+
+    writer.write(0, shazam::ResultGroup());
+    ASSERT_EQUALS(writer.getWrittenGroups(), 1);
+
+    bool thrown = false;
+    shazam::ResultWriter ordered(output, {"MD5"}, false);
+
+    try {
+        ordered.writePart(shazam::ResultGroup());
+    } catch (const std::logic_error&) {
+        thrown = true;
+    }
+
+    ASSERT("Ordered writers don't take parts", thrown);
 }
 
 // -------------- END Testing Checker ----------------------------------------------------
 
+// -------------- Testing Work Stealing Pool ---------------------------------------------
+
+void test_pool_runs_every_task() {
+    std::atomic<int> counter(0);
+    shazam::WorkStealingPool pool(4);
+
+    for (int i = 0; i < 1000; i++)
+        pool.submit([&counter]() { counter++; });
+
+    pool.wait();
+
+    ASSERT_EQUALS(counter.load(), 1000);
+}
+
+void test_pool_never_runs_an_empty_task() {
+    // Workers racing for the last tasks of a round must wait for another
+    // one instead of coming back empty handed
+    for (int round = 0; round < 300; round++) {
+        std::atomic<int> counter(0);
+        bool thrown = false;
+        shazam::WorkStealingPool pool(8);
+
+        for (int i = 0; i < 200; i++)
+            pool.submit([&counter]() { counter++; });
+
+        try {
+            pool.wait();
+        } catch (const std::exception& err) {
+            thrown = true;
+        }
+
+        ASSERT("No task fails", !thrown);
+        ASSERT_EQUALS(counter.load(), 200);
+    }
+}
+
+void test_pool_runs_the_tasks_submitted_by_its_tasks() {
+    std::atomic<int> counter(0);
+    shazam::WorkStealingPool pool(4);
+
+    for (int i = 0; i < 50; i++) {
+        pool.submit([&pool, &counter]() {
+            for (int j = 0; j < 20; j++)
+                pool.submit([&counter]() { counter++; });
+        });
+    }
+
+    pool.wait();
+
+    ASSERT_EQUALS(counter.load(), 1000);
+}
+
+void test_pool_rethrows_task_errors() {
+    shazam::WorkStealingPool pool(2);
+    bool thrown = false;
+
+    pool.submit([]() { throw std::runtime_error("task failed"); });
+
+    try {
+        pool.wait();
+    } catch (const std::runtime_error& err) {
+        thrown = true;
+    }
+
+    ASSERT("Pool.wait rethrows the task error", thrown);
+}
+
+void test_device_scheduler_limits_each_device() {
+    // Device numbers with no block device behind them, which aren't rotational
+    const std::uint64_t DISK = 1, SSD = 2;
+    std::atomic<int> running[3] = {0, 0, 0}, most[3] = {0, 0, 0};
+    std::vector<int> diskOrder;
+    std::mutex orderMutex;
+    bool thrown = false;
+
+    shazam::DeviceScheduler scheduler(4);
+    scheduler.setLimit(DISK, 1);
+
+    {
+        shazam::WorkStealingPool pool(4);
+        scheduler.submit(pool, DISK, []() { throw std::runtime_error("task failed"); });
+
+        for (int i = 0; i < 8; i++) {
+            for (auto device : {DISK, SSD}) {
+                scheduler.submit(pool, device, [&, i, device]() {
+                    const int now = ++running[device];
+                    int seen = most[device];
+
+                    while (now > seen && !most[device].compare_exchange_weak(seen, now));
+
+                    if (device == DISK) {
+                        std::lock_guard<std::mutex> lock(orderMutex);
+                        diskOrder.push_back(i);
+                    }
+
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    running[device]--;
+                });
+            }
+        }
+
+        try {
+            pool.wait();
+        } catch (const std::runtime_error& err) {
+            thrown = true;
+        }
+    }
+
+    ASSERT("The errors of a device are rethrown", thrown);
+    ASSERT("A device runs its tasks after an error", diskOrder == std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7}));
+    ASSERT_EQUALS(most[DISK].load(), 1);
+    ASSERT("The other devices run several tasks at once", most[SSD].load() > 1);
+    ASSERT("Devices without a queue aren't rotational", !shazam::isRotationalDevice(SSD));
+}
+
+// -------------- END Testing Work Stealing Pool -----------------------------------------
+
+// -------------- Testing Progress Observer -----------------------------------------------
+
+void test_progress_observer_counts_the_bytes() {
+    shazam::HashFactory hfactory;
+    shazam::FileFactory ffactory;
+    auto progress = std::make_shared<shazam::ProgressObserver>(40);
+    auto hash = hfactory.hashFile("SHA256", ffactory.create(VALID_FILE_S_PATH));
+
+    progress->expect(hash->getFileSize());
+    hash->setObserver(progress);
+    ASSERT_EQUALS(progress->getObservablesNumber(), 1);
+
+    hash->calculate();
+    hash->notifyObserver();
+
+    ASSERT_EQUALS(progress->getProcessedBytes(), hash->getFileSize());
+    ASSERT_EQUALS(progress->getObservablesNumber(), 0);
+}
+
+// -------------- END Testing Progress Observer -------------------------------------------
+
 // -------------- Testing Hash Comparator --------------------------------------------------------
 
 void test_hash_comparator_match()
@@ -233,7 +1358,7 @@ void test_hash_comparator_match()
     const auto originalHashSum = shazam::HashSum {
         .filename=VALID_FILE_S_PATH,
         .hashType="SHA1",
-        .hashSum=NOT_MATCH_TEST_SHA1SUM
+        .hashSum=digestOf("SHA1", NOT_MATCH_TEST_SHA1SUM)
     };
 
     shazam::HashComparator hcomparator(originalHashSum, currentHashSum);
@@ -251,7 +1376,7 @@ void test_hash_comparator_not_match()
     const auto originalHashSum = shazam::HashSum {
         .filename=VALID_FILE_S_PATH,
         .hashType="SHA1",
-        .hashSum=VALID_FILE_S_SHA1SUM
+        .hashSum=digestOf("SHA1", VALID_FILE_S_SHA1SUM)
     };
 
     shazam::HashComparator hcomparator(originalHashSum, currentHashSum);
@@ -259,21 +1384,260 @@ void test_hash_comparator_not_match()
     ASSERT("Testing Hash Comparator", hcomparator.compareHashes().result == shazam::MATCH);
 }
 
+void test_hash_comparator_ignores_the_case()
+{
+    const auto lower = shazam::HashSum { .filename=VALID_FILE_S_PATH, .hashType="SHA1", .hashSum=digestOf("SHA1", VALID_FILE_S_SHA1SUM) };
+    const auto upper = shazam::HashSum {
+        .filename=VALID_FILE_S_PATH,
+        .hashType="SHA1",
+        .hashSum=digestOf("SHA1", shazam::toUpperCase(VALID_FILE_S_SHA1SUM))
+    };
+    const auto malformed = shazam::HashSum { .filename=VALID_FILE_S_PATH, .hashType="SHA1", .hashSum=digestOf("SHA1", "xyz") };
+
+    ASSERT("Digests are compared as bytes", shazam::HashComparator(upper, lower).compareHashes().result == shazam::MATCH);
+    ASSERT("Malformed digests never match", shazam::HashComparator(malformed, lower).compareHashes().result == shazam::NOT_MATCH);
+}
+
+void test_digests_as_bytes()
+{
+    const auto digest = digestOf("SHA1", shazam::toUpperCase(VALID_FILE_S_SHA1SUM));
+    std::unordered_set<shazam::Digest> seen = {digest};
+
+    ASSERT_EQUALS(digest.size(), 20);
+    ASSERT("Digests are written in lowercase", digest.toHex() == VALID_FILE_S_SHA1SUM);
+    ASSERT("Digests can be looked up", seen.count(digestOf("SHA1", VALID_FILE_S_SHA1SUM)) == 1);
+    ASSERT("The hash type is part of the digest", digest != digestOf("MD5", VALID_FILE_S_SHA1SUM));
+    ASSERT("Malformed digests are empty", digestOf("SHA1", "0g").empty() && digestOf("SHA1", "012").empty());
+}
+
 // -------------- END Hash Comparator ----------------------------------------------------
 
+// -------------- Testing Manifests ------------------------------------------------------
+
+void test_manifest_formats() {
+    std::istringstream manifest(
+        VALID_FILE_S_SHA256SUM "  " VALID_FILE_S_PATH "\n"
+        VALID_FILE_S_MD5SUM " *binary file.txt\n"
+        "\\" VALID_FILE_S_SHA1SUM "  with\\nnewline\r\n"
+        "SHA512 (" VALID_FILE_S_PATH ") = " VALID_FILE_S_SHA512SUM "\n"
+        "\n"
+        "# SHA1\n"
+        VALID_FILE_S_SHA1SUM " " VALID_FILE_S_PATH "\n"
+        "not a manifest line\n"
+        "abc  too-short\n"
+    );
+
+    shazam::ManifestReader reader(manifest);
+    shazam::ManifestEntry entry;
+    std::vector<std::string> parsed;
+
+    while (reader.next(entry))
+        parsed.push_back(entry.hashType + "|" + entry.filename + "|" + entry.hashSum.toHex());
+
+    ASSERT_EQUALS(parsed.size(), 5);
+    ASSERT("GNU text mode line", parsed[0] == "SHA256|" VALID_FILE_S_PATH "|" VALID_FILE_S_SHA256SUM);
+    ASSERT("GNU binary mode line", parsed[1] == "MD5|binary file.txt|" VALID_FILE_S_MD5SUM);
+    ASSERT("GNU escaped line", parsed[2] == "SHA1|with\nnewline|" VALID_FILE_S_SHA1SUM);
+    ASSERT("BSD line", parsed[3] == "SHA512|" VALID_FILE_S_PATH "|" VALID_FILE_S_SHA512SUM);
+    ASSERT("Shazam output line", parsed[4] == "SHA1|" VALID_FILE_S_PATH "|" VALID_FILE_S_SHA1SUM);
+    ASSERT_EQUALS(reader.getMalformedLines(), 2);
+}
+
+void test_manifest_types_sharing_a_length() {
+    const std::string BLAKE3_SUM = "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262";
+
+    ASSERT("BLAKE3 sums are written under a header", shazam::alwaysInSection("BLAKE3"));
+    ASSERT("XXH128 sums are written under a header", shazam::alwaysInSection("XXH128"));
+    ASSERT("XXH3 sums are told by their length", !shazam::alwaysInSection("XXH3"));
+    ASSERT("SHA256 sums are told by their length", !shazam::alwaysInSection("SHA256"));
+
+    std::istringstream manifest(
+        "XXH3_2d06800538d394c2  empty\n"
+        "# BLAKE3\n" + BLAKE3_SUM + " empty\n"
+        "BLAKE2b (" VALID_FILE_S_PATH ") = " + std::string(128, 'a') + "\n"
+    );
+
+    shazam::ManifestReader reader(manifest);
+    shazam::ManifestEntry entry;
+
+    ASSERT("xxhsum lines are read", reader.next(entry) && entry.hashType == "XXH3" && entry.hashSum.toHex() == "2d06800538d394c2");
+    ASSERT("BLAKE3 lines are read under their header", reader.next(entry) && entry.hashType == "BLAKE3" && entry.hashSum.toHex() == BLAKE3_SUM);
+    ASSERT("BSD BLAKE2b lines are read", reader.next(entry) && entry.hashType == "BLAKE2B");
+    ASSERT_EQUALS(reader.getMalformedLines(), 0);
+}
+
+void test_verifier_reports_failures() {
+    std::ostringstream output;
+    std::istringstream manifest(
+        VALID_FILE_S_SHA256SUM "  " VALID_FILE_S_PATH "\n"
+        VALID_FILE_S_SHA1SUM "  " VALID_FILE_S_PATH "\n"
+        VALID_FILE_S_MD5SUM "  " "i_dont_exist.txt" "\n"
+        "0000000000000000000000000000000000000000  " VALID_FILE_S_PATH "\n"
+    );
+
+    shazam::Verifier verifier(output);
+    verifier.setJobs(4);
+    const auto summary = verifier.verify(manifest);
+
+    ASSERT_EQUALS(summary.matched, 2);
+    ASSERT_EQUALS(summary.mismatched, 1);
+    ASSERT_EQUALS(summary.unreadable, 1);
+    ASSERT("Verification fails", !summary.ok());
+    ASSERT("Mismatches are reported", output.str().find(VALID_FILE_S_PATH ": FAILED\n") != std::string::npos);
+    ASSERT("Unreadable files are reported", output.str().find("i_dont_exist.txt" ": FAILED open or read\n") != std::string::npos);
+}
+
+void test_verifier_fail_fast() {
+    std::ostringstream output;
+    std::string lines = "0000000000000000000000000000000000000000  " VALID_FILE_S_PATH "\n";
+
+    for (int i = 0; i < 100; i++)
+        lines += VALID_FILE_S_SHA1SUM "  " VALID_FILE_S_PATH "\n";
+
+    std::istringstream manifest(lines);
+    shazam::Verifier verifier(output);
+    verifier.setJobs(1);
+    verifier.setFailFast(true);
+    const auto summary = verifier.verify(manifest);
+
+    ASSERT_EQUALS(summary.mismatched, 1);
+    ASSERT_EQUALS(summary.matched, 0);
+}
+
+// -------------- END Testing Manifests --------------------------------------------------
+
+// -------------- Testing Hash Cache ----------------------------------------------------
+
+#define CACHE_FILE_PATH ".cachefortest.shazam.tmp"
+
+void test_hash_cache_persists_hash_sums() {
+    std::remove(CACHE_FILE_PATH);
+
+    struct stat filestat;
+    stat(VALID_FILE_S_PATH, &filestat);
+
+    {
+        shazam::HashCache cache(CACHE_FILE_PATH);
+        cache.store(filestat, digestOf("SHA1", VALID_FILE_S_SHA1SUM));
+        cache.save();
+    }
+
+    shazam::HashCache cache(CACHE_FILE_PATH);
+    shazam::Digest sum;
+
+    ASSERT("Cached hash sums are found", cache.lookup(filestat, shazam::hashTypeIndex("SHA1"), sum) && sum.toHex() == VALID_FILE_S_SHA1SUM);
+    ASSERT("Other hash types are not", !cache.lookup(filestat, shazam::hashTypeIndex("MD5"), sum));
+
+    filestat.st_mtim.tv_nsec++;
+    ASSERT("Changed files are not", !cache.lookup(filestat, shazam::hashTypeIndex("SHA1"), sum));
+    ASSERT_EQUALS(cache.getHits(), 1);
+    ASSERT_EQUALS(cache.getMisses(), 2);
+
+    std::remove(CACHE_FILE_PATH);
+}
+
+void test_hash_cache_skips_unchanged_files() {
+    std::remove(CACHE_FILE_PATH);
+
+    struct stat filestat;
+    stat(VALID_FILE_S_PATH, &filestat);
+
+    // A wrong hash sum in the cache shows that the file wasn't read
+    auto cache = std::make_shared<shazam::HashCache>(CACHE_FILE_PATH);
+    cache->store(filestat, digestOf("SHA1", NOT_MATCH_TEST_SHA1SUM));
+
+    shazam::HashFactory hfactory;
+    shazam::FileFactory ffactory;
+    hfactory.setCache(cache);
+
+    ASSERT("Unchanged files come from the cache",
+        hfactory.hashFile("SHA1", ffactory.create(VALID_FILE_S_PATH))->get().hashSum.toHex() == NOT_MATCH_TEST_SHA1SUM);
+    ASSERT("Uncached hash sums are calculated and stored",
+        hfactory.hashFile("MD5", ffactory.create(VALID_FILE_S_PATH))->get().hashSum.toHex() == VALID_FILE_S_MD5SUM);
+
+    shazam::Digest sum;
+    ASSERT("Calculated hash sums are cached", cache->lookup(filestat, shazam::hashTypeIndex("MD5"), sum) && sum.toHex() == VALID_FILE_S_MD5SUM);
+
+    std::remove(CACHE_FILE_PATH);
+}
+
+// -------------- END Testing Hash Cache ------------------------------------------------
+
+// -------------- Testing Statistics ----------------------------------------------------
+
+void test_stats_count_the_hashed_files() {
+    shazam::HashFactory hfactory;
+    shazam::FileFactory ffactory;
+    const std::uintmax_t size = std::filesystem::file_size(VALID_FILE_S_PATH);
+
+    shazam::Stats::setEnabled(true);
+    shazam::Stats::reset();
+    hfactory.hashFile("SHA1", ffactory.create(VALID_FILE_S_PATH))->calculate();
+    shazam::Stats::setEnabled(false);
+
+    auto counters = shazam::Stats::total();
+    const std::size_t sha1 = shazam::Stats::algorithmIndex("SHA1");
+
+    ASSERT_EQUALS(counters.files, 1);
+    ASSERT_EQUALS(counters.bytes, size);
+    ASSERT_EQUALS(counters.algorithmBytes[sha1], size);
+    ASSERT("The file was read", counters.reads > 0 && counters.phaseCalls[shazam::PHASE_VALIDATE] == 1);
+
+    hfactory.hashFile("SHA1", ffactory.create(VALID_FILE_S_PATH))->calculate();
+    ASSERT_EQUALS(shazam::Stats::total().files, 1);
+}
+
+void test_stats_keep_the_counters_of_finished_threads() {
+    shazam::Stats::setEnabled(true);
+    shazam::Stats::reset();
+
+    // Like the reading thread of every pipelined file
+    for (int i = 0; i < 100; i++)
+        std::thread([]() { shazam::Stats::addSyscalls(2); }).join();
+
+    shazam::Stats::setEnabled(false);
+    ASSERT_EQUALS(shazam::Stats::total().syscalls, 200);
+
+    shazam::Stats::reset();
+    ASSERT_EQUALS(shazam::Stats::total().syscalls, 0);
+}
+
+// -------------- END Testing Statistics ------------------------------------------------
+
 
 int main(void) {
     // ---- File Factory
     RUN(test_file_factory_non_existent_file);
     RUN(test_file_factory_on_directories);
     RUN(test_file_factory_on_non_permissive_files);
+    RUN(test_file_factory_keeps_the_file_open);
+    RUN(test_file_table_keeps_the_files);
 
     // ---- Hash Sums
     RUN(test_md5sum);
+    RUN(test_md5sum_past_512_mib);
     RUN(test_sha1sum);
     RUN(test_sha256sum);
     RUN(test_sha384sum);
     RUN(test_sha512sum);
+    RUN(test_multiple_hash_sums_in_one_pass);
+    RUN(test_engines_match_the_wrappers);
+    RUN(test_modern_hash_vectors);
+    RUN(test_tree_hash);
+    RUN(test_sha1_kernels);
+    RUN(test_sha256_kernels);
+    RUN(test_multibuffer_kernels);
+    RUN(test_blake3_kernels);
+
+    // ---- Readers
+    RUN(test_io_modes_match_the_file_hash);
+    RUN(test_page_cache_modes_match_the_file_hash);
+    RUN(test_sparse_files_hash_like_their_data);
+    RUN(test_streams_are_hashed_and_copied);
+    RUN(test_fifos_wait_for_their_writer);
+    RUN(test_pipelined_reader_stops_with_the_consumer);
+    RUN(test_mapped_reader_survives_truncation);
+    RUN(test_io_mode_names);
 
     // ---- File Size
     RUN(test_file_size);
@@ -290,10 +1654,47 @@ int main(void) {
     RUN(test_checker_on_valid_files);
     RUN(test_checker_on_valid_and_invalid_files);
     RUN(test_checker_hash_sum_calculation);
+    RUN(test_checker_parallel_calculation);
+    RUN(test_checker_batch_calculation);
+    RUN(test_uring_batch_calculation);
+    RUN(test_checker_recursive_calculation);
+    RUN(test_walker_follows_every_link_but_the_loops);
+    RUN(test_checker_streams_in_order);
+    RUN(test_checker_streams_big_files_in_their_place);
+    RUN(test_checker_streams_a_list_of_files);
+    RUN(test_result_writer_reorders_the_groups);
+    RUN(test_result_writer_spills_the_other_sections);
+    RUN(test_result_writer_counts_the_parts_of_a_group_once);
+
+    // -- Work Stealing Pool
+    RUN(test_pool_runs_every_task);
+    RUN(test_pool_never_runs_an_empty_task);
+    RUN(test_pool_runs_the_tasks_submitted_by_its_tasks);
+    RUN(test_pool_rethrows_task_errors);
+    RUN(test_device_scheduler_limits_each_device);
+
+    // -- Progress Observer
+    RUN(test_progress_observer_counts_the_bytes);
 
     // -- Hash Comparator
     RUN(test_hash_comparator_match);
     RUN(test_hash_comparator_not_match);
+    RUN(test_hash_comparator_ignores_the_case);
+    RUN(test_digests_as_bytes);
+
+    // -- Hash Cache
+    RUN(test_hash_cache_persists_hash_sums);
+    RUN(test_hash_cache_skips_unchanged_files);
+
+    // -- Statistics
+    RUN(test_stats_count_the_hashed_files);
+    RUN(test_stats_keep_the_counters_of_finished_threads);
+
+    // -- Manifests
+    RUN(test_manifest_formats);
+    RUN(test_manifest_types_sharing_a_length);
+    RUN(test_verifier_reports_failures);
+    RUN(test_verifier_fail_fast);
 
     return TEST_REPORT();
 }